@@ -186,14 +186,96 @@ static PyTypeObject kfs_ClientType = {
 };
 
 
+typedef vector<Py_buffer *> kfs_Buffers;
+
 struct kfs_File {
     PyObject_HEAD
     PyObject *name;       // File name
     PyObject *mode;       // Access mode
     PyObject *pclient;    // Python object for KFS client
     int fd;               // File descriptor
+    // Buffers pinned by read_prefetch() and write_async(): the client
+    // library reads into or writes from these asynchronously, therefore
+    // they must not be released until the io completes.
+    kfs_Buffers *prefetched;
+    kfs_Buffers *pending_writes;
 };
 
+static void
+release_buffers(kfs_Buffers *&bufs)
+{
+    if (bufs == NULL)
+        return;
+    for (kfs_Buffers::iterator b = bufs->begin(); b != bufs->end(); ++b) {
+        PyBuffer_Release(*b);
+        delete *b;
+    }
+    delete bufs;
+    bufs = NULL;
+}
+
+static void
+pin_buffer(kfs_Buffers *&bufs, Py_buffer *buf)
+{
+    if (bufs == NULL)
+        bufs = new kfs_Buffers();
+    bufs->push_back(buf);
+}
+
+/*
+ * Detach the buffers pinned by the writes queued so far. The writes queued by
+ * other threads while the GIL is released, after the detach, are not covered
+ * by the subsequent wait, therefore their buffers must stay pinned.
+ */
+static kfs_Buffers *
+detach_buffers(kfs_Buffers *&bufs)
+{
+    kfs_Buffers *const ret = bufs;
+    bufs = NULL;
+    return ret;
+}
+
+/*
+ * The read with the same buffer completes the prefetch, release the
+ * buffer pinned by the corresponding read_prefetch() call, if any.
+ */
+static void
+release_prefetched(kfs_File *self, const void *ptr)
+{
+    if (self->prefetched == NULL)
+        return;
+    kfs_Buffers &bufs = *self->prefetched;
+    for (kfs_Buffers::iterator b = bufs.begin(); b != bufs.end(); ) {
+        if ((*b)->buf == ptr) {
+            PyBuffer_Release(*b);
+            delete *b;
+            b = bufs.erase(b);
+        } else
+            ++b;
+    }
+}
+
+/*
+ * Close the file with the GIL released, as close waits for the pending
+ * io to complete, and then release all pinned buffers.
+ */
+static int
+close_file(kfs_File *self)
+{
+    kfs_Client *cl = (kfs_Client *)self->pclient;
+    const int fd = self->fd;
+    int status = 0;
+    if (fd != -1) {
+        self->fd = -1;
+        Py_BEGIN_ALLOW_THREADS
+        status = cl->client->Close(fd);
+        Py_END_ALLOW_THREADS
+    }
+    release_buffers(self->prefetched);
+    release_buffers(self->pending_writes);
+    return status;
+}
+
 static PyObject *
 File_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
 {
@@ -212,6 +294,8 @@ File_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
         Py_INCREF(noname);
         self->pclient = noname;
         self->fd = -1;
+        self->prefetched = NULL;
+        self->pending_writes = NULL;
     }
     return (PyObject *)self;
 }
@@ -220,9 +304,7 @@ static void
 File_dealloc(PyObject *pself)
 {
     kfs_File *self = (kfs_File *)pself;
-    kfs_Client *cl = (kfs_Client *)self->pclient;
-    if (self->fd != -1)
-        cl->client->Close(self->fd);
+    close_file(self);
     Py_DECREF(self->name);
     Py_DECREF(self->mode);
     Py_DECREF(self->pclient);
@@ -260,8 +342,12 @@ set_file_members(
         return -1;
 
     // open the file if necessary
-    if (fd < 0)
-        fd = client->client->Open(path, mode);
+    if (fd < 0) {
+        const string name(path);
+        Py_BEGIN_ALLOW_THREADS
+        fd = client->client->Open(name.c_str(), mode);
+        Py_END_ALLOW_THREADS
+    }
 
     if (fd < 0) {
         SetPyIoError(fd);
@@ -337,9 +423,15 @@ kfs_reopen(PyObject *pself, PyObject *args)
     if (mode == -1)
         return NULL;
 
-    int fd = cl->client->Open(PyString_AsString(self->name), mode);
-    if (fd == -1)
+    const string name(PyString_AsString(self->name));
+    int fd;
+    Py_BEGIN_ALLOW_THREADS
+    fd = cl->client->Open(name.c_str(), mode);
+    Py_END_ALLOW_THREADS
+    if (fd < 0) {
+        SetPyIoError(fd);
         return NULL;
+    }
 
     self->fd = fd;
     self->mode = PyString_FromString(modestr);
@@ -350,10 +442,10 @@ static PyObject *
 kfs_close(PyObject *pself, PyObject *args)
 {
     kfs_File *self = (kfs_File *)pself;
-    kfs_Client *cl = (kfs_Client *)self->pclient;
-    if (self->fd != -1) {
-        cl->client->Close(self->fd);
-        self->fd = -1;
+    int s = close_file(self);
+    if (s < 0) {
+        SetPyIoError(s);
+        return NULL;
     }
     Py_RETURN_NONE;
 }
@@ -378,7 +470,11 @@ kfs_read(PyObject *pself, PyObject *args)
         return NULL;
 
     char *buf = PyString_AsString(v);
-    ssize_t nr = cl->client->Read(self->fd, buf, rsize);
+    const int fd = self->fd;
+    ssize_t nr;
+    Py_BEGIN_ALLOW_THREADS
+    nr = cl->client->Read(fd, buf, rsize);
+    Py_END_ALLOW_THREADS
     if (nr < 0) {
         Py_DECREF(v);
         SetPyIoError(nr);
@@ -394,31 +490,291 @@ kfs_write(PyObject *pself, PyObject *args)
 {
     kfs_File *self = (kfs_File *)pself;
     kfs_Client *cl = (kfs_Client *)self->pclient;
-    int wsize = -1;
-    char *buf = NULL;
+    Py_buffer buf;
 
-    if (!PyArg_ParseTuple(args, "s#", &buf, &wsize))
+    if (!PyArg_ParseTuple(args, "s*", &buf))
         return NULL;
 
     if (self->fd == -1) {
-        SetPyIoError(EBADF);
+        PyBuffer_Release(&buf);
+        SetPyIoError(-EBADF);
         return NULL;
     }
 
-    ssize_t nw = cl->client->Write(self->fd, buf, (ssize_t)wsize);
+    const int fd = self->fd;
+    ssize_t nw;
+    Py_BEGIN_ALLOW_THREADS
+    nw = cl->client->Write(fd, (const char *)buf.buf, (size_t)buf.len);
+    Py_END_ALLOW_THREADS
+    const Py_ssize_t wsize = buf.len;
+    PyBuffer_Release(&buf);
     if (nw < 0) {
         SetPyIoError(nw);
         return NULL;
     }
     if (nw != wsize) {
         PyObject *msg = PyString_FromFormat(
-            "requested write of %d bytes but %ld were written",
-            wsize, (long)nw);
+            "requested write of %ld bytes but %ld were written",
+            (long)wsize, (long)nw);
         return msg;
     }
     Py_RETURN_NONE;
 }
 
+/*!
+ * \brief read into a writable buffer, such as bytearray or memoryview
+ *
+ * Reads directly into the caller's buffer, without intermediate string
+ * allocation and copy. If the buffer was passed to read_prefetch(), then
+ * the read completes the prefetch. Returns the number of bytes read.
+ */
+static PyObject *
+kfs_readinto(PyObject *pself, PyObject *args)
+{
+    kfs_File *self = (kfs_File *)pself;
+    kfs_Client *cl = (kfs_Client *)self->pclient;
+    Py_buffer buf;
+
+    if (!PyArg_ParseTuple(args, "w*", &buf))
+        return NULL;
+
+    if (self->fd == -1) {
+        PyBuffer_Release(&buf);
+        SetPyIoError(-EBADF);
+        return NULL;
+    }
+
+    const int fd = self->fd;
+    ssize_t nr;
+    Py_BEGIN_ALLOW_THREADS
+    nr = cl->client->Read(fd, (char *)buf.buf, (size_t)buf.len);
+    Py_END_ALLOW_THREADS
+    release_prefetched(self, buf.buf);
+    PyBuffer_Release(&buf);
+    if (nr < 0) {
+        SetPyIoError(nr);
+        return NULL;
+    }
+    return PyInt_FromSsize_t(nr);
+}
+
+/*!
+ * \brief positional read, the file position is not changed
+ */
+static PyObject *
+kfs_pread(PyObject *pself, PyObject *args)
+{
+    kfs_File *self = (kfs_File *)pself;
+    kfs_Client *cl = (kfs_Client *)self->pclient;
+    ssize_t rsize = -1l;
+    PY_LONG_LONG pos = 0;
+
+    if (!PyArg_ParseTuple(args, "lL", &rsize, &pos))
+        return NULL;
+
+    if (self->fd == -1) {
+        SetPyIoError(-EBADF);
+        return NULL;
+    }
+    if (rsize < 0 || pos < 0) {
+        SetPyIoError(-EINVAL);
+        return NULL;
+    }
+
+    PyObject *v = PyString_FromStringAndSize((char *)NULL, rsize);
+    if (v == NULL)
+        return NULL;
+
+    char *buf = PyString_AsString(v);
+    const int fd = self->fd;
+    ssize_t nr;
+    Py_BEGIN_ALLOW_THREADS
+    nr = cl->client->PRead(fd, (chunkOff_t)pos, buf, rsize);
+    Py_END_ALLOW_THREADS
+    if (nr < 0) {
+        Py_DECREF(v);
+        SetPyIoError(nr);
+        return NULL;
+    }
+    if (nr != rsize)
+        _PyString_Resize(&v, nr);
+    return v;
+}
+
+/*!
+ * \brief positional read into a writable buffer
+ */
+static PyObject *
+kfs_preadinto(PyObject *pself, PyObject *args)
+{
+    kfs_File *self = (kfs_File *)pself;
+    kfs_Client *cl = (kfs_Client *)self->pclient;
+    Py_buffer buf;
+    PY_LONG_LONG pos = 0;
+
+    if (!PyArg_ParseTuple(args, "w*L", &buf, &pos))
+        return NULL;
+
+    if (self->fd == -1 || pos < 0) {
+        PyBuffer_Release(&buf);
+        SetPyIoError(self->fd == -1 ? -EBADF : -EINVAL);
+        return NULL;
+    }
+
+    const int fd = self->fd;
+    ssize_t nr;
+    Py_BEGIN_ALLOW_THREADS
+    nr = cl->client->PRead(fd, (chunkOff_t)pos, (char *)buf.buf,
+        (size_t)buf.len);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&buf);
+    if (nr < 0) {
+        SetPyIoError(nr);
+        return NULL;
+    }
+    return PyInt_FromSsize_t(nr);
+}
+
+/*!
+ * \brief positional write, the file position is not changed
+ */
+static PyObject *
+kfs_pwrite(PyObject *pself, PyObject *args)
+{
+    kfs_File *self = (kfs_File *)pself;
+    kfs_Client *cl = (kfs_Client *)self->pclient;
+    Py_buffer buf;
+    PY_LONG_LONG pos = 0;
+
+    if (!PyArg_ParseTuple(args, "s*L", &buf, &pos))
+        return NULL;
+
+    if (self->fd == -1 || pos < 0) {
+        PyBuffer_Release(&buf);
+        SetPyIoError(self->fd == -1 ? -EBADF : -EINVAL);
+        return NULL;
+    }
+
+    const int fd = self->fd;
+    ssize_t nw;
+    Py_BEGIN_ALLOW_THREADS
+    nw = cl->client->PWrite(fd, (chunkOff_t)pos, (const char *)buf.buf,
+        (size_t)buf.len);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&buf);
+    if (nw < 0) {
+        SetPyIoError(nw);
+        return NULL;
+    }
+    return PyInt_FromSsize_t(nw);
+}
+
+/*!
+ * \brief start reading into the buffer from the current file position
+ *
+ * The buffer is held by the file object until the subsequent readinto()
+ * with the same buffer collects the data, or until the file is closed.
+ * The buffer must not be modified in the meantime.
+ */
+static PyObject *
+kfs_readPrefetch(PyObject *pself, PyObject *args)
+{
+    kfs_File *self = (kfs_File *)pself;
+    kfs_Client *cl = (kfs_Client *)self->pclient;
+    Py_buffer *buf = new Py_buffer;
+
+    if (!PyArg_ParseTuple(args, "w*", buf)) {
+        delete buf;
+        return NULL;
+    }
+
+    if (self->fd == -1) {
+        PyBuffer_Release(buf);
+        delete buf;
+        SetPyIoError(-EBADF);
+        return NULL;
+    }
+
+    const int fd = self->fd;
+    int s;
+    Py_BEGIN_ALLOW_THREADS
+    s = cl->client->ReadPrefetch(fd, (char *)buf->buf, (size_t)buf->len);
+    Py_END_ALLOW_THREADS
+    if (s < 0) {
+        PyBuffer_Release(buf);
+        delete buf;
+        SetPyIoError(s);
+        return NULL;
+    }
+    pin_buffer(self->prefetched, buf);
+    Py_RETURN_NONE;
+}
+
+/*!
+ * \brief queue write at the current file position, and advance the position
+ *
+ * The data is not copied, the buffer is held by the file object until
+ * write_async_wait(), sync(), or close() returns.
+ */
+static PyObject *
+kfs_writeAsync(PyObject *pself, PyObject *args)
+{
+    kfs_File *self = (kfs_File *)pself;
+    kfs_Client *cl = (kfs_Client *)self->pclient;
+    Py_buffer *buf = new Py_buffer;
+
+    if (!PyArg_ParseTuple(args, "s*", buf)) {
+        delete buf;
+        return NULL;
+    }
+
+    if (self->fd == -1) {
+        PyBuffer_Release(buf);
+        delete buf;
+        SetPyIoError(-EBADF);
+        return NULL;
+    }
+
+    const int fd = self->fd;
+    int s;
+    Py_BEGIN_ALLOW_THREADS
+    s = cl->client->WriteAsync(fd, (const char *)buf->buf, (size_t)buf->len);
+    Py_END_ALLOW_THREADS
+    if (s < 0) {
+        PyBuffer_Release(buf);
+        delete buf;
+        SetPyIoError(s);
+        return NULL;
+    }
+    pin_buffer(self->pending_writes, buf);
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+kfs_writeAsyncWait(PyObject *pself, PyObject *args)
+{
+    kfs_File *self = (kfs_File *)pself;
+    kfs_Client *cl = (kfs_Client *)self->pclient;
+
+    if (self->fd == -1) {
+        SetPyIoError(-EBADF);
+        return NULL;
+    }
+
+    const int fd = self->fd;
+    kfs_Buffers *written = detach_buffers(self->pending_writes);
+    int s;
+    Py_BEGIN_ALLOW_THREADS
+    s = cl->client->WriteAsyncCompletionHandler(fd);
+    Py_END_ALLOW_THREADS
+    release_buffers(written);
+    if (s < 0) {
+        SetPyIoError(s);
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
 static PyObject *
 kfs_chunkLocations(PyObject *pself, PyObject *args)
 {
@@ -436,7 +792,11 @@ kfs_chunkLocations(PyObject *pself, PyObject *args)
 
     vector<vector <string> > results;
 
-    int s = cl->client->GetDataLocation(self->fd, off, len, results);
+    const int fd = self->fd;
+    int s;
+    Py_BEGIN_ALLOW_THREADS
+    s = cl->client->GetDataLocation(fd, off, len, results);
+    Py_END_ALLOW_THREADS
     if (s < 0) {
         SetPyIoError(s);
         return NULL;
@@ -471,8 +831,12 @@ kfs_dataVerify(PyObject *pself, PyObject *args)
         return NULL;
     }
 
-        bool res = cl->client->VerifyDataChecksums(self->fd);
-        return Py_BuildValue("b", res);
+    const int fd = self->fd;
+    bool res;
+    Py_BEGIN_ALLOW_THREADS
+    res = cl->client->VerifyDataChecksums(fd);
+    Py_END_ALLOW_THREADS
+    return Py_BuildValue("b", res);
 }
 
 static PyObject *
@@ -490,7 +854,11 @@ kfs_truncate(PyObject *pself, PyObject *args)
         return NULL;
     }
 
-    int s = cl->client->Truncate(self->fd, off);
+    const int fd = self->fd;
+    int s;
+    Py_BEGIN_ALLOW_THREADS
+    s = cl->client->Truncate(fd, off);
+    Py_END_ALLOW_THREADS
     if (s < 0) {
         SetPyIoError(s);
         return NULL;
@@ -504,7 +872,19 @@ kfs_sync(PyObject *pself, PyObject *args)
 {
     kfs_File *self = (kfs_File *)pself;
     kfs_Client *cl = (kfs_Client *)self->pclient;
-    int s = cl->client->Sync(self->fd);
+
+    if (self->fd == -1) {
+        SetPyIoError(-EBADF);
+        return NULL;
+    }
+
+    const int fd = self->fd;
+    kfs_Buffers *written = detach_buffers(self->pending_writes);
+    int s;
+    Py_BEGIN_ALLOW_THREADS
+    s = cl->client->Sync(fd);
+    Py_END_ALLOW_THREADS
+    release_buffers(written);
     if (s < 0) {
         SetPyIoError(s);
         return NULL;
@@ -528,7 +908,11 @@ kfs_seek(PyObject *pself, PyObject *args)
         return NULL;
     }
 
-    off_t s = cl->client->Seek(self->fd, off, whence);
+    const int fd = self->fd;
+    off_t s;
+    Py_BEGIN_ALLOW_THREADS
+    s = cl->client->Seek(fd, off, whence);
+    Py_END_ALLOW_THREADS
     if (s < 0) {
         SetPyIoError(s);
         return NULL;
@@ -560,6 +944,13 @@ static PyMethodDef File_methods[] = {
     { "close", kfs_close, METH_NOARGS, "Close file." },
     { "read", kfs_read, METH_VARARGS, "Read from file." },
     { "write", kfs_write, METH_VARARGS, "Write to file." },
+    { "readinto", kfs_readinto, METH_VARARGS, "Read from file into buffer." },
+    { "pread", kfs_pread, METH_VARARGS, "Read from file at offset." },
+    { "preadinto", kfs_preadinto, METH_VARARGS, "Read from file at offset into buffer." },
+    { "pwrite", kfs_pwrite, METH_VARARGS, "Write to file at offset." },
+    { "read_prefetch", kfs_readPrefetch, METH_VARARGS, "Start reading into buffer." },
+    { "write_async", kfs_writeAsync, METH_VARARGS, "Queue write from buffer." },
+    { "write_async_wait", kfs_writeAsyncWait, METH_NOARGS, "Wait for queued writes." },
     { "truncate", kfs_truncate, METH_VARARGS, "Truncate a file." },
     { "chunk_locations", kfs_chunkLocations, METH_VARARGS, "Get location(s) of a chunk." },
     { "seek", kfs_seek, METH_VARARGS, "Seek to file offset." },
@@ -582,11 +973,21 @@ PyDoc_STRVAR(File_doc,
 "and syncs.  When a file is closed, its fd becomes -1 and no further\n"
 "operations can be done on it unless it is reopened with the kfs.file\n"
 "open method.\n\n"
+"Blocking operations release the global interpreter lock, allowing\n"
+"concurrent io from multiple threads.\n\n"
 "Methods:\n"
 "\topen([mode]) -- reopen closed file\n"
 "\tclose()     -- close file\n"
 "\tread(len)   -- read len bytes, return as string\n"
 "\twrite(str)  -- write string to file\n"
+"\treadinto(buf) -- read into bytearray or other writable buffer\n"
+"\tpread(len, off) -- read len bytes at offset off\n"
+"\tpreadinto(buf, off) -- read into buffer at offset off\n"
+"\tpwrite(str, off) -- write string at offset off\n"
+"\tread_prefetch(buf) -- start reading into buffer, readinto(buf) completes\n"
+"\twrite_async(buf) -- queue write, the buffer must not be modified until\n"
+"\t                    write_async_wait(), sync(), or close() returns\n"
+"\twrite_async_wait() -- wait for queued writes\n"
 "\ttruncate(off) -- truncate file at specified offset\n"
 "\tseek(off)   -- seek to specified offset\n"
 "\ttell()      -- return current offest\n"
@@ -772,7 +1173,10 @@ kfs_cd(PyObject *pself, PyObject *args)
 
     string path = build_path(self->cwd, patharg);
         KfsFileAttr attr;
-    int status = self->client->Stat(path.c_str(), attr);
+    int status;
+    Py_BEGIN_ALLOW_THREADS
+    status = self->client->Stat(path.c_str(), attr);
+    Py_END_ALLOW_THREADS
     if (status < 0) {
         SetPyIoError(status);
         return NULL;
@@ -812,7 +1216,10 @@ kfs_isdir(PyObject *pself, PyObject *args)
         return NULL;
 
     string path = build_path(self->cwd, patharg);
-    bool res = self->client->IsDirectory(path.c_str());
+    bool res;
+    Py_BEGIN_ALLOW_THREADS
+    res = self->client->IsDirectory(path.c_str());
+    Py_END_ALLOW_THREADS
         return Py_BuildValue("b", res);
 }
 
@@ -826,7 +1233,10 @@ kfs_isfile(PyObject *pself, PyObject *args)
         return NULL;
 
     string path = build_path(self->cwd, patharg);
-    bool res = self->client->IsFile(path.c_str());
+    bool res;
+    Py_BEGIN_ALLOW_THREADS
+    res = self->client->IsFile(path.c_str());
+    Py_END_ALLOW_THREADS
         return Py_BuildValue("b", res);
 }
 
@@ -840,7 +1250,10 @@ kfs_mkdir(PyObject *pself, PyObject *args)
         return NULL;
 
     string path = build_path(self->cwd, patharg);
-    int status  = self->client->Mkdir(path.c_str());
+    int status;
+    Py_BEGIN_ALLOW_THREADS
+    status = self->client->Mkdir(path.c_str());
+    Py_END_ALLOW_THREADS
     if (status < 0) {
         SetPyIoError(status);
         return NULL;
@@ -858,7 +1271,10 @@ kfs_mkdirs(PyObject *pself, PyObject *args)
         return NULL;
 
     string path = build_path(self->cwd, patharg);
-    int status  = self->client->Mkdirs(path.c_str());
+    int status;
+    Py_BEGIN_ALLOW_THREADS
+    status = self->client->Mkdirs(path.c_str());
+    Py_END_ALLOW_THREADS
     if (status < 0) {
         SetPyIoError(status);
         return NULL;
@@ -876,7 +1292,10 @@ kfs_rmdir(PyObject *pself, PyObject *args)
         return NULL;
 
     string path = build_path(self->cwd, patharg);
-    int status = self->client->Rmdir(path.c_str());
+    int status;
+    Py_BEGIN_ALLOW_THREADS
+    status = self->client->Rmdir(path.c_str());
+    Py_END_ALLOW_THREADS
     if (status < 0) {
         SetPyIoError(status);
         return NULL;
@@ -894,7 +1313,10 @@ kfs_rmdirs(PyObject *pself, PyObject *args)
         return NULL;
 
     string path = build_path(self->cwd, patharg);
-    int status = self->client->Rmdirs(path.c_str());
+    int status;
+    Py_BEGIN_ALLOW_THREADS
+    status = self->client->Rmdirs(path.c_str());
+    Py_END_ALLOW_THREADS
     if (status < 0) {
         SetPyIoError(status);
         return NULL;
@@ -920,7 +1342,10 @@ kfs_readdir(PyObject *pself, PyObject *args)
 
     string path = build_path(self->cwd, patharg);
     vector <string> result;
-    int status = self->client->Readdir(path.c_str(), result);
+    int status;
+    Py_BEGIN_ALLOW_THREADS
+    status = self->client->Readdir(path.c_str(), result);
+    Py_END_ALLOW_THREADS
     if (status < 0) {
         SetPyIoError(status);
         return NULL;
@@ -972,7 +1397,10 @@ kfs_readdirplus(PyObject *pself, PyObject *args)
     string path = build_path(self->cwd, patharg);
 
     vector <KfsFileAttr> result;
-    int status = self->client->ReaddirPlus(path.c_str(), result);
+    int status;
+    Py_BEGIN_ALLOW_THREADS
+    status = self->client->ReaddirPlus(path.c_str(), result);
+    Py_END_ALLOW_THREADS
     if (status < 0) {
         SetPyIoError(status);
         return NULL;
@@ -997,7 +1425,10 @@ kfs_stat(PyObject *pself, PyObject *args)
 
     string path = build_path(self->cwd, patharg);
         KfsFileAttr attr;
-    int status = self->client->Stat(path.c_str(), attr, true);
+    int status;
+    Py_BEGIN_ALLOW_THREADS
+    status = self->client->Stat(path.c_str(), attr, true);
+    Py_END_ALLOW_THREADS
     if (status < 0) {
         SetPyIoError(status);
         return NULL;
@@ -1032,7 +1463,10 @@ kfs_getNumChunks(PyObject *pself, PyObject *args)
         return NULL;
 
     string path = build_path(self->cwd, patharg);
-    int chunkCount = self->client->GetNumChunks(path.c_str());
+    int chunkCount;
+    Py_BEGIN_ALLOW_THREADS
+    chunkCount = self->client->GetNumChunks(path.c_str());
+    Py_END_ALLOW_THREADS
     if (chunkCount < 0) {
         SetPyIoError(chunkCount);
         return NULL;
@@ -1049,7 +1483,10 @@ kfs_getChunkSize(PyObject *pself, PyObject *args)
     if (!PyArg_ParseTuple(args, "s", &patharg))
         return NULL;
     string path = build_path(self->cwd, patharg);
-    int chunksz = self->client->GetChunkSize(path.c_str());
+    int chunksz;
+    Py_BEGIN_ALLOW_THREADS
+    chunksz = self->client->GetChunkSize(path.c_str());
+    Py_END_ALLOW_THREADS
         return Py_BuildValue("i", chunksz);
 }
 
@@ -1064,7 +1501,10 @@ kfs_create(PyObject *pself, PyObject *args)
         return NULL;
 
     string path = build_path(self->cwd, patharg);
-    int fd = self->client->Create(path.c_str(), numReplicas);
+    int fd;
+    Py_BEGIN_ALLOW_THREADS
+    fd = self->client->Create(path.c_str(), numReplicas);
+    Py_END_ALLOW_THREADS
     if (fd < 0) {
         SetPyIoError(fd);
         return NULL;
@@ -1087,7 +1527,10 @@ kfs_remove(PyObject *pself, PyObject *args)
         return NULL;
 
     string path = build_path(self->cwd, patharg);
-    int status = self->client->Remove(path.c_str());
+    int status;
+    Py_BEGIN_ALLOW_THREADS
+    status = self->client->Remove(path.c_str());
+    Py_END_ALLOW_THREADS
     if (status < 0) {
         SetPyIoError(status);
         return NULL;
@@ -1107,7 +1550,10 @@ kfs_rename(PyObject *pself, PyObject *args)
 
     string spath = build_path(self->cwd, srcpath);
     string dpath = build_path(self->cwd, dstpath);
-    int status = self->client->Rename(spath.c_str(), dpath.c_str(), overwrite);
+    int status;
+    Py_BEGIN_ALLOW_THREADS
+    status = self->client->Rename(spath.c_str(), dpath.c_str(), overwrite);
+    Py_END_ALLOW_THREADS
     if (status < 0) {
         SetPyIoError(status);
         return NULL;
@@ -1127,8 +1573,11 @@ kfs_coalesceblocks(PyObject *pself, PyObject *args)
     string spath = build_path(self->cwd, srcpath);
     string dpath = build_path(self->cwd, dstpath);
         chunkOff_t dstStartOffset;
-    int status = self->client->CoalesceBlocks(
+    int status;
+    Py_BEGIN_ALLOW_THREADS
+    status = self->client->CoalesceBlocks(
             spath.c_str(), dpath.c_str(), &dstStartOffset);
+    Py_END_ALLOW_THREADS
     if (status < 0) {
         SetPyIoError(status);
         return NULL;
@@ -0,0 +1,149 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file AppendBatch.h
+// \brief Record append replication batch encoding, used by the append master
+// to replicate concurrent appends with a single rpc down the chain.
+//
+//----------------------------------------------------------------------------
+
+#ifndef CHUNK_APPEND_BATCH_H
+#define CHUNK_APPEND_BATCH_H
+
+#include "common/kfstypes.h"
+#include "common/RequestParser.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <ostream>
+#include <string>
+
+namespace KFS
+{
+
+using std::ostream;
+using std::string;
+
+// Replication batch iterator. The batch has "length client-seq write-id..."
+// entry for every append, with one write id per replication chain position.
+class AppendBatchParser
+{
+public:
+    AppendBatchParser(
+        const string& batch,
+        uint32_t      numServers,
+        int           replicationPos)
+        : mPtr(batch.data()),
+          mEnd(mPtr + batch.size()),
+          mNumServers(numServers),
+          mReplicationPos(replicationPos)
+        {}
+    bool Next(size_t& length, kfsSeq_t& seq, int64_t& writeId)
+    {
+        if (! ValueParser::ParseInt(mPtr, mEnd - mPtr, length) ||
+                ! ValueParser::ParseInt(mPtr, mEnd - mPtr, seq)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < mNumServers; i++) {
+            int64_t wid = -1;
+            if (! ValueParser::ParseInt(mPtr, mEnd - mPtr, wid)) {
+                return false;
+            }
+            if (int(i) == mReplicationPos) {
+                writeId = wid;
+            }
+        }
+        return true;
+    }
+private:
+    const char*       mPtr;
+    const char* const mEnd;
+    const uint32_t    mNumServers;
+    const int         mReplicationPos;
+};
+
+// Appends batch entry for one append. The write ids are taken from the
+// append's "host port write-id ..." servers list.
+inline static ostream&
+AppendBatchEntry(ostream& os, size_t length, kfsSeq_t seq,
+    const string& servers, uint32_t numServers)
+{
+    os << length << ' ' << seq;
+    const char*       ptr = servers.data();
+    const char* const end = ptr + servers.size();
+    for (uint32_t i = 0; i < numServers * 3; i++) {
+        while (ptr < end && (*ptr & 0xFF) <= ' ') {
+            ptr++;
+        }
+        const char* const start = ptr;
+        while (ptr < end && (*ptr & 0xFF) > ' ') {
+            ptr++;
+        }
+        if (i % 3 == 2) {
+            os << ' ';
+            os.write(start, ptr - start);
+        }
+    }
+    return os;
+}
+
+// Commits the batch appends in order, all appends must be "in progress", at
+// the consecutive offsets starting from the next commit offset. The write id
+// state table T maps write id to the entry with mStatus, mOffset, and
+// mAppendCount fields. Returns false, and the write id of the first append
+// that can not be committed, if any, otherwise advances the next commit
+// offset, and the commit count.
+template<typename T>
+inline static bool
+AppendBatchCommit(
+    const string& batch,
+    int           count,
+    uint32_t      numServers,
+    int           replicationPos,
+    int           inProgressStatus,
+    T&            writeIdState,
+    int64_t&      nextCommitOffset,
+    uint64_t&     commitCount,
+    int64_t&      writeId)
+{
+    bool              okFlag = true;
+    size_t            length = 0;
+    kfsSeq_t          seq    = -1;
+    AppendBatchParser parser(batch, numServers, replicationPos);
+    for (int i = 0; okFlag && i < count; i++) {
+        typename T::iterator widIt;
+        okFlag = parser.Next(length, seq, writeId) &&
+            (widIt = writeIdState.find(writeId)) != writeIdState.end() &&
+            widIt->second.mStatus == inProgressStatus &&
+            widIt->second.mOffset == nextCommitOffset;
+        if (okFlag) {
+            nextCommitOffset += length;
+            commitCount++;
+            widIt->second.mAppendCount++;
+        }
+    }
+    return okFlag;
+}
+
+} // namespace KFS
+
+#endif /* CHUNK_APPEND_BATCH_H */
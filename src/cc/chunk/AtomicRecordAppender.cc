@@ -129,9 +129,11 @@ Then meta server updates list of chunk servers hosting the chunk based on the
 
 #include "common/MsgLogger.h"
 #include "common/StdAllocator.h"
+#include "common/RequestParser.h"
 #include "kfsio/Globals.h"
 #include "qcdio/QCDLList.h"
 #include "AtomicRecordAppender.h"
+#include "AppendBatch.h"
 #include "ChunkManager.h"
 #include "LeaseClerk.h"
 #include "DiskIo.h"
@@ -150,6 +152,7 @@ using std::make_pair;
 using std::min;
 using std::max;
 using std::string;
+using std::ostream;
 using std::ostringstream;
 using std::istringstream;
 using std::ws;
@@ -177,18 +180,23 @@ RecordAppendOp::RecordAppendOp(kfsSeq_t s)
       checksum(0),
       servers(),
       masterCommittedOffset(-1),
+      appendBatchCount(0),
+      appendBatch(),
       clientSeqStr(),
       dataBuf(),
       origClnt(0),
       origSeq(s),
-      replicationStartTime(0)
+      replicationStartTime(0),
+      batchHead(0),
+      batchNext(0)
 {
     AppendReplicationList::Init(*this);
 }
 
 RecordAppendOp::~RecordAppendOp()
 {
-    assert(! origClnt && ! QCDLListOp<RecordAppendOp>::IsInList(*this));
+    assert(! origClnt && ! batchHead && ! batchNext &&
+        ! QCDLListOp<RecordAppendOp>::IsInList(*this));
 }
 
 string
@@ -208,6 +216,9 @@ RecordAppendOp::Show() const
        " client-seq: " << clientSeq <<
        " master-committed: " << masterCommittedOffset
     ;
+    if (appendBatchCount > 0) {
+        os << " batch: " << appendBatchCount;
+    }
     return os.str();
 }
 
@@ -287,6 +298,12 @@ public:
     int  ChangeChunkSpaceReservaton(
         int64_t writeId, size_t nBytesIn, bool releaseFlag, string* errMsg);
     int  InvalidateWriteId(int64_t writeId, bool declareFailureFlag);
+    void SetReplicationBatchFlag(bool flag)
+    {
+        if (IsMaster()) {
+            mReplicationBatchFlag = flag;
+        }
+    }
     void AppendBegin(RecordAppendOp *op, int replicationPos,
         ServerLocation peerLoc);
     void GetOpStatus(GetRecordAppendOpStatus* op);
@@ -389,6 +406,13 @@ private:
     int                     mBufFrontPadding;
     int                     mIoOpsInFlight;
     int                     mReplicationsInFlight;
+    // Write master: appends waiting to be replicated in the next batch, and
+    // the number of record append ops sent to the peer.
+    RecordAppendOp*         mPendingBatchHead;
+    RecordAppendOp*         mPendingBatchTail;
+    int                     mPendingBatchCount;
+    size_t                  mPendingBatchBytes;
+    int                     mPeerOpsInFlight;
     size_t                  mBytesReserved;
     uint64_t                mAppendCommitCount;
     uint32_t                mChunkChecksum;
@@ -398,6 +422,9 @@ private:
     bool                    mFlushFullBlocksFlag:1;
     bool                    mCanDoLowOnBuffersFlushFlag:1;
     bool                    mMakeStableSucceededFlag:1;
+    // Write master: all servers down the replication chain support
+    // replication batches, set by write id allocation.
+    bool                    mReplicationBatchFlag:1;
     const uint64_t          mInstanceNum;
     int                     mConsecutiveOutOfSpaceCount;
     WriteIdState            mWriteIdState;
@@ -433,6 +460,16 @@ private:
     inline void SetCanDoLowOnBuffersFlushFlag(bool flag);
     void UpdateMasterCommittedOffset(int64_t masterCommittedOffset);
     void AppendCommit(RecordAppendOp *op);
+    int  BatchBegin(RecordAppendOp& op, string& msg);
+    void BatchCommit(RecordAppendOp& op);
+    void Replicate(RecordAppendOp* op);
+    void SendReplicationBatch();
+    void ReplicationDone(RecordAppendOp* op);
+    void EnqueueForReplication(RecordAppendOp* op)
+    {
+        mPeerOpsInFlight++;
+        mPeer->Enqueue(op);
+    }
     // helper function that flushes the buffered data.  the input
     // argument specifies whether the flush on the buffered data
     // should be aligned to checksum blocks.
@@ -614,6 +651,11 @@ AtomicRecordAppender::AtomicRecordAppender(
       mBufFrontPadding(0),
       mIoOpsInFlight(0),
       mReplicationsInFlight(0),
+      mPendingBatchHead(0),
+      mPendingBatchTail(0),
+      mPendingBatchCount(0),
+      mPendingBatchBytes(0),
+      mPeerOpsInFlight(0),
       mBytesReserved(0),
       mAppendCommitCount(0),
       mChunkChecksum(0),
@@ -623,6 +665,7 @@ AtomicRecordAppender::AtomicRecordAppender(
       mFlushFullBlocksFlag(false),
       mCanDoLowOnBuffersFlushFlag(false),
       mMakeStableSucceededFlag(false),
+      mReplicationBatchFlag(uint32_t(replicationPos + 1) >= numServers),
       mInstanceNum(++sInstanceNum),
       mConsecutiveOutOfSpaceCount(0),
       mWriteIdState(),
@@ -656,6 +699,7 @@ AtomicRecordAppender::~AtomicRecordAppender()
         mState == kStatePendingDelete &&
         mIoOpsInFlight == 0 &&
         mReplicationsInFlight == 0 &&
+        ! mPendingBatchHead &&
         mWriteIdState.empty() &&
         AppendReplicationList::IsEmpty(mReplicationList) &&
         ! gChunkManager.IsWriteAppenderOwns(mChunkId)
@@ -835,7 +879,7 @@ AtomicRecordAppender::EventHandler(int code, void* data)
                     OpDone(static_cast<WriteOp*>(op));
                 break;
                 case CMD_RECORD_APPEND:
-                    OpDone(static_cast<RecordAppendOp*>(op));
+                    ReplicationDone(static_cast<RecordAppendOp*>(op));
                 break;
                 case CMD_READ:
                     OpDone(static_cast<ReadOp*>(op));
@@ -1151,6 +1195,9 @@ AtomicRecordAppender::AppendBegin(
     } else if (mNextOffset + op->numBytes > int64_t(CHUNKSIZE)) {
         msg    = "out of chunk space";
         status = kErrParameters;
+    } else if (IsMaster() && op->appendBatchCount > 0) {
+        status = kErrParameters;
+        msg    = "protocol error: append batch sent to master";
     } else if (IsMaster() && op->clnt != this &&
             (client = op->GetClientSM()) &&
             client->GetReservedSpace(mChunkId, op->writeId) < op->numBytes) {
@@ -1164,8 +1211,10 @@ AtomicRecordAppender::AppendBegin(
         FatalError();
     }
 
+    const bool batchFlag     = status == 0 && op->appendBatchCount > 0;
     // Check if it is master 0 ack: no payload just commit offset.
-    const bool masterAckflag = status == 0 && op->numBytes == 0 &&
+    const bool masterAckflag = status == 0 && ! batchFlag &&
+        op->numBytes == 0 &&
         op->writeId == -1 &&
         (IsMaster() ? (op->clnt == this) : (op->masterCommittedOffset >= 0));
     WriteIdState::iterator const widIt = (masterAckflag || status != 0) ?
@@ -1181,6 +1230,8 @@ AtomicRecordAppender::AppendBegin(
         } else {
             UpdateMasterCommittedOffset(op->masterCommittedOffset);
         }
+    } else if (batchFlag) {
+        status = BatchBegin(*op, msg);
     } else if (status == 0) {
         if (widIt == mWriteIdState.end()) {
             status = kErrParameters;
@@ -1279,13 +1330,16 @@ AtomicRecordAppender::AppendBegin(
     if (status == 0 && ! masterAckflag) {
         // Write id table is updated only in the case when execution is
         // committed. Otherwise the op is discarded, and treated like
-        // it was never received.
-        assert(widIt != mWriteIdState.end() && widIt->second.mStatus == 0);
-        WIdState& ws = widIt->second;
-        ws.mStatus = kErrStatusInProgress;
-        ws.mLength = op->numBytes;
-        ws.mOffset = op->fileOffset;
-        ws.mSeq    = op->clientSeq;
+        // it was never received. BatchBegin() updates write id table for
+        // every append in the batch.
+        if (! batchFlag) {
+            assert(widIt != mWriteIdState.end() && widIt->second.mStatus == 0);
+            WIdState& ws = widIt->second;
+            ws.mStatus = kErrStatusInProgress;
+            ws.mLength = op->numBytes;
+            ws.mOffset = op->fileOffset;
+            ws.mSeq    = op->clientSeq;
+        }
 
         // Move blocks into the internal buffer.
         // The main reason to do this now, and not to wait for the replication
@@ -1369,10 +1423,218 @@ AtomicRecordAppender::AppendBegin(
             mTimer.ScheduleTimeoutNoLaterThanIn(
                 gAtomicRecordAppendManager.GetReplicationTimeoutSec());
         }
-        mPeer->Enqueue(op);
+        Replicate(op);
+    } else {
+        OpDone(op);
+    }
+}
+
+int
+AtomicRecordAppender::BatchBegin(RecordAppendOp& op, string& msg)
+{
+    if (op.fileOffset != mNextOffset) {
+        // Out of order replication.
+        msg = "invalid append batch offset";
+        SetState(kStateReplicationFailed);
+        return kErrParameters;
+    }
+    UpdateMasterCommittedOffset(op.masterCommittedOffset);
+    // Validate all appends first, the batch is either executed as a whole or
+    // discarded.
+    int      status  = 0;
+    int      count   = 0;
+    size_t   total   = 0;
+    size_t   length  = 0;
+    kfsSeq_t seq     = -1;
+    int64_t  writeId = -1;
+    AppendBatchParser parser(op.appendBatch, op.numServers, mReplicationPos);
+    while (count < op.appendBatchCount && parser.Next(length, seq, writeId)) {
+        count++;
+        total += length;
+        WriteIdState::iterator const widIt = mWriteIdState.find(writeId);
+        if (length <= 0 || widIt == mWriteIdState.end()) {
+            status = kErrParameters;
+            msg    = "invalid append batch write id or length";
+            break;
+        }
+        WIdState& ws = widIt->second;
+        if (ws.mStatus == kErrStatusInProgress &&
+                mMasterCommittedOffset >= ws.mOffset + int64_t(ws.mLength)) {
+            ws.mStatus = 0; // Master committed.
+        }
+        if (ws.mReadOnlyFlag) {
+            status = kErrWidReadOnly;
+            msg    = "no appends allowed with this write id";
+            break;
+        }
+        if (ws.mStatus != 0) {
+            status = kErrParameters;
+            msg    = ws.mStatus == kErrStatusInProgress ?
+                "has operation in flight" :
+                "invalid write id: previous append failed";
+            break;
+        }
+    }
+    if (status == 0 &&
+            (count != op.appendBatchCount || total != op.numBytes)) {
+        status = kErrParameters;
+        msg    = "malformed append batch";
+    }
+    if (status == 0) {
+        const uint32_t checksum = ComputeBlockChecksum(&op.dataBuf, op.numBytes);
+        if (op.checksum != checksum) {
+            ostringstream os;
+            os << "append batch checksum mismatch: "
+                " received: " << op.checksum <<
+                " actual: " << checksum
+            ;
+            msg    = os.str();
+            status = kErrParameters;
+            Cntrs().mChecksumErrorCount++;
+            SetState(kStateReplicationFailed);
+        }
+    }
+    if (status != 0) {
+        return status;
+    }
+    AppendBatchParser batch(op.appendBatch, op.numServers, mReplicationPos);
+    for (int i = 0; i < count && batch.Next(length, seq, writeId); i++) {
+        WIdState& ws = mWriteIdState[writeId];
+        ws.mStatus = kErrStatusInProgress;
+        ws.mLength = length;
+        ws.mOffset = mNextOffset;
+        ws.mSeq    = seq;
+        mNextOffset += length;
+    }
+    return status;
+}
+
+void
+AtomicRecordAppender::Replicate(RecordAppendOp* op)
+{
+    // Write master coalesces appends that arrive while the prior replication
+    // rpcs are in flight into a single batch, in order to reduce the number of
+    // rpcs, and the per rpc processing and network overheads down the chain.
+    const int maxBytes =
+        gAtomicRecordAppendManager.GetReplicationBatchMaxBytes();
+    if (! IsMaster() || ! mReplicationBatchFlag ||
+            op->numBytes <= 0 || maxBytes <= 0 ||
+            op->numBytes >= size_t(maxBytes)) {
+        // Replication must preserve the append order.
+        SendReplicationBatch();
+        EnqueueForReplication(op);
+        return;
+    }
+    op->batchNext = 0;
+    if (mPendingBatchTail) {
+        mPendingBatchTail->batchNext = op;
+    } else {
+        mPendingBatchHead = op;
+    }
+    mPendingBatchTail = op;
+    mPendingBatchCount++;
+    mPendingBatchBytes += op->numBytes;
+    // Keep the batch rpc header well under the max rpc header size.
+    const int kWriteIdLen = 21;
+    const int maxCount    = max(1, MAX_RPC_HEADER_LEN / 2 /
+        ((int(mNumServers) + 2) * kWriteIdLen));
+    if (mPeerOpsInFlight <
+                gAtomicRecordAppendManager.GetReplicationBatchMaxInFlight() ||
+            mPendingBatchBytes >= size_t(maxBytes) ||
+            mPendingBatchCount >= maxCount) {
+        SendReplicationBatch();
+    }
+}
+
+void
+AtomicRecordAppender::SendReplicationBatch()
+{
+    RecordAppendOp* const head  = mPendingBatchHead;
+    const int             count = mPendingBatchCount;
+    if (! head) {
+        return;
+    }
+    mPendingBatchHead  = 0;
+    mPendingBatchTail  = 0;
+    mPendingBatchCount = 0;
+    mPendingBatchBytes = 0;
+    if (mState != kStateOpen) {
+        // Replication has failed, do not send, AppendCommit() will declare
+        // the appends status undefined.
+        // The last OpDone() might delete this.
+        RecordAppendOp* next = head;
+        while (next) {
+            RecordAppendOp* const cur = next;
+            next = cur->batchNext;
+            cur->batchNext = 0;
+            OpDone(cur);
+        }
+        return;
+    }
+    if (count == 1) {
+        EnqueueForReplication(head);
+        return;
+    }
+    // Use offset as seq. # for debugging
+    RecordAppendOp* const op = new RecordAppendOp(head->fileOffset);
+    op->clnt             = this;
+    op->chunkId          = mChunkId;
+    op->chunkVersion     = mChunkVersion;
+    op->numServers       = mNumServers;
+    op->servers          = mCommitAckServers;
+    op->offset           = head->offset;
+    op->fileOffset       = head->fileOffset;
+    op->clientSeq        = head->clientSeq;
+    op->appendBatchCount = count;
+    op->batchHead        = head;
+    ostringstream os;
+    for (RecordAppendOp* cur = head; cur; cur = cur->batchNext) {
+        op->numBytes += cur->numBytes;
+        op->dataBuf.Move(&cur->dataBuf);
+        if (cur != head) {
+            os << ' ';
+        }
+        AppendBatchEntry(os, cur->numBytes, cur->clientSeq,
+            cur->servers, mNumServers);
+    }
+    op->appendBatch           = os.str();
+    op->checksum              = ComputeBlockChecksum(&op->dataBuf, op->numBytes);
+    op->masterCommittedOffset = mNextCommitOffset;
+    mCommitOffsetAckSent      = mNextCommitOffset;
+    Cntrs().mReplicationBatchCount++;
+    Cntrs().mReplicationBatchAppendCount += count;
+    WAPPEND_LOG_STREAM_DEBUG <<
+        "replication batch: " << op->Show() <<
+    KFS_LOG_EOM;
+    EnqueueForReplication(op);
+}
+
+void
+AtomicRecordAppender::ReplicationDone(RecordAppendOp* op)
+{
+    assert(mPeerOpsInFlight > 0);
+    mPeerOpsInFlight--;
+    // The pending appends are accounted in replications in flight, and
+    // prevent OpDone() from deleting this.
+    const bool sendFlag = mPendingBatchHead != 0;
+    RecordAppendOp* next = op->batchHead;
+    if (next) {
+        op->batchHead = 0;
+        while (next) {
+            RecordAppendOp* const cur = next;
+            next = cur->batchNext;
+            cur->batchNext = 0;
+            cur->status    = op->status;
+            cur->statusMsg = op->statusMsg;
+            OpDone(cur);
+        }
+        delete op;
     } else {
         OpDone(op);
     }
+    if (sendFlag) {
+        SendReplicationBatch();
+    }
 }
 
 int
@@ -1479,6 +1741,10 @@ AtomicRecordAppender::AppendCommit(RecordAppendOp *op)
         SetState(kStateReplicationFailed);
         return;
     }
+    if (op->appendBatchCount > 0) {
+        BatchCommit(*op);
+        return;
+    }
     // AppendBegin checks if write id is read only.
     // If write id wasn't read only in the append begin, it cannot transition
     // into into read only between AppendBegin and AppendCommit, as it should
@@ -1544,6 +1810,41 @@ AtomicRecordAppender::AppendCommit(RecordAppendOp *op)
     KFS_LOG_EOM;
 }
 
+void
+AtomicRecordAppender::BatchCommit(RecordAppendOp& op)
+{
+    int64_t    writeId = -1;
+    const bool okFlag  = ! IsMaster() &&
+        op.fileOffset == mNextCommitOffset &&
+        op.chunkId == mChunkId &&
+        op.chunkVersion == mChunkVersion &&
+        AppendBatchCommit(op.appendBatch, op.appendBatchCount,
+            op.numServers, mReplicationPos, kErrStatusInProgress,
+            mWriteIdState, mNextCommitOffset, mAppendCommitCount, writeId);
+    if (! okFlag) {
+        WAPPEND_LOG_STREAM_FATAL <<
+            "commit: out of order or invalid append batch" <<
+            " chunk: "        << mChunkId <<
+            " chunkVersion: " << mChunkVersion <<
+            " offset: "       << mNextCommitOffset <<
+            " nextOffset: "   << mNextOffset <<
+            " writeId: "      << writeId <<
+            " " << op.Show() <<
+        KFS_LOG_EOM;
+        FatalError();
+        return;
+    }
+    op.status = 0;
+    WAPPEND_LOG_STREAM_DEBUG <<
+        "commit batch:"
+        " state: "        << GetStateAsStr() <<
+        " offset: next: " << mNextOffset <<
+        " commit: "       << mNextCommitOffset <<
+        " master: "       << mMasterCommittedOffset <<
+        " " << op.Show() <<
+    KFS_LOG_EOM;
+}
+
 void
 AtomicRecordAppender::GetOpStatus(GetRecordAppendOpStatus* op)
 {
@@ -1736,6 +2037,8 @@ AtomicRecordAppender::CloseChunk(CloseOp* op, int64_t writeId, bool& forwardFlag
         CloseOp* const fwdOp = new CloseOp(0, op);
         fwdOp->needAck = false;
         SET_HANDLER(fwdOp, &CloseOp::HandlePeerReply);
+        // Close must follow the pending appends.
+        SendReplicationBatch();
         mPeer->Enqueue(fwdOp);
     }
     WAPPEND_LOG_STREAM(status == 0 ?
@@ -2626,6 +2929,8 @@ AtomicRecordAppendManager::AtomicRecordAppendManager()
       mMaxWriteIdsPerChunk(16 << 10),
       mCloseOutOfSpaceThreshold(4),
       mCloseOutOfSpaceSec(5),
+      mReplicationBatchMaxBytes(256 << 10),
+      mReplicationBatchMaxInFlight(2),
       mInstanceNum(0),
       mCounters()
 {
@@ -2668,6 +2973,12 @@ AtomicRecordAppendManager::SetParameters(const Properties& props)
         mCloseOutOfSpaceThreshold);
     mCloseOutOfSpaceSec     = props.getValue(
         "chunkServer.recAppender.closeOutOfSpaceSec", mCloseOutOfSpaceSec);
+    mReplicationBatchMaxBytes = props.getValue(
+        "chunkServer.recAppender.replicationBatchMaxBytes",
+        mReplicationBatchMaxBytes);
+    mReplicationBatchMaxInFlight = props.getValue(
+        "chunkServer.recAppender.replicationBatchMaxInFlight",
+        mReplicationBatchMaxInFlight);
     mTotalBuffersBytes       = 0;
     if (! mAppenders.empty()) {
         UpdateAppenderFlushLimit();
@@ -2905,6 +3216,16 @@ AtomicRecordAppendManager::InvalidateWriteId(
         it->second->InvalidateWriteId(writeId, declareFailureFlag));
 }
 
+void
+AtomicRecordAppendManager::SetReplicationBatchFlag(
+    kfsChunkId_t chunkId, bool flag)
+{
+    ARAMap::const_iterator const it = mAppenders.find(chunkId);
+    if (it != mAppenders.end()) {
+        it->second->SetReplicationBatchFlag(flag);
+    }
+}
+
 int
 AtomicRecordAppendManager::GetAlignmentAndFwdFlag(kfsChunkId_t chunkId,
     bool& forwardFlag) const
@@ -50,6 +50,8 @@ public:
         Counter mAppendErrorCount;
         Counter mReplicationErrorCount;
         Counter mReplicationTimeoutCount;
+        Counter mReplicationBatchCount;
+        Counter mReplicationBatchAppendCount;
         Counter mAppenderAllocCount;
         Counter mAppenderAllocMasterCount;
         Counter mAppenderAllocErrorCount;
@@ -83,6 +85,8 @@ public:
             mAppendErrorCount = 0;
             mReplicationErrorCount = 0;
             mReplicationTimeoutCount = 0;
+            mReplicationBatchCount = 0;
+            mReplicationBatchAppendCount = 0;
             mAppenderAllocCount = 0;
             mAppenderAllocMasterCount = 0;
             mAppenderAllocErrorCount = 0;
@@ -128,6 +132,9 @@ public:
     int    GetMaxWriteIdsPerChunk()      const { return mMaxWriteIdsPerChunk;      }
     int    GetCloseOutOfSpaceThreshold() const { return mCloseOutOfSpaceThreshold; }
     int    GetCloseOutOfSpaceSec()       const { return mCloseOutOfSpaceSec;       }
+    int    GetReplicationBatchMaxBytes() const { return mReplicationBatchMaxBytes; }
+    int    GetReplicationBatchMaxInFlight() const
+        { return mReplicationBatchMaxInFlight; }
     bool   IsChunkStable(kfsChunkId_t chunkId) const;
     /// For record appends, (1) clients will reserve space in a chunk and
     /// then write and (2) clients can release their reserved space.
@@ -144,6 +151,7 @@ public:
     int    InvalidateWriteIdDeclareFailure(kfsChunkId_t chunkId, int64_t writeId) {
         return InvalidateWriteId(chunkId, writeId, true);
     }
+    void   SetReplicationBatchFlag(kfsChunkId_t chunkId, bool flag);
     int64_t GetOpenAppendersCount() const {
         return mOpenAppendersCount;
     }
@@ -197,6 +205,8 @@ private:
     int                   mMaxWriteIdsPerChunk;
     int                   mCloseOutOfSpaceThreshold;
     int                   mCloseOutOfSpaceSec;
+    int                   mReplicationBatchMaxBytes;
+    int                   mReplicationBatchMaxInFlight;
     AtomicRecordAppender* mPendingFlushList[1];
     const uint64_t        mInstanceNum;
     Counters              mCounters;
@@ -24,11 +24,13 @@
 //----------------------------------------------------------------------------
 
 #include <algorithm>
+#include <string.h>
 
 #include "BufferManager.h"
 #include "qcdio/QCUtils.h"
 #include "kfsio/NetManager.h"
 #include "kfsio/Globals.h"
+#include "common/Properties.h"
 
 namespace KFS
 {
@@ -40,16 +42,100 @@ using std::max;
 // Chunk server disk and network io buffer manager implementation.
 BufferManager::Client::Client()
     : mManagerPtr(0),
+      mTenantPtr(0),
       mByteCount(0),
       mWaitingForByteCount(0),
-      mWaitStart(0)
+      mWaitStart(0),
+      mWaitingForDiskIoFlag(false)
 {
     WaitQueue::Init(*this);
 }
 
+class BufferManager::Tenant
+{
+public:
+    Tenant(
+        const string& inName)
+        : mName(inName),
+          mWeight(-1),
+          mMaxBytesPerSec(-1),
+          mMaxOpsPerSec(-1),
+          mCurWeight(1),
+          mBytesBucket(),
+          mOpsBucket(),
+          mVirtualTime(0),
+          mWaitingCount(0),
+          mCounters()
+    {
+        WaitQueue::Init(mWaitQueuePtr);
+        mCounters.Clear();
+    }
+    void UpdateTokens(
+        int64_t inNowUsecs)
+    {
+        mBytesBucket.Update(inNowUsecs);
+        mOpsBucket.Update(inNowUsecs);
+    }
+
+    const string   mName;
+    // Configured parameters, negative values mean use the defaults.
+    int            mWeight;
+    double         mMaxBytesPerSec;
+    double         mMaxOpsPerSec;
+    int            mCurWeight;
+    TokenBucket    mBytesBucket;
+    TokenBucket    mOpsBucket;
+    int64_t        mVirtualTime;
+    int            mWaitingCount;
+    TenantCounters mCounters;
+    Client*        mWaitQueuePtr[1];
+private:
+    Tenant(
+        const Tenant& inTenant);
+    Tenant& operator=(
+        const Tenant& inTenant);
+};
+
+    void
+BufferManager::TokenBucket::Set(
+    double  inRate,
+    double  inBurstSecs,
+    int64_t inNowUsecs)
+{
+    const bool theWasLimitedFlag = 0 < mRate;
+    mRate      = max(0., inRate);
+    mMaxTokens = max(1., mRate * inBurstSecs);
+    if (! theWasLimitedFlag) {
+        mTokens    = mMaxTokens;
+        mLastUsecs = inNowUsecs;
+    } else {
+        mTokens = min(mMaxTokens, mTokens);
+    }
+}
+
+    void
+BufferManager::TokenBucket::Update(
+    int64_t inNowUsecs)
+{
+    if (mRate <= 0 || inNowUsecs <= mLastUsecs) {
+        return;
+    }
+    mTokens = min(mMaxTokens,
+        mTokens + (inNowUsecs - mLastUsecs) * 1e-6 * mRate);
+    mLastUsecs = inNowUsecs;
+}
+
 BufferManager::BufferManager(
     bool inEnabledFlag /* = true */)
     : ITimeout(),
+      mTenants(),
+      mBytesBucket(),
+      mOpsBucket(),
+      mVirtualTime(0),
+      mBurstSecs(1),
+      mDefaultWeight(1),
+      mDefaultMaxBytesPerSec(0),
+      mDefaultMaxOpsPerSec(0),
       mTotalCount(0),
       mMaxClientQuota(0),
       mRemainingCount(0),
@@ -71,14 +157,20 @@ BufferManager::BufferManager(
       mWaitingAvgUsecs(0),
       mCounters()
 {
-    WaitQueue::Init(mWaitQueuePtr);
     mCounters.Clear();
+    // The first entry is the default tenant.
+    mTenants.push_back(new Tenant(string()));
     BufferManager::SetWaitingAvgInterval(20);
 }
 
 BufferManager::~BufferManager()
 {
-    QCRTASSERT(WaitQueue::IsEmpty(mWaitQueuePtr));
+    for (Tenants::const_iterator theIt = mTenants.begin();
+            theIt != mTenants.end();
+            ++theIt) {
+        QCRTASSERT(WaitQueue::IsEmpty((*theIt)->mWaitQueuePtr));
+        delete *theIt;
+    }
     globalNetManager().UnRegisterTimeoutHandler(this);
 }
 
@@ -139,11 +231,24 @@ BufferManager::Modify(
     mCounters.mRequestByteCount += inByteCount;
     mGetRequestCount++;
     inClient.mManagerPtr = this;
+    Tenant& theTenant = GetTenant(inClient);
+    theTenant.mCounters.mRequestCount++;
+    theTenant.mCounters.mRequestByteCount += inByteCount;
+    bool theHasTokensFlag = true;
+    if (inForDiskIoFlag) {
+        theTenant.mCounters.mIoRequestCount++;
+        theTenant.mCounters.mIoRequestByteCount += inByteCount;
+        const int64_t theNowUsecs = microseconds();
+        mBytesBucket.Update(theNowUsecs);
+        mOpsBucket.Update(theNowUsecs);
+        theTenant.UpdateTokens(theNowUsecs);
+        theHasTokensFlag = HasIoTokens(theTenant);
+    }
     const ByteCount theReqCount    =
         inClient.mWaitingForByteCount + inClient.mByteCount + inByteCount;
     const bool      theGrantedFlag = ! inClient.IsWaiting() && (
         theReqCount <= 0 || (
-            (! inForDiskIoFlag || ! mDiskOverloadedFlag) &&
+            (! inForDiskIoFlag || (! mDiskOverloadedFlag && theHasTokensFlag)) &&
             ! IsLowOnBuffers() &&
             theReqCount < mRemainingCount &&
             ! IsOverQuota(inClient)
@@ -154,13 +259,22 @@ BufferManager::Modify(
         mRemainingCount -= theReqCount;
         mCounters.mRequestGrantedCount++;
         mCounters.mRequestGrantedByteCount += inByteCount;
+        Charge(theTenant, inByteCount, inForDiskIoFlag);
     } else {
         mCounters.mRequestDeniedCount++;
         mCounters.mRequestDeniedByteCount += inByteCount;
+        if (! theHasTokensFlag) {
+            theTenant.mCounters.mThrottledCount++;
+        }
         // If already waiting leave him in the same place in the queue.
-        if (! inClient.IsWaiting()) {
-            inClient.mWaitStart = microseconds();
-            WaitQueue::PushBack(mWaitQueuePtr, inClient);
+        if (inClient.IsWaiting()) {
+            inClient.mWaitingForDiskIoFlag =
+                inClient.mWaitingForDiskIoFlag || inForDiskIoFlag;
+        } else {
+            inClient.mWaitStart            = microseconds();
+            inClient.mWaitingForDiskIoFlag = inForDiskIoFlag;
+            WaitQueue::PushBack(theTenant.mWaitQueuePtr, inClient);
+            theTenant.mWaitingCount++;
             mWaitingCount++;
         }
         mWaitingByteCount += inByteCount;
@@ -183,12 +297,15 @@ BufferManager::Unregister(
         return;
     }
     QCRTASSERT(inClient.mManagerPtr == this);
+    Tenant& theTenant = GetTenant(inClient);
     if (IsWaiting(inClient)) {
         mWaitingCount--;
+        theTenant.mWaitingCount--;
         mWaitingByteCount -= inClient.mWaitingForByteCount;
     }
-    WaitQueue::Remove(mWaitQueuePtr, inClient);
-    inClient.mWaitingForByteCount = 0;
+    WaitQueue::Remove(theTenant.mWaitQueuePtr, inClient);
+    inClient.mWaitingForByteCount  = 0;
+    inClient.mWaitingForDiskIoFlag = false;
     Put(inClient, inClient.mByteCount);
     assert(! inClient.IsWaiting() && inClient.mByteCount == 0);
 }
@@ -205,10 +322,20 @@ BufferManager::CancelRequest(
         assert(inClient.mWaitingForByteCount == 0);
         return;
     }
-    WaitQueue::Remove(mWaitQueuePtr, inClient);
+    Tenant& theTenant = GetTenant(inClient);
+    WaitQueue::Remove(theTenant.mWaitQueuePtr, inClient);
     mWaitingCount--;
+    theTenant.mWaitingCount--;
     mWaitingByteCount -= inClient.mWaitingForByteCount;
-    inClient.mWaitingForByteCount = 0;
+    inClient.mWaitingForByteCount  = 0;
+    inClient.mWaitingForDiskIoFlag = false;
+}
+
+    bool
+BufferManager::IsWaiting(
+    const BufferManager::Client& inClient) const
+{
+    return WaitQueue::IsInList(GetTenant(inClient).mWaitQueuePtr, inClient);
 }
 
     bool
@@ -226,22 +353,48 @@ BufferManager::IsLowOnBuffers() const
     /* virtual */ void
 BufferManager::Timeout()
 {
-    bool    theSetTimeFlag = true;
-    int64_t theNowUsecs    = 0;
+    int64_t theNowUsecs = microseconds();
+    UpdateTokens(theNowUsecs);
     while (! mDiskOverloadedFlag && ! IsLowOnBuffers()) {
-        WaitQueue::Iterator theIt(mWaitQueuePtr);
-        Client*             theClientPtr;
-        while ((theClientPtr = theIt.Next())) {
-            // Skip all that are over quota.
-            if (! IsOverQuota(*theClientPtr)) {
-                break;
+        // Weighted fair queuing: serve the tenant with the smallest virtual
+        // time, that has client that is not over quota, and io tokens if the
+        // client waits for disk io.
+        Tenant* theTenantPtr = 0;
+        Client* theClientPtr = 0;
+        int64_t theMinTime   = 0;
+        for (Tenants::const_iterator theTIt = mTenants.begin();
+                theTIt != mTenants.end();
+                ++theTIt) {
+            Tenant& theTenant = **theTIt;
+            if (WaitQueue::IsEmpty(theTenant.mWaitQueuePtr)) {
+                continue;
+            }
+            const int64_t theTime = max(mVirtualTime, theTenant.mVirtualTime);
+            if (theTenantPtr && theMinTime <= theTime) {
+                continue;
+            }
+            WaitQueue::Iterator theIt(theTenant.mWaitQueuePtr);
+            Client*             thePtr;
+            while ((thePtr = theIt.Next())) {
+                // Skip all that are over quota.
+                if (! IsOverQuota(*thePtr)) {
+                    break;
+                }
+            }
+            if (! thePtr || (thePtr->mWaitingForDiskIoFlag &&
+                    ! HasIoTokens(theTenant))) {
+                continue;
             }
+            theTenantPtr = &theTenant;
+            theClientPtr = thePtr;
+            theMinTime   = theTime;
         }
         if (! theClientPtr ||
                 theClientPtr->mWaitingForByteCount > mRemainingCount) {
             break;
         }
-        WaitQueue::Remove(mWaitQueuePtr, *theClientPtr);
+        WaitQueue::Remove(theTenantPtr->mWaitQueuePtr, *theClientPtr);
+        theTenantPtr->mWaitingCount--;
         mWaitingCount--;
         const ByteCount theGrantedCount = theClientPtr->mWaitingForByteCount;
         assert(theGrantedCount > 0);
@@ -251,16 +404,17 @@ BufferManager::Timeout()
         if (theClientPtr->mByteCount <= 0 && theGrantedCount > 0) {
             mClientsWihtBuffersCount++;
         }
-        if (theSetTimeFlag) {
-            theSetTimeFlag = false;
-            theNowUsecs    = microseconds();
-        }
-        mCounters.mRequestWaitUsecs += max(int64_t(0),
+        const int64_t theWaitUsecs = max(int64_t(0),
             theNowUsecs - theClientPtr->mWaitStart);
+        mCounters.mRequestWaitUsecs += theWaitUsecs;
         mCounters.mRequestGrantedCount++;
         mCounters.mRequestGrantedByteCount += theGrantedCount;
+        theTenantPtr->mCounters.mRequestWaitUsecs += theWaitUsecs;
+        Charge(*theTenantPtr, theGrantedCount,
+            theClientPtr->mWaitingForDiskIoFlag);
         theClientPtr->mByteCount += theGrantedCount;
-        theClientPtr->mWaitingForByteCount = 0;
+        theClientPtr->mWaitingForByteCount  = 0;
+        theClientPtr->mWaitingForDiskIoFlag = false;
         theClientPtr->Granted(theGrantedCount);
     }
     UpdateWaitingAvg();
@@ -440,9 +594,17 @@ BufferManager::UpdateWaitingAvg()
     }
     const int64_t theNowUsecs  = microseconds();
     const int64_t theEnd       = theNowUsecs - kWaitingAvgIntervalUsec;
-    const int64_t theWaitUsecs = WaitQueue::IsEmpty(mWaitQueuePtr) ?
-        int64_t(0) : max(int64_t(0),
-            theNowUsecs - WaitQueue::Front(mWaitQueuePtr)->mWaitStart);
+    int64_t       theWaitUsecs = 0;
+    for (Tenants::const_iterator theIt = mTenants.begin();
+            theIt != mTenants.end();
+            ++theIt) {
+        const Client* const theClientPtr =
+            WaitQueue::Front((*theIt)->mWaitQueuePtr);
+        if (theClientPtr) {
+            theWaitUsecs = max(theWaitUsecs,
+                theNowUsecs - theClientPtr->mWaitStart);
+        }
+    }
     while (mWaitingAvgUsecsLast <= theEnd) {
         mWaitingAvgBytes = CalcWaitingAvg(mWaitingAvgBytes, mWaitingByteCount);
         mWaitingAvgCount = CalcWaitingAvg(mWaitingAvgCount, mWaitingCount);
@@ -452,4 +614,192 @@ BufferManager::UpdateWaitingAvg()
     }
 }
 
+    void
+BufferManager::UpdateTokens(
+    int64_t inNowUsecs)
+{
+    mBytesBucket.Update(inNowUsecs);
+    mOpsBucket.Update(inNowUsecs);
+    for (Tenants::const_iterator theIt = mTenants.begin();
+            theIt != mTenants.end();
+            ++theIt) {
+        (*theIt)->UpdateTokens(inNowUsecs);
+    }
+}
+
+    bool
+BufferManager::HasIoTokens(
+    const BufferManager::Tenant& inTenant) const
+{
+    return (
+        inTenant.mBytesBucket.HasTokens() &&
+        inTenant.mOpsBucket.HasTokens() &&
+        mBytesBucket.HasTokens() &&
+        mOpsBucket.HasTokens()
+    );
+}
+
+    void
+BufferManager::Charge(
+    BufferManager::Tenant&   inTenant,
+    BufferManager::ByteCount inByteCount,
+    bool                     inForDiskIoFlag)
+{
+    // Start time fair queuing: the system virtual time is the start time of
+    // the last served request.
+    mVirtualTime = max(mVirtualTime, inTenant.mVirtualTime);
+    inTenant.mVirtualTime = mVirtualTime +
+        inByteCount * kVirtualTimeScale / inTenant.mCurWeight;
+    if (! inForDiskIoFlag) {
+        return;
+    }
+    inTenant.mBytesBucket.Consume((double)inByteCount);
+    inTenant.mOpsBucket.Consume(1);
+    mBytesBucket.Consume((double)inByteCount);
+    mOpsBucket.Consume(1);
+}
+
+    BufferManager::Tenant*
+BufferManager::FindTenant(
+    const char* inNamePtr,
+    size_t      inNameLen,
+    bool        inCreateFlag)
+{
+    if (inNameLen <= 0) {
+        return mTenants.front();
+    }
+    for (Tenants::const_iterator theIt = mTenants.begin() + 1;
+            theIt != mTenants.end();
+            ++theIt) {
+        const string& theName = (*theIt)->mName;
+        if (theName.length() == inNameLen &&
+                memcmp(theName.data(), inNamePtr, inNameLen) == 0) {
+            return *theIt;
+        }
+    }
+    if (! inCreateFlag || kMaxTenants <= mTenants.size()) {
+        return 0;
+    }
+    Tenant* const theTenantPtr = new Tenant(string(inNamePtr, inNameLen));
+    mTenants.push_back(theTenantPtr);
+    SetTenantLimits(*theTenantPtr, microseconds());
+    return theTenantPtr;
+}
+
+    void
+BufferManager::SetTenantLimits(
+    BufferManager::Tenant& inTenant,
+    int64_t                inNowUsecs)
+{
+    inTenant.mCurWeight = max(1,
+        inTenant.mWeight < 0 ? mDefaultWeight : inTenant.mWeight);
+    inTenant.mBytesBucket.Set(inTenant.mMaxBytesPerSec < 0 ?
+        mDefaultMaxBytesPerSec : inTenant.mMaxBytesPerSec,
+        mBurstSecs, inNowUsecs);
+    inTenant.mOpsBucket.Set(inTenant.mMaxOpsPerSec < 0 ?
+        mDefaultMaxOpsPerSec : inTenant.mMaxOpsPerSec,
+        mBurstSecs, inNowUsecs);
+}
+
+    void
+BufferManager::SetTenant(
+    BufferManager::Client& inClient,
+    const char*            inNamePtr,
+    size_t                 inNameLen)
+{
+    const Tenant& theCur = GetTenant(inClient);
+    if (theCur.mName.length() == inNameLen &&
+            memcmp(theCur.mName.data(), inNamePtr, inNameLen) == 0) {
+        return;
+    }
+    // Do not move waiting client between the wait queues.
+    if (IsWaiting(inClient)) {
+        return;
+    }
+    Tenant* const theTenantPtr = FindTenant(inNamePtr, inNameLen, true);
+    inClient.mTenantPtr = theTenantPtr == mTenants.front() ? 0 : theTenantPtr;
+}
+
+    void
+BufferManager::SetQosParameters(
+    const Properties& inProperties)
+{
+    const string  thePrefix("chunkServer.bufferManager.qos.");
+    const int64_t theNowUsecs = microseconds();
+    mBurstSecs = max(1e-3, inProperties.getValue(
+        thePrefix + "burstSec", mBurstSecs));
+    mBytesBucket.Set(inProperties.getValue(
+        thePrefix + "maxBytesPerSec", mBytesBucket.GetRate()),
+        mBurstSecs, theNowUsecs);
+    mOpsBucket.Set(inProperties.getValue(
+        thePrefix + "maxOpsPerSec", mOpsBucket.GetRate()),
+        mBurstSecs, theNowUsecs);
+    mDefaultWeight = max(1, inProperties.getValue(
+        thePrefix + "defaultWeight", mDefaultWeight));
+    mDefaultMaxBytesPerSec = inProperties.getValue(
+        thePrefix + "defaultMaxBytesPerSec", mDefaultMaxBytesPerSec);
+    mDefaultMaxOpsPerSec = inProperties.getValue(
+        thePrefix + "defaultMaxOpsPerSec", mDefaultMaxOpsPerSec);
+    // Tenant parameters: chunkServer.bufferManager.qos.tenant.<name>.<param>
+    // where param is one of weight, maxBytesPerSec, maxOpsPerSec
+    const string theTenantPrefix = thePrefix + "tenant.";
+    for (Properties::iterator theIt = inProperties.begin();
+            theIt != inProperties.end();
+            ++theIt) {
+        const string& theKey = theIt->first;
+        if (theKey.compare(0, theTenantPrefix.length(), theTenantPrefix) != 0) {
+            continue;
+        }
+        const size_t thePos = theKey.rfind('.');
+        if (thePos <= theTenantPrefix.length()) {
+            continue;
+        }
+        Tenant* const theTenantPtr = FindTenant(
+            theKey.data() + theTenantPrefix.length(),
+            thePos - theTenantPrefix.length(), true);
+        if (! theTenantPtr) {
+            continue;
+        }
+        const char* const theParamPtr = theKey.c_str() + thePos + 1;
+        const double      theValue    = inProperties.getValue(theKey, -1.);
+        if (strcmp(theParamPtr, "weight") == 0) {
+            theTenantPtr->mWeight = (int)theValue;
+        } else if (strcmp(theParamPtr, "maxBytesPerSec") == 0) {
+            theTenantPtr->mMaxBytesPerSec = theValue;
+        } else if (strcmp(theParamPtr, "maxOpsPerSec") == 0) {
+            theTenantPtr->mMaxOpsPerSec = theValue;
+        }
+    }
+    for (Tenants::const_iterator theIt = mTenants.begin();
+            theIt != mTenants.end();
+            ++theIt) {
+        SetTenantLimits(**theIt, theNowUsecs);
+    }
+}
+
+    void
+BufferManager::ShowTenants(
+    ostream& inStream) const
+{
+    for (Tenants::const_iterator theIt = mTenants.begin();
+            theIt != mTenants.end();
+            ++theIt) {
+        const Tenant&         theTenant = **theIt;
+        const TenantCounters& theCtrs   = theTenant.mCounters;
+        inStream << "Tenant-" <<
+            (theTenant.mName.empty() ? string("default") : theTenant.mName) <<
+            ": weight="      << theTenant.mCurWeight <<
+            ",max-bytes-sec=" << theTenant.mBytesBucket.GetRate() <<
+            ",max-ops-sec="  << theTenant.mOpsBucket.GetRate() <<
+            ",req="          << theCtrs.mRequestCount <<
+            ",req-bytes="    << theCtrs.mRequestByteCount <<
+            ",io="           << theCtrs.mIoRequestCount <<
+            ",io-bytes="     << theCtrs.mIoRequestByteCount <<
+            ",throttled="    << theCtrs.mThrottledCount <<
+            ",wait-usec="    << theCtrs.mRequestWaitUsecs <<
+            ",waiting="      << theTenant.mWaitingCount <<
+        "\r\n";
+    }
+}
+
 } /* namespace KFS */
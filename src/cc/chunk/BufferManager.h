@@ -31,8 +31,17 @@
 #include "qcdio/QCIoBufferPool.h"
 #include "kfsio/ITimeout.h"
 
+#include <string>
+#include <vector>
+#include <ostream>
+
 namespace KFS
 {
+using std::string;
+using std::vector;
+using std::ostream;
+
+class Properties;
 
 // Chunk server disk and network io buffer manager. The intent is "fair" io
 // buffer allocation between clients [connections]. The buffer pool size fixed
@@ -44,11 +53,21 @@ namespace KFS
 // server as feedback chunk server "load" metric in chunk placement. The load
 // metric presently has the most effect for write append chunk placement with
 // large number of append clients in radix sort.
+//
+// Clients can be tagged with tenant (job or user) name. Each tenant has its
+// own wait queue, and optional bandwidth and iops token bucket limits. The
+// tenant limits are nested within optional node wide limits. The limits apply
+// to the disk io requests, and the io buffers stay allocated until the data
+// is written to disk or sent over the network, thus effectively limiting
+// both. The waiting clients are served in weighted fair queuing order by
+// tenant. Without tenant configuration all clients belong to the default
+// tenant, and served in FIFO order.
 class BufferManager : private ITimeout
 {
 public:
     typedef int64_t ByteCount;
     typedef int64_t RequestCount;
+    class Tenant;
     struct Counters
     {
         typedef int64_t Counter;
@@ -72,6 +91,27 @@ public:
             mRequestWaitUsecs        = 0;
         }
     };
+    struct TenantCounters
+    {
+        typedef int64_t Counter;
+
+        Counter mRequestCount;
+        Counter mRequestByteCount;
+        Counter mIoRequestCount;
+        Counter mIoRequestByteCount;
+        Counter mThrottledCount;
+        Counter mRequestWaitUsecs;
+
+        void Clear()
+        {
+            mRequestCount       = 0;
+            mRequestByteCount   = 0;
+            mIoRequestCount     = 0;
+            mIoRequestByteCount = 0;
+            mThrottledCount     = 0;
+            mRequestWaitUsecs   = 0;
+        }
+    };
 
     class Client
     {
@@ -109,9 +149,11 @@ public:
         Client*        mPrevPtr[1];
         Client*        mNextPtr[1];
         BufferManager* mManagerPtr;
+        Tenant*        mTenantPtr;
         ByteCount      mByteCount;
         ByteCount      mWaitingForByteCount;
         int64_t        mWaitStart;
+        bool           mWaitingForDiskIoFlag;
 
         friend class BufferManager;
         friend class QCDLListOp<Client, 0>;
@@ -154,8 +196,7 @@ public:
     bool IsLowOnBuffers() const;
     virtual void Timeout();
     bool IsWaiting(
-        const Client& inClient) const
-        { return WaitQueue::IsInList(mWaitQueuePtr, inClient); }
+        const Client& inClient) const;
     void Unregister(
         Client& inClient);
     void CancelRequest(
@@ -203,15 +244,69 @@ public:
     {
         return ((mWaitingAvgIntervalIdx + 1) * kWaitingAvgSampleIntervalSec);
     }
+    // Assign client to the tenant with the specified name, empty name
+    // assigns to the default tenant. The tenant is created on the first use.
+    void SetTenant(
+        Client&     inClient,
+        const char* inNamePtr,
+        size_t      inNameLen);
+    void SetQosParameters(
+        const Properties& inProperties);
+    // Per tenant usage, one "name: value" line per counter.
+    void ShowTenants(
+        ostream& inStream) const;
 private:
     typedef QCDLList<Client, 0> WaitQueue;
+    typedef vector<Tenant*>     Tenants;
+    class TokenBucket
+    {
+    public:
+        TokenBucket()
+            : mRate(0),
+              mMaxTokens(0),
+              mTokens(0),
+              mLastUsecs(0)
+            {}
+        void Set(
+            double  inRate,
+            double  inBurstSecs,
+            int64_t inNowUsecs);
+        void Update(
+            int64_t inNowUsecs);
+        bool HasTokens() const
+            { return (mRate <= 0 || 0 < mTokens); }
+        void Consume(
+            double inCount)
+        {
+            if (0 < mRate) {
+                mTokens -= inCount;
+            }
+        }
+        double GetRate() const
+            { return mRate; }
+    private:
+        double  mRate;
+        double  mMaxTokens;
+        double  mTokens;
+        int64_t mLastUsecs;
+    };
+    enum { kMaxTenants = 256 };
+    // Virtual time is measured in bytes scaled by weight.
+    enum { kVirtualTimeScale = 1 << 10 };
     // 39 bits integer part -- max 0.5TB bytes waiting
     // 24 bits after 12 bits fractional part multiplication -- should be sufficent
     // for 2 sec resolution.
     enum { kWaitingAvgFracBits = 12 };
     enum { kWaitingAvgSampleIntervalSec = 1 };
 
-    Client*         mWaitQueuePtr[1];
+    Tenants         mTenants;
+    TokenBucket     mBytesBucket;
+    TokenBucket     mOpsBucket;
+    int64_t         mVirtualTime;
+    double          mBurstSecs;
+    int             mDefaultWeight;
+    double          mDefaultMaxBytesPerSec;
+    double          mDefaultMaxOpsPerSec;
     QCIoBufferPool* mBufferPoolPtr;
     ByteCount       mTotalCount;
     ByteCount       mMaxClientQuota;
@@ -242,6 +337,24 @@ private:
     int64_t CalcWaitingAvg(
         int64_t inAvg,
         int64_t inSample) const;
+    Tenant& GetTenant(
+        const Client& inClient) const
+        { return (inClient.mTenantPtr ? *inClient.mTenantPtr : *mTenants[0]); }
+    Tenant* FindTenant(
+        const char* inNamePtr,
+        size_t      inNameLen,
+        bool        inCreateFlag);
+    void SetTenantLimits(
+        Tenant& inTenant,
+        int64_t inNowUsecs);
+    bool HasIoTokens(
+        const Tenant& inTenant) const;
+    void Charge(
+        Tenant&   inTenant,
+        ByteCount inByteCount,
+        bool      inForDiskIoFlag);
+    void UpdateTokens(
+        int64_t inNowUsecs);
 
     BufferManager(
         const BufferManager& inManager);
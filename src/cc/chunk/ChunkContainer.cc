@@ -0,0 +1,820 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file ChunkContainer.cc
+// \brief Chunk directory container file with sparse chunk slots.
+//
+//----------------------------------------------------------------------------
+
+#include "ChunkContainer.h"
+
+#include "common/MsgLogger.h"
+#include "kfsio/checksum.h"
+#include "kfsio/event.h"
+#include "kfsio/KfsCallbackObj.h"
+#include "qcdio/QCUtils.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <stddef.h>
+#include <assert.h>
+
+#include <algorithm>
+
+namespace KFS
+{
+
+using std::min;
+using std::max;
+
+const uint64_t kChunkContainerMagic   = 0x31524e5443534651ULL; // QFSCTNR1
+const uint32_t kChunkContainerVersion = 1;
+
+struct ChunkContainerSuperBlock
+{
+    uint64_t mMagic;
+    uint32_t mVersion;
+    uint32_t mBlockSize;
+    uint64_t mSlotSize;
+    uint64_t mMaxSlots;
+    uint64_t mDataOffset;
+    uint32_t mChecksum;
+
+    uint32_t ComputeChecksum() const
+    {
+        return ComputeBlockChecksum(reinterpret_cast<const char*>(this),
+            offsetof(ChunkContainerSuperBlock, mChecksum));
+    }
+} __attribute__ ((__packed__));
+
+struct ChunkContainerIndexRecord
+{
+    uint64_t mFileId;
+    uint64_t mChunkId;
+    uint64_t mChunkVersion;
+    uint32_t mState;
+    uint32_t mChecksum;
+
+    // Seed checksum with the slot index, in order to detect records written
+    // into wrong position.
+    uint32_t ComputeChecksum(
+        int inSlotIdx) const
+    {
+        return ComputeBlockChecksum((uint32_t)inSlotIdx + 1,
+            reinterpret_cast<const char*>(this),
+            offsetof(ChunkContainerIndexRecord, mChecksum));
+    }
+} __attribute__ ((__packed__));
+
+class ChunkContainer::IndexBlock : public KfsCallbackObj
+{
+public:
+    IndexBlock(
+        ChunkContainer& inContainer,
+        int             inBlockIdx)
+        : KfsCallbackObj(),
+          mContainer(inContainer),
+          mBlockIdx(inBlockIdx),
+          mIoPtr(0),
+          mInFlight(),
+          mQueued()
+        { SET_HANDLER(this, &IndexBlock::Done); }
+    ~IndexBlock()
+        { delete mIoPtr; }
+    bool IsInFlight() const
+        { return (mIoPtr != 0); }
+    bool Start(
+        string* outErrMsgPtr)
+    {
+        IOBuffer buf;
+        mContainer.Serialize(mBlockIdx, &mContainer.mBlockBuf[0]);
+        buf.CopyIn(&mContainer.mBlockBuf[0], mContainer.mBlockSize);
+        mIoPtr = new DiskIo(mContainer.mFilePtr, this);
+        const ssize_t res = mIoPtr->Write(
+            (Offset)(mBlockIdx + 1) * mContainer.mBlockSize,
+            mContainer.mBlockSize, &buf);
+        if (res != mContainer.mBlockSize) {
+            delete mIoPtr;
+            mIoPtr = 0;
+            if (outErrMsgPtr) {
+                *outErrMsgPtr = "failed to schedule index write: " +
+                    QCUtils::SysError(res < 0 ? (int)-res : EIO);
+            }
+            return false;
+        }
+        mContainer.mWritesInFlight++;
+        return true;
+    }
+    int Done(
+        int   inCode,
+        void* inDataPtr)
+    {
+        const bool okFlag = inCode == EVENT_DISK_WROTE && inDataPtr &&
+            *reinterpret_cast<const int*>(inDataPtr) >= mContainer.mBlockSize;
+        if (! okFlag) {
+            KFS_LOG_STREAM_ERROR << mContainer.mFileName <<
+                ": index block: " << mBlockIdx <<
+                " write failure: " << inCode <<
+                " status: " << (inDataPtr ?
+                    *reinterpret_cast<const int*>(inDataPtr) : -1) <<
+            KFS_LOG_EOM;
+        }
+        delete mIoPtr;
+        mIoPtr = 0;
+        mContainer.WriteDone(*this, okFlag);
+        return 0;
+    }
+
+    ChunkContainer& mContainer;
+    const int       mBlockIdx;
+    DiskIo*         mIoPtr;
+    Waiters         mInFlight;
+    Waiters         mQueued;
+private:
+    IndexBlock(
+        const IndexBlock& inBlock);
+    IndexBlock& operator=(
+        const IndexBlock& inBlock);
+};
+
+class ChunkContainer::SpaceRelease : public KfsCallbackObj
+{
+public:
+    SpaceRelease(
+        ChunkContainer& inContainer,
+        int             inSlotIdx)
+        : KfsCallbackObj(),
+          mContainer(inContainer),
+          mSlotIdx(inSlotIdx)
+        { SET_HANDLER(this, &SpaceRelease::Done); }
+    int Done(
+        int   inCode,
+        void* inDataPtr)
+    {
+        const bool okFlag = inCode == EVENT_DISK_PUNCH_HOLE_DONE;
+        const int  sysErr = (okFlag || ! inDataPtr) ? 0 :
+            -*reinterpret_cast<const int*>(inDataPtr);
+        ChunkContainer& container = mContainer;
+        const int       slotIdx   = mSlotIdx;
+        delete this;
+        container.ReleaseSpaceDone(slotIdx, okFlag, sysErr);
+        return 0;
+    }
+private:
+    ChunkContainer& mContainer;
+    const int       mSlotIdx;
+
+    SpaceRelease(
+        const SpaceRelease& inRelease);
+    SpaceRelease& operator=(
+        const SpaceRelease& inRelease);
+};
+
+ChunkContainer::ChunkContainer(
+    const string& inFileName,
+    Offset        inSlotSize,
+    int           inBlockSize)
+    : mFileName(inFileName),
+      mSlotSize(inSlotSize),
+      mBlockSize(inBlockSize),
+      mRecordsPerBlock(inBlockSize / (int)sizeof(ChunkContainerIndexRecord)),
+      mDataOffset(0),
+      mUsedSlotCount(0),
+      mWritesInFlight(0),
+      mReleasesInFlight(0),
+      mCompletionDepth(0),
+      mFd(-1),
+      mPunchHoleFlag(true),
+      mClosedFlag(false),
+      mFilePtr(),
+      mSlots(),
+      mFreeSlots(),
+      mIndexBlocks(),
+      mBlockBuf(inBlockSize)
+{}
+
+ChunkContainer::~ChunkContainer()
+{
+    for (IndexBlocks::iterator it = mIndexBlocks.begin();
+            it != mIndexBlocks.end();
+            ++it) {
+        delete *it;
+    }
+    mFilePtr.reset();
+    if (mFd >= 0) {
+        close(mFd);
+    }
+}
+
+    /* static */ ChunkContainer*
+ChunkContainer::Open(
+    const string& inFileName,
+    Offset        inSlotSize,
+    int64_t       inMaxSlots,
+    int64_t       inAvgChunkSize,
+    bool          inBufferedIoFlag,
+    string*       outErrMsgPtr)
+{
+    const int blockSize = IOBufferData::GetDefaultBufferSize();
+    if (blockSize < (int)sizeof(ChunkContainerSuperBlock) ||
+            inSlotSize <= 0 || inSlotSize % blockSize != 0) {
+        if (outErrMsgPtr) {
+            *outErrMsgPtr = "invalid io buffer or slot size";
+        }
+        return 0;
+    }
+    ChunkContainer* const container = new ChunkContainer(
+        inFileName, inSlotSize, blockSize);
+    if (! container->Load(inMaxSlots, inAvgChunkSize, inBufferedIoFlag,
+            outErrMsgPtr)) {
+        delete container;
+        return 0;
+    }
+    KFS_LOG_STREAM_INFO << inFileName <<
+        ": slots: "    << container->GetMaxSlots() <<
+        " used: "      << container->GetUsedSlotCount() <<
+    KFS_LOG_EOM;
+    return container;
+}
+
+    bool
+ChunkContainer::Create(
+    int64_t inMaxSlots,
+    int64_t inAvgChunkSize,
+    string* outErrMsgPtr)
+{
+    int64_t maxSlots = inMaxSlots;
+    if (maxSlots <= 0) {
+        const size_t   pos = mFileName.rfind('/');
+        const string   dir = pos == string::npos ?
+            string(".") : mFileName.substr(0, pos + 1);
+        struct statvfs stat;
+        if (statvfs(dir.c_str(), &stat)) {
+            const int err = errno;
+            if (outErrMsgPtr) {
+                *outErrMsgPtr = dir + ": " + QCUtils::SysError(err);
+            }
+            return false;
+        }
+        // The slots are sparse, therefore the number of slots is determined
+        // by the average, not the max chunk size.
+        maxSlots = (int64_t)stat.f_blocks * stat.f_frsize /
+            max((int64_t)mBlockSize, inAvgChunkSize);
+        maxSlots = min((int64_t(1) << 31) - 1, maxSlots);
+    }
+    if (maxSlots <= 0 || maxSlots >= (int64_t(1) << 31)) {
+        if (outErrMsgPtr) {
+            *outErrMsgPtr = "invalid number of slots";
+        }
+        return false;
+    }
+    // Write super block into temporary file, then rename it, in order to
+    // ensure that the container with invalid super block never exists.
+    const string tmpName = mFileName + ".tmp";
+    const int    fd      = open(tmpName.c_str(),
+        O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    ChunkContainerSuperBlock& sb =
+        *reinterpret_cast<ChunkContainerSuperBlock*>(&mBlockBuf[0]);
+    int err = 0;
+    if (fd < 0) {
+        err = errno;
+    } else {
+        // Set the file size to the container size, in order to ensure that
+        // all slots can be written. Reduce the number of slots if the size
+        // exceeds the host file system max file size. The file is sparse,
+        // therefore no space is allocated.
+        for (; ;) {
+            const int64_t blocks =
+                (maxSlots + mRecordsPerBlock - 1) / mRecordsPerBlock;
+            memset(&mBlockBuf[0], 0, mBlockSize);
+            sb.mMagic      = kChunkContainerMagic;
+            sb.mVersion    = kChunkContainerVersion;
+            sb.mBlockSize  = (uint32_t)mBlockSize;
+            sb.mSlotSize   = (uint64_t)mSlotSize;
+            sb.mMaxSlots   = (uint64_t)maxSlots;
+            sb.mDataOffset = (uint64_t)(blocks + 1) * mBlockSize;
+            sb.mChecksum   = sb.ComputeChecksum();
+            if (ftruncate(fd, (off_t)(sb.mDataOffset + maxSlots * mSlotSize))
+                    == 0) {
+                break;
+            }
+            err = errno;
+            if ((err != EFBIG && err != EINVAL) || maxSlots <= 1) {
+                break;
+            }
+            err = 0;
+            maxSlots /= 2;
+        }
+        if (err == 0 && (
+                pwrite(fd, &mBlockBuf[0], mBlockSize, 0) != mBlockSize ||
+                fsync(fd))) {
+            err = errno ? errno : EIO;
+        }
+        if (close(fd) && err == 0) {
+            err = errno;
+        }
+        if (err == 0 && rename(tmpName.c_str(), mFileName.c_str())) {
+            err = errno;
+        }
+        if (err != 0) {
+            unlink(tmpName.c_str());
+        }
+    }
+    if (err != 0) {
+        if (outErrMsgPtr) {
+            *outErrMsgPtr = "failed to create " + mFileName + ": " +
+                QCUtils::SysError(err);
+        }
+        return false;
+    }
+    KFS_LOG_STREAM_INFO << mFileName <<
+        ": created slots: " << maxSlots <<
+        " slot size: "      << mSlotSize <<
+        " data offset: "    << sb.mDataOffset <<
+    KFS_LOG_EOM;
+    return true;
+}
+
+    bool
+ChunkContainer::Load(
+    int64_t inMaxSlots,
+    int64_t inAvgChunkSize,
+    bool    inBufferedIoFlag,
+    string* outErrMsgPtr)
+{
+    struct stat st;
+    if (stat(mFileName.c_str(), &st)) {
+        const int err = errno;
+        if (err != ENOENT) {
+            if (outErrMsgPtr) {
+                *outErrMsgPtr = mFileName + ": " + QCUtils::SysError(err);
+            }
+            return false;
+        }
+        if (! Create(inMaxSlots, inAvgChunkSize, outErrMsgPtr)) {
+            return false;
+        }
+    }
+    if ((mFd = open(mFileName.c_str(), O_RDWR)) < 0 ||
+            fstat(mFd, &st)) {
+        const int err = errno;
+        if (outErrMsgPtr) {
+            *outErrMsgPtr = mFileName + ": " + QCUtils::SysError(err);
+        }
+        return false;
+    }
+    const ChunkContainerSuperBlock& sb =
+        *reinterpret_cast<const ChunkContainerSuperBlock*>(&mBlockBuf[0]);
+    const char* errMsg = 0;
+    if (pread(mFd, &mBlockBuf[0], mBlockSize, 0) != mBlockSize) {
+        errMsg = "failed to read super block";
+    } else if (sb.mMagic != kChunkContainerMagic ||
+            sb.mChecksum != sb.ComputeChecksum()) {
+        errMsg = "invalid super block";
+    } else if (sb.mVersion != kChunkContainerVersion) {
+        errMsg = "unsupported version";
+    } else if (sb.mBlockSize != (uint32_t)mBlockSize) {
+        errMsg = "io buffer size mismatch";
+    } else if (sb.mSlotSize != (uint64_t)mSlotSize) {
+        errMsg = "slot size mismatch";
+    } else if (sb.mMaxSlots <= 0 || sb.mMaxSlots >= (uint64_t(1) << 31) ||
+            sb.mDataOffset < (uint64_t)mBlockSize * (1 +
+                (sb.mMaxSlots + mRecordsPerBlock - 1) / mRecordsPerBlock) ||
+            sb.mDataOffset % mBlockSize != 0) {
+        errMsg = "invalid super block parameters";
+    }
+    if (errMsg) {
+        if (outErrMsgPtr) {
+            *outErrMsgPtr = mFileName + ": " + errMsg;
+        }
+        return false;
+    }
+    const int maxSlots = (int)sb.mMaxSlots;
+    mDataOffset = (Offset)sb.mDataOffset;
+    mSlots.resize(maxSlots);
+    const int blocks = (maxSlots + mRecordsPerBlock - 1) / mRecordsPerBlock;
+    mIndexBlocks.resize(blocks, 0);
+    const int    kMaxReadBlocks = 256;
+    vector<char> buf((size_t)min(blocks, kMaxReadBlocks) * mBlockSize);
+    for (int i = 0; i < blocks; ) {
+        const int     cnt = min(blocks - i, kMaxReadBlocks);
+        const ssize_t len = (ssize_t)cnt * mBlockSize;
+        // Sparse never written index blocks read as zeros, and zero filled
+        // records have invalid checksum, i.e. these slots are free.
+        const ssize_t rd  = pread(
+            mFd, &buf[0], len, (off_t)(i + 1) * mBlockSize);
+        if (rd < 0) {
+            const int err = errno;
+            if (outErrMsgPtr) {
+                *outErrMsgPtr = mFileName + ": index read failure: " +
+                    QCUtils::SysError(err);
+            }
+            return false;
+        }
+        if (rd < len) {
+            memset(&buf[0] + rd, 0, len - rd);
+        }
+        for (int k = 0; k < cnt; k++) {
+            const ChunkContainerIndexRecord* const rec =
+                reinterpret_cast<const ChunkContainerIndexRecord*>(
+                    &buf[0] + (size_t)k * mBlockSize);
+            const int start = (i + k) * mRecordsPerBlock;
+            const int end   = min(maxSlots, start + mRecordsPerBlock);
+            for (int idx = start; idx < end; idx++) {
+                const ChunkContainerIndexRecord& r = rec[idx - start];
+                if (r.mState != kSlotStateStable ||
+                        r.mChecksum != r.ComputeChecksum(idx)) {
+                    continue;
+                }
+                Slot& slot = mSlots[idx];
+                slot.mFileId       = (kfsFileId_t)r.mFileId;
+                slot.mChunkId      = (kfsChunkId_t)r.mChunkId;
+                slot.mChunkVersion = (kfsSeq_t)r.mChunkVersion;
+                slot.mState        = kSlotStateStable;
+                mUsedSlotCount++;
+            }
+        }
+        i += cnt;
+    }
+    for (int i = 0; i < maxSlots; i++) {
+        if (mSlots[i].mState != kSlotStateStable) {
+            mFreeSlots.push(i);
+        }
+    }
+    ReleaseFreeSlotsSpace();
+    mFilePtr.reset(new DiskIo::File());
+    string      err;
+    const bool  kReadOnlyFlag         = false;
+    const bool  kReserveFileSpaceFlag = false;
+    const bool  kCreateFlag           = false;
+    if (! mFilePtr->Open(
+            mFileName.c_str(),
+            mDataOffset + (Offset)maxSlots * mSlotSize,
+            kReadOnlyFlag,
+            kReserveFileSpaceFlag,
+            kCreateFlag,
+            &err,
+            0,
+            inBufferedIoFlag)) {
+        if (outErrMsgPtr) {
+            *outErrMsgPtr = mFileName + ": " + err;
+        }
+        mFilePtr.reset();
+        return false;
+    }
+    return true;
+}
+
+    void
+ChunkContainer::Close()
+{
+    mClosedFlag = true;
+    DeleteSelfIfDone();
+}
+
+    void
+ChunkContainer::DeleteSelfIfDone()
+{
+    if (mClosedFlag && mWritesInFlight <= 0 && mReleasesInFlight <= 0 &&
+            mCompletionDepth <= 0) {
+        delete this;
+    }
+}
+
+    void
+ChunkContainer::ReleaseFreeSlotsSpace()
+{
+#ifdef SEEK_DATA
+    // Deallocate space of the slots that were freed, but not deallocated, and
+    // of the slots that were not stable prior to restart. The kept stale
+    // chunks data is retained until the slot is re-used.
+    const int    maxSlots = GetMaxSlots();
+    const Offset end      = GetSlotOffset(maxSlots);
+    Offset       pos      = mDataOffset;
+    int          count    = 0;
+    while (pos < end) {
+        const off_t data = lseek(mFd, (off_t)pos, SEEK_DATA);
+        if (data < 0 || (Offset)data >= end) {
+            break; // No more data, or not supported.
+        }
+        const int idx = (int)(((Offset)data - mDataOffset) / mSlotSize);
+        pos = GetSlotOffset(idx + 1);
+        if (mSlots[idx].mState == kSlotStateStable ||
+                mSlots[idx].mState == kSlotStateStale) {
+            continue;
+        }
+        const int err = QCUtils::ReleaseFileSpace(
+            mFd, GetSlotOffset(idx), mSlotSize);
+        if (err != 0) {
+            KFS_LOG_STREAM(err == EOPNOTSUPP ?
+                    MsgLogger::kLogLevelINFO :
+                    MsgLogger::kLogLevelERROR) << mFileName <<
+                ": failed to release slot: " << idx <<
+                " space: " << QCUtils::SysError(err) <<
+            KFS_LOG_EOM;
+            if (err == EOPNOTSUPP) {
+                mPunchHoleFlag = false;
+                break;
+            }
+            continue;
+        }
+        count++;
+    }
+    if (count > 0) {
+        KFS_LOG_STREAM_INFO << mFileName <<
+            ": released space of slots: " << count <<
+        KFS_LOG_EOM;
+    }
+#endif
+}
+
+    void
+ChunkContainer::ReleaseSlotSpace(
+    int inSlotIdx)
+{
+    // Do not deallocate the kept stale chunk space, the data is retained
+    // until the slot is re-used.
+    if (mPunchHoleFlag && ! mClosedFlag &&
+            mSlots[inSlotIdx].mState != kSlotStateStale) {
+        SpaceRelease* const release = new SpaceRelease(*this, inSlotIdx);
+        string              errMsg;
+        if (DiskIo::PunchHole(
+                mFileName.c_str(),
+                GetSlotOffset(inSlotIdx),
+                mSlotSize,
+                release,
+                &errMsg)) {
+            mReleasesInFlight++;
+            return;
+        }
+        delete release;
+        KFS_LOG_STREAM_ERROR << mFileName <<
+            ": slot: " << inSlotIdx <<
+            " failed to schedule space release: " << errMsg <<
+        KFS_LOG_EOM;
+    }
+    // The slot can be re-used even if its space isn't deallocated, the chunk
+    // data beyond the chunk size is never read.
+    mFreeSlots.push(inSlotIdx);
+    mUsedSlotCount--;
+}
+
+    void
+ChunkContainer::ReleaseSpaceDone(
+    int  inSlotIdx,
+    bool inOkFlag,
+    int  inSysErr)
+{
+    assert(mReleasesInFlight > 0);
+    mReleasesInFlight--;
+    if (! inOkFlag) {
+        KFS_LOG_STREAM(inSysErr == EOPNOTSUPP ?
+                MsgLogger::kLogLevelINFO :
+                MsgLogger::kLogLevelERROR) << mFileName <<
+            ": slot: " << inSlotIdx <<
+            " space release failure: " << QCUtils::SysError(inSysErr) <<
+        KFS_LOG_EOM;
+        if (inSysErr == EOPNOTSUPP) {
+            mPunchHoleFlag = false;
+        }
+    }
+    mFreeSlots.push(inSlotIdx);
+    mUsedSlotCount--;
+    DeleteSelfIfDone();
+}
+
+    int
+ChunkContainer::Allocate(
+    kfsFileId_t  inFileId,
+    kfsChunkId_t inChunkId,
+    string*      outErrMsgPtr)
+{
+    const char* errMsg = 0;
+    if (mClosedFlag) {
+        errMsg = "container closed";
+    } else if (mFreeSlots.empty()) {
+        errMsg = "no free slots";
+    }
+    if (errMsg) {
+        if (outErrMsgPtr) {
+            *outErrMsgPtr = errMsg;
+        }
+        return -1;
+    }
+    const int idx = mFreeSlots.top();
+    mFreeSlots.pop();
+    Slot& slot = mSlots[idx];
+    slot.mFileId       = inFileId;
+    slot.mChunkId      = inChunkId;
+    slot.mChunkVersion = 0;
+    slot.mState        = kSlotStateDirty;
+    mUsedSlotCount++;
+    return idx;
+}
+
+    void
+ChunkContainer::Release(
+    int inSlotIdx)
+{
+    if (inSlotIdx < 0 || GetMaxSlots() <= inSlotIdx ||
+            mSlots[inSlotIdx].mState != kSlotStateDirty) {
+        KFS_LOG_STREAM_ERROR << mFileName <<
+            ": invalid slot release: " << inSlotIdx <<
+        KFS_LOG_EOM;
+        return;
+    }
+    mSlots[inSlotIdx] = Slot();
+    mFreeSlots.push(inSlotIdx);
+    mUsedSlotCount--;
+}
+
+    bool
+ChunkContainer::Update(
+    int             inSlotIdx,
+    SlotState       inState,
+    kfsSeq_t        inChunkVersion,
+    KfsCallbackObj* inCbPtr,
+    int             inDoneCode,
+    string*         outErrMsgPtr)
+{
+    if (inSlotIdx < 0 || GetMaxSlots() <= inSlotIdx ||
+            mSlots[inSlotIdx].mState == kSlotStateFree ||
+            mSlots[inSlotIdx].mState == kSlotStateStale) {
+        if (outErrMsgPtr) {
+            *outErrMsgPtr = "invalid slot";
+        }
+        return false;
+    }
+    Slot& slot = mSlots[inSlotIdx];
+    slot.mState        = inState;
+    slot.mChunkVersion = inChunkVersion;
+    return Schedule(inSlotIdx, Waiter(inCbPtr, inDoneCode), outErrMsgPtr);
+}
+
+    bool
+ChunkContainer::Free(
+    int             inSlotIdx,
+    bool            inKeepFlag,
+    KfsCallbackObj* inCbPtr,
+    int             inDoneCode,
+    string*         outErrMsgPtr)
+{
+    if (inSlotIdx < 0 || GetMaxSlots() <= inSlotIdx ||
+            mSlots[inSlotIdx].mState == kSlotStateFree ||
+            mSlots[inSlotIdx].mState == kSlotStateStale) {
+        if (outErrMsgPtr) {
+            *outErrMsgPtr = "invalid slot";
+        }
+        return false;
+    }
+    Slot& slot = mSlots[inSlotIdx];
+    // Keep ids and version of the stale chunk for diagnostics until the slot
+    // is re-used.
+    slot.mState = inKeepFlag ? kSlotStateStale : kSlotStateFree;
+    return Schedule(inSlotIdx, Waiter(inCbPtr, inDoneCode, inSlotIdx),
+        outErrMsgPtr);
+}
+
+    bool
+ChunkContainer::Schedule(
+    int           inSlotIdx,
+    const Waiter& inWaiter,
+    string*       outErrMsgPtr)
+{
+    if (mClosedFlag) {
+        if (outErrMsgPtr) {
+            *outErrMsgPtr = "container closed";
+        }
+        return false;
+    }
+    IndexBlock*& block = mIndexBlocks[inSlotIdx / mRecordsPerBlock];
+    if (! block) {
+        block = new IndexBlock(*this, inSlotIdx / mRecordsPerBlock);
+    }
+    if (block->IsInFlight()) {
+        // The in memory index is already updated, the next write of this
+        // block will include the update.
+        block->mQueued.push_back(inWaiter);
+        return true;
+    }
+    block->mInFlight.push_back(inWaiter);
+    if (! block->Start(outErrMsgPtr)) {
+        block->mInFlight.pop_back();
+        return false;
+    }
+    return true;
+}
+
+    void
+ChunkContainer::Serialize(
+    int   inBlockIdx,
+    char* inBufPtr) const
+{
+    memset(inBufPtr, 0, mBlockSize);
+    ChunkContainerIndexRecord* rec =
+        reinterpret_cast<ChunkContainerIndexRecord*>(inBufPtr);
+    const int start = inBlockIdx * mRecordsPerBlock;
+    const int end   = min(GetMaxSlots(), start + mRecordsPerBlock);
+    for (int idx = start; idx < end; idx++, rec++) {
+        const Slot& slot = mSlots[idx];
+        rec->mFileId       = (uint64_t)slot.mFileId;
+        rec->mChunkId      = (uint64_t)slot.mChunkId;
+        rec->mChunkVersion = (uint64_t)slot.mChunkVersion;
+        rec->mState        = (uint32_t)slot.mState;
+        rec->mChecksum     = rec->ComputeChecksum(idx);
+    }
+}
+
+    void
+ChunkContainer::WriteDone(
+    ChunkContainer::IndexBlock& inBlock,
+    bool                        inOkFlag)
+{
+    assert(mWritesInFlight > 0);
+    mWritesInFlight--;
+    mCompletionDepth++;
+    Waiters done;
+    done.swap(inBlock.mInFlight);
+    for (Waiters::const_iterator it = done.begin(); it != done.end(); ++it) {
+        if (it->mFreeSlotIdx < 0) {
+            continue;
+        }
+        if (inOkFlag) {
+            ReleaseSlotSpace(it->mFreeSlotIdx);
+        } else {
+            // Do not re-use slot until restart, the on disk state is unknown.
+            KFS_LOG_STREAM_ERROR << mFileName <<
+                ": failed to free slot: " << it->mFreeSlotIdx <<
+            KFS_LOG_EOM;
+        }
+    }
+    Waiters failed;
+    if (! inBlock.mQueued.empty()) {
+        inBlock.mInFlight.swap(inBlock.mQueued);
+        string errMsg("container closed");
+        if (mClosedFlag || ! inBlock.Start(&errMsg)) {
+            KFS_LOG_STREAM_ERROR << mFileName <<
+                ": index block: " << inBlock.mBlockIdx <<
+                " " << errMsg <<
+            KFS_LOG_EOM;
+            failed.swap(inBlock.mInFlight);
+        }
+    }
+    int status = inOkFlag ? 0 : -EIO;
+    for (Waiters::const_iterator it = done.begin(); it != done.end(); ++it) {
+        if (it->mCbPtr) {
+            it->mCbPtr->HandleEvent(
+                inOkFlag ? it->mDoneCode : EVENT_DISK_ERROR, &status);
+        }
+    }
+    for (Waiters::const_iterator it = failed.begin();
+            it != failed.end();
+            ++it) {
+        if (it->mCbPtr) {
+            status = -EIO;
+            it->mCbPtr->HandleEvent(EVENT_DISK_ERROR, &status);
+        }
+    }
+    mCompletionDepth--;
+    DeleteSelfIfDone();
+}
+
+    int
+ChunkContainer::ReadSlotHeader(
+    int    inSlotIdx,
+    char*  inBufPtr,
+    size_t inSize)
+{
+    if (inSlotIdx < 0 || GetMaxSlots() <= inSlotIdx ||
+            (Offset)inSize > mSlotSize || mFd < 0) {
+        return -EINVAL;
+    }
+    const ssize_t rd = pread(mFd, inBufPtr, inSize,
+        (off_t)GetSlotOffset(inSlotIdx));
+    return (rd < 0 ? -errno : (int)rd);
+}
+
+}
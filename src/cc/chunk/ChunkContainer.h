@@ -0,0 +1,255 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file ChunkContainer.h
+// \brief Chunk directory container file with sparse chunk slots.
+//
+//----------------------------------------------------------------------------
+
+#ifndef CHUNK_CONTAINER_H
+#define CHUNK_CONTAINER_H
+
+#include "DiskIo.h"
+#include "common/kfstypes.h"
+
+#include <string>
+#include <vector>
+#include <queue>
+#include <functional>
+
+namespace KFS
+{
+
+using std::string;
+using std::vector;
+using std::priority_queue;
+using std::greater;
+
+class KfsCallbackObj;
+
+// Optional chunk directory storage layout. Instead of one file per chunk, the
+// chunks are stored in slots of a single per chunk directory container file.
+// Each slot has exactly the same layout as the chunk file: chunk header
+// followed by the chunk data.
+// The container file is sparse: slot is only a range of the file offsets with
+// the max chunk size, the host file system allocates space as the chunk data
+// is written, therefore chunk uses the same space as it would use in its own
+// file. The slot space is deallocated ("punched") when the slot is freed.
+// The number of slots is derived from the host file system size and the
+// expected average chunk size. If the container runs out of slots, the chunks
+// are stored in chunk files.
+// The slot index, which is kept at the beginning of the container file, has
+// one small record per slot with the chunk file id, chunk id, version, and
+// slot state. The index serves the same purpose as the chunk file name: the
+// version change and the transition into the stable state are index record
+// updates instead of chunk file renames, and the chunk delete is an index
+// record update instead of unlink.
+// The index records are packed into io blocks. The index block is always
+// written as a whole from the in memory copy of the index, therefore the
+// index block updates are serialized: at most one write per block is in
+// flight, the updates that arrive while the write is in flight are batched
+// into the next write.
+// On restart "free", "stale", and "dirty" (not stable) slots are all
+// considered available, and their space is deallocated. Slot is returned into
+// the free list only after the "free" or "stale" record write and the slot
+// space deallocation complete, therefore a slot in the free list never has a
+// "stable" record on disk.
+//
+// File layout:
+// [0, block size)                  -- super block
+// [block size, data offset)        -- index
+// [data offset, + slot size * max slots) -- slots
+class ChunkContainer
+{
+public:
+    typedef DiskIo::Offset Offset;
+    enum SlotState
+    {
+        kSlotStateFree   = 0,
+        kSlotStateDirty  = 1,
+        kSlotStateStable = 2,
+        kSlotStateStale  = 3
+    };
+    struct Slot
+    {
+        Slot()
+            : mFileId(-1),
+              mChunkId(-1),
+              mChunkVersion(-1),
+              mState(kSlotStateFree)
+            {}
+        kfsFileId_t  mFileId;
+        kfsChunkId_t mChunkId;
+        kfsSeq_t     mChunkVersion;
+        SlotState    mState;
+    };
+
+    // Open existing or create new container file. The file is opened with
+    // the disk queue the file name maps to, therefore the disk queue must be
+    // started prior to the open. Index is loaded synchronously.
+    // If inMaxSlots <= 0 the max number of slots in the new container is
+    // derived from the host file system size divided by inAvgChunkSize. The
+    // number of slots is reduced if the host file system max file size is
+    // less than the container size.
+    static ChunkContainer* Open(
+        const string& inFileName,
+        Offset        inSlotSize,
+        int64_t       inMaxSlots,
+        int64_t       inAvgChunkSize,
+        bool          inBufferedIoFlag,
+        string*       outErrMsgPtr);
+    // Detach container from the chunk directory. The object deletes itself
+    // once all index writes in flight are complete.
+    void Close();
+    int GetMaxSlots() const
+        { return (int)mSlots.size(); }
+    int GetUsedSlotCount() const
+        { return mUsedSlotCount; }
+    const Slot& GetSlot(
+        int inSlotIdx) const
+        { return mSlots[inSlotIdx]; }
+    Offset GetSlotOffset(
+        int inSlotIdx) const
+        { return (mDataOffset + inSlotIdx * mSlotSize); }
+    Offset GetSlotSize() const
+        { return mSlotSize; }
+    const string& GetFileName() const
+        { return mFileName; }
+    const DiskIo::FilePtr& GetFilePtr() const
+        { return mFilePtr; }
+    // Allocate "dirty" slot, no index write is issued: the on disk record
+    // of the free slot is never "stable". Returns slot index or -1 if
+    // container has no free slots.
+    int Allocate(
+        kfsFileId_t  inFileId,
+        kfsChunkId_t inChunkId,
+        string*      outErrMsgPtr);
+    // Return slot allocated with Allocate(), and with no index updates
+    // issued back into the free list.
+    void Release(
+        int inSlotIdx);
+    // Update slot index record. Invokes inCbPtr with inDoneCode on success,
+    // or with EVENT_DISK_ERROR on failure.
+    bool Update(
+        int             inSlotIdx,
+        SlotState       inState,
+        kfsSeq_t        inChunkVersion,
+        KfsCallbackObj* inCbPtr,
+        int             inDoneCode,
+        string*         outErrMsgPtr);
+    // Mark slot as free or stale, and return it into the free list once index
+    // write and slot space deallocation complete. The completion is invoked
+    // when the index write completes.
+    bool Free(
+        int             inSlotIdx,
+        bool            inKeepFlag,
+        KfsCallbackObj* inCbPtr,
+        int             inDoneCode,
+        string*         outErrMsgPtr);
+    // Synchronously read the beginning of the slot: chunk header. Intended
+    // to be used only at startup.
+    int ReadSlotHeader(
+        int    inSlotIdx,
+        char*  inBufPtr,
+        size_t inSize);
+private:
+    struct Waiter
+    {
+        Waiter(
+            KfsCallbackObj* inCbPtr       = 0,
+            int             inDoneCode    = 0,
+            int             inFreeSlotIdx = -1)
+            : mCbPtr(inCbPtr),
+              mDoneCode(inDoneCode),
+              mFreeSlotIdx(inFreeSlotIdx)
+            {}
+        KfsCallbackObj* mCbPtr;
+        int             mDoneCode;
+        int             mFreeSlotIdx;
+    };
+    typedef vector<Waiter> Waiters;
+    class IndexBlock;
+    class SpaceRelease;
+    typedef vector<IndexBlock*> IndexBlocks;
+    typedef priority_queue<int, vector<int>, greater<int> > FreeSlots;
+
+    const string    mFileName;
+    const Offset    mSlotSize;
+    const int       mBlockSize;
+    const int       mRecordsPerBlock;
+    Offset          mDataOffset;
+    int             mUsedSlotCount;
+    int             mWritesInFlight;
+    int             mReleasesInFlight;
+    int             mCompletionDepth;
+    int             mFd;
+    bool            mPunchHoleFlag;
+    bool            mClosedFlag;
+    DiskIo::FilePtr mFilePtr;
+    vector<Slot>    mSlots;
+    FreeSlots       mFreeSlots;
+    IndexBlocks     mIndexBlocks;
+    vector<char>    mBlockBuf;
+
+    ChunkContainer(
+        const string& inFileName,
+        Offset        inSlotSize,
+        int           inBlockSize);
+    ~ChunkContainer();
+    bool Load(
+        int64_t inMaxSlots,
+        int64_t inAvgChunkSize,
+        bool    inBufferedIoFlag,
+        string* outErrMsgPtr);
+    bool Create(
+        int64_t inMaxSlots,
+        int64_t inAvgChunkSize,
+        string* outErrMsgPtr);
+    void ReleaseFreeSlotsSpace();
+    void ReleaseSlotSpace(
+        int inSlotIdx);
+    void ReleaseSpaceDone(
+        int  inSlotIdx,
+        bool inOkFlag,
+        int  inSysErr);
+    bool Schedule(
+        int           inSlotIdx,
+        const Waiter& inWaiter,
+        string*       outErrMsgPtr);
+    void Serialize(
+        int   inBlockIdx,
+        char* inBufPtr) const;
+    void WriteDone(
+        IndexBlock& inBlock,
+        bool        inOkFlag);
+    void DeleteSelfIfDone();
+    friend class IndexBlock;
+    friend class SpaceRelease;
+private:
+    ChunkContainer(
+        const ChunkContainer& inContainer);
+    ChunkContainer& operator=(
+        const ChunkContainer& inContainer);
+};
+
+}
+
+#endif /* CHUNK_CONTAINER_H */
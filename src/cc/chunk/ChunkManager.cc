@@ -42,6 +42,7 @@
 #include "utils.h"
 #include "Logger.h"
 #include "DiskIo.h"
+#include "ChunkContainer.h"
 #include "Replicator.h"
 
 #include "kfsio/Counter.h"
@@ -58,6 +59,7 @@
 namespace KFS
 {
 using std::ofstream;
+using std::ifstream;
 using std::ostringstream;
 using std::min;
 using std::max;
@@ -97,6 +99,7 @@ struct ChunkManager::ChunkDirInfo
           evacuateInFlightCount(0),
           rescheduleEvacuateThreshold(0),
           diskQueue(0),
+          container(0),
           deviceId(-1),
           dirLock(),
           countFsSpaceAvailableFlag(true),
@@ -104,6 +107,7 @@ struct ChunkManager::ChunkDirInfo
           checkDirReadableFlightFlag(false),
           checkEvacuateFileInFlightFlag(false),
           evacuateChunksOpInFlightFlag(false),
+          staleDeleteInFlightFlag(false),
           evacuateFlag(false),
           evacuateStartedFlag(false),
           evacuateDoneFlag(false),
@@ -111,11 +115,22 @@ struct ChunkManager::ChunkDirInfo
           placementSkipFlag(false),
           lastEvacuationActivityTime(
             globalNetManager().Now() - 365 * 24 * 60 * 60),
+          staleDeletes(),
+          staleDeleteCredits(0),
           fsSpaceAvailCb(),
           checkDirReadableCb(),
           checkEvacuateFileCb(),
           evacuateChunksCb(),
-          evacuateChunksOp(0, &evacuateChunksCb)
+          staleDeleteCb(),
+          evacuateChunksOp(0, &evacuateChunksCb),
+          scrubChunkIds(),
+          scrubIdx(0),
+          scrubChunkId(-1),
+          scrubPassCount(0),
+          scrubDebtBytes(0),
+          scrubTime(0),
+          scrubInFlightFlag(false),
+          scrubCb()
     {
         fsSpaceAvailCb.SetHandler(this,
             &ChunkDirInfo::FsSpaceAvailDone);
@@ -127,6 +142,10 @@ struct ChunkManager::ChunkDirInfo
             &ChunkDirInfo::EvacuateChunksDone);
         renameEvacuateFileCb.SetHandler(this,
             &ChunkDirInfo::RenameEvacuateFileDone);
+        staleDeleteCb.SetHandler(this,
+            &ChunkDirInfo::StaleChunksDeleteDone);
+        scrubCb.SetHandler(this,
+            &ChunkDirInfo::ScrubDone);
         for (int i = 0; i < kChunkDirListCount; i++) {
             ChunkList::Init(chunkLists[i]);
             ChunkDirList::Init(chunkLists[i]);
@@ -136,8 +155,15 @@ struct ChunkManager::ChunkDirInfo
     int CheckDirReadableDone(int code, void* data);
     int CheckEvacuateFileDone(int code, void* data);
     int RenameEvacuateFileDone(int code, void* data);
+    int StaleChunksDeleteDone(int code, void* data);
     void DiskError(int sysErr);
     int EvacuateChunksDone(int code, void* data);
+    int ScrubDone(int code, void* data)
+    {
+        gChunkManager.ScrubDone(*this,
+            reinterpret_cast<GetChunkMetadataOp*>(data));
+        return 0;
+    }
     void ScheduleEvacuate(int maxChunkCount = -1);
     void RestartEvacuation();
     void UpdateLastEvacuationActivityTime()
@@ -163,6 +189,13 @@ struct ChunkManager::ChunkDirInfo
             die("chunk dir stop: invalid chunk count");
             chunkCount = 0;
         }
+        if (container) {
+            container->Close();
+            container = 0;
+        }
+        // The stale chunk files that are not deleted yet will be cleaned up
+        // when the directory is back in use.
+        staleDeletes.clear();
         if (diskQueue) {
             string err;
             if (! DiskIo::StopIoQueue(
@@ -183,6 +216,10 @@ struct ChunkManager::ChunkDirInfo
         totalSpace                  = 0;
         evacuateStartChunkCount     = -1;
         evacuateStartByteCount      = -1;
+        // Keep scrub position, in order to resume from the same chunk if
+        // the directory is back in use.
+        scrubChunkIds.clear();
+        scrubIdx                    = 0;
     }
     void SetEvacuateStarted()
     {
@@ -214,6 +251,7 @@ struct ChunkManager::ChunkDirInfo
     int                   evacuateInFlightCount;
     int                   rescheduleEvacuateThreshold;
     DiskQueue*            diskQueue;
+    ChunkContainer*       container;
     DirChecker::DeviceId  deviceId;
     DirChecker::LockFdPtr dirLock;
     bool                  countFsSpaceAvailableFlag:1;
@@ -221,18 +259,49 @@ struct ChunkManager::ChunkDirInfo
     bool                  checkDirReadableFlightFlag:1;
     bool                  checkEvacuateFileInFlightFlag:1;
     bool                  evacuateChunksOpInFlightFlag:1;
+    bool                  staleDeleteInFlightFlag:1;
     bool                  evacuateFlag:1;
     bool                  evacuateStartedFlag:1;
     bool                  evacuateDoneFlag:1;
     bool                  evacuateFileRenameInFlightFlag:1;
     bool                  placementSkipFlag:1;
     time_t                lastEvacuationActivityTime;
+    // Stale chunk file deletes queued for the next batch.
+    struct StaleDelete
+    {
+        StaleDelete(
+            kfsChunkId_t  id,
+            kfsSeq_t      vers,
+            const string& name)
+            : chunkId(id),
+              chunkVersion(vers),
+              fileName(name)
+            {}
+        kfsChunkId_t chunkId;
+        kfsSeq_t     chunkVersion;
+        string       fileName;
+    };
+    typedef vector<StaleDelete> StaleDeletes;
+    StaleDeletes          staleDeletes;
+    int                   staleDeleteCredits;
     KfsCallbackObj        fsSpaceAvailCb;
     KfsCallbackObj        checkDirReadableCb;
     KfsCallbackObj        checkEvacuateFileCb;
     KfsCallbackObj        evacuateChunksCb;
     KfsCallbackObj        renameEvacuateFileCb;
+    KfsCallbackObj        staleDeleteCb;
     EvacuateChunksOp      evacuateChunksOp;
+    // Chunk ids to scrub sorted in ascending order, the ids are looked up in
+    // the chunk table before scrubbing as the list isn't updated when
+    // chunks are added or removed.
+    vector<kfsChunkId_t>  scrubChunkIds;
+    size_t                scrubIdx;
+    kfsChunkId_t          scrubChunkId; // Last scrubbed chunk.
+    int64_t               scrubPassCount;
+    int64_t               scrubDebtBytes;
+    time_t                scrubTime;
+    bool                  scrubInFlightFlag;
+    KfsCallbackObj        scrubCb;
 
     enum { kChunkInfoHDirListCount = kChunkInfoHandleListCount + 1 };
     enum ChunkListType
@@ -365,6 +434,7 @@ public:
           dataFH(),
           lastIOTime(0),
           readChunkMetaOp(0),
+          containerSlot(-1),
           isBeingReplicated(false),
           mDeleteFlag(false),
           mWriteAppenderOwnsFlag(false),
@@ -446,6 +516,9 @@ public:
     time_t           lastIOTime;
     /// keep track of the op that is doing the read
     ReadChunkMetaOp* readChunkMetaOp;
+    /// chunk directory container slot, or -1 if chunk is stored in its own
+    /// file
+    int              containerSlot;
 
     void Release(ChunkLists* chunkInfoLists);
 
@@ -597,6 +670,9 @@ public:
         DetachFromChunkDir(evacuateFlag);
     }
     const string& GetDirname() const       { return mChunkDir.dirname; }
+    ChunkContainer* GetContainer() const {
+        return (containerSlot >= 0 ? mChunkDir.container : 0);
+    }
     const ChunkDirInfo& GetDirInfo() const { return mChunkDir; }
     ChunkDirInfo& GetDirInfo()             { return mChunkDir; }
 
@@ -778,7 +854,30 @@ WriteChunkMetaOp::Start(ChunkInfoHandle* cih)
             cih->HandleEvent(EVENT_DISK_RENAME_DONE, &res);
             return 0;
         }
-        if (! DiskIo::Rename(
+        if (cih->containerSlot >= 0) {
+            // Chunk is in container: update the slot index record instead
+            // of rename.
+            ChunkContainer* const container = cih->GetContainer();
+            if (! container) {
+                statusMsg = "no container";
+                status    = -EBADF;
+            } else if (! container->Update(
+                    cih->containerSlot,
+                    stableFlag ?
+                        ChunkContainer::kSlotStateStable :
+                        ChunkContainer::kSlotStateDirty,
+                    stableFlag ? targetVersion : kfsSeq_t(0),
+                    cih,
+                    EVENT_DISK_RENAME_DONE,
+                    &statusMsg)) {
+                status = -EAGAIN;
+            }
+            if (status < 0) {
+                KFS_LOG_STREAM_ERROR <<
+                    Show() << " failed: " << statusMsg <<
+                KFS_LOG_EOM;
+            }
+        } else if (! DiskIo::Rename(
                 gChunkManager.MakeChunkPathname(cih).c_str(),
                 gChunkManager.MakeChunkPathname(
                     cih, stableFlag, targetVersion).c_str(),
@@ -1041,6 +1140,10 @@ ChunkManager::ChunkManager()
       mStaleChunkCompletion(*this),
       mStaleChunkOpsInFlight(0),
       mMaxStaleChunkOpsInFlight(4),
+      mStaleChunkDeleteBatchesInFlight(0),
+      mStaleChunkDeleteBatchSize(64),
+      mMaxStaleChunkDeletesPerSec(256),
+      mStaleChunkDeleteCreditsTime(0),
       mMaxDirCheckDiskTimeouts(4),
       mChunkPlacementPendingReadWeight(0),
       mChunkPlacementPendingWriteWeight(0),
@@ -1061,6 +1164,17 @@ ChunkManager::ChunkManager()
       mMetaHeartbeatTime(globalNetManager().Now() - 365 * 24 * 60 * 60),
       mMetaEvacuateCount(-1),
       mMaxEvacuateIoErrors(2),
+      mChunkContainerFlag(false),
+      mChunkContainerFileName("chunks.container"),
+      mChunkContainerMaxSlots(0),
+      mChunkContainerAvgChunkSize(8 << 20),
+      mScrubberBytesPerSec(0),
+      mScrubberMaxPendingIoRequests(2),
+      mScrubberBackoffSec(5),
+      mScrubberStateFileName("scrubber.state"),
+      mScrubberStateSaveIntervalSec(300),
+      mScrubberStateSaveTime(globalNetManager().Now()),
+      mScrubberStateLoadedFlag(false),
       mChunkHeaderBuffer(reinterpret_cast<char*>(&mChunkHeaderBufferAlloc))
 {
     mDirChecker.SetInterval(180);
@@ -1080,12 +1194,17 @@ ChunkManager::~ChunkManager()
 void
 ChunkManager::Shutdown()
 {
+    if (mScrubberStateLoadedFlag) {
+        SaveScrubberState();
+    }
     mDirChecker.Stop();
     // Run delete queue before removing chunk table entries.
+    mMaxStaleChunkDeletesPerSec = 0; // No delete rate limit on shutdown.
     RunStaleChunksQueue();
     for (int i = 0; ;) {
         const bool completionFlag = DiskIo::RunIoCompletion();
-        if (mStaleChunkOpsInFlight <= 0) {
+        if (mStaleChunkOpsInFlight <= 0 &&
+                mStaleChunkDeleteBatchesInFlight <= 0) {
             break;
         }
         if (completionFlag) {
@@ -1154,6 +1273,13 @@ ChunkManager::Shutdown()
         usleep(10000);
     }
     globalNetManager().UnRegisterTimeoutHandler(this);
+    for (ChunkDirs::iterator it = mChunkDirs.begin();
+            it < mChunkDirs.end(); ++it) {
+        if (it->container) {
+            it->container->Close();
+            it->container = 0;
+        }
+    }
     string errMsg;
     if (! DiskIo::Shutdown(&errMsg)) {
         KFS_LOG_STREAM_INFO <<
@@ -1205,6 +1331,12 @@ ChunkManager::SetParameters(const Properties& prop)
     mMaxStaleChunkOpsInFlight = prop.getValue(
         "chunkServer.maxStaleChunkOpsInFlight",
         mMaxStaleChunkOpsInFlight);
+    mStaleChunkDeleteBatchSize = max(1, prop.getValue(
+        "chunkServer.staleChunkDeleteBatchSize",
+        mStaleChunkDeleteBatchSize));
+    mMaxStaleChunkDeletesPerSec = prop.getValue(
+        "chunkServer.maxStaleChunkDeletesPerSec",
+        mMaxStaleChunkDeletesPerSec);
     mMaxDirCheckDiskTimeouts = prop.getValue(
         "chunkServer.maxDirCheckDiskTimeouts",
         mMaxDirCheckDiskTimeouts);
@@ -1282,6 +1414,21 @@ ChunkManager::SetParameters(const Properties& prop)
         "chunkServer.maxEvacuateIoErrors",
         mMaxEvacuateIoErrors
     ));
+    mScrubberBytesPerSec = prop.getValue(
+        "chunkServer.scrubber.bytesPerSec",
+        mScrubberBytesPerSec);
+    mScrubberMaxPendingIoRequests = prop.getValue(
+        "chunkServer.scrubber.maxPendingIoRequests",
+        mScrubberMaxPendingIoRequests);
+    mScrubberBackoffSec = max(1, prop.getValue(
+        "chunkServer.scrubber.backoffSec",
+        mScrubberBackoffSec));
+    mScrubberStateFileName = prop.getValue(
+        "chunkServer.scrubber.stateFileName",
+        mScrubberStateFileName);
+    mScrubberStateSaveIntervalSec = max(1, prop.getValue(
+        "chunkServer.scrubber.stateSaveIntervalSec",
+        mScrubberStateSaveIntervalSec));
 
     DirChecker::FileNames excludes;
     excludes.insert(mEvacuateDoneFileName);
@@ -1329,6 +1476,25 @@ ChunkManager::Init(const vector<string>& chunkDirs, const Properties& prop)
     mChunkDirLockName = prop.getValue(
         "chunkServer.dirLockFileName",
         mChunkDirLockName);
+    mChunkContainerFlag = prop.getValue(
+        "chunkServer.chunkContainer.enable",
+        mChunkContainerFlag ? 1 : 0) != 0;
+    mChunkContainerFileName = prop.getValue(
+        "chunkServer.chunkContainer.fileName",
+        mChunkContainerFileName);
+    mChunkContainerMaxSlots = prop.getValue(
+        "chunkServer.chunkContainer.maxSlots",
+        mChunkContainerMaxSlots);
+    mChunkContainerAvgChunkSize = max(int64_t(1) << 20, prop.getValue(
+        "chunkServer.chunkContainer.avgChunkSize",
+        mChunkContainerAvgChunkSize));
+    if (mChunkContainerFlag && (mChunkContainerFileName.empty() ||
+            mChunkContainerFileName.find('/') != string::npos)) {
+        KFS_LOG_STREAM_ERROR <<
+            "invalid chunk container file name: " << mChunkContainerFileName <<
+        KFS_LOG_EOM;
+        return false;
+    }
     if (mStaleChunksDir.empty()) {
         KFS_LOG_STREAM_ERROR <<
             "invalid stale chunks dir name: " << mStaleChunksDir <<
@@ -1473,6 +1639,18 @@ ChunkManager::AllocChunk(
         cih->Delete(mChunkInfoLists);
         return -EFAULT;
     }
+    if (chunkdir->container) {
+        string errMsg;
+        cih->containerSlot = chunkdir->container->Allocate(
+            fileId, chunkId, &errMsg);
+        if (cih->containerSlot < 0) {
+            // Fall back to chunk file.
+            KFS_LOG_STREAM_ERROR << chunkdir->dirname <<
+                " chunk: " << chunkId <<
+                " container slot allocation failure: " << errMsg <<
+            KFS_LOG_EOM;
+        }
+    }
     KFS_LOG_STREAM_INFO << "Creating chunk: " << MakeChunkPathname(cih) <<
     KFS_LOG_EOM;
     int ret = OpenChunk(cih, O_RDWR | O_CREAT);
@@ -2408,6 +2586,85 @@ ChunkManager::AddMapping(ChunkManager::ChunkDirInfo& dir, const char* filename,
     AddMapping(cih);
 }
 
+void
+ChunkManager::AddContainerMappings(ChunkManager::ChunkDirInfo& dir)
+{
+    ChunkContainer& container = *dir.container;
+    const int       maxSlots  = container.GetMaxSlots();
+    for (int i = 0; i < maxSlots; i++) {
+        const ChunkContainer::Slot& slot = container.GetSlot(i);
+        if (slot.mState != ChunkContainer::kSlotStateStable) {
+            continue;
+        }
+        // Load chunk header to get the chunk size. The chunk size isn't
+        // stored in the slot index, as it changes with every write.
+        const int rd = container.ReadSlotHeader(
+            i, mChunkHeaderBuffer, kChunkHeaderBufferSize);
+        const DiskChunkInfo_t& dci      =
+            *reinterpret_cast<const DiskChunkInfo_t*>(mChunkHeaderBuffer);
+        const uint64_t         checksum =
+            *reinterpret_cast<const uint64_t*>(&dci + 1);
+        int res = rd == kChunkHeaderBufferSize ?
+            dci.Validate(slot.mChunkId, slot.mChunkVersion) :
+            (rd < 0 ? rd : -EINVAL);
+        if (res == 0 && (checksum != 0 || mRequireChunkHeaderChecksumFlag) &&
+                ComputeBlockChecksum(mChunkHeaderBuffer, sizeof(dci)) !=
+                    checksum) {
+            res = -EBADCKSUM;
+        }
+        ChunkInfoHandle* cih = 0;
+        if (res == 0 && GetChunkInfoHandle(slot.mChunkId, &cih) == 0) {
+            res = -EEXIST;
+        }
+        if (res != 0) {
+            KFS_LOG_STREAM_INFO <<
+                "ignoring chunk: "  << slot.mChunkId <<
+                " version: "        << slot.mChunkVersion <<
+                " slot: "           << i <<
+                " in: "             << container.GetFileName() <<
+                " status: "         << res <<
+                (res == -EEXIST ? " duplicate, keeping: " : "") <<
+                (cih ? MakeChunkPathname(cih) : string()) <<
+            KFS_LOG_EOM;
+            const bool kKeepFlag = true;
+            container.Free(i, kKeepFlag, 0, 0, 0);
+            continue;
+        }
+        cih = new ChunkInfoHandle(dir);
+        cih->containerSlot          = i;
+        cih->chunkInfo.fileId       = slot.mFileId;
+        cih->chunkInfo.chunkId      = slot.mChunkId;
+        cih->chunkInfo.chunkVersion = slot.mChunkVersion;
+        cih->chunkInfo.chunkSize    = dci.chunkSize;
+        AddMapping(cih);
+    }
+}
+
+bool
+ChunkManager::OpenChunkContainer(ChunkManager::ChunkDirInfo& dir)
+{
+    if (! mChunkContainerFlag || dir.container) {
+        return true;
+    }
+    string errMsg;
+    dir.container = ChunkContainer::Open(
+        dir.dirname + mChunkContainerFileName,
+        (ChunkContainer::Offset)(CHUNKSIZE + KFS_CHUNK_HEADER_SIZE),
+        mChunkContainerMaxSlots,
+        mChunkContainerAvgChunkSize,
+        mBufferedIoFlag,
+        &errMsg
+    );
+    if (! dir.container) {
+        KFS_LOG_STREAM_ERROR <<
+            "chunk directory: " << dir.dirname <<
+            " failed to open chunk container: " << errMsg <<
+        KFS_LOG_EOM;
+        return false;
+    }
+    return true;
+}
+
 int
 ChunkManager::OpenChunk(kfsChunkId_t chunkId, int openFlags)
 {
@@ -2432,19 +2689,31 @@ ChunkManager::OpenChunk(ChunkInfoHandle* cih, int openFlags)
     const bool kReserveFileSpace = true;
     const string fn = MakeChunkPathname(cih);
     bool tempFailureFlag = false;
+    ChunkContainer* const container = cih->GetContainer();
     // Set reservation size larger than max chunk size in order to detect files
     // that weren't properly closed. + 1 here will make file one io block bigger
     // QCDiskQueue::OpenFile() makes EOF block size aligned.
-    if (! cih->dataFH->Open(
-            fn.c_str(),
-            CHUNKSIZE + KFS_CHUNK_HEADER_SIZE + 1,
-            (openFlags & (O_WRONLY | O_RDWR)) == 0,
-            kReserveFileSpace,
-            (openFlags & O_CREAT) != 0,
-            &errMsg,
-            &tempFailureFlag,
-            mBufferedIoFlag)) {
+    if (cih->containerSlot >= 0 ? (! container ||
+            ! cih->dataFH->OpenExtent(
+                container->GetFilePtr(),
+                container->GetSlotOffset(cih->containerSlot),
+                container->GetSlotSize(),
+                (openFlags & (O_WRONLY | O_RDWR)) == 0,
+                &errMsg)) :
+            ! cih->dataFH->Open(
+                fn.c_str(),
+                CHUNKSIZE + KFS_CHUNK_HEADER_SIZE + 1,
+                (openFlags & (O_WRONLY | O_RDWR)) == 0,
+                kReserveFileSpace,
+                (openFlags & O_CREAT) != 0,
+                &errMsg,
+                &tempFailureFlag,
+                mBufferedIoFlag)) {
         mCounters.mOpenErrorCount++;
+        if (container && (openFlags & O_CREAT) != 0) {
+            container->Release(cih->containerSlot);
+            cih->containerSlot = -1;
+        }
         if ((openFlags & O_CREAT) != 0 || ! tempFailureFlag) {
             //
             // we are unable to open/create a file. notify the metaserver
@@ -2924,9 +3193,11 @@ ChunkManager::ReadChunkDone(ReadOp *op)
     KFS_LOG_STREAM_ERROR << str << KFS_LOG_EOM;
     if (retry) {
         op->dataBuf->Clear();
+        op->status = 0;
         if (ReadChunk(op) == 0) {
             return false;
         }
+        op->status = -EBADCKSUM;
     }
     if (mAbortOnChecksumMismatchFlag) {
         die(str);
@@ -3318,6 +3589,11 @@ ChunkManager::Restore()
             if (dent->d_name == mChunkDirLockName) {
                 continue;
             }
+            if (it->container &&
+                    dent->d_name == it->container->GetFileName().substr(
+                        dir.length())) {
+                continue;
+            }
             string const name(dir + dent->d_name);
             struct stat buf;
             if (stat(name.c_str(), &buf)) {
@@ -3331,6 +3607,9 @@ ChunkManager::Restore()
             }
         }
         closedir(dirStream);
+        if (it->container) {
+            AddContainerMappings(*it);
+        }
     }
     if (scheduleEvacuateFlag) {
         UpdateCountFsSpaceAvailableFlags();
@@ -3534,27 +3813,50 @@ ChunkManager::RunStaleChunksQueue(bool completionFlag)
         // stable version. If not then unstable chunk will be cleaned up on the
         // next restart.
         ChunkInfoHandle** const ci = mChunkTable.Find(cih->chunkInfo.chunkId);
-        if (! ci ||
+        // Container slot is never shared, therefore it always has to be freed.
+        ChunkContainer* const container = cih->GetContainer();
+        if (container) {
+            string err;
+            const bool ok = container->Free(
+                cih->containerSlot,
+                cih->IsKeep(),
+                &mStaleChunkCompletion,
+                EVENT_DISK_DELETE_DONE,
+                &err
+            );
+            if (ok) {
+                mStaleChunkOpsInFlight++;
+            }
+            KFS_LOG_STREAM(ok ?
+                    MsgLogger::kLogLevelINFO :
+                    MsgLogger::kLogLevelERROR) <<
+                (cih->IsKeep() ? "marking stale" : "freeing") <<
+                " chunk: " << cih->chunkInfo.chunkId <<
+                " version: " << cih->chunkInfo.chunkVersion <<
+                " slot: " << cih->containerSlot <<
+                " in: " << container->GetFileName() <<
+                (ok ? " ok" : " error: ") << err <<
+                " in flight: " << mStaleChunkOpsInFlight <<
+            KFS_LOG_EOM;
+        } else if (cih->containerSlot >= 0) {
+            // Container is closed, the slot will be re-claimed on restart.
+        } else if (! ci ||
                 ! (*ci)->CanHaveVersion(cih->chunkInfo.chunkVersion)) {
             if (cih->IsKeep()) {
                 if (MarkChunkStale(cih, &mStaleChunkCompletion) == 0) {
                     mStaleChunkOpsInFlight++;
                 }
-            } else {
-                const string fileName = MakeChunkPathname(cih);
-                string err;
-                const bool ok = DiskIo::Delete(
-                    fileName.c_str(), &mStaleChunkCompletion, &err);
-                if (ok) {
-                    mStaleChunkOpsInFlight++;
+            } else if (! QueueStaleChunkDelete(cih)) {
+                // The directory batch is full, or the directory is out of
+                // delete credits. Leave the chunk in the queue, and move on
+                // to the chunks in the other directories, unless no
+                // directory in use can accept more deletes, in order not to
+                // re-scan the entire queue on every completion and timer
+                // tick.
+                if (! CanQueueStaleChunkDeletes()) {
+                    break;
                 }
-                KFS_LOG_STREAM(ok ?
-                        MsgLogger::kLogLevelINFO :
-                        MsgLogger::kLogLevelERROR) <<
-                    "deleting stale chunk: " << fileName <<
-                    (ok ? " ok" : " error: ") << err <<
-                    " in flight: " << mStaleChunkOpsInFlight <<
-                KFS_LOG_EOM;
+                continue;
             }
         }
         const int64_t size = min(mUsedSpace, cih->chunkInfo.chunkSize);
@@ -3562,6 +3864,124 @@ ChunkManager::RunStaleChunksQueue(bool completionFlag)
         mUsedSpace -= size;
         Delete(*cih);
     }
+    StartStaleChunkDeletes();
+}
+
+bool
+ChunkManager::QueueStaleChunkDelete(ChunkInfoHandle* cih)
+{
+    // Stale chunk files are deleted in batches, one batch per chunk
+    // directory in flight. The batch delete does not stall chunk reads and
+    // writes in the disk queue, unlike individual deletes.
+    ChunkDirInfo& dir = cih->GetDirInfo();
+    if (dir.availableSpace < 0) {
+        // Directory is not in use, the file will be cleaned up when the
+        // directory is back in use.
+        return true;
+    }
+    if (! CanQueueStaleChunkDelete(dir)) {
+        return false;
+    }
+    // The chunk id and version are kept in order to check, at the time the
+    // batch is issued, that the chunk file with the same name wasn't
+    // re-created, as the names queued while the batch is in flight wait for
+    // the next batch.
+    dir.staleDeletes.push_back(ChunkDirInfo::StaleDelete(
+        cih->chunkInfo.chunkId,
+        cih->chunkInfo.chunkVersion,
+        MakeChunkPathname(cih)
+    ));
+    dir.staleDeleteCredits--;
+    KFS_LOG_STREAM_DEBUG <<
+        "queued stale chunk delete: " << dir.staleDeletes.back().fileName <<
+        " queued: " << dir.staleDeletes.size() <<
+    KFS_LOG_EOM;
+    return true;
+}
+
+bool
+ChunkManager::CanQueueStaleChunkDelete(const ChunkDirInfo& dir) const
+{
+    // The directories not in use are excluded: the stale chunk files in
+    // these directories are not queued.
+    return (0 <= dir.availableSpace &&
+        (int)dir.staleDeletes.size() < mStaleChunkDeleteBatchSize &&
+        (mMaxStaleChunkDeletesPerSec <= 0 || dir.staleDeleteCredits > 0)
+    );
+}
+
+bool
+ChunkManager::CanQueueStaleChunkDeletes() const
+{
+    for (ChunkDirs::const_iterator it = mChunkDirs.begin();
+            it < mChunkDirs.end(); ++it) {
+        if (CanQueueStaleChunkDelete(*it)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+ChunkManager::StartStaleChunkDeletes()
+{
+    for (ChunkDirs::iterator it = mChunkDirs.begin();
+            it < mChunkDirs.end(); ++it) {
+        if (it->staleDeleteInFlightFlag || it->staleDeletes.empty()) {
+            continue;
+        }
+        // Re-check the chunk table: the chunk might have been re-created or
+        // replicated into the same file since the delete was queued.
+        string names;
+        int    count = 0;
+        for (ChunkDirInfo::StaleDeletes::const_iterator
+                sit = it->staleDeletes.begin();
+                sit != it->staleDeletes.end();
+                ++sit) {
+            ChunkInfoHandle** const ci = mChunkTable.Find(sit->chunkId);
+            if (ci && &(*ci)->GetDirInfo() == &*it &&
+                    (*ci)->CanHaveVersion(sit->chunkVersion)) {
+                KFS_LOG_STREAM_INFO <<
+                    "skipping stale chunk delete: " << sit->fileName <<
+                    " chunk exists" <<
+                KFS_LOG_EOM;
+                continue;
+            }
+            names.append(sit->fileName.c_str(), sit->fileName.size() + 1);
+            count++;
+        }
+        it->staleDeletes.clear();
+        if (count <= 0) {
+            continue;
+        }
+        string err;
+        const bool ok = DiskIo::DeleteBatch(
+            names.data(),
+            names.size(),
+            &it->staleDeleteCb,
+            &err
+        );
+        if (ok) {
+            it->staleDeleteInFlightFlag = true;
+            mStaleChunkDeleteBatchesInFlight++;
+        }
+        KFS_LOG_STREAM(ok ?
+                MsgLogger::kLogLevelINFO :
+                MsgLogger::kLogLevelERROR) <<
+            "deleting stale chunks: " << count <<
+            " in: " << it->dirname <<
+            (ok ? " ok" : " error: ") << err <<
+            " batches in flight: " << mStaleChunkDeleteBatchesInFlight <<
+        KFS_LOG_EOM;
+    }
+}
+
+void
+ChunkManager::StaleChunkDeleteBatchDone()
+{
+    assert(mStaleChunkDeleteBatchesInFlight > 0);
+    mStaleChunkDeleteBatchesInFlight--;
+    RunStaleChunksQueue();
 }
 
 void
@@ -3569,6 +3989,16 @@ ChunkManager::Timeout()
 {
     const time_t now = globalNetManager().Now();
 
+    if (now != mStaleChunkDeleteCreditsTime) {
+        mStaleChunkDeleteCreditsTime = now;
+        const int credits = mMaxStaleChunkDeletesPerSec;
+        for (ChunkDirs::iterator it = mChunkDirs.begin();
+                it < mChunkDirs.end(); ++it) {
+            it->staleDeleteCredits = credits;
+        }
+        RunStaleChunksQueue();
+    }
+
     if (now >= mNextCheckpointTime) {
         mNextCheckpointTime = globalNetManager().Now() + mCheckpointIntervalSecs;
         // if any writes have been around for "too" long, remove them
@@ -3586,10 +4016,202 @@ ChunkManager::Timeout()
         GetFsSpaceAvailable();
         mNextGetFsSpaceAvailableTime = now + mGetFsSpaceAvailableIntervalSecs;
     }
+    if (mScrubberBytesPerSec > 0) {
+        if (! mScrubberStateLoadedFlag) {
+            LoadScrubberState();
+        }
+        for (ChunkDirs::iterator it = mChunkDirs.begin();
+                it < mChunkDirs.end(); ++it) {
+            Scrub(*it, now);
+        }
+        if (mScrubberStateSaveTime + mScrubberStateSaveIntervalSec <= now) {
+            SaveScrubberState();
+        }
+    }
     gLeaseClerk.Timeout();
     gAtomicRecordAppendManager.Timeout();
 }
 
+void
+ChunkManager::Scrub(ChunkDirInfo& dir, time_t now)
+{
+    if (dir.scrubInFlightFlag || dir.availableSpace < 0 || ! dir.diskQueue ||
+            dir.evacuateFlag) {
+        return;
+    }
+    if (dir.scrubTime < now) {
+        if (dir.scrubDebtBytes > 0) {
+            dir.scrubDebtBytes = max(int64_t(0), dir.scrubDebtBytes -
+                int64_t(now - dir.scrubTime) * mScrubberBytesPerSec);
+        }
+        dir.scrubTime = now;
+    }
+    if (dir.scrubDebtBytes > 0) {
+        return;
+    }
+    // Yield to client and replication io.
+    int     freeRequestCount;
+    int     requestCount;
+    int64_t readBlockCount;
+    int64_t writeBlockCount;
+    int     blockSize;
+    if (! DiskIo::GetDiskQueuePendingCount(
+            dir.diskQueue,
+            freeRequestCount,
+            requestCount,
+            readBlockCount,
+            writeBlockCount,
+            blockSize)) {
+        die(dir.dirname + ": get pending io count failed");
+    }
+    if (requestCount > mScrubberMaxPendingIoRequests) {
+        dir.scrubDebtBytes = mScrubberBackoffSec * mScrubberBytesPerSec;
+        return;
+    }
+    ChunkInfoHandle* cih = 0;
+    for (int rebuildCount = 0; ; ) {
+        if (dir.scrubChunkIds.size() <= dir.scrubIdx) {
+            if (! dir.scrubChunkIds.empty()) {
+                dir.scrubPassCount++;
+                mCounters.mScrubPassCount++;
+                dir.scrubChunkId = -1;
+                KFS_LOG_STREAM_INFO <<
+                    "scrub: " << dir.dirname <<
+                    " pass: " << dir.scrubPassCount << " complete" <<
+                KFS_LOG_EOM;
+            }
+            dir.scrubChunkIds.clear();
+            dir.scrubIdx = 0;
+            if (2 <= rebuildCount++) {
+                break;
+            }
+            ChunkDirList::Iterator it(
+                dir.chunkLists[ChunkDirInfo::kChunkDirList]);
+            ChunkInfoHandle* ch;
+            while ((ch = it.Next())) {
+                if (dir.scrubChunkId < ch->chunkInfo.chunkId) {
+                    dir.scrubChunkIds.push_back(ch->chunkInfo.chunkId);
+                }
+            }
+            if (dir.scrubChunkIds.empty()) {
+                // Start from the beginning, if resumed past the last chunk.
+                dir.scrubChunkId = -1;
+                continue;
+            }
+            sort(dir.scrubChunkIds.begin(), dir.scrubChunkIds.end());
+        }
+        const kfsChunkId_t chunkId = dir.scrubChunkIds[dir.scrubIdx++];
+        ChunkInfoHandle** const ci = mChunkTable.Find(chunkId);
+        if (! ci) {
+            continue;
+        }
+        ChunkInfoHandle* const ch = *ci;
+        if (&ch->GetDirInfo() != &dir || ch->IsStale() ||
+                ch->IsEvacuate() || ch->isBeingReplicated ||
+                ! ch->IsChunkReadable() || ch->IsWriteAppenderOwns() ||
+                IsWritePending(chunkId) || ch->chunkInfo.chunkSize <= 0) {
+            dir.scrubChunkId = chunkId;
+            continue;
+        }
+        cih = ch;
+        break;
+    }
+    if (! cih) {
+        dir.scrubDebtBytes = mScrubberBackoffSec * mScrubberBytesPerSec;
+        return;
+    }
+    // Read and verify chunk header and all data blocks checksums. The read
+    // path reports corrupted chunks to the meta server, and moves them into
+    // lost and found.
+    GetChunkMetadataOp* const op = new GetChunkMetadataOp(0);
+    op->chunkId        = cih->chunkInfo.chunkId;
+    op->readVerifyFlag = true;
+    op->clnt           = &dir.scrubCb;
+    dir.scrubInFlightFlag = true;
+    KFS_LOG_STREAM_DEBUG <<
+        "scrub: " << dir.dirname <<
+        " chunk: " << op->chunkId <<
+        " size: "  << cih->chunkInfo.chunkSize <<
+    KFS_LOG_EOM;
+    op->Execute();
+}
+
+void
+ChunkManager::ScrubDone(ChunkDirInfo& dir, GetChunkMetadataOp* op)
+{
+    assert(op && dir.scrubInFlightFlag);
+    dir.scrubInFlightFlag = false;
+    dir.scrubChunkId      = op->chunkId;
+    dir.scrubDebtBytes   += op->numBytesScrubbed + KFS_CHUNK_HEADER_SIZE;
+    mCounters.mScrubChunkCount++;
+    mCounters.mScrubByteCount += op->numBytesScrubbed;
+    if (op->status < 0) {
+        KFS_LOG_STREAM_ERROR <<
+            "scrub: " << dir.dirname <<
+            " chunk: "   << op->chunkId <<
+            " scrubbed: " << op->numBytesScrubbed <<
+            " status: "  << op->status <<
+            " " << op->statusMsg <<
+        KFS_LOG_EOM;
+    }
+    delete op;
+}
+
+void
+ChunkManager::LoadScrubberState()
+{
+    mScrubberStateLoadedFlag = true;
+    if (mScrubberStateFileName.empty()) {
+        return;
+    }
+    ifstream is(mScrubberStateFileName.c_str());
+    if (! is) {
+        return;
+    }
+    string       dirname;
+    kfsChunkId_t chunkId;
+    int64_t      passCount;
+    while (is >> dirname >> chunkId >> passCount) {
+        for (ChunkDirs::iterator it = mChunkDirs.begin();
+                it < mChunkDirs.end(); ++it) {
+            if (it->dirname == dirname) {
+                it->scrubChunkId   = chunkId;
+                it->scrubPassCount = passCount;
+                KFS_LOG_STREAM_INFO <<
+                    "scrub: " << dirname <<
+                    " resume after chunk: " << chunkId <<
+                    " pass: " << passCount <<
+                KFS_LOG_EOM;
+                break;
+            }
+        }
+    }
+}
+
+void
+ChunkManager::SaveScrubberState()
+{
+    mScrubberStateSaveTime = globalNetManager().Now();
+    if (mScrubberStateFileName.empty()) {
+        return;
+    }
+    const string tmpName = mScrubberStateFileName + ".tmp";
+    ofstream os(tmpName.c_str(), ofstream::out | ofstream::trunc);
+    for (ChunkDirs::const_iterator it = mChunkDirs.begin();
+            it < mChunkDirs.end(); ++it) {
+        os << it->dirname << " " << it->scrubChunkId <<
+            " " << it->scrubPassCount << "\n";
+    }
+    os.close();
+    if (! os || rename(tmpName.c_str(), mScrubberStateFileName.c_str())) {
+        const int err = errno;
+        KFS_LOG_STREAM_ERROR <<
+            "scrub: failed to save state: " << mScrubberStateFileName <<
+            " " << QCUtils::SysError(err) <<
+        KFS_LOG_EOM;
+    }
+}
+
 void
 ChunkManager::ScavengePendingWrites(time_t now)
 {
@@ -3755,6 +4377,10 @@ ChunkManager::StartDiskIo()
         if (! (it->diskQueue = DiskIo::FindDiskQueue(it->dirname.c_str()))) {
             die(it->dirname + ": failed to find disk queue");
         }
+        if (! OpenChunkContainer(*it)) {
+            NotifyMetaChunksLost(*it);
+            continue;
+        }
         KFS_LOG_STREAM_INFO <<
             "chunk directory: " << it->dirname <<
             " devId: "          << it->deviceId <<
@@ -3866,6 +4492,33 @@ ChunkManager::ChunkDirInfo::CheckDirReadableDone(int code, void* data)
     return 0;
 }
 
+int
+ChunkManager::ChunkDirInfo::StaleChunksDeleteDone(int code, void* data)
+{
+    if ((code != EVENT_DISK_DELETE_DONE && code != EVENT_DISK_ERROR) ||
+            ! staleDeleteInFlightFlag) {
+        die("StaleChunksDeleteDone invalid completion");
+    }
+    staleDeleteInFlightFlag = false;
+    if (code == EVENT_DISK_ERROR) {
+        // Some files might have been already deleted. The remaining files
+        // will be cleaned up on restart.
+        KFS_LOG_STREAM_ERROR <<
+            "chunk directory: " << dirname <<
+            " stale chunks delete error: " <<
+            QCUtils::SysError(-*reinterpret_cast<int*>(data)) <<
+        KFS_LOG_EOM;
+    } else {
+        KFS_LOG_STREAM_DEBUG <<
+            "chunk directory: " << dirname <<
+            " stale chunks deleted: " <<
+            *reinterpret_cast<const int64_t*>(data) <<
+        KFS_LOG_EOM;
+    }
+    gChunkManager.StaleChunkDeleteBatchDone();
+    return 0;
+}
+
 int
 ChunkManager::ChunkDirInfo::FsSpaceAvailDone(int code, void* data)
 {
@@ -4261,6 +4914,15 @@ ChunkManager::CheckChunkDirs()
                 it->availableSpace             = 0;
                 it->deviceId                   = dit->second.first;
                 it->dirLock                    = dit->second.second;
+                if (! OpenChunkContainer(*it)) {
+                    // For now do not keep trying, the same as with disk
+                    // queue start failure below.
+                    it->Stop();
+                    continue;
+                }
+                if (it->container) {
+                    AddContainerMappings(*it);
+                }
                 it->corruptedChunksCount       = 0;
                 it->evacuateCheckIoErrorsCount = 0;
                 ChunkDirs::const_iterator cit;
@@ -86,6 +86,9 @@ public:
         Counter mLostChunksCount;
         Counter mDirLostChunkCount;
         Counter mChunkDirLostCount;
+        Counter mScrubChunkCount;
+        Counter mScrubByteCount;
+        Counter mScrubPassCount;
 
         void Clear()
         {
@@ -98,6 +101,9 @@ public:
             mLostChunksCount          = 0;
             mDirLostChunkCount        = 0;
             mChunkDirLostCount        = 0;
+            mScrubChunkCount          = 0;
+            mScrubByteCount           = 0;
+            mScrubPassCount           = 0;
         }
     };
 
@@ -692,6 +698,10 @@ private:
     StaleChunkCompletion mStaleChunkCompletion;
     int mStaleChunkOpsInFlight;
     int mMaxStaleChunkOpsInFlight;
+    int mStaleChunkDeleteBatchesInFlight;
+    int mStaleChunkDeleteBatchSize;
+    int mMaxStaleChunkDeletesPerSec;
+    time_t mStaleChunkDeleteCreditsTime;
     int mMaxDirCheckDiskTimeouts;
     double mChunkPlacementPendingReadWeight;
     double mChunkPlacementPendingWriteWeight;
@@ -714,6 +724,21 @@ private:
     time_t     mMetaHeartbeatTime;
     int64_t    mMetaEvacuateCount;
     int        mMaxEvacuateIoErrors;
+    bool       mChunkContainerFlag;
+    string     mChunkContainerFileName;
+    int64_t    mChunkContainerMaxSlots;
+    int64_t    mChunkContainerAvgChunkSize;
+    /// Background scrubber: read bandwidth per chunk directory, 0 disables
+    /// scrubbing.
+    int64_t    mScrubberBytesPerSec;
+    /// Back off if the chunk directory disk queue has more requests pending.
+    int        mScrubberMaxPendingIoRequests;
+    int        mScrubberBackoffSec;
+    /// File to persist scrub position in order to resume after restart.
+    string     mScrubberStateFileName;
+    int        mScrubberStateSaveIntervalSec;
+    time_t     mScrubberStateSaveTime;
+    bool       mScrubberStateLoadedFlag;
 
     enum
     {
@@ -732,6 +757,11 @@ private:
     /// When a checkpoint file is read, update the mChunkTable[] to
     /// include a mapping for cih->chunkInfo.chunkId.
     void AddMapping(ChunkDirInfo& dir, const char* filename, int64_t filesz);
+    /// Add mappings for all stable chunks in the chunk directory container.
+    void AddContainerMappings(ChunkDirInfo& dir);
+    /// Open or create chunk directory container, if container mode is
+    /// enabled.
+    bool OpenChunkContainer(ChunkDirInfo& dir);
     void AddMapping(ChunkInfoHandle *cih);
 
     /// Of the various directories this chunkserver is configured with, find the directory to store a chunk file.  
@@ -794,7 +824,20 @@ private:
     void UpdateChecksums(ChunkInfoHandle *cih, WriteOp *op);
     bool IsChunkStable(const ChunkInfoHandle* cih) const;
     void RunStaleChunksQueue(bool completionFlag = false);
+    bool QueueStaleChunkDelete(ChunkInfoHandle* cih);
+    bool CanQueueStaleChunkDelete(const ChunkDirInfo& dir) const;
+    bool CanQueueStaleChunkDeletes() const;
+    void StartStaleChunkDeletes();
+    void StaleChunkDeleteBatchDone();
     int OpenChunk(ChunkInfoHandle* cih, int openFlags);
+
+    /// Start checksum verification of the next stable chunk in the
+    /// directory, if the directory's scrub bandwidth allows and the
+    /// directory's io queue isn't busy with other requests.
+    void Scrub(ChunkDirInfo& dir, time_t now);
+    void ScrubDone(ChunkDirInfo& dir, GetChunkMetadataOp* op);
+    void LoadScrubberState();
+    void SaveScrubberState();
 private:
     // No copy.
     ChunkManager(const ChunkManager&);
@@ -550,6 +550,12 @@ ClientSM::HandleClientCmd(IOBuffer* iobuf, int cmdLen)
     }
 
     iobuf->Consume(cmdLen);
+    if (! op->tenant.empty()) {
+        // Short rpc format requests have no tenant, the tenant is per
+        // connection, and is set by the long format requests.
+        GetBufferManager().SetTenant(
+            *this, op->tenant.GetPtr(), op->tenant.GetSize());
+    }
     ByteCount bufferBytes = -1;
     if (op->op == CMD_WRITE_PREPARE) {
         WritePrepareOp* const wop = static_cast<WritePrepareOp*>(op);
@@ -581,7 +587,8 @@ ClientSM::HandleClientCmd(IOBuffer* iobuf, int cmdLen)
         bufferBytes = IoRequestBytes(waop->numBytes);
     }
     CLIENT_SM_LOG_STREAM_DEBUG <<
-        "got: seq: " << op->seq << " " << op->Show() <<
+        "got: seq: " << op->seq <<
+        (op->shortRpcFormatFlag ? " short fmt " : " ") << op->Show() <<
     KFS_LOG_EOM;
 
     bool submitResponseFlag = false;
@@ -96,6 +96,7 @@ static int DiskQueueToSysError(
         case QCDiskQueue::kErrorRename:               return EIO;
         case QCDiskQueue::kErrorGetFsAvailable:       return EIO;
         case QCDiskQueue::kErrorCheckDirReadable:     return EIO;
+        case QCDiskQueue::kErrorPunchHole:            return EIO;
         default:                                      break;
     }
     return EINVAL;
@@ -290,9 +291,11 @@ public:
           mFileNamePrefixes(inFileNamePrefixPtr ? inFileNamePrefixPtr : ""),
           mDeviceId(inDeviceId),
           mDeleteNullFilePtr(new DiskIo::File()),
+          mDeleteBatchNullFilePtr(new DiskIo::File()),
           mRenameNullFilePtr(new DiskIo::File()),
           mGetFsSpaceAvailableNullFilePtr(new DiskIo::File()),
           mCheckDirReadableNullFilePtr(new DiskIo::File()),
+          mPunchHoleNullFilePtr(new DiskIo::File()),
           mSimulatorPtr(inSimulatorConfigPtr ?
             new DiskErrorSimulator(*inSimulatorConfigPtr) : 0)
     {
@@ -300,9 +303,11 @@ public:
         DiskQueueList::Init(*this);
         DiskQueueList::PushBack(inListPtr, *this);
         mDeleteNullFilePtr->mQueuePtr              = this;
+        mDeleteBatchNullFilePtr->mQueuePtr         = this;
         mRenameNullFilePtr->mQueuePtr              = this;
         mGetFsSpaceAvailableNullFilePtr->mQueuePtr = this;
         mCheckDirReadableNullFilePtr->mQueuePtr    = this;
+        mPunchHoleNullFilePtr->mQueuePtr           = this;
     }
     void Delete(
         DiskQueue** inListPtr)
@@ -404,12 +409,16 @@ public:
         { return (! mFileNamePrefixes.empty()); }
     DiskIo::FilePtr GetDeleteNullFile()
         { return mDeleteNullFilePtr; };
+    DiskIo::FilePtr GetDeleteBatchNullFile()
+        { return mDeleteBatchNullFilePtr; };
     DiskIo::FilePtr GetRenameNullFile()
         { return mRenameNullFilePtr; };
     DiskIo::FilePtr GetGetFsSpaceAvailableNullFile()
         { return mGetFsSpaceAvailableNullFilePtr; };
     DiskIo::FilePtr GetCheckDirReadableNullFile()
         { return mCheckDirReadableNullFilePtr; };
+    DiskIo::FilePtr GetPunchHoleNullFile()
+        { return mPunchHoleNullFilePtr; };
     virtual void TraceMsg(
         const char* inMsgPtr,
         int         inLength)
@@ -432,9 +441,11 @@ private:
     string                    mFileNamePrefixes;
     DeviceId                  mDeviceId;
     DiskIo::FilePtr           mDeleteNullFilePtr; // Pseudo files.
+    DiskIo::FilePtr           mDeleteBatchNullFilePtr;
     DiskIo::FilePtr           mRenameNullFilePtr;
     DiskIo::FilePtr           mGetFsSpaceAvailableNullFilePtr;
     DiskIo::FilePtr           mCheckDirReadableNullFilePtr;
+    DiskIo::FilePtr           mPunchHoleNullFilePtr;
     DiskErrorSimulator* const mSimulatorPtr;
     DiskQueue*                mPrevPtr[1];
     DiskQueue*                mNextPtr[1];
@@ -443,9 +454,11 @@ private:
     {
         DiskQueue::Stop();
         mDeleteNullFilePtr->mQueuePtr              = 0;
+        mDeleteBatchNullFilePtr->mQueuePtr         = 0;
         mRenameNullFilePtr->mQueuePtr              = 0;
         mGetFsSpaceAvailableNullFilePtr->mQueuePtr = 0;
         mCheckDirReadableNullFilePtr->mQueuePtr    = 0;
+        mPunchHoleNullFilePtr->mQueuePtr           = 0;
         delete mSimulatorPtr;
     }
    friend class QCDLListOp<DiskQueue, 0>;
@@ -489,6 +502,8 @@ public:
             "chunkServer.ioBufferPool.bufferSize", 4 << 10)),
           mBufferPoolLockMemoryFlag(inConfig.getValue(
             "chunkServer.ioBufferPool.lockMemory", false)),
+          mBufferPoolThreadCacheBufferCount(inConfig.getValue(
+            "chunkServer.ioBufferPool.threadCacheBufferCount", 32)),
           mDiskOverloadedPendingRequestCount(inConfig.getValue(
             "chunkServer.diskIo.overloadedPendingRequestCount",
                 mDiskQueueMaxQueueDepth * 3 / 4)),
@@ -558,7 +573,8 @@ public:
             mBufferPoolPartitionCount,
             mBufferPoolPartitionBufferCount,
             mBufferPoolBufferSize,
-            mBufferPoolLockMemoryFlag
+            mBufferPoolLockMemoryFlag,
+            mBufferPoolThreadCacheBufferCount
         );
         if (theSysError) {
             if (inErrMessagePtr) {
@@ -881,6 +897,15 @@ public:
             mCounters.mDeleteErrorCount++;
         }
     }
+    void DeleteBatchDone(
+        int64_t inRetCode)
+    {
+        if (inRetCode >= 0) {
+            mCounters.mDeleteCount += inRetCode;
+        } else {
+            mCounters.mDeleteErrorCount++;
+        }
+    }
     void RenameDone(
         int64_t inRetCode)
     {
@@ -908,8 +933,26 @@ public:
             mCounters.mCheckDirReadableErrorCount++;
         }
     }
+    void PunchHoleDone(
+        int64_t inRetCode)
+    {
+        if (inRetCode >= 0) {
+            mCounters.mPunchHoleCount++;
+        } else {
+            mCounters.mPunchHoleErrorCount++;
+        }
+    }
     int GetFdCountPerFile() const
         { return mDiskQueueThreadCount; }
+    double GetAvgPendingRequestCount()
+    {
+        DiskQueueList::Iterator theItr(mDiskQueuesPtr);
+        int                     theCount = 0;
+        while (theItr.Next()) {
+            theCount++;
+        }
+        return ((mReadReqCount + mWriteReqCount) / (double)max(1, theCount));
+    }
     void GetCounters(
         Counters& outCounters)
         { outCounters = mCounters; }
@@ -947,6 +990,7 @@ public:
         mBufferManager.SetWaitingAvgInterval(inProperties.getValue(
             "chunkServer.bufferManager.waitingAvgInterval",
             mBufferManager.GetWaitingAvgInterval()));
+        mBufferManager.SetQosParameters(inProperties);
         mMaxIoTime = max(1, inProperties.getValue(
             "chunkServer.diskIo.maxIoTimeSec", mMaxIoTime));
     }
@@ -1022,6 +1066,7 @@ private:
     const int                      mBufferPoolPartitionBufferCount;
     const int                      mBufferPoolBufferSize;
     const int                      mBufferPoolLockMemoryFlag;
+    const int                      mBufferPoolThreadCacheBufferCount;
     const int                      mDiskOverloadedPendingRequestCount;
     const int                      mDiskClearOverloadedPendingRequestCount;
     const int                      mDiskOverloadedMinFreeBufferCount;
@@ -1265,6 +1310,13 @@ DiskIo::GetCounters(
     sDiskIoQueuesPtr->GetCounters(outCounters);
 }
 
+    /* static */ double
+DiskIo::GetAvgPendingRequestCount()
+{
+    return (sDiskIoQueuesPtr ?
+        sDiskIoQueuesPtr->GetAvgPendingRequestCount() : 0.);
+}
+
      /* static */ bool
 DiskIo::Delete(
     const char*     inFileNamePtr,
@@ -1280,6 +1332,23 @@ DiskIo::Delete(
     );
 }
 
+     /* static */ bool
+DiskIo::DeleteBatch(
+    const char*     inFileNamesPtr,
+    size_t          inFileNamesLength,
+    KfsCallbackObj* inCallbackObjPtr /* = 0 */,
+    string*         inErrMessagePtr /* = 0 */)
+{
+    return EnqueueMeta(
+        kMetaOpTypeDeleteBatch,
+        inFileNamesPtr,
+        0,
+        inCallbackObjPtr,
+        inErrMessagePtr,
+        inFileNamesLength
+    );
+}
+
      /* static */ bool
 DiskIo::Rename(
     const char*     inSrcFileNamePtr,
@@ -1296,6 +1365,26 @@ DiskIo::Rename(
     );
 }
 
+     /* static */ bool
+DiskIo::PunchHole(
+    const char*     inFileNamePtr,
+    int64_t         inOffset,
+    int64_t         inLength,
+    KfsCallbackObj* inCallbackObjPtr /* = 0 */,
+    string*         inErrMessagePtr /* = 0 */)
+{
+    return EnqueueMeta(
+        kMetaOpTypePunchHole,
+        inFileNamePtr,
+        0,
+        inCallbackObjPtr,
+        inErrMessagePtr,
+        0,
+        inOffset,
+        inLength
+    );
+}
+
      /* static */ bool
 DiskIo::GetFsSpaceAvailable(
     const char*     inPathNamePtr,
@@ -1375,13 +1464,21 @@ DiskIo::EnqueueMeta(
     const char*        inNamePtr,
     const char*        inNextNamePtr,
     KfsCallbackObj*    inCallbackObjPtr,
-    string*            inErrMessagePtr)
+    string*            inErrMessagePtr,
+    size_t             inNamesLength,
+    int64_t            inOffset,
+    int64_t            inLength)
 {
     const char* theErrMsgPtr = 0;
     if (! inNamePtr) {
         theErrMsgPtr = "file or directory name is null";
+    } else if (inOpType == kMetaOpTypeDeleteBatch && inNamesLength <= 0) {
+        theErrMsgPtr = "empty file name list";
     } else if (inOpType == kMetaOpTypeRename && ! inNextNamePtr) {
         theErrMsgPtr = "destination file name is null";
+    } else if (inOpType == kMetaOpTypePunchHole &&
+            (inOffset < 0 || inLength <= 0)) {
+        theErrMsgPtr = "invalid byte range";
     } else if (! sDiskIoQueuesPtr) {
         theErrMsgPtr = "disk queues are not initialized";
     } else {
@@ -1427,6 +1524,39 @@ DiskIo::EnqueueMeta(
                         sDiskIoQueuesPtr->DeleteDone(-1);
                     }
                     break;
+                case kMetaOpTypeDeleteBatch:
+                    theDiskIoPtr = new DiskIo(
+                        theQueuePtr->GetDeleteBatchNullFile(),
+                        theCallbackPtr
+                    );
+                    sDiskIoQueuesPtr->SetInFlight(theDiskIoPtr);
+                    theStatus = theQueuePtr->DeleteBatch(
+                        inNamePtr,
+                        inNamesLength,
+                        theDiskIoPtr,
+                        sDiskIoQueuesPtr->GetMaxEnqueueWaitTimeNanoSec()
+                    );
+                    if (theStatus.IsError()) {
+                        sDiskIoQueuesPtr->DeleteBatchDone(-1);
+                    }
+                    break;
+                case kMetaOpTypePunchHole:
+                    theDiskIoPtr = new DiskIo(
+                        theQueuePtr->GetPunchHoleNullFile(),
+                        theCallbackPtr
+                    );
+                    sDiskIoQueuesPtr->SetInFlight(theDiskIoPtr);
+                    theStatus = theQueuePtr->PunchHole(
+                        inNamePtr,
+                        inOffset,
+                        inLength,
+                        theDiskIoPtr,
+                        sDiskIoQueuesPtr->GetMaxEnqueueWaitTimeNanoSec()
+                    );
+                    if (theStatus.IsError()) {
+                        sDiskIoQueuesPtr->PunchHoleDone(-1);
+                    }
+                    break;
                 case kMetaOpTypeGetFsSpaceAvailable:
                     theDiskIoPtr = new DiskIo(
                         theQueuePtr->GetGetFsSpaceAvailableNullFile(),
@@ -1548,12 +1678,55 @@ DiskIo::File::Open(
     return true;
 }
 
+    bool
+DiskIo::File::OpenExtent(
+    const DiskIo::FilePtr& inContainerPtr,
+    DiskIo::Offset         inStartOffset,
+    DiskIo::Offset         inMaxFileSize,
+    bool                   inReadOnlyFlag  /* = false */,
+    string*                inErrMessagePtr /* = 0 */)
+{
+    const char* theErrMsgPtr = 0;
+    if (IsOpen()) {
+       theErrMsgPtr = "file is already open";
+    } else if (! inContainerPtr || ! inContainerPtr->IsOpen() ||
+            inContainerPtr->IsExtent()) {
+        theErrMsgPtr = "invalid container file";
+    } else if (inStartOffset < 0 || inMaxFileSize <= 0) {
+        theErrMsgPtr = "invalid extent";
+    } else if (! inReadOnlyFlag && inContainerPtr->IsReadOnly()) {
+        theErrMsgPtr = "container file is read only";
+    } else {
+        const int theBlockSize =
+            inContainerPtr->GetDiskQueuePtr()->GetBlockSize();
+        if (theBlockSize <= 0 || inStartOffset % theBlockSize != 0) {
+            theErrMsgPtr = "extent start is not block aligned";
+        }
+    }
+    if (theErrMsgPtr) {
+        if (inErrMessagePtr) {
+            *inErrMessagePtr = theErrMsgPtr;
+        }
+        DiskIoReportError(theErrMsgPtr, EINVAL);
+        return false;
+    }
+    Reset();
+    mQueuePtr          = inContainerPtr->mQueuePtr;
+    mFileIdx           = inContainerPtr->mFileIdx;
+    mReadOnlyFlag      = inReadOnlyFlag;
+    mSpaceReservedFlag = true;
+    mStartOffset       = inStartOffset;
+    mMaxFileSize       = inMaxFileSize;
+    mContainerPtr      = inContainerPtr;
+    return true;
+}
+
     bool
 DiskIo::File::Close(
     DiskIo::Offset inFileSize,     /* = -1 */
     string*        inErrMessagePtr /* = 0  */)
 {
-    if (mFileIdx < 0 || ! mQueuePtr) {
+    if (mFileIdx < 0 || ! mQueuePtr || IsExtent()) {
         Reset();
         return true;
     }
@@ -1644,6 +1817,9 @@ DiskIo::File::Reset()
     mFileIdx           = -1;
     mReadOnlyFlag      = false;
     mSpaceReservedFlag = false;
+    mStartOffset       = 0;
+    mMaxFileSize       = -1;
+    mContainerPtr.reset();
 }
 
 DiskIo::DiskIo(
@@ -1683,13 +1859,14 @@ DiskIo::Read(
     DiskIo::Offset inOffset,
     size_t         inNumBytes)
 {
-    if (inOffset < 0 ||
+    if (inOffset < 0 || ! mFilePtr->IsInRange(inOffset, inNumBytes) ||
             mRequestId != QCDiskQueue::kRequestIdNone || ! mFilePtr->IsOpen()) {
         KFS_LOG_STREAM_ERROR <<
             "file: " << mFilePtr->GetFileIdx() <<
             " " << (mFilePtr->IsOpen() ? "open" : "closed") <<
             " read request: " << mRequestId <<
             " offset: " << inOffset <<
+            " size: " << inNumBytes <<
         KFS_LOG_EOM;
         DiskIoReportError("DiskIo::Read: bad parameters", EINVAL);
         return -EINVAL;
@@ -1724,7 +1901,7 @@ DiskIo::Read(
     sDiskIoQueuesPtr->SetInFlight(this);
     const DiskQueue::EnqueueStatus theStatus = theQueuePtr->Read(
         mFilePtr->GetFileIdx(),
-        inOffset / theBlockSize,
+        (mFilePtr->GetStartOffset() + inOffset) / theBlockSize,
         0, // inBufferIteratorPtr // allocate buffers just beofre read
         theBufferCnt,
         this,
@@ -1754,6 +1931,7 @@ DiskIo::Write(
     IOBuffer*      inBufferPtr)
 {
     if (inOffset < 0 || ! inBufferPtr ||
+            ! mFilePtr->IsInRange(inOffset, inNumBytes) ||
             mRequestId != QCDiskQueue::kRequestIdNone || ! mFilePtr->IsOpen()) {
         KFS_LOG_STREAM_ERROR <<
             "file: " << mFilePtr->GetFileIdx() <<
@@ -1836,7 +2014,7 @@ DiskIo::Write(
     sDiskIoQueuesPtr->SetInFlight(this);
     const DiskQueue::EnqueueStatus theStatus = theQueuePtr->Write(
         mFilePtr->GetFileIdx(),
-        inOffset / theBlockSize,
+        (mFilePtr->GetStartOffset() + inOffset) / theBlockSize,
         &theBufItr,
         mIoBuffers.size(),
         this,
@@ -1976,6 +2154,18 @@ DiskIo::RunCompletion()
         theMetaFlag = true;
         theCode = EVENT_DISK_DELETE_DONE;
         sDiskIoQueuesPtr->DeleteDone(mIoRetCode);
+    } else if (mFilePtr.get() ==
+            theQueuePtr->GetDeleteBatchNullFile().get()) {
+        theOpNamePtr = "delete batch";
+        theMetaFlag = true;
+        theCode = EVENT_DISK_DELETE_DONE;
+        sDiskIoQueuesPtr->DeleteBatchDone(mIoRetCode);
+    } else if (mFilePtr.get() ==
+            theQueuePtr->GetPunchHoleNullFile().get()) {
+        theOpNamePtr = "punch hole";
+        theMetaFlag = true;
+        theCode = EVENT_DISK_PUNCH_HOLE_DONE;
+        sDiskIoQueuesPtr->PunchHoleDone(mIoRetCode);
     } else if (mFilePtr.get() == theQueuePtr->GetRenameNullFile().get()) {
         theOpNamePtr = "rename";
         theMetaFlag = true;
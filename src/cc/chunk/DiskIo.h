@@ -72,6 +72,8 @@ public:
         Counter mGetFsSpaceAvailableErrorCount;
         Counter mCheckDirReadableCount;
         Counter mCheckDirReadableErrorCount;
+        Counter mPunchHoleCount;
+        Counter mPunchHoleErrorCount;
         Counter mTimedOutErrorCount;
         Counter mTimedOutErrorReadByteCount;
         Counter mTimedOutErrorWriteByteCount;
@@ -94,6 +96,8 @@ public:
             mGetFsSpaceAvailableErrorCount = 0;
             mCheckDirReadableCount         = 0;
             mCheckDirReadableErrorCount    = 0;
+            mPunchHoleCount                = 0;
+            mPunchHoleErrorCount           = 0;
             mTimedOutErrorCount            = 0;
             mTimedOutErrorReadByteCount    = 0;
             mTimedOutErrorWriteByteCount   = 0;
@@ -124,15 +128,36 @@ public:
     static BufferManager& GetBufferManager();
     static void GetCounters(
         Counters& outCounters);
+    // Average number of pending requests per disk queue.
+    static double GetAvgPendingRequestCount();
     static bool Delete(
         const char*     inFileNamePtr,
         KfsCallbackObj* inCallbackObjPtr = 0,
         string*    inErrMessagePtr  = 0);
+    // Delete files in the same directory, the names are null terminated and
+    // inFileNamesLength includes all the terminating nulls. The delete runs
+    // concurrently with the reads and writes. On completion the data points
+    // to the number of the files deleted, or EVENT_DISK_ERROR is returned if
+    // any of the deletes fail.
+    static bool DeleteBatch(
+        const char*     inFileNamesPtr,
+        size_t          inFileNamesLength,
+        KfsCallbackObj* inCallbackObjPtr = 0,
+        string*         inErrMessagePtr  = 0);
     static bool Rename(
         const char*     inSrcFileNamePtr,
         const char*     inDstFileNamePtr,
         KfsCallbackObj* inCallbackObjPtr = 0,
         string*         inErrMessagePtr  = 0);
+    // Deallocate file space in the byte range, the range reads as zeros after
+    // completion. The caller must ensure that the range has no io in flight.
+    // On completion the data points to the range length.
+    static bool PunchHole(
+        const char*     inFileNamePtr,
+        int64_t         inOffset,
+        int64_t         inLength,
+        KfsCallbackObj* inCallbackObjPtr = 0,
+        string*         inErrMessagePtr  = 0);
     static bool GetFsSpaceAvailable(
         const char*     inPathNamePtr,
         KfsCallbackObj* inCallbackObjPtr = 0,
@@ -160,7 +185,10 @@ public:
             : mQueuePtr(0),
               mFileIdx(-1),
               mReadOnlyFlag(false),
-              mSpaceReservedFlag(false)
+              mSpaceReservedFlag(false),
+              mStartOffset(0),
+              mMaxFileSize(-1),
+              mContainerPtr()
             {}
         ~File()
         {
@@ -177,8 +205,31 @@ public:
             string*     inErrMessagePtr        = 0,
             bool*       inRetryFlagPtr         = 0,
             bool        inBufferedIoFlag       = false);
+        /// Open file as a fixed size extent [inStartOffset,
+        /// inStartOffset + inMaxFileSize) of already open container file.
+        /// All io offsets are relative to the extent start, and io outside of
+        /// the extent boundaries is rejected. Close() only detaches extent
+        /// from the container, the container file remains open while there
+        /// are references to it.
+        bool OpenExtent(
+            const boost::shared_ptr<File>& inContainerPtr,
+            Offset                         inStartOffset,
+            Offset                         inMaxFileSize,
+            bool                           inReadOnlyFlag  = false,
+            string*                        inErrMessagePtr = 0);
         bool IsOpen() const
             { return (mFileIdx >= 0); }
+        bool IsExtent() const
+            { return (mContainerPtr.get() != 0); }
+        Offset GetStartOffset() const
+            { return mStartOffset; }
+        bool IsInRange(
+            Offset inOffset,
+            size_t inNumBytes) const
+        {
+            return (mMaxFileSize < 0 ||
+                inOffset + (Offset)inNumBytes <= mMaxFileSize);
+        }
         bool Close(
             Offset  inFileSize      = -1,
             string* inErrMessagePtr = 0);
@@ -201,6 +252,9 @@ public:
         int        mFileIdx;
         bool       mReadOnlyFlag:1;
         bool       mSpaceReservedFlag:1;
+        Offset     mStartOffset;
+        Offset     mMaxFileSize;
+        boost::shared_ptr<File> mContainerPtr;
 
         void Reset();
         friend class DiskQueue;
@@ -289,6 +343,8 @@ private:
         kMetaOpTypeRename              = 2,
         kMetaOpTypeGetFsSpaceAvailable = 3,
         kMetaOpTypeCheckDirReadable    = 4,
+        kMetaOpTypeDeleteBatch         = 5,
+        kMetaOpTypePunchHole           = 6,
         kMetaOpTypeNumOps
     };
 
@@ -297,7 +353,10 @@ private:
         const char*     inSrcFileNamePtr,
         const char*     inDstFileNamePtr,
         KfsCallbackObj* inCallbackObjPtr,
-        string*         inErrMessagePtr);
+        string*         inErrMessagePtr,
+        size_t          inNamesLength = 0,
+        int64_t         inOffset      = -1,
+        int64_t         inLength      = -1);
 
     friend class QCDLListOp<DiskIo, 0>;
     friend class DiskIoQueues;
@@ -69,6 +69,7 @@ using std::make_pair;
 using std::ostream_iterator;
 using std::copy;
 using std::hex;
+using std::dec;
 using std::max;
 using namespace KFS::libkfsio;
 
@@ -160,6 +161,7 @@ private:
         instance.AddCounter("Get Chunk Metadata", CMD_GET_CHUNK_METADATA);
         instance.AddCounter("Alloc", CMD_ALLOC_CHUNK);
         instance.AddCounter("Delete", CMD_DELETE_CHUNK);
+        instance.AddCounter("Delete Chunks", CMD_DELETE_CHUNKS);
         instance.AddCounter("Truncate", CMD_TRUNCATE_CHUNK);
         instance.AddCounter("Replicate", CMD_REPLICATE_CHUNK);
         instance.AddCounter("Heartbeat", CMD_HEARTBEAT);
@@ -201,6 +203,9 @@ SubmitOpResponse(KfsOp *op)
 }
 
 int64_t KfsOp::sOpsCount = 0;
+kfsSeq_t HeartbeatOp::sPrevSeq = -1;
+HeartbeatOp::Counter HeartbeatOp::sPrevCounters[CS_HB_COUNTERS_COUNT];
+bool HeartbeatOp::sSchemaMismatchFlag = false;
 
 KfsOp::~KfsOp()
 {
@@ -240,6 +245,7 @@ MakeRequestHandler()
     .MakeParser<GetChunkMetadataOp      >("GET_CHUNK_METADATA")
     .MakeParser<AllocChunkOp            >("ALLOCATE")
     .MakeParser<DeleteChunkOp           >("DELETE")
+    .MakeParser<DeleteChunksOp          >("DELETE_CHUNKS")
     .MakeParser<TruncateChunkOp         >("TRUNCATE")
     .MakeParser<ReplicateChunkOp        >("REPLICATE")
     .MakeParser<HeartbeatOp             >("HEARTBEAT")
@@ -253,6 +259,13 @@ MakeRequestHandler()
     .MakeParser<StatsOp                 >("STATS")
     .MakeParser<SetProperties           >("CMD_SET_PROPERTIES")
     .MakeParser<RestartChunkServerOp    >("RESTART_CHUNK_SERVER")
+    // Short rpc format data ops, the names must be lower case, see
+    // KfsOp::ValidateRequestHeader().
+    .MakeShortParser<ReadOp             >("rd")
+    .MakeShortParser<WriteIdAllocOp     >("wa")
+    .MakeShortParser<WritePrepareOp     >("wp")
+    .MakeShortParser<WriteSyncOp        >("ws")
+    .MakeShortParser<RecordAppendOp     >("ra")
     ;
 }
 static const ChunkRequestHandler& sRequestHandler = MakeRequestHandler();
@@ -348,7 +361,9 @@ WriteSyncOp::Validate()
     checksums.reserve(checksumsCnt);
     for (int i = 0; i < checksumsCnt; i++) {
         uint32_t cksum = 0;
-        if (! ValueParser::ParseInt(ptr, end - ptr, cksum)) {
+        if (! (shortRpcFormatFlag ?
+                HexValueParser::ParseInt(ptr, end - ptr, cksum) :
+                ValueParser::ParseInt(ptr, end - ptr, cksum))) {
             return false;
         }
         checksums.push_back(cksum);
@@ -826,6 +841,57 @@ DeleteChunkOp::Execute()
     gLogger.Submit(this);
 }
 
+bool
+DeleteChunksOp::ParseContent(istream& is)
+{
+    if (status != 0) {
+        return false;
+    }
+    kfsChunkId_t c = -1;
+    chunkIds.reserve(max(0, numChunks));
+    const istream::fmtflags isFlags = is.flags();
+    if (hexFormatFlag) {
+        is >> hex;
+    }
+    for(int i = 0; i < numChunks; ++i) {
+        if (! (is >> c)) {
+            ostringstream os;
+            os <<
+                "failed to parse delete chunks request:"
+                " expected: "   << numChunks <<
+                " got: "        << i <<
+                " last chunk: " << c
+            ;
+            statusMsg = os.str();
+            status = -EINVAL;
+            break;
+        }
+        chunkIds.push_back(c);
+    }
+    is.flags(isFlags);
+    return (status == 0);
+}
+
+void
+DeleteChunksOp::Execute()
+{
+    status = 0;
+    for (ChunkIds::const_iterator it = chunkIds.begin();
+            it != chunkIds.end();
+            ++it) {
+        const int ret = gChunkManager.DeleteChunk(*it);
+        if (ret < 0) {
+            failedChunks.push_back(make_pair(*it, ret));
+        }
+    }
+    KFS_LOG_STREAM_INFO << "delete chunks: " <<
+        (chunkIds.empty() ? kfsChunkId_t(-1) : chunkIds.front()) <<
+        " count: "  << chunkIds.size() <<
+        " failed: " << failedChunks.size() <<
+    KFS_LOG_EOM;
+    gLogger.Submit(this);
+}
+
 void
 TruncateChunkOp::Execute()
 {
@@ -979,11 +1045,86 @@ ChangeChunkVersOp::HandleChunkMetaWriteDone(int code, void* data)
     return 0;
 }
 
+template<typename T> inline static HeartbeatOp::Counter
+HeartbeatCounterValue(T val, int scale)
+{
+    return ((HeartbeatOp::Counter)val * scale);
+}
+
+inline static HeartbeatOp::Counter
+HeartbeatCounterValue(double val, int scale)
+{
+    const double scaled = val * scale;
+    return (HeartbeatOp::Counter)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+}
+
+bool
+HeartbeatOp::IsNextCounter(const char* key) const
+{
+    return (key ?
+        (hbCount < CS_HB_COUNTERS_COUNT &&
+            strcmp(ChunkServerHeartbeat::GetName(hbCount), key) == 0) :
+        hbCount == CS_HB_COUNTERS_COUNT
+    );
+}
+
+void
+HeartbeatOp::SchemaMismatch(const char* key)
+{
+    // The counters must be appended in the schema order, otherwise the meta
+    // server would attribute the values to the wrong counters. Disable the
+    // binary heartbeat, and convert the counters appended so far into text.
+    const char* const name = ChunkServerHeartbeat::GetName(hbCount);
+    KFS_LOG_STREAM_ERROR <<
+        "heartbeat schema mismatch:"
+        " position: " << hbCount <<
+        " counter: "  << (key  ? key  : "end") <<
+        " expected: " << (name ? name : "end") <<
+        " disabling binary heartbeat" <<
+    KFS_LOG_EOM;
+    sSchemaMismatchFlag = true;
+    hbBinaryFlag        = false;
+    for (int i = 0; i < hbCount; i++) {
+        response << ChunkServerHeartbeat::GetName(i) << ": ";
+        const int scale = ChunkServerHeartbeat::GetScale(i);
+        if (scale == 1) {
+            response << hbCounters[i];
+        } else {
+            response << (double)hbCounters[i] / scale;
+        }
+        response << "\r\n";
+    }
+    hbCount = 0;
+}
+
+void
+HeartbeatOp::Encode()
+{
+    // Delta encode if the meta server has the previous heartbeat.
+    const bool deltaFlag = 0 <= hbBaseSeq && hbBaseSeq == sPrevSeq;
+    char       buf[ChunkServerHeartbeat::kMaxEncodedSize];
+    const int  len = ChunkServerHeartbeat::Encode(
+        hbCounters, deltaFlag ? sPrevCounters : 0, hbCount, buf);
+    hbContent.assign(buf, len);
+    memcpy(sPrevCounters, hbCounters, sizeof(hbCounters[0]) * hbCount);
+    sPrevSeq = seq;
+    cmdShow << " hb-bytes: " << len << (deltaFlag ? " delta" : "");
+}
+
 template<typename T> void
 HeartbeatOp::Append(const char* key1, const char* key2, T val)
 {
     if (key1 && *key1) {
-        response << key1 << ": " << val << "\r\n";
+        if (hbBinaryFlag && ! IsNextCounter(key1)) {
+            SchemaMismatch(key1);
+        }
+        if (hbBinaryFlag) {
+            hbCounters[hbCount] = HeartbeatCounterValue(
+                val, ChunkServerHeartbeat::GetScale(hbCount));
+            hbCount++;
+        } else {
+            response << key1 << ": " << val << "\r\n";
+        }
     }
     if (key2 && *key2) {
         cmdShow  << " " << key2 << ": " << val;
@@ -999,6 +1140,9 @@ HeartbeatOp::Execute()
     getloadavg(loadavg, 3);
 #endif
     gChunkManager.MetaHeartbeat(*this);
+    hbBinaryFlag = ! sSchemaMismatchFlag &&
+        ChunkServerHeartbeat::kSchemaVersion <= hbFormat;
+    hbCount      = 0;
 
     const int64_t writeCount       = gChunkManager.GetNumWritableChunks();
     const int64_t writeAppendCount = gAtomicRecordAppendManager.GetOpenAppendersCount();
@@ -1058,6 +1202,10 @@ HeartbeatOp::Execute()
     Append("Chunk-open-errors",   "open", cm.mOpenErrorCount);
     Append("Dir-chunk-lost",      "dce",  cm.mDirLostChunkCount);
     Append("Chunk-dir-lost",      "cdl",  cm.mChunkDirLostCount);
+    cmdShow << " scrub:";
+    Append("Scrub-chunks",        "chk",  cm.mScrubChunkCount);
+    Append("Scrub-bytes",         "byt",  cm.mScrubByteCount);
+    Append("Scrub-passes",        "pas",  cm.mScrubPassCount);
 
     MetaServerSM::Counters mc;
     gMetaServerSM.GetCounters(mc);
@@ -1117,6 +1265,8 @@ HeartbeatOp::Execute()
     cmdShow << " repl:";
     Append("WAppend-replication-errors",   "err", wa.mReplicationErrorCount);
     Append("WAppend-replication-tiemouts", "tmo", wa.mReplicationTimeoutCount);
+    Append("WAppend-replication-batches",  "cnt", wa.mReplicationBatchCount);
+    Append("WAppend-replication-batched",  "ops", wa.mReplicationBatchAppendCount);
     cmdShow << " alloc:";
     Append("WAppend-alloc-count",        "cnt", wa.mAppenderAllocCount);
     Append("WAppend-alloc-master-count", "mas", wa.mAppenderAllocMasterCount);
@@ -1223,6 +1373,9 @@ HeartbeatOp::Execute()
     Append("Replication-errors", "err",    replCntrs.mReplicationErrorCount);
     Append("Replication-cancel", "cancel", replCntrs.mReplicationCanceledCount);
     Append("Replicator-count",   "obj",    replCntrs.mReplicatorCount);
+    Append("Replication-throttled",       "thr",  replCntrs.mThrottledCount);
+    Append("Replication-throttled-usec",  "thru", replCntrs.mThrottledUsecs);
+    Append("Replication-capacity",        "cap",  Replicator::GetCapacity());
     cmdShow << " recov:";
     Append("Recovery-count",  "cnt",    replCntrs.mRecoveryCount);
     Append("Recovery-errors", "err",    replCntrs.mRecoveryErrorCount);
@@ -1237,7 +1390,16 @@ HeartbeatOp::Execute()
     Append("Disk-bytes-read",  "drd",  globals().ctrDiskBytesRead.GetValue());
     Append("Disk-bytes-write", "dwr",  globals().ctrDiskBytesWritten.GetValue());
     Append("Total-ops-count",  "ops",  KfsOp::GetOpsCount());
+    cmdShow <<  " punch:";
+    Append("Disk-punch-hole-count",  "cnt", dio.mPunchHoleCount);
+    Append("Disk-punch-hole-errors", "err", dio.mPunchHoleErrorCount);
 
+    if (hbBinaryFlag && ! IsNextCounter(0)) {
+        SchemaMismatch(0);
+    }
+    if (hbBinaryFlag) {
+        Encode();
+    }
     status = 0;
     gLogger.Submit(this);
 }
@@ -1468,6 +1630,7 @@ WriteIdAllocOp::ForwardToPeer(const ServerLocation& loc)
     }
     fwdedOp = new WriteIdAllocOp(0, *this);
     fwdedOp->writePrepareReplyFlag = false; // set by the next one in the chain.
+    fwdedOp->appendBatchFlag       = false; // set by the next one in the chain.
     // When forwarded op completes, call this op HandlePeerReply.
     fwdedOp->clnt = this;
     SET_HANDLER(this, &WriteIdAllocOp::HandlePeerReply);
@@ -1492,6 +1655,14 @@ WriteIdAllocOp::HandlePeerReply(int code, void *data)
     writeIdStr += " " + fwdedOp->writeIdStr;
     writePrepareReplyFlag =
         writePrepareReplyFlag && fwdedOp->writePrepareReplyFlag;
+    if (isForRecordAppend) {
+        // Write id allocation is the record append replication handshake:
+        // the write master batches the appends replication only if all
+        // servers down the chain support batches.
+        appendBatchFlag = appendBatchFlag && fwdedOp->appendBatchFlag;
+        gAtomicRecordAppendManager.SetReplicationBatchFlag(
+            chunkId, appendBatchFlag);
+    }
     ReadChunkMetadata();
     return 0;
 }
@@ -2048,7 +2219,7 @@ GetChunkMetadataOp::HandleChunkMetaReadDone(int code, void *data)
         status = -EBADF;
     }
 
-    if (status < 0 || ! readVerifyFlag) {
+    if (status < 0 || ! readVerifyFlag || chunkSize <= 0) {
         gLogger.Submit(this);
         return 0;
     }
@@ -2098,7 +2269,9 @@ GetChunkMetadataOp::HandleScrubReadDone(int code, void *data)
             readOp.dataBuf->Trim(readOp.numBytes);
         }
         // verify checksum
-        gChunkManager.ReadChunkDone(&readOp);
+        if (! gChunkManager.ReadChunkDone(&readOp)) {
+            return 0; // Retry.
+        }
         status = readOp.status;
         if (status == 0) {
             KFS_LOG_STREAM_DEBUG << "scrub read succeeded"
@@ -2169,6 +2342,7 @@ StatsOp::Execute()
     os << "Num aios: " << 0 << "\r\n";
     os << "Num ops: " << gChunkServer.GetNumOps() << "\r\n";
     globals().counterManager.Show(os);
+    DiskIo::GetBufferManager().ShowTenants(os);
     stats = os.str();
     status = 0;
     // clnt->HandleEvent(EVENT_CMD_DONE, this);
@@ -2178,13 +2352,24 @@ StatsOp::Execute()
 inline static bool
 OkHeader(const KfsOp* op, ostream &os, bool checkStatus = true)
 {
-    os << "OK\r\n";
-    os << "Cseq: " << op->seq << "\r\n";
-    os << "Status: " << op->status << "\r\n";
+    if (op->shortRpcFormatFlag) {
+        os << "OK\r\n"
+            "c: " << HexIntFmt(op->seq)    << "\r\n"
+            "s: " << HexIntFmt(op->status) << "\r\n";
+    } else {
+        os << "OK\r\n";
+        os << "Cseq: " << op->seq << "\r\n";
+        os << "Status: " << op->status << "\r\n";
+        if (0 < op->shortRpcFormatOfferVers) {
+            // Acknowledge the short format with the version to use.
+            os << "Short-rpc-fmt: " << min(op->shortRpcFormatOfferVers,
+                KFS_SHORT_RPC_FORMAT_VERS) << "\r\n";
+        }
+    }
     if (! op->statusMsg.empty()) {
         const size_t p = op->statusMsg.find('\r');
         assert(string::npos == p && op->statusMsg.find('\n') == string::npos);
-        os << "Status-message: " <<
+        os << (op->shortRpcFormatFlag ? "m: " : "Status-message: ") <<
             (p == string::npos ? op->statusMsg : op->statusMsg.substr(0, p)) <<
         "\r\n";
     }
@@ -2235,6 +2420,24 @@ void
 ReadOp::Response(ostream &os)
 {
     PutHeader(this, os);
+    if (shortRpcFormatFlag) {
+        os << "d: " << driveName << "\r\n";
+        if (status < 0) {
+            os << "\r\n";
+            return;
+        }
+        os << "D: " << (diskIOTime * 1e-6) << "\r\n";
+        if (! checksum.empty()) {
+            os << "E: " << HexIntFmt(checksum.size()) << "\r\n"
+                "C:";
+            for (uint32_t i = 0; i < checksum.size(); i++) {
+                os << ' ' << HexIntFmt(checksum[i]);
+            }
+            os << "\r\n";
+        }
+        os << "l: " << HexIntFmt(numBytesIO) << "\r\n\r\n";
+        return;
+    }
     os << "Drivename: " << driveName << "\r\n";
     if (status < 0) {
         os << "\r\n";
@@ -2260,9 +2463,20 @@ WriteIdAllocOp::Response(ostream &os)
     if (! OkHeader(this, os)) {
         return;
     }
+    if (shortRpcFormatFlag) {
+        if (writePrepareReplyFlag) {
+            os << "P: 1\r\n";
+        }
+        os << "W: " << writeIdStr << "\r\n"
+        "\r\n";
+        return;
+    }
     if (writePrepareReplyFlag) {
         os << "Write-prepare-reply: 1\r\n";
     }
+    if (isForRecordAppend && appendBatchFlag) {
+        os << "Append-batch-repl: 1\r\n";
+    }
     os << "Write-id: " << writeIdStr <<  "\r\n"
     "\r\n";
 }
@@ -2283,6 +2497,10 @@ RecordAppendOp::Response(ostream &os)
     if (! OkHeader(this, os)) {
         return;
     }
+    if (shortRpcFormatFlag) {
+        os << "F: " << HexIntFmt(fileOffset) << "\r\n\r\n";
+        return;
+    }
     os << "File-offset: " << fileOffset << "\r\n\r\n";
 }
 
@@ -2303,7 +2521,14 @@ RecordAppendOp::Request(ostream &os)
         "Client-cseq: "      << clientSeq             << "\r\n"
         "Servers: "          << servers               << "\r\n"
         "Master-committed: " << masterCommittedOffset << "\r\n"
-    "\r\n";
+    ;
+    if (appendBatchCount > 0) {
+        os <<
+        "Append-batch-count: " << appendBatchCount << "\r\n"
+        "Append-batch: "       << appendBatch      << "\r\n"
+        ;
+    }
+    os << "\r\n";
 }
 
 void
@@ -2466,9 +2691,41 @@ HeartbeatOp::Response(ostream &os)
     if (! OkHeader(this, os)) {
         return;
     }
+    if (hbBinaryFlag) {
+        os <<
+            "Hb-fmt: "         << ChunkServerHeartbeat::kSchemaVersion << "\r\n"
+            "Content-length: " << hbContent.size() << "\r\n"
+        "\r\n";
+        os.write(hbContent.data(), hbContent.size());
+        return;
+    }
     os << response.str() << "\r\n";
 }
 
+void
+DeleteChunksOp::Response(ostream &os)
+{
+    if (! OkHeader(this, os)) {
+        return;
+    }
+    os << "Num-failed: " << failedChunks.size() << "\r\n";
+    if (failedChunks.empty()) {
+        os << "\r\n";
+        return;
+    }
+    // Chunk id and status pairs, chunk ids are in hex.
+    ostringstream content;
+    content << hex;
+    for (FailedChunks::const_iterator it = failedChunks.begin();
+            it != failedChunks.end();
+            ++it) {
+        content << it->first << " " << dec << it->second << hex << "\n";
+    }
+    const string str = content.str();
+    os << "Content-length: " << str.size() << "\r\n\r\n";
+    os.write(str.data(), str.size());
+}
+
 void
 ReplicateChunkOp::Response(ostream &os)
 {
@@ -2776,6 +3033,7 @@ HelloMetaOp::Request(ostream &os)
             gAtomicRecordAppendManager.GetAppendersWithWidCount() << "\r\n"
         "Num-re-replications: " << Replicator::GetNumReplications() << "\r\n"
         "Stale-chunks-hex-format: 1\r\n"
+        "Bulk-delete: 1\r\n"
         "Content-int-base: 16\r\n"
     ;
     ostringstream chunkInfo;
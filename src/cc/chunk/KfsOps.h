@@ -37,6 +37,7 @@
 #include "common/kfsdecls.h"
 #include "common/time.h"
 #include "common/StBuffer.h"
+#include "common/ChunkServerHeartbeat.h"
 #include "Chunk.h"
 #include "DiskIo.h"
 #include "RemoteSyncSM.h"
@@ -51,6 +52,7 @@
 #include <vector>
 #include <set>
 #include <list>
+#include <utility>
 
 namespace KFS
 {
@@ -59,6 +61,7 @@ using std::string;
 using std::vector;
 using std::set;
 using std::list;
+using std::pair;
 using std::ostream;
 using std::istream;
 using std::ostringstream;
@@ -68,6 +71,7 @@ enum KfsOp_t {
     // Meta server->Chunk server ops
     CMD_ALLOC_CHUNK,
     CMD_DELETE_CHUNK,
+    CMD_DELETE_CHUNKS,
     CMD_TRUNCATE_CHUNK,
     CMD_REPLICATE_CHUNK,
     CMD_CHANGE_CHUNK_VERS,
@@ -144,6 +148,9 @@ struct KfsOp : public KfsCallbackObj {
     bool            noReply:1;
     bool            noRetry:1;
     bool            clientSMFlag:1;
+    bool            shortRpcFormatFlag:1; // request and response short format
+    int             shortRpcFormatOfferVers; // client short format version
+    StringBufT<32>  tenant; // qos tenant name, the buffer manager scheduling
     string          statusMsg; // output, optional, mostly for debugging
     KfsCallbackObj* clnt;
     // keep statistics
@@ -159,6 +166,9 @@ struct KfsOp : public KfsCallbackObj {
           noReply(false),
           noRetry(false),
           clientSMFlag(false),
+          shortRpcFormatFlag(false),
+          shortRpcFormatOfferVers(0),
+          tenant(),
           statusMsg(),
           clnt(c),
           startTime(microseconds())
@@ -201,6 +211,9 @@ struct KfsOp : public KfsCallbackObj {
         bool        hasChecksum,
         uint32_t    checksum)
     {
+        // Short rpc format request names are lower case, all other request
+        // names are upper case.
+        shortRpcFormatFlag = nameLen > 0 && 'a' <= *name && *name <= 'z';
         return (! hasChecksum ||
                 Checksum(name, nameLen, header, headerLen) == checksum);
     }
@@ -214,7 +227,36 @@ struct KfsOp : public KfsCallbackObj {
     template<typename T> static T& ParserDef(T& parser)
     {
         return parser
-        .Def("Cseq", &KfsOp::seq, kfsSeq_t(-1))
+        .Def("Cseq",          &KfsOp::seq,                     kfsSeq_t(-1))
+        .Def("Short-rpc-fmt", &KfsOp::shortRpcFormatOfferVers, 0)
+        .Def("Tenant",        &KfsOp::tenant)
+        ;
+    }
+    // Short rpc format is used by the clients for the chunk data ops: read,
+    // write id alloc, write prepare, write sync, and record append.
+    //
+    // Handshake: the client sends "Short-rpc-fmt: <version>" text request
+    // header with these ops. The server responds with the min of the client
+    // and its own version, KFS_SHORT_RPC_FORMAT_VERS. The client switches
+    // the connection to the short format once it receives a version that it
+    // supports, and back to text format on connection reset. The clients and
+    // servers that do not know the header keep using text format.
+    //
+    // Format, version 1: the request names are lower case, the keys are one
+    // letter, integers are hex, with negative values represented as minus
+    // sign followed by the magnitude, checksum vectors are space separated
+    // hex. The "\r\n\r\n" framing is the same as text format.
+    //
+    // This is deliberately not a fixed layout binary header. Keeping the
+    // framing lets ClientSM, the in place request parser, and the io buffer
+    // handling to stay format agnostic, with no separate code path per
+    // format. The measured parsing cost was in the long keys, decimal
+    // conversion, and unused fields, which the short format removes. A
+    // binary format can be introduced later as the next version.
+    template<typename T> static T& ShortParserDef(T& parser)
+    {
+        return parser
+        .Def("c", &KfsOp::seq, kfsSeq_t(-1))
         ;
     }
 private:
@@ -433,6 +475,45 @@ struct DeleteChunkOp : public KfsOp {
     }
 };
 
+// Bulk delete: deletes the chunks listed in the request content, and replies
+// with the status of the chunks that failed to delete.
+struct DeleteChunksOp : public KfsOp {
+    typedef vector<kfsChunkId_t>          ChunkIds;
+    typedef vector<pair<kfsChunkId_t, int> > FailedChunks;
+    int          contentLength;
+    int          numChunks;
+    bool         hexFormatFlag;
+    ChunkIds     chunkIds;     // input
+    FailedChunks failedChunks; // output
+    DeleteChunksOp(kfsSeq_t s = 0)
+        : KfsOp(CMD_DELETE_CHUNKS, s),
+          contentLength(0),
+          numChunks(0),
+          hexFormatFlag(false),
+          chunkIds(),
+          failedChunks()
+        {}
+    void Execute();
+    void Response(ostream &os);
+    string Show() const {
+        ostringstream os;
+
+        os << "delete-chunks: count: " << numChunks <<
+            " failed: " << failedChunks.size();
+        return os.str();
+    }
+    virtual int GetContentLength() const { return contentLength; }
+    virtual bool ParseContent(istream& is);
+    template<typename T> static T& ParserDef(T& parser)
+    {
+        return KfsOp::ParserDef(parser)
+        .Def("Content-length", &DeleteChunksOp::contentLength)
+        .Def("Num-chunks",     &DeleteChunksOp::numChunks)
+        .Def("HexFormat",      &DeleteChunksOp::hexFormatFlag, false)
+        ;
+    }
+};
+
 struct TruncateChunkOp : public KfsOp {
     kfsChunkId_t chunkId;  // input
     size_t       chunkSize; // size to which file should be truncated to
@@ -548,12 +629,24 @@ struct ReplicateChunkOp : public KfsOp {
 };
 
 struct HeartbeatOp : public KfsOp {
+    typedef ChunkServerHeartbeat::Counter Counter;
     int64_t       metaEvacuateCount; // input
+    int           hbFormat;  // input: max. binary heartbeat schema version
+    kfsSeq_t      hbBaseSeq; // input: delta encoding base heartbeat sequence
+    bool          hbBinaryFlag;
+    int           hbCount;
+    Counter       hbCounters[CS_HB_COUNTERS_COUNT];
+    string        hbContent;
     ostringstream response;
     ostringstream cmdShow;
     HeartbeatOp(kfsSeq_t s = 0)
         : KfsOp(CMD_HEARTBEAT, s),
           metaEvacuateCount(-1),
+          hbFormat(0),
+          hbBaseSeq(-1),
+          hbBinaryFlag(false),
+          hbCount(0),
+          hbContent(),
           response(),
           cmdShow()
         { cmdShow << "meta-heartbeat:"; }
@@ -567,8 +660,20 @@ struct HeartbeatOp : public KfsOp {
     {
         return KfsOp::ParserDef(parser)
         .Def("Num-evacuate", &HeartbeatOp::metaEvacuateCount, int64_t(-1))
+        .Def("Hb-fmt",       &HeartbeatOp::hbFormat,          0)
+        .Def("Hb-base",      &HeartbeatOp::hbBaseSeq,         kfsSeq_t(-1))
         ;
     }
+private:
+    // The last binary heartbeat sent, used as delta encoding base.
+    static kfsSeq_t sPrevSeq;
+    static Counter  sPrevCounters[CS_HB_COUNTERS_COUNT];
+    // Set on the first counters order mismatch, disables binary heartbeat.
+    static bool     sSchemaMismatchFlag;
+
+    bool IsNextCounter(const char* key) const;
+    void SchemaMismatch(const char* key);
+    void Encode();
 };
 
 struct StaleChunksOp : public KfsOp {
@@ -723,6 +828,8 @@ struct RecordAppendOp : public KfsOp {
     uint32_t       checksum;              /* input: as computed by the sender; 0 means sender didn't send */
     string         servers;               /* input: set of servers on which to write */
     int64_t        masterCommittedOffset; /* input piggy back master's ack to slave */
+    int            appendBatchCount;      /* input: number of appends in replication batch */
+    string         appendBatch;           /* input: per append length, client seq, and write ids */
     StringBufT<32> clientSeqStr;
     IOBuffer       dataBuf;               /* buffer with the data to be written */
     /*
@@ -732,6 +839,12 @@ struct RecordAppendOp : public KfsOp {
     KfsCallbackObj* origClnt;
     kfsSeq_t        origSeq;
     time_t          replicationStartTime;
+    /*
+     * write master replication batch: the batch op points to the list of
+     * the appends it replicates, the appends are linked with batchNext.
+     */
+    RecordAppendOp* batchHead;
+    RecordAppendOp* batchNext;
     RecordAppendOp* mPrevPtr[1];
     RecordAppendOp* mNextPtr[1];
 
@@ -756,6 +869,21 @@ struct RecordAppendOp : public KfsOp {
         .Def("Checksum",         &RecordAppendOp::checksum)
         .Def("Client-cseq",      &RecordAppendOp::clientSeqStr)
         .Def("Master-committed", &RecordAppendOp::masterCommittedOffset, int64_t(-1))
+        .Def("Append-batch-count", &RecordAppendOp::appendBatchCount,  int(0))
+        .Def("Append-batch",       &RecordAppendOp::appendBatch)
+        ;
+    }
+    template<typename T> static T& ShortParserDef(T& parser)
+    {
+        return KfsOp::ShortParserDef(parser)
+        .Def("H", &RecordAppendOp::chunkId,      kfsChunkId_t(-1))
+        .Def("V", &RecordAppendOp::chunkVersion, int64_t(-1))
+        .Def("O", &RecordAppendOp::offset,       int64_t(-1))
+        .Def("F", &RecordAppendOp::fileOffset,   int64_t(-1))
+        .Def("B", &RecordAppendOp::numBytes)
+        .Def("R", &RecordAppendOp::numServers)
+        .Def("S", &RecordAppendOp::servers)
+        .Def("K", &RecordAppendOp::checksum)
         ;
     }
 };
@@ -846,6 +974,7 @@ struct WriteIdAllocOp : public KfsOp {
     WriteIdAllocOp* fwdedOp;           /* if we did any fwd'ing, this is the op that tracks it */
     bool            isForRecordAppend; /* set if the write-id-alloc is for a record append that will follow */
     bool            writePrepareReplyFlag; /* write prepare reply supported */
+    bool            appendBatchFlag;   /* record append replication batches supported down the chain */
     StringBufT<32>  clientSeqStr;
     RemoteSyncSMPtr appendPeer;
 
@@ -863,6 +992,7 @@ struct WriteIdAllocOp : public KfsOp {
           fwdedOp(0),
           isForRecordAppend(false),
           writePrepareReplyFlag(true),
+          appendBatchFlag(true),
           clientSeqStr(),
           appendPeer()
     {
@@ -881,6 +1011,7 @@ struct WriteIdAllocOp : public KfsOp {
           fwdedOp(0),
           isForRecordAppend(other.isForRecordAppend),
           writePrepareReplyFlag(other.writePrepareReplyFlag),
+          appendBatchFlag(other.appendBatchFlag),
           clientSeqStr(),
           appendPeer()
         {}
@@ -927,6 +1058,18 @@ struct WriteIdAllocOp : public KfsOp {
         .Def("Write-prepare-reply", &WriteIdAllocOp::writePrepareReplyFlag)
         ;
     }
+    template<typename T> static T& ShortParserDef(T& parser)
+    {
+        return KfsOp::ShortParserDef(parser)
+        .Def("H", &WriteIdAllocOp::chunkId,           kfsChunkId_t(-1))
+        .Def("V", &WriteIdAllocOp::chunkVersion,      int64_t(-1))
+        .Def("O", &WriteIdAllocOp::offset)
+        .Def("B", &WriteIdAllocOp::numBytes)
+        .Def("R", &WriteIdAllocOp::numServers)
+        .Def("S", &WriteIdAllocOp::servers)
+        .Def("A", &WriteIdAllocOp::isForRecordAppend, false)
+        ;
+    }
 };
 
 struct WritePrepareOp : public KfsOp {
@@ -994,6 +1137,19 @@ struct WritePrepareOp : public KfsOp {
         .Def("Reply",         &WritePrepareOp::replyRequestedFlag)
         ;
     }
+    template<typename T> static T& ShortParserDef(T& parser)
+    {
+        return KfsOp::ShortParserDef(parser)
+        .Def("H", &WritePrepareOp::chunkId,      kfsChunkId_t(-1))
+        .Def("V", &WritePrepareOp::chunkVersion, int64_t(-1))
+        .Def("O", &WritePrepareOp::offset)
+        .Def("B", &WritePrepareOp::numBytes)
+        .Def("R", &WritePrepareOp::numServers)
+        .Def("S", &WritePrepareOp::servers)
+        .Def("K", &WritePrepareOp::checksum)
+        .Def("P", &WritePrepareOp::replyRequestedFlag)
+        ;
+    }
 };
 
 struct WritePrepareFwdOp : public KfsOp {
@@ -1176,6 +1332,19 @@ struct WriteSyncOp : public KfsOp {
         .Def("Checksums",        &WriteSyncOp::checksumsStr)
         ;
     }
+    template<typename T> static T& ShortParserDef(T& parser)
+    {
+        return KfsOp::ShortParserDef(parser)
+        .Def("H", &WriteSyncOp::chunkId,      kfsChunkId_t(-1))
+        .Def("V", &WriteSyncOp::chunkVersion, int64_t(-1))
+        .Def("O", &WriteSyncOp::offset)
+        .Def("B", &WriteSyncOp::numBytes)
+        .Def("R", &WriteSyncOp::numServers)
+        .Def("S", &WriteSyncOp::servers)
+        .Def("E", &WriteSyncOp::checksumsCnt)
+        .Def("C", &WriteSyncOp::checksumsStr)
+        ;
+    }
 };
 
 struct ReadChunkMetaOp : public KfsOp {
@@ -1309,6 +1478,15 @@ struct ReadOp : public KfsOp {
         .Def("Num-bytes",        &ReadOp::numBytes)
         ;
     }
+    template<typename T> static T& ShortParserDef(T& parser)
+    {
+        return KfsOp::ShortParserDef(parser)
+        .Def("H", &ReadOp::chunkId,      kfsChunkId_t(-1))
+        .Def("V", &ReadOp::chunkVersion, int64_t(-1))
+        .Def("O", &ReadOp::offset)
+        .Def("B", &ReadOp::numBytes)
+        ;
+    }
 };
 
 // used for retrieving a chunk's size
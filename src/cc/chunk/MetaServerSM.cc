@@ -72,7 +72,8 @@ MetaServerSM::MetaServerSM()
       mConnectedTime(0),
       mReconnectFlag(false),
       mCounters(),
-      mWOStream()
+      mWOStream(),
+      mReplyProperties()
 {
     // Force net manager construction here, to insure that net manager
     // destructor is called after gMetaServerSM destructor.
@@ -460,12 +461,9 @@ MetaServerSM::HandleMsg(IOBuffer *iobuf, int msgLen)
 bool
 MetaServerSM::HandleReply(IOBuffer *iobuf, int msgLen)
 {
-    Properties prop;
-    {
-        IOBuffer::IStream is(*iobuf, msgLen);
-        const char separator = ':';
-        prop.loadProperties(is, separator, false);
-    }
+    Properties& prop = mReplyProperties;
+    prop.clear();
+    LoadProperties(*iobuf, msgLen, prop);
     iobuf->Consume(msgLen);
 
     const kfsSeq_t seq    = prop.getValue("Cseq",  (kfsSeq_t)-1);
@@ -37,6 +37,7 @@
 #include "kfsio/NetConnection.h"
 #include "kfsio/IOBuffer.h"
 #include "common/StdAllocator.h"
+#include "common/Properties.h"
 
 #include <map>
 #include <deque>
@@ -50,7 +51,6 @@ using std::deque;
 using std::map;
 
 class MetaServerSMTimeoutImpl;
-class Properties;
 
 class MetaServerSM : public KfsCallbackObj, private ITimeout {
 public:
@@ -206,6 +206,8 @@ private:
     bool               mReconnectFlag;
     Counters           mCounters;
     IOBuffer::WOStream mWOStream;
+    /// Reply header, re-used to parse replies without allocations.
+    Properties         mReplyProperties;
 
     /// Connect to the meta server
     /// @retval 0 if connect was successful; -1 otherwise
@@ -310,11 +310,7 @@ RemoteSyncSM::HandleResponse(IOBuffer *iobuf, int msgLen)
             }
         }
         Properties prop;
-        {
-            const char separator(':');
-            IOBuffer::IStream is(*iobuf, msgLen);
-            prop.loadProperties(is, separator, false);
-        }
+        LoadProperties(*iobuf, msgLen, prop);
         iobuf->Consume(msgLen);
         mReplySeqNum = prop.getValue("Cseq", (kfsSeq_t) -1);
         if (mReplySeqNum < 0) {
@@ -335,6 +331,8 @@ RemoteSyncSM::HandleResponse(IOBuffer *iobuf, int msgLen)
                 wiao->writeIdStr            = prop.getValue("Write-id", "");
                 wiao->writePrepareReplyFlag =
                     prop.getValue("Write-prepare-reply", 0) != 0;
+                wiao->appendBatchFlag       =
+                    prop.getValue("Append-batch-repl", 0) != 0;
             } else if (op->op == CMD_READ) {
                 ReadOp *rop = static_cast<ReadOp *> (op);
                 const int checksumEntries = prop.getValue("Checksum-entries", 0);
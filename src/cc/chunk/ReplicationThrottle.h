@@ -0,0 +1,295 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Re-replication and recovery feedback controller.
+// The controller adjusts replication "capacity" with additive increase and
+// multiplicative decrease, using the average client request latency and the
+// average disk queue depth as congestion signals. The capacity is reported to
+// the meta server with the heartbeat, and the meta server scales the number
+// of concurrent replications it hands out to this node accordingly. By
+// default the max. capacity is 1, i.e. the controller can only reduce the
+// replication rate. The max. capacity above 1 allows the meta server to
+// schedule more than the configured number of replications to the node that
+// is not busy.
+// The capacity also scales the replication bandwidth: the replicators wait
+// before issuing the next read while the token bucket is empty.
+//
+// The controller does not depend on the chunk server state, the caller
+// supplies the time and the congestion signals, and runs the timer.
+//
+//----------------------------------------------------------------------------
+
+#ifndef CHUNK_REPLICATION_THROTTLE_H
+#define CHUNK_REPLICATION_THROTTLE_H
+
+#include "common/Properties.h"
+#include "common/MsgLogger.h"
+
+#include <stdint.h>
+
+#include <list>
+#include <utility>
+#include <algorithm>
+
+namespace KFS
+{
+
+using std::list;
+using std::pair;
+using std::make_pair;
+using std::max;
+using std::min;
+
+// T must have Resume() method, invoked when the paused replicator can issue
+// the next read.
+template<typename T>
+class ReplicationThrottleT
+{
+public:
+    ReplicationThrottleT(
+        int64_t now)
+        : mEnabledFlag(true),
+          mIntervalUsecs(2 * 1000 * 1000),
+          mTargetClientLatencyUsecs(50 * 1000),
+          mTargetDiskQueueDepth(32),
+          mMinCapacity(0.1),
+          mMaxCapacity(1),
+          mIncreasePerSec(0.05),
+          mDecreaseFactor(0.5),
+          mMaxBytesPerSec(0),
+          mCapacity(1),
+          mBaseBytesPerSec(0),
+          mBytesPerSec(0),
+          mTokens(0),
+          mLastUpdateUsecs(now),
+          mLastTokensUpdateUsecs(now),
+          mByteCount(0),
+          mPrevByteCount(0),
+          mPrevClientReqCount(0),
+          mPrevClientReqUsecs(0),
+          mClientLatencyUsecs(0),
+          mDiskQueueDepth(0),
+          mWaiting()
+        {}
+    void SetParameters(
+        const Properties& props)
+    {
+        mEnabledFlag = props.getValue(
+            "chunkServer.replicationThrottle.enabled",
+            mEnabledFlag ? 1 : 0) != 0;
+        mIntervalUsecs = (int64_t)(max(0.1, props.getValue(
+            "chunkServer.replicationThrottle.intervalSec",
+            mIntervalUsecs * 1e-6)) * 1e6);
+        mTargetClientLatencyUsecs = props.getValue(
+            "chunkServer.replicationThrottle.targetClientLatencyUsec",
+            mTargetClientLatencyUsecs);
+        mTargetDiskQueueDepth = props.getValue(
+            "chunkServer.replicationThrottle.targetDiskQueueDepth",
+            mTargetDiskQueueDepth);
+        mMinCapacity = max(0.01, props.getValue(
+            "chunkServer.replicationThrottle.minCapacity",
+            mMinCapacity));
+        mMaxCapacity = max(mMinCapacity, props.getValue(
+            "chunkServer.replicationThrottle.maxCapacity",
+            mMaxCapacity));
+        mIncreasePerSec = max(0., props.getValue(
+            "chunkServer.replicationThrottle.increasePerSec",
+            mIncreasePerSec));
+        mDecreaseFactor = min(1., max(0.01, props.getValue(
+            "chunkServer.replicationThrottle.decreaseFactor",
+            mDecreaseFactor)));
+        mMaxBytesPerSec = props.getValue(
+            "chunkServer.replicationThrottle.maxBytesPerSec",
+            mMaxBytesPerSec);
+        mCapacity = mEnabledFlag ?
+            min(mMaxCapacity, max(mMinCapacity, mCapacity)) : 1.;
+        SetBytesPerSec();
+    }
+    double GetCapacity() const
+        { return mCapacity; }
+    double GetBytesPerSec() const
+        { return mBytesPerSec; }
+    bool IsUpdateDue(
+        int64_t now) const
+        { return (mLastUpdateUsecs + mIntervalUsecs <= now); }
+    bool IsWaiting() const
+        { return (! mWaiting.empty()); }
+    // The client request count and time are cumulative, the controller uses
+    // the difference with the previous update to compute the average client
+    // request latency.
+    void Update(
+        int64_t now,
+        int64_t clientReqCount,
+        int64_t clientReqUsecs,
+        double  diskQueueDepth)
+    {
+        if (! IsUpdateDue(now)) {
+            return;
+        }
+        const double elapsed = (now - mLastUpdateUsecs) * 1e-6;
+        mLastUpdateUsecs = now;
+        mClientLatencyUsecs = mPrevClientReqCount < clientReqCount ?
+            (clientReqUsecs - mPrevClientReqUsecs) /
+                (clientReqCount - mPrevClientReqCount) :
+            int64_t(0);
+        mPrevClientReqCount = clientReqCount;
+        mPrevClientReqUsecs = clientReqUsecs;
+        mDiskQueueDepth     = diskQueueDepth;
+        const double bytesPerSec = (mByteCount - mPrevByteCount) / elapsed;
+        mPrevByteCount = mByteCount;
+        if (! mEnabledFlag) {
+            mCapacity = 1;
+            SetBytesPerSec();
+            return;
+        }
+        const double prevCapacity  = mCapacity;
+        const bool   congestedFlag =
+            (0 < mTargetClientLatencyUsecs &&
+                mTargetClientLatencyUsecs < mClientLatencyUsecs) ||
+            (0 < mTargetDiskQueueDepth &&
+                mTargetDiskQueueDepth < mDiskQueueDepth);
+        if (congestedFlag) {
+            if (mBytesPerSec <= 0 && mMaxBytesPerSec <= 0) {
+                mBaseBytesPerSec = bytesPerSec;
+            }
+            mCapacity = max(mMinCapacity, mCapacity * mDecreaseFactor);
+        } else {
+            mCapacity = min(mMaxCapacity,
+                mCapacity + mIncreasePerSec * elapsed);
+        }
+        SetBytesPerSec();
+        if (prevCapacity != mCapacity) {
+            KFS_LOG_STREAM(congestedFlag ?
+                    MsgLogger::kLogLevelINFO :
+                    MsgLogger::kLogLevelDEBUG) << "replication throttle:"
+                " capacity: "       << prevCapacity <<
+                " => "              << mCapacity <<
+                " bytes/sec: "      << bytesPerSec <<
+                " limit: "          << mBytesPerSec <<
+                " client latency: " << mClientLatencyUsecs <<
+                " disk queue: "     << mDiskQueueDepth <<
+            KFS_LOG_EOM;
+        }
+    }
+    // Returns true if replicator must wait for Resume() before the next read.
+    bool Pause(
+        T&      repl,
+        int64_t bytes,
+        int64_t now)
+    {
+        mByteCount += max(int64_t(0), bytes);
+        UpdateTokens(now);
+        if (mBytesPerSec <= 0) {
+            return false;
+        }
+        mTokens -= bytes;
+        if (0 <= mTokens && mWaiting.empty()) {
+            return false;
+        }
+        mWaiting.push_back(make_pair(&repl, now));
+        return true;
+    }
+    void Remove(
+        T& repl)
+    {
+        for (typename Waiting::iterator it = mWaiting.begin();
+                it != mWaiting.end();
+                ++it) {
+            if (it->first == &repl) {
+                mWaiting.erase(it);
+                break;
+            }
+        }
+    }
+    // Resumes the waiting replicators in the order they were paused, while
+    // the token bucket is not empty. Returns the total wait time.
+    int64_t Resume(
+        int64_t now)
+    {
+        UpdateTokens(now);
+        int64_t waitUsecs = 0;
+        while (! mWaiting.empty() && (0 <= mTokens || mBytesPerSec <= 0)) {
+            T& repl = *mWaiting.front().first;
+            waitUsecs += max(int64_t(0), now - mWaiting.front().second);
+            mWaiting.pop_front();
+            repl.Resume();
+        }
+        return waitUsecs;
+    }
+private:
+    typedef list<pair<T*, int64_t> > Waiting;
+
+    bool    mEnabledFlag;
+    int64_t mIntervalUsecs;
+    int64_t mTargetClientLatencyUsecs;
+    double  mTargetDiskQueueDepth;
+    double  mMinCapacity;
+    double  mMaxCapacity;
+    double  mIncreasePerSec;
+    double  mDecreaseFactor;
+    double  mMaxBytesPerSec;
+    double  mCapacity;
+    double  mBaseBytesPerSec;
+    double  mBytesPerSec;
+    double  mTokens;
+    int64_t mLastUpdateUsecs;
+    int64_t mLastTokensUpdateUsecs;
+    int64_t mByteCount;
+    int64_t mPrevByteCount;
+    int64_t mPrevClientReqCount;
+    int64_t mPrevClientReqUsecs;
+    int64_t mClientLatencyUsecs;
+    double  mDiskQueueDepth;
+    Waiting mWaiting;
+
+    void SetBytesPerSec()
+    {
+        const double base = mMaxBytesPerSec > 0 ?
+            mMaxBytesPerSec : mBaseBytesPerSec;
+        // With no bandwidth limit configured, pace only while the capacity is
+        // below 1, relative to the replication rate observed when the
+        // congestion started.
+        mBytesPerSec = (base > 0 && (mMaxBytesPerSec > 0 || mCapacity < 1)) ?
+            base * mCapacity : 0.;
+    }
+    void UpdateTokens(
+        int64_t now)
+    {
+        if (mBytesPerSec <= 0) {
+            mTokens                = 0;
+            mLastTokensUpdateUsecs = now;
+            return;
+        }
+        if (mLastTokensUpdateUsecs < now) {
+            // One second burst.
+            mTokens = min(mBytesPerSec, mTokens +
+                (now - mLastTokensUpdateUsecs) * 1e-6 * mBytesPerSec);
+            mLastTokensUpdateUsecs = now;
+        }
+    }
+private:
+    ReplicationThrottleT(const ReplicationThrottleT&);
+    ReplicationThrottleT& operator=(const ReplicationThrottleT&);
+};
+
+} // namespace KFS
+
+#endif /* CHUNK_REPLICATION_THROTTLE_H */
@@ -41,6 +41,8 @@
 #include "Logger.h"
 #include "BufferManager.h"
 #include "DiskIo.h"
+#include "ClientManager.h"
+#include "ReplicationThrottle.h"
 
 #include "common/MsgLogger.h"
 #include "common/StdAllocator.h"
@@ -49,12 +51,14 @@
 #include "kfsio/NetConnection.h"
 #include "kfsio/Globals.h"
 #include "kfsio/checksum.h"
+#include "kfsio/ITimeout.h"
 #include "libclient/KfsNetClient.h"
 #include "libclient/Reader.h"
 #include "libclient/KfsOps.h"
 
 #include <string>
 #include <sstream>
+#include <algorithm>
 
 namespace KFS
 {
@@ -71,6 +75,51 @@ using KFS::libkfsio::globalNetManager;
 using KFS::client::Reader;
 using KFS::client::KfsNetClient;
 
+class ReplicatorImpl;
+
+// Replication throttle: runs the feedback controller with the client manager
+// and disk queue congestion signals, and the timer that resumes the paused
+// replicators.
+class ReplicationThrottle : public ITimeout
+{
+public:
+    static ReplicationThrottle& Instance()
+    {
+        // Never deleted, to avoid destructor running after net manager.
+        static ReplicationThrottle* const sInstancePtr =
+            new ReplicationThrottle();
+        return *sInstancePtr;
+    }
+    void SetParameters(const Properties& props)
+    {
+        mThrottle.SetParameters(props);
+        Timeout();
+    }
+    double GetCapacity()
+    {
+        Update(microseconds());
+        return mThrottle.GetCapacity();
+    }
+    // Returns true if replicator must wait for Resume() before the next read.
+    bool Pause(ReplicatorImpl& repl, int64_t bytes);
+    void Remove(ReplicatorImpl& repl)
+        { mThrottle.Remove(repl); }
+    virtual void Timeout();
+private:
+    ReplicationThrottleT<ReplicatorImpl> mThrottle;
+    bool                                 mRegisteredFlag;
+
+    ReplicationThrottle()
+        : ITimeout(),
+          mThrottle(microseconds()),
+          mRegisteredFlag(false)
+        {}
+    void Update(int64_t now);
+private:
+    ReplicationThrottle(const ReplicationThrottle&);
+    ReplicationThrottle& operator=(const ReplicationThrottle&);
+};
+
 class ReplicatorImpl :
     public KfsCallbackObj,
     public QCRefCountedObj,
@@ -120,6 +169,16 @@ public:
         { return sCounters; };
     static bool GetUseConnectionPoolFlag()
         { return sUseConnectionPoolFlag; }
+    // Replication throttle wait completion.
+    void Resume()
+    {
+        mThrottledFlag = false;
+        if (mCancelFlag) {
+            Terminate();
+        } else {
+            Read();
+        }
+    }
 
 protected:
     // Inputs from the metaserver
@@ -141,6 +200,7 @@ protected:
     // Are we done yet?
     bool               mDone;
     bool               mCancelFlag;
+    bool               mThrottledFlag;
 
     virtual ~ReplicatorImpl();
     // Cleanup...
@@ -157,6 +217,10 @@ protected:
             // Cancel buffers wait, and fail the op.
             CancelRequest();
             Terminate();
+        } else if (mThrottledFlag) {
+            mThrottledFlag = false;
+            ReplicationThrottle::Instance().Remove(*this);
+            Terminate();
         }
     }
     virtual ByteCount GetBufferBytesRequired() const;
@@ -227,7 +291,8 @@ ReplicatorImpl::ReplicatorImpl(ReplicateChunkOp *op, const RemoteSyncSMPtr &peer
     mReadOp(0),
     mWriteOp(op->chunkId, op->chunkVersion),
     mDone(false),
-    mCancelFlag(false)
+    mCancelFlag(false),
+    mThrottledFlag(false)
 {
     mReadOp.chunkId = op->chunkId;
     mReadOp.chunkVersion = op->chunkVersion;
@@ -521,6 +586,10 @@ ReplicatorImpl::HandleWriteDone(int code, void *data)
         HandleReadDone(EVENT_CMD_DONE, &mReadOp);
         return 0;
     }
+    if (ReplicationThrottle::Instance().Pause(*this, mWriteOp.numBytesIO)) {
+        mThrottledFlag = true;
+        return 0;
+    }
     Read();
     return 0;
 }
@@ -1058,6 +1127,54 @@ int  RSReplicatorImpl::sRSReaderMetaOpTimeoutSec                   = 4 * 60;
 int  RSReplicatorImpl::sRSReaderMetaIdleTimeoutSec                 = 5 * 60;
 bool RSReplicatorImpl::sRSReaderMetaResetConnectionOnOpTimeoutFlag = true;
 
+void
+ReplicationThrottle::Update(int64_t now)
+{
+    if (! mThrottle.IsUpdateDue(now)) {
+        return;
+    }
+    ClientManager::Counters cli;
+    gClientManager.GetCounters(cli);
+    mThrottle.Update(
+        now,
+        cli.mReadRequestCount +
+        cli.mWriteRequestCount +
+        cli.mAppendRequestCount,
+        cli.mReadRequestTimeMicroSecs +
+        cli.mWriteRequestTimeMicroSecs +
+        cli.mAppendRequestTimeMicroSecs,
+        DiskIo::GetAvgPendingRequestCount()
+    );
+}
+
+bool
+ReplicationThrottle::Pause(ReplicatorImpl& repl, int64_t bytes)
+{
+    const int64_t now = microseconds();
+    Update(now);
+    if (! mThrottle.Pause(repl, bytes, now)) {
+        return false;
+    }
+    ReplicatorImpl::Ctrs().mThrottledCount++;
+    if (! mRegisteredFlag) {
+        mRegisteredFlag = true;
+        globalNetManager().RegisterTimeoutHandler(this);
+    }
+    return true;
+}
+
+void
+ReplicationThrottle::Timeout()
+{
+    const int64_t now = microseconds();
+    Update(now);
+    ReplicatorImpl::Ctrs().mThrottledUsecs += mThrottle.Resume(now);
+    if (! mThrottle.IsWaiting() && mRegisteredFlag) {
+        mRegisteredFlag = false;
+        globalNetManager().UnRegisterTimeoutHandler(this);
+    }
+}
+
 int
 Replicator::GetNumReplications()
 {
@@ -1076,6 +1193,13 @@ Replicator::SetParameters(const Properties& props)
 {
     ReplicatorImpl::SetParameters(props);
     RSReplicatorImpl::SetParameters(props);
+    ReplicationThrottle::Instance().SetParameters(props);
+}
+
+double
+Replicator::GetCapacity()
+{
+    return ReplicationThrottle::Instance().GetCapacity();
 }
 
 void
@@ -49,6 +49,8 @@ public:
         Counter mRecoveryErrorCount;
         Counter mRecoveryCanceledCount;
         Counter mReplicatorCount;
+        Counter mThrottledCount;
+        Counter mThrottledUsecs;
         Counters()
             : mReplicationCount(0),
               mReplicationErrorCount(0),
@@ -56,7 +58,9 @@ public:
               mRecoveryCount(0),
               mRecoveryErrorCount(0),
               mRecoveryCanceledCount(0),
-              mReplicatorCount(0)
+              mReplicatorCount(0),
+              mThrottledCount(0),
+              mThrottledUsecs(0)
             {}
         void Reset()
             { *this = Counters(); }
@@ -66,6 +70,10 @@ public:
     static void CancelAll();
     static void SetParameters(const Properties& props);
     static void GetCounters(Counters& counters);
+    // Replication and recovery capacity relative to the meta server
+    // configured max. concurrent replications per node, adjusted by the
+    // feedback controller using client request latency and disk queue depth.
+    static double GetCapacity();
 };
 
 }
@@ -30,6 +30,7 @@
 
 #include "utils.h"
 #include "common/MsgLogger.h"
+#include "common/Properties.h"
 #include "kfsio/IOBuffer.h"
 
 namespace KFS
@@ -52,6 +53,22 @@ bool IsMsgAvail(IOBuffer *iobuf, int *msgLen)
     return true;
 }
 
+void LoadProperties(IOBuffer& iobuf, int len, Properties& prop)
+{
+    // Main thread's buffer
+    static char tempBuf[MAX_RPC_HEADER_LEN];
+
+    const char separator = ':';
+    if (len > MAX_RPC_HEADER_LEN) {
+        IOBuffer::IStream is(iobuf, len);
+        prop.loadProperties(is, separator, false);
+        return;
+    }
+    int               hdrLen = len;
+    const char* const buf    = iobuf.CopyOutOrGetBufPtr(tempBuf, hdrLen);
+    prop.loadProperties(buf, hdrLen, separator);
+}
+
 void die(const string &msg)
 {
     string lm = "panic: " + msg;
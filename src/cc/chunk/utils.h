@@ -36,6 +36,7 @@ namespace KFS
 using std::string;
 
 class IOBuffer;
+class Properties;
 ///
 /// Given some data in a buffer, determine if we have a received a
 /// valid op---one that ends with "\r\n\r\n".  
@@ -46,6 +47,16 @@ class IOBuffer;
 ///
 bool IsMsgAvail(IOBuffer* iobuf, int* msgLen);
 
+///
+/// Load rpc header "key: value" pairs into properties. The header is copied
+/// only if it spans more than one io buffer. Must be invoked from the main
+/// (network) thread.
+/// @param[in]  iobuf : buffer containing the header
+/// @param[in]  len : header length
+/// @param[out] prop : properties with the header's key value pairs
+///
+void LoadProperties(IOBuffer& iobuf, int len, Properties& prop);
+
 ///
 /// \brief bomb out on "impossible" error
 /// \param[in] msg       panic text
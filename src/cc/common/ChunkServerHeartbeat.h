@@ -0,0 +1,354 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Chunk server heartbeat counters schema, and compact binary heartbeat
+// encoding shared by chunk and meta servers.
+//
+// The binary heartbeat is sent as the heartbeat response content, when the
+// meta server requests it with "Hb-fmt" header. The content format is:
+// <schema version> <flags> <counter count> <counter>*
+// All fields are variable length integers, 7 bits per byte, little endian,
+// the high bit set in all bytes except the last one. Counters are zig zag
+// encoded to keep small negative values short. With kFlagDelta set every
+// counter is the difference with the corresponding counter in the previous
+// heartbeat response, the meta server specifies with "Hb-base" header.
+//
+// The counters order defines the schema, and must match the order of the
+// counters in the chunk server text heartbeat response. Any change of the
+// list below requires schema version change.
+//
+//----------------------------------------------------------------------------
+
+#ifndef COMMON_CHUNK_SERVER_HEARTBEAT_H
+#define COMMON_CHUNK_SERVER_HEARTBEAT_H
+
+#include <stdint.h>
+#include <string.h>
+
+namespace KFS
+{
+
+// f(id, name, scale)
+// The floating point values are sent as fixed point numbers multiplied by
+// the scale.
+#define KfsForEachChunkServerHeartbeatCounter(f) \
+    f(TOTAL_SPACE,                   "Total-space",                   1) \
+    f(TOTAL_FS_SPACE,                "Total-fs-space",                1) \
+    f(USED_SPACE,                    "Used-space",                    1) \
+    f(NUM_DRIVES,                    "Num-drives",                    1) \
+    f(NUM_WR_DRIVES,                 "Num-wr-drives",                 1) \
+    f(NUM_CHUNKS,                    "Num-chunks",                    1) \
+    f(NUM_WRITABLE_CHUNKS,           "Num-writable-chunks",           1) \
+    f(EVACUATE,                      "Evacuate",                      1) \
+    f(EVACUATE_BYTES,                "Evacuate-bytes",                1) \
+    f(EVACUATE_DONE,                 "Evacuate-done",                 1) \
+    f(EVACUATE_DONE_BYTES,           "Evacuate-done-bytes",           1) \
+    f(EVACUATE_IN_FLIGHT,            "Evacuate-in-flight",            1) \
+    f(NUM_RANDOM_WRITES,             "Num-random-writes",             1) \
+    f(NUM_APPENDS,                   "Num-appends",                   1) \
+    f(NUM_RE_REPLICATIONS,           "Num-re-replications",           1) \
+    f(NUM_APPENDS_WITH_WIDS,         "Num-appends-with-wids",         1) \
+    f(UPTIME,                        "Uptime",                        1) \
+    f(CPU_USER,                      "CPU-user",                      1) \
+    f(CPU_SYS,                       "CPU-sys",                       1) \
+    f(CPU_LOAD_AVG,                  "CPU-load-avg",                  1000) \
+    f(CHUNK_CORRUPTED,               "Chunk-corrupted",               1) \
+    f(CHUNK_LOST,                    "Chunk-lost",                    1) \
+    f(CHUNK_HEADER_ERRORS,           "Chunk-header-errors",           1) \
+    f(CHUNK_CHKSUM_ERRORS,           "Chunk-chksum-errors",           1) \
+    f(CHUNK_READ_ERRORS,             "Chunk-read-errors",             1) \
+    f(CHUNK_WRITE_ERRORS,            "Chunk-write-errors",            1) \
+    f(CHUNK_OPEN_ERRORS,             "Chunk-open-errors",             1) \
+    f(DIR_CHUNK_LOST,                "Dir-chunk-lost",                1) \
+    f(CHUNK_DIR_LOST,                "Chunk-dir-lost",                1) \
+    f(SCRUB_CHUNKS,                  "Scrub-chunks",                  1) \
+    f(SCRUB_BYTES,                   "Scrub-bytes",                   1) \
+    f(SCRUB_PASSES,                  "Scrub-passes",                  1) \
+    f(META_CONNECT,                  "Meta-connect",                  1) \
+    f(META_HELLO_COUNT,              "Meta-hello-count",              1) \
+    f(META_HELLO_ERRORS,             "Meta-hello-errors",             1) \
+    f(META_ALLOC_COUNT,              "Meta-alloc-count",              1) \
+    f(META_ALLOC_ERRORS,             "Meta-alloc-errors",             1) \
+    f(CLIENT_ACCEPT,                 "Client-accept",                 1) \
+    f(CLIENT_ACTIVE,                 "Client-active",                 1) \
+    f(CLIENT_REQ_INVALID,            "Client-req-invalid",            1) \
+    f(CLIENT_REQ_INVALID_HEADER,     "Client-req-invalid-header",     1) \
+    f(CLIENT_REQ_INVALID_LENGTH,     "Client-req-invalid-length",     1) \
+    f(CLIENT_READ_COUNT,             "Client-read-count",             1) \
+    f(CLIENT_READ_BYTES,             "Client-read-bytes",             1) \
+    f(CLIENT_READ_MICRO_SEC,         "Client-read-micro-sec",         1) \
+    f(CLIENT_READ_ERRORS,            "Client-read-errors",            1) \
+    f(CLIENT_WRITE_COUNT,            "Client-write-count",            1) \
+    f(CLIENT_WRITE_BYTES,            "Client-write-bytes",            1) \
+    f(CLIENT_WRITE_MICRO_SEC,        "Client-write-micro-sec",        1) \
+    f(CLIENT_WRITE_ERRORS,           "Client-write-errors",           1) \
+    f(CLIENT_APPEND_COUNT,           "Client-append-count",           1) \
+    f(CLIENT_APPEND_BYTES,           "Client-append-bytes",           1) \
+    f(CLIENT_APPEND_MICRO_SEC,       "Client-append-micro-sec",       1) \
+    f(CLIENT_APPEND_ERRORS,          "Client-append-errors",          1) \
+    f(CLIENT_OTHER_COUNT,            "Client-other-count",            1) \
+    f(CLIENT_OTHER_MICRO_SEC,        "Client-other-micro-sec",        1) \
+    f(CLIENT_OTHER_ERRORS,           "Client-other-errors",           1) \
+    f(TIMER_OVERRUN_COUNT,           "Timer-overrun-count",           1) \
+    f(TIMER_OVERRUN_SEC,             "Timer-overrun-sec",             1) \
+    f(WRITE_APPENDERS,               "Write-appenders",               1) \
+    f(WAPPEND_COUNT,                 "WAppend-count",                 1) \
+    f(WAPPEND_BYTES,                 "WAppend-bytes",                 1) \
+    f(WAPPEND_ERRORS,                "WAppend-errors",                1) \
+    f(WAPPEND_REPLICATION_ERRORS,    "WAppend-replication-errors",    1) \
+    f(WAPPEND_REPLICATION_TIEMOUTS,  "WAppend-replication-tiemouts",  1) \
+    f(WAPPEND_REPLICATION_BATCHES,   "WAppend-replication-batches",   1) \
+    f(WAPPEND_REPLICATION_BATCHED,   "WAppend-replication-batched",   1) \
+    f(WAPPEND_ALLOC_COUNT,           "WAppend-alloc-count",           1) \
+    f(WAPPEND_ALLOC_MASTER_COUNT,    "WAppend-alloc-master-count",    1) \
+    f(WAPPEND_ALLOC_ERRORS,          "WAppend-alloc-errors",          1) \
+    f(WAPPEND_WID_ALLOC_COUNT,       "WAppend-wid-alloc-count",       1) \
+    f(WAPPEND_WID_ALLOC_ERRORS,      "WAppend-wid-alloc-errors",      1) \
+    f(WAPPEND_WID_ALLOC_NO_APPENDER, "WAppend-wid-alloc-no-appender", 1) \
+    f(WAPPEND_SRESERVE_COUNT,        "WAppend-sreserve-count",        1) \
+    f(WAPPEND_SRESERVE_BYTES,        "WAppend-sreserve-bytes",        1) \
+    f(WAPPEND_SRESERVE_ERRORS,       "WAppend-sreserve-errors",       1) \
+    f(WAPPEND_SRESERVE_DENIED,       "WAppend-sreserve-denied",       1) \
+    f(WAPPEND_BMCS_COUNT,            "WAppend-bmcs-count",            1) \
+    f(WAPPEND_BMCS_ERRORS,           "WAppend-bmcs-errors",           1) \
+    f(WAPPEND_MCS_COUNT,             "WAppend-mcs-count",             1) \
+    f(WAPPEND_MCS_ERRORS,            "WAppend-mcs-errors",            1) \
+    f(WAPPEND_MCS_LENGTH_ERRORS,     "WAppend-mcs-length-errors",     1) \
+    f(WAPPEND_MCS_CHKSUM_ERRORS,     "WAppend-mcs-chksum-errors",     1) \
+    f(WAPPEND_GET_OP_STATUS_COUNT,   "WAppend-get-op-status-count",   1) \
+    f(WAPPEND_GET_OP_STATUS_ERRORS,  "WAppend-get-op-status-errors",  1) \
+    f(WAPPEND_GET_OP_STATUS_KNOWN,   "WAppend-get-op-status-known",   1) \
+    f(WAPPEND_CHKSUM_ERROS,          "WAppend-chksum-erros",          1) \
+    f(WAPPEND_READ_ERROS,            "WAppend-read-erros",            1) \
+    f(WAPPEND_WRITE_ERRORS,          "WAppend-write-errors",          1) \
+    f(WAPPEND_LEASE_EX_ERRORS,       "WAppend-lease-ex-errors",       1) \
+    f(WAPPEND_LOST_TIMEOUTS,         "WAppend-lost-timeouts",         1) \
+    f(WAPPEND_LOST_CHUNKS,           "WAppend-lost-chunks",           1) \
+    f(BUFFER_BYTES_TOTAL,            "Buffer-bytes-total",            1) \
+    f(BUFFER_BYTES_WAIT,             "Buffer-bytes-wait",             1) \
+    f(BUFFER_BYTES_WAIT_AVG,         "Buffer-bytes-wait-avg",         1) \
+    f(BUFFER_USEC_WAIT_AVG,          "Buffer-usec-wait-avg",          1) \
+    f(BUFFER_CLIENTS_WAIT_AVG,       "Buffer-clients-wait-avg",       1) \
+    f(BUFFER_TOTAL_COUNT,            "Buffer-total-count",            1) \
+    f(BUFFER_MIN_COUNT,              "Buffer-min-count",              1) \
+    f(BUFFER_FREE_COUNT,             "Buffer-free-count",             1) \
+    f(BUFFER_CLIENTS,                "Buffer-clients",                1) \
+    f(BUFFER_CLIENTS_WAIT,           "Buffer-clients-wait",           1) \
+    f(BUFFER_REQ_TOTAL,              "Buffer-req-total",              1) \
+    f(BUFFER_REQ_BYTES,              "Buffer-req-bytes",              1) \
+    f(BUFFER_REQ_DENIED_TOTAL,       "Buffer-req-denied-total",       1) \
+    f(BUFFER_REQ_DENIED_BYTES,       "Buffer-req-denied-bytes",       1) \
+    f(BUFFER_REQ_GRANTED_TOTAL,      "Buffer-req-granted-total",      1) \
+    f(BUFFER_REQ_GRANTED_BYTES,      "Buffer-req-granted-bytes",      1) \
+    f(BUFFER_REQ_WAIT_USEC,          "Buffer-req-wait-usec",          1) \
+    f(DISK_READ_COUNT,               "Disk-read-count",               1) \
+    f(DISK_READ_BYTES,               "Disk-read-bytes",               1) \
+    f(DISK_READ_ERRORS,              "Disk-read-errors",              1) \
+    f(DISK_WRITE_COUNT,              "Disk-write-count",              1) \
+    f(DISK_WRITE_BYTES,              "Disk-write-bytes",              1) \
+    f(DISK_WRITE_ERRORS,             "Disk-write-errors",             1) \
+    f(DISK_SYNC_COUNT,               "Disk-sync-count",               1) \
+    f(DISK_SYNC_ERRORS,              "Disk-sync-errors",              1) \
+    f(DISK_DELETE_COUNT,             "Disk-delete-count",             1) \
+    f(DISK_DELETE_ERRORS,            "Disk-delete-errors",            1) \
+    f(DISK_RENAME_COUNT,             "Disk-rename-count",             1) \
+    f(DISK_RENAME_ERRORS,            "Disk-rename-errors",            1) \
+    f(DISK_FS_GET_FREE_COUNT,        "Disk-fs-get-free-count",        1) \
+    f(DISK_FS_GET_FREE_ERRORS,       "Disk-fs-get-free-errors",       1) \
+    f(DISK_DIR_READABLE_COUNT,       "Disk-dir-readable-count",       1) \
+    f(DISK_DIR_READABLE_ERRORS,      "Disk-dir-readable-errors",      1) \
+    f(DISK_TIMEDOUT_COUNT,           "Disk-timedout-count",           1) \
+    f(DISK_TIMEDOUT_READ_BYTES,      "Disk-timedout-read-bytes",      1) \
+    f(DISK_TIMEDOUT_WRITE_BYTES,     "Disk-timedout-write-bytes",     1) \
+    f(DISK_OPEN_FILES,               "Disk-open-files",               1) \
+    f(MSG_LOG_LEVEL,                 "Msg-log-level",                 1) \
+    f(MSG_LOG_COUNT,                 "Msg-log-count",                 1) \
+    f(MSG_LOG_DROP,                  "Msg-log-drop",                  1) \
+    f(MSG_LOG_WRITE_ERRORS,          "Msg-log-write-errors",          1) \
+    f(MSG_LOG_WAIT,                  "Msg-log-wait",                  1) \
+    f(MSG_LOG_WAITED_MICRO_SEC,      "Msg-log-waited-micro-sec",      1) \
+    f(REPLICATION_COUNT,             "Replication-count",             1) \
+    f(REPLICATION_ERRORS,            "Replication-errors",            1) \
+    f(REPLICATION_CANCEL,            "Replication-cancel",            1) \
+    f(REPLICATOR_COUNT,              "Replicator-count",              1) \
+    f(REPLICATION_THROTTLED,         "Replication-throttled",         1) \
+    f(REPLICATION_THROTTLED_USEC,    "Replication-throttled-usec",    1) \
+    f(REPLICATION_CAPACITY,          "Replication-capacity",          1000) \
+    f(RECOVERY_COUNT,                "Recovery-count",                1) \
+    f(RECOVERY_ERRORS,               "Recovery-errors",               1) \
+    f(RECOVERY_CANCEL,               "Recovery-cancel",               1) \
+    f(OPS_IN_FLIGHT_COUNT,           "Ops-in-flight-count",           1) \
+    f(SOCKET_COUNT,                  "Socket-count",                  1) \
+    f(DISK_FD_COUNT,                 "Disk-fd-count",                 1) \
+    f(NET_BYTES_READ,                "Net-bytes-read",                1) \
+    f(NET_BYTES_WRITE,               "Net-bytes-write",               1) \
+    f(DISK_BYTES_READ,               "Disk-bytes-read",               1) \
+    f(DISK_BYTES_WRITE,              "Disk-bytes-write",              1) \
+    f(TOTAL_OPS_COUNT,               "Total-ops-count",               1) \
+    f(DISK_PUNCH_HOLE_COUNT,         "Disk-punch-hole-count",         1) \
+    f(DISK_PUNCH_HOLE_ERRORS,        "Disk-punch-hole-errors",        1) \
+
+enum ChunkServerHeartbeatCounterId
+{
+#define KfsMakeChunkServerHeartbeatEnumEntry(id, name, scale) CS_HB_##id,
+    KfsForEachChunkServerHeartbeatCounter(KfsMakeChunkServerHeartbeatEnumEntry)
+#undef KfsMakeChunkServerHeartbeatEnumEntry
+    CS_HB_COUNTERS_COUNT // must be the last one
+};
+
+class ChunkServerHeartbeat
+{
+public:
+    enum { kSchemaVersion   = 2 };
+    enum { kFlagDelta       = 1 };
+    enum { kMaxEncodedSize  =
+        (3 + CS_HB_COUNTERS_COUNT) * ((64 + 6) / 7) };
+    typedef int64_t Counter;
+
+    static const char* GetName(
+        int inId)
+    {
+        return ((0 <= inId && inId < CS_HB_COUNTERS_COUNT) ?
+            GetDefs()[inId].mNamePtr : 0);
+    }
+    static int GetScale(
+        int inId)
+    {
+        return ((0 <= inId && inId < CS_HB_COUNTERS_COUNT) ?
+            GetDefs()[inId].mScale : 1);
+    }
+    static int Find(
+        const char* inNamePtr)
+    {
+        for (int i = 0; i < CS_HB_COUNTERS_COUNT; i++) {
+            if (strcmp(GetDefs()[i].mNamePtr, inNamePtr) == 0) {
+                return i;
+            }
+        }
+        return -1;
+    }
+    // Returns encoded length. The buffer must be at least kMaxEncodedSize
+    // bytes. The base, if not null, must have the same number of counters.
+    static int Encode(
+        const Counter* inCountersPtr,
+        const Counter* inBasePtr,
+        int            inCount,
+        char*          inBufPtr)
+    {
+        char* thePtr = inBufPtr;
+        thePtr = Put(thePtr, kSchemaVersion);
+        thePtr = Put(thePtr, inBasePtr ? kFlagDelta : 0);
+        thePtr = Put(thePtr, inCount);
+        for (int i = 0; i < inCount; i++) {
+            const Counter theVal = inCountersPtr[i] -
+                (inBasePtr ? inBasePtr[i] : Counter(0));
+            thePtr = Put(thePtr,
+                (uint64_t(theVal) << 1) ^ uint64_t(theVal >> 63));
+        }
+        return (int)(thePtr - inBufPtr);
+    }
+    // Decodes in place into the counters array, does not allocate memory.
+    // With delta encoding the counters array must contain the base values.
+    // Returns number of counters decoded, or -1 on format error.
+    static int Decode(
+        const char* inBufPtr,
+        int         inLength,
+        Counter*    inCountersPtr,
+        int         inMaxCount,
+        bool&       outDeltaFlag)
+    {
+        const char* thePtr = inBufPtr;
+        const char* theEnd = inBufPtr + inLength;
+        uint64_t    theVersion = 0;
+        uint64_t    theFlags   = 0;
+        uint64_t    theCount   = 0;
+        if (! (thePtr = Get(thePtr, theEnd, theVersion)) ||
+                theVersion != kSchemaVersion ||
+                ! (thePtr = Get(thePtr, theEnd, theFlags)) ||
+                ! (thePtr = Get(thePtr, theEnd, theCount)) ||
+                uint64_t(inMaxCount) < theCount) {
+            return -1;
+        }
+        outDeltaFlag = (theFlags & kFlagDelta) != 0;
+        for (int i = 0; i < (int)theCount; i++) {
+            uint64_t theVal = 0;
+            if (! (thePtr = Get(thePtr, theEnd, theVal))) {
+                return -1;
+            }
+            const Counter theDelta = Counter(theVal >> 1) ^ -Counter(theVal & 1);
+            inCountersPtr[i] = outDeltaFlag ?
+                inCountersPtr[i] + theDelta : theDelta;
+        }
+        return (thePtr == theEnd ? (int)theCount : -1);
+    }
+private:
+    struct Def
+    {
+        const char* mNamePtr;
+        int         mScale;
+    };
+    static const Def* GetDefs()
+    {
+        static const Def sDefs[] = {
+#define KfsMakeChunkServerHeartbeatDef(id, name, scale) { name, scale },
+    KfsForEachChunkServerHeartbeatCounter(KfsMakeChunkServerHeartbeatDef)
+#undef KfsMakeChunkServerHeartbeatDef
+            { 0, 0 }
+        };
+        return sDefs;
+    }
+    static char* Put(
+        char*    inPtr,
+        uint64_t inVal)
+    {
+        char*    thePtr = inPtr;
+        uint64_t theVal = inVal;
+        while (0x7F < theVal) {
+            *thePtr++ = (char)((theVal & 0x7F) | 0x80);
+            theVal >>= 7;
+        }
+        *thePtr++ = (char)theVal;
+        return thePtr;
+    }
+    static const char* Get(
+        const char* inPtr,
+        const char* inEndPtr,
+        uint64_t&   outVal)
+    {
+        uint64_t theVal   = 0;
+        int      theShift = 0;
+        for (const char* thePtr = inPtr;
+                thePtr < inEndPtr && theShift < 64;
+                theShift += 7) {
+            const uint64_t theByte = *thePtr++ & 0xFF;
+            theVal |= (theByte & 0x7F) << theShift;
+            if ((theByte & 0x80) == 0) {
+                outVal = theVal;
+                return thePtr;
+            }
+        }
+        return 0;
+    }
+};
+
+} // namespace KFS
+
+#endif /* COMMON_CHUNK_SERVER_HEARTBEAT_H */
@@ -27,7 +27,9 @@
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
+#include <cstring>
 #include "Properties.h"
+#include "RequestParser.h"
 
 namespace KFS
 {
@@ -80,21 +82,61 @@ Properties::AsciiToLower(const string& str)
     return s;
 }
 
-inline
-Properties::iterator Properties::find(const string& key) const
+inline const char*
+Properties::find(const string& key, size_t* len) const
 {
-    return propmap.find(key);
+    // The last entry wins, the same way as with the map insert.
+    const size_t klen = key.length();
+    for (FlatEntries::const_reverse_iterator it = flatentries.rbegin();
+            it != flatentries.rend();
+            ++it) {
+        if (it->keyLen == klen &&
+                memcmp(flatbuf.data() + it->keyOff, key.data(), klen) == 0) {
+            if (len) {
+                *len = it->valLen;
+            }
+            return (flatbuf.c_str() + it->valOff);
+        }
+    }
+    PropMap::const_iterator const i = propmap.find(key);
+    if (i == propmap.end()) {
+        return 0;
+    }
+    if (len) {
+        *len = i->second.length();
+    }
+    return i->second.c_str();
+}
+
+void
+Properties::flatToMap() const
+{
+    if (flatentries.empty()) {
+        return;
+    }
+    for (FlatEntries::const_iterator it = flatentries.begin();
+            it != flatentries.end();
+            ++it) {
+        propmap[string(flatbuf.data() + it->keyOff, it->keyLen)].assign(
+            flatbuf.data() + it->valOff, it->valLen);
+    }
+    flatentries.clear();
+    flatbuf.clear();
 }
 
 Properties::Properties(int base)
     : intbase(base),
-      propmap()
+      propmap(),
+      flatbuf(),
+      flatentries()
 {
 }
 
 Properties::Properties(const Properties &p)
     : intbase(p.intbase),
-      propmap(p.propmap)
+      propmap(p.propmap),
+      flatbuf(p.flatbuf),
+      flatentries(p.flatentries)
 {
 }
 
@@ -123,6 +165,7 @@ Properties::loadProperties(istream &ist, char delimiter,
     bool verbose /* = false */, bool multiline /* = false */,
     bool keysAsciiToLower /* = false */)
 {
+    flatToMap();
     string line;
     while (ist) {
         getline(ist, line); //read one line at a time
@@ -150,9 +193,51 @@ Properties::loadProperties(istream &ist, char delimiter,
     return 0;
 }
 
+int
+Properties::loadProperties(const char* buf, size_t len, char delimiter,
+    bool multiline /* = false */)
+{
+    PropertiesTokenizer tokenizer(buf, len);
+    if (multiline) {
+        flatToMap();
+        // Reuse key buffer, map node key is only copied on insert.
+        string key;
+        while (tokenizer.Next(delimiter)) {
+            const PropertiesTokenizer::Token& name = tokenizer.GetKey();
+            if (0 < name.mLen && *name.mPtr == '#') {
+                continue; // ignore comments
+            }
+            const PropertiesTokenizer::Token& value = tokenizer.GetValue();
+            key.assign(name.mPtr, name.mLen);
+            propmap[key].append(value.mPtr, value.mLen);
+        }
+        return 0;
+    }
+    // Keep the map entries, if any, flat entries have precedence.
+    while (tokenizer.Next(delimiter)) {
+        const PropertiesTokenizer::Token& name = tokenizer.GetKey();
+        if (0 < name.mLen && *name.mPtr == '#') {
+            continue; // ignore comments
+        }
+        const PropertiesTokenizer::Token& value = tokenizer.GetValue();
+        FlatEntry entry;
+        entry.keyOff = flatbuf.length();
+        entry.keyLen = name.mLen;
+        flatbuf.append(name.mPtr, name.mLen);
+        flatbuf.push_back(0);
+        entry.valOff = flatbuf.length();
+        entry.valLen = value.mLen;
+        flatbuf.append(value.mPtr, value.mLen);
+        flatbuf.push_back(0);
+        flatentries.push_back(entry);
+    }
+    return 0;
+}
+
 void
 Properties::setValue(const string& key, const string& value)
 {
+    flatToMap();
     propmap[key] = value;
     return;
 }
@@ -160,72 +245,72 @@ Properties::setValue(const string& key, const string& value)
 string
 Properties::getValue(const string& key, const string& def) const
 {
-    PropMap::const_iterator const i = find(key);
-    return (i == propmap.end() ? def : i->second);
+    size_t            len = 0;
+    const char* const val = find(key, &len);
+    return (val ? string(val, len) : def);
 }
 
 const char*
 Properties::getValue(const string& key, const char* def) const
 {
-    PropMap::const_iterator const i = find(key);
-    return (i == propmap.end() ? def : i->second.c_str());
+    const char* const val = find(key);
+    return (val ? val : def);
 }
 
 int
 Properties::getValue(const string& key, int def) const
 {
-    PropMap::const_iterator const i = find(key);
-    return (i == propmap.end() ? def :
-        (int)strtol(i->second.c_str(), 0, intbase));
+    const char* const val = find(key);
+    return (val ? (int)strtol(val, 0, intbase) : def);
 }
 
 unsigned int
 Properties::getValue(const string& key, unsigned int def) const
 {
-    PropMap::const_iterator const i = find(key);
-    return (i == propmap.end() ? def :
-        (unsigned int)strtoul(i->second.c_str(), 0, intbase));
+    const char* const val = find(key);
+    return (val ? (unsigned int)strtoul(val, 0, intbase) : def);
 }
 
 long
 Properties::getValue(const string& key, long def) const
 {
-    PropMap::const_iterator const i = find(key);
-    return (i == propmap.end() ? def : strtol(i->second.c_str(), 0, intbase));
+    const char* const val = find(key);
+    return (val ? strtol(val, 0, intbase) : def);
 }
 
 unsigned long
 Properties::getValue(const string& key, unsigned long def) const
 {
-    PropMap::const_iterator const i = find(key);
-    return (i == propmap.end() ? def : strtoul(i->second.c_str(), 0, intbase));
+    const char* const val = find(key);
+    return (val ? strtoul(val, 0, intbase) : def);
 }
 
 long long
 Properties::getValue(const string& key, long long def) const
 {
-    PropMap::const_iterator const i = find(key);
-    return (i == propmap.end() ? def : strtoll(i->second.c_str(), 0, intbase));
+    const char* const val = find(key);
+    return (val ? strtoll(val, 0, intbase) : def);
 }
 
 unsigned long long
 Properties::getValue(const string& key, unsigned long long def) const
 {
-    PropMap::const_iterator const i = find(key);
-    return (i == propmap.end() ? def : strtoull(i->second.c_str(), 0, intbase));
+    const char* const val = find(key);
+    return (val ? strtoull(val, 0, intbase) : def);
 }
 
 double
 Properties::getValue(const string& key, double def) const
 {
-    PropMap::const_iterator const i = find(key);
-    return (i == propmap.end() ? def : atof(i->second.c_str()));
+    const char* const val = find(key);
+    return (val ? atof(val) : def);
 }
 
 void
 Properties::getList(string &outBuf,
     const string& linePrefix, const string& lineSuffix) const
 {
+  flatToMap();
   PropMap::const_iterator iter;
   for (iter = propmap.begin(); iter != propmap.end(); iter++) {
     if (iter->first.size() > 0) {
@@ -242,6 +327,8 @@ Properties::getList(string &outBuf,
 void
 Properties::copyWithPrefix(const string& prefix, Properties& props) const
 {
+    flatToMap();
+    props.flatToMap();
     PropMap::const_iterator iter;
     for (iter = propmap.begin(); iter != propmap.end(); iter++) {
         const string& key = iter->first;
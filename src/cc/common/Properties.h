@@ -30,6 +30,7 @@
 #include <istream>
 #include <string>
 #include <map>
+#include <vector>
 
 #include "StdAllocator.h"
 
@@ -39,6 +40,7 @@ namespace KFS
 using std::map;
 using std::string;
 using std::istream;
+using std::vector;
 
 // Key: value properties.
 // Can be used to parse rfc822 style request headers, or configuration files.
@@ -51,21 +53,42 @@ private :
         std::less<string>,
         StdFastAllocator<std::pair<const string, string> >
     > PropMap;
-    PropMap propmap;
-    inline PropMap::const_iterator find(const string& key) const;
+    mutable PropMap propmap;
+    // Key value pairs loaded from a contiguous buffer, such as rpc header.
+    // The keys and values are copied into one null separated buffer, and
+    // looked up by linear search. With the same properties object re-used
+    // for every rpc, loading is done without allocations. The pairs are
+    // moved into the map only when the map is needed: iteration, list,
+    // copy with prefix, or set value.
+    struct FlatEntry
+    {
+        size_t keyOff;
+        size_t keyLen;
+        size_t valOff;
+        size_t valLen;
+    };
+    typedef vector<FlatEntry> FlatEntries;
+    string      flatbuf;
+    FlatEntries flatentries;
+    inline const char* find(const string& key, size_t* len = 0) const;
+    void flatToMap() const;
 
 public:
     static string AsciiToLower(const string& str);
 
     typedef PropMap::const_iterator iterator;
-    iterator begin() const { return propmap.begin(); }
-    iterator end() const { return propmap.end(); }
+    iterator begin() const { flatToMap(); return propmap.begin(); }
+    iterator end() const { flatToMap(); return propmap.end(); }
     // load the properties from a file
     int loadProperties(const char* fileName, char delimiter,
         bool verbose, bool multiline = false, bool keysAsciiToLower = false);
     // load the properties from an in-core buffer
     int loadProperties(istream &ist, char delimiter,
         bool verbose, bool multiline = false, bool keysAsciiToLower = false);
+    // load the properties from a contiguous buffer, such as rpc header,
+    // without intermediate stream and line copies.
+    int loadProperties(const char* buf, size_t len, char delimiter,
+        bool multiline = false);
     string getValue(const string& key, const string& def) const;
     const char* getValue(const string& key, const char* def) const;
     int getValue(const string& key, int def) const;
@@ -78,12 +101,21 @@ public:
     void setValue(const string& key, const string& value);
     void getList(string &outBuf, const string& linePrefix,
         const string& lineSuffix = string("\n")) const;
-    void clear() { propmap.clear(); }
-    bool empty() const { return propmap.empty(); }
-    size_t size() const { return propmap.size(); }
+    void clear()
+    {
+        propmap.clear();
+        flatbuf.clear();
+        flatentries.clear();
+    }
+    bool empty() const { return (propmap.empty() && flatentries.empty()); }
+    size_t size() const { flatToMap(); return propmap.size(); }
     void copyWithPrefix(const string& prefix, Properties& props) const;
     void swap(Properties& props)
-        { propmap.swap(props.propmap); }
+    {
+        propmap.swap(props.propmap);
+        flatbuf.swap(props.flatbuf);
+        flatentries.swap(props.flatentries);
+    }
     void setIntBase(int base)
         { intbase = base; }
     Properties(int base = 10);
@@ -35,6 +35,7 @@
 #include <iterator>
 
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -45,6 +46,7 @@ namespace KFS
 using std::string;
 using std::streambuf;
 using std::istream;
+using std::ostream;
 using std::min;
 using std::make_pair;
 using std::map;
@@ -145,7 +147,7 @@ public:
         T&           outValue)
     {
         if (inLen <= 0) {
-            return -1;
+            return false;
         }
         const unsigned char* thePtr =
             reinterpret_cast<const unsigned char*>(ioPtr);
@@ -275,14 +277,55 @@ _KFS_ValueParser_IntTypes(_KFS_DEFINE_ValueParser_IntSetValue)
         bool&       outValue)
     {
         int theVal = 0;
-        if (! ParseInt(inPtr, inLen, theVal)) {
+        if (ParseInt(inPtr, inLen, theVal)) {
+            outValue = theVal != 0;
+        } else {
             outValue = inDefaultValue;
         }
-        outValue = theVal != 0;
     }
 };
 
 typedef ValueParserT<DecIntParser> ValueParser;
+typedef ValueParserT<HexIntParser> HexValueParser;
+
+// Integer output in the format accepted by HexIntParser and strtol(): lower
+// case hex digits, with negative values represented as the minus sign
+// followed by the magnitude.
+class HexIntFmt
+{
+public:
+    HexIntFmt(
+        int64_t inVal)
+        : mNegativeFlag(inVal < 0),
+          mVal(inVal < 0 ? uint64_t(0) - uint64_t(inVal) : uint64_t(inVal))
+        {}
+    ostream& Insert(
+        ostream& inStream) const
+    {
+        char        theBuf[sizeof(mVal) * 2 + 1];
+        char* const theEndPtr = theBuf + sizeof(theBuf);
+        char*       thePtr    = theEndPtr;
+        uint64_t    theVal    = mVal;
+        do {
+            *--thePtr = "0123456789abcdef"[theVal & 0xF];
+            theVal >>= 4;
+        } while (theVal != 0);
+        if (mNegativeFlag) {
+            *--thePtr = '-';
+        }
+        return inStream.write(thePtr, theEndPtr - thePtr);
+    }
+private:
+    const bool     mNegativeFlag;
+    const uint64_t mVal;
+};
+
+inline ostream& operator<<(
+    ostream&         inStream,
+    const HexIntFmt& inFmt)
+{
+    return inFmt.Insert(inStream);
+}
 
 class PropertiesTokenizer
 {
@@ -378,7 +421,7 @@ public:
                 }
                 mPtr++;
             }
-            if (*mPtr != inSeparator) {
+            if (mPtr >= mEndPtr || *mPtr != inSeparator) {
                 // Ignore malformed line.
                 while (mPtr < mEndPtr && *mPtr != '\n') {
                     mPtr++;
@@ -695,6 +738,14 @@ public:
         }
         return *this;
     }
+    template <typename OBJ, typename VALUE_PARSER>
+    RequestParser<ABSTRACT_OBJ, OBJ, VALUE_PARSER>& BeginMakeParser(
+        const OBJ*          inNullPtr,
+        const VALUE_PARSER* inNullValueParserPtr)
+    {
+        static RequestParser<ABSTRACT_OBJ, OBJ, VALUE_PARSER> sParser;
+        return sParser;
+    }
     template <typename OBJ>
     RequestHandler& MakeParser(
         const char* inNamePtr,
@@ -708,6 +759,21 @@ public:
                 )
             );
     }
+    // Short rpc format: short keys, and hex integer values.
+    template <typename OBJ>
+    RequestHandler& MakeShortParser(
+        const char* inNamePtr,
+        const OBJ*  inNullPtr = 0)
+    {
+        return
+            EndMakeParser(
+                inNamePtr,
+                OBJ::ShortParserDef(
+                    BeginMakeParser(
+                        inNullPtr, static_cast<const HexValueParser*>(0))
+                )
+            );
+    }
 
 private:
     typedef PropertiesTokenizer::Token Name;
@@ -48,6 +48,8 @@ const fid_t ROOTFID = 2;      //!< special fid for "/
 //!< detect clients running old binaries.
 const int KFS_CLIENT_PROTO_VERS = 114;
 const int KFS_CLIENT_MIN_STRIPED_FILE_SUPPORT_PROTO_VERS = 110;
+//!< Chunk server data ops short rpc format version, see chunk/KfsOps.h.
+const int KFS_SHORT_RPC_FORMAT_VERS = 1;
 
 //!< Declarations as used in the Chunkserver/client-library
 typedef int64_t kfsFileId_t;
@@ -0,0 +1,168 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief IOBuffer performance test. Emulates IOBuffer operations of the
+// chunk server write and read paths.
+//
+//----------------------------------------------------------------------------
+
+#include "kfsio/IOBuffer.h"
+#include "common/time.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+#include <vector>
+
+using namespace KFS;
+using std::cout;
+using std::cerr;
+using std::vector;
+
+// Free list allocator, an approximation of the chunk server io buffer pool.
+class FreeListAllocator : public libkfsio::IOBufferAllocator
+{
+public:
+    FreeListAllocator(
+        size_t inBufSize)
+        : mBufSize(inBufSize),
+          mFreeList()
+        {}
+    virtual size_t GetBufferSize() const
+        { return mBufSize; }
+    virtual char* Allocate()
+    {
+        if (mFreeList.empty()) {
+            return new char[mBufSize];
+        }
+        char* const theRet = mFreeList.back();
+        mFreeList.pop_back();
+        return theRet;
+    }
+    virtual void Deallocate(
+        char* inBufPtr)
+        { mFreeList.push_back(inBufPtr); }
+private:
+    const size_t  mBufSize;
+    vector<char*> mFreeList;
+};
+
+// Write path: the request header and payload are received into the network
+// buffer, the payload is moved into the op buffer, the op buffer is cloned
+// for forwarding to the next replica in the synchronous replication chain,
+// and finally consumed once written to disk.
+static int64_t
+WritePath(
+    int  inIterations,
+    int  inPayloadSize,
+    const char* inDataPtr)
+{
+    const char* const kHeader =
+        "WRITE_PREPARE\r\nCseq: 1\r\nChunk-handle: 1\r\n\r\n";
+    const int kHeaderLen = (int)strlen(kHeader);
+    int64_t   theCheck   = 0;
+    IOBuffer  theNetBuf;
+    for (int i = 0; i < inIterations; i++) {
+        theNetBuf.CopyIn(kHeader, kHeaderLen);
+        theNetBuf.CopyIn(inDataPtr, inPayloadSize);
+        const int theIdx = theNetBuf.IndexOf(0, "\r\n\r\n");
+        theNetBuf.Consume(theIdx + 4);
+        IOBuffer theOpBuf;
+        theOpBuf.Move(&theNetBuf, inPayloadSize);
+        IOBuffer* const theFwdBufPtr = theOpBuf.Clone();
+        theOpBuf.MakeBuffersFull();
+        theCheck += theOpBuf.BytesConsumable();
+        theCheck += theFwdBufPtr->Consume(theFwdBufPtr->BytesConsumable());
+        delete theFwdBufPtr;
+        theOpBuf.Consume(theOpBuf.BytesConsumable());
+    }
+    return theCheck;
+}
+
+// Read path: disk io completion creates buffers, the reply header is
+// written in front of the payload into the network buffer, and the network
+// buffer is consumed as it is sent.
+static int64_t
+ReadPath(
+    int         inIterations,
+    int         inPayloadSize,
+    const char* inDataPtr)
+{
+    const char* const kHeader = "OK\r\nCseq: 1\r\nStatus: 0\r\n\r\n";
+    const int kHeaderLen = (int)strlen(kHeader);
+    int64_t   theCheck   = 0;
+    IOBuffer  theNetBuf;
+    for (int i = 0; i < inIterations; i++) {
+        IOBuffer theDiskBuf;
+        theDiskBuf.EnsureSpaceAvailable(inPayloadSize);
+        IOBuffer theTmpBuf;
+        theTmpBuf.CopyIn(inDataPtr, inPayloadSize);
+        theDiskBuf.ReplaceKeepBuffersFull(&theTmpBuf, 0, inPayloadSize);
+        theNetBuf.CopyIn(kHeader, kHeaderLen);
+        theNetBuf.Move(&theDiskBuf);
+        for (IOBuffer::iterator theIt = theNetBuf.begin();
+                theIt != theNetBuf.end();
+                ++theIt) {
+            theCheck += theIt->BytesConsumable();
+        }
+        theNetBuf.Consume(theNetBuf.BytesConsumable());
+    }
+    return theCheck;
+}
+
+int
+main(int argc, char** argv)
+{
+    if (argc > 1 && (! strcmp(argv[1], "-h") || ! strcmp(argv[1], "--help"))) {
+        cerr << "Usage: " << argv[0] <<
+            " [iterations] [payload size] [use default allocator]\n";
+        return 0;
+    }
+    const int theIterations = argc > 1 ? (int)atof(argv[1]) : 100000;
+    const int theSize       = argc > 2 ? (int)atof(argv[2]) : (64 << 10);
+    if (theIterations <= 0 || theSize <= 0) {
+        cerr << "invalid parameters\n";
+        return 1;
+    }
+    static FreeListAllocator sAllocator(4 << 10);
+    if ((argc <= 3 || atoi(argv[3]) == 0) &&
+            ! libkfsio::SetIOBufferAllocator(&sAllocator)) {
+        cerr << "failed to set io buffer allocator\n";
+        return 1;
+    }
+    vector<char> theData(theSize, 'x');
+    int64_t theStart = microseconds();
+    int64_t theCheck = WritePath(theIterations, theSize, &theData[0]);
+    int64_t theEnd   = microseconds();
+    cout << "write: " << theIterations << " x " << theSize <<
+        " " << (theEnd - theStart) * 1e-6 << " sec. " <<
+        (theEnd - theStart) * 1e3 / theIterations << " nsec/op " <<
+        theCheck << "\n";
+    theStart = theEnd;
+    theCheck = ReadPath(theIterations, theSize, &theData[0]);
+    theEnd   = microseconds();
+    cout << "read:  " << theIterations << " x " << theSize <<
+        " " << (theEnd - theStart) * 1e-6 << " sec. " <<
+        (theEnd - theStart) * 1e3 / theIterations << " nsec/op " <<
+        theCheck << "\n";
+    return 0;
+}
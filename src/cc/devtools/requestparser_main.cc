@@ -25,11 +25,16 @@
 
 #include "common/RequestParser.h"
 #include "common/Properties.h"
+#include "common/time.h"
 
 #include <stdint.h>
 #include <stdio.h>
 #include <unistd.h>
 
+#include <string>
+#include <sstream>
+#include <vector>
+
 using namespace KFS;
 
 class AbstractTest
@@ -163,6 +168,17 @@ public:
         res->Load(props);
         return res;
     }
+    static AbstractTest* Load(
+        const char* buf,
+        size_t      len)
+    {
+        Test* const res = new Test;
+        const char separator = ':';
+        Properties props;
+        props.loadProperties(buf, len, separator);
+        res->Load(props);
+        return res;
+    }
     virtual std::ostream& Show(
         std::ostream& inStream)
     {
@@ -198,6 +214,10 @@ Max-appenders: 640000000\r
 /*
     To benchmark:
     ../src/test-scripts/allocatesend.pl 1e6 | ( time src/cc/devtools/requestparser_test q )
+    Flags: q - quiet, n - no parse, a - allocate only, p - properties with
+    istream, b - properties from buffer, s - print parse rate.
+    To fuzz:
+    src/cc/devtools/requestparser f [iterations] [seed]
 */
 
 typedef RequestHandler<AbstractTest> ReqHandler;
@@ -211,12 +231,176 @@ static const ReqHandler& MakeRequestHandler()
 }
 static const ReqHandler& sReqHandler = MakeRequestHandler();
 
+class Fuzzer
+{
+public:
+    Fuzzer(
+        unsigned int inSeed)
+        : mRand(inSeed),
+          mHeader()
+        {}
+    // Compare properties loaded with the buffer tokenizer with the ones
+    // loaded with istream from well formed headers, and run parsers on
+    // random binary input. The binary input is copied into the buffer of
+    // exactly the input size, to let memory checkers detect buffer overruns.
+    int Run(
+        int inIterations)
+    {
+        int        theMismatchCount = 0;
+        // Re-use the buffer properties, the same way as the rpc clients do.
+        Properties theBufProps;
+        for (int i = 0; i < inIterations; i++) {
+            if (! CheckHexInt() && theMismatchCount++ < 8) {
+                std::cerr << "hex int mismatch: " << mHeader << "\n";
+            }
+            const bool theBinaryFlag = Rand(4) == 0;
+            if (theBinaryFlag) {
+                GenerateBinary(512);
+            } else {
+                GenerateHeader();
+            }
+            const std::vector<char> theBuf(mHeader.begin(), mHeader.end());
+            const char* const thePtr = theBuf.empty() ? 0 : &theBuf[0];
+            delete sReqHandler.Handle(thePtr, theBuf.size());
+            const char theSeparator = ':';
+            theBufProps.clear();
+            theBufProps.loadProperties(thePtr, theBuf.size(), theSeparator);
+            if (theBinaryFlag) {
+                continue;
+            }
+            Properties        theStreamProps;
+            BufferInputStream theStream(mHeader.data(), mHeader.size());
+            theStreamProps.loadProperties(theStream, theSeparator, false);
+            // Look up first, as iteration moves the buffer properties into
+            // the map.
+            if (! LookupEquals(theBufProps, theStreamProps) ||
+                    ! Equals(theBufProps, theStreamProps)) {
+                if (theMismatchCount++ < 8) {
+                    std::cerr << "mismatch:\n" << mHeader << "\n";
+                }
+            }
+        }
+        std::cout << "iterations: " << inIterations <<
+            " mismatches: " << theMismatchCount << "\n";
+        return (theMismatchCount == 0 ? 0 : 1);
+    }
+private:
+    unsigned int mRand;
+    std::string  mHeader;
+
+    int Rand(
+        int inMax)
+    {
+        mRand = mRand * 1103515245 + 12345;
+        return (int)((mRand >> 16) % (unsigned int)inMax);
+    }
+    // Short rpc format integer output must be parsable by both HexIntParser
+    // and strtoll(), the latter is used by the client's Properties.
+    bool CheckHexInt()
+    {
+        uint64_t theBits = 0;
+        for (int i = 0; i < 4; i++) {
+            theBits = (theBits << 16) | Rand(1 << 16);
+        }
+        int64_t theVal = (int64_t)(theBits >> (Rand(63) + 1));
+        if (Rand(2) == 0) {
+            theVal = -theVal;
+        }
+        std::ostringstream theStream;
+        theStream << HexIntFmt(theVal);
+        mHeader = theStream.str();
+        const char* thePtr    = mHeader.data();
+        int64_t     theParsed = 0;
+        return (
+            HexIntParser::Parse(thePtr, mHeader.size(), theParsed) &&
+            theParsed == theVal &&
+            thePtr == mHeader.data() + mHeader.size() &&
+            (int64_t)strtoll(mHeader.c_str(), 0, 16) == theVal
+        );
+    }
+    void Append(
+        const char* inAlphabetPtr,
+        int         inMaxLen)
+    {
+        const int theAlphabetLen = (int)strlen(inAlphabetPtr);
+        for (int i = Rand(inMaxLen + 1); i > 0; i--) {
+            mHeader += inAlphabetPtr[Rand(theAlphabetLen)];
+        }
+    }
+    void GenerateBinary(
+        int inMaxLen)
+    {
+        mHeader.clear();
+        for (int i = Rand(inMaxLen + 1); i > 0; i--) {
+            mHeader += (char)Rand(256);
+        }
+    }
+    void GenerateHeader()
+    {
+        mHeader = Rand(2) ? "ALLOCATE\r\n" : "";
+        for (int i = Rand(17); i > 0; i--) {
+            Append(" ", 2);
+            Append("aZ09- ", 24);
+            if (Rand(8) != 0) {
+                Append(" \t", 2);
+                mHeader += ':';
+            }
+            Append("aZ09-: \t", 32);
+            if (Rand(8) != 0) {
+                mHeader += Rand(2) ? "\r\n" : "\n";
+            }
+        }
+        if (Rand(4) != 0) {
+            mHeader += "\r\n";
+        }
+    }
+    static bool LookupEquals(
+        const Properties& inBufProps,
+        const Properties& inStreamProps)
+    {
+        if (inBufProps.empty() != inStreamProps.empty()) {
+            return false;
+        }
+        for (Properties::iterator theIt = inStreamProps.begin();
+                theIt != inStreamProps.end();
+                ++theIt) {
+            const char* const theValPtr =
+                inBufProps.getValue(theIt->first, (const char*)0);
+            if (! theValPtr || theIt->second != theValPtr) {
+                return false;
+            }
+        }
+        return true;
+    }
+    static bool Equals(
+        const Properties& inLhs,
+        const Properties& inRhs)
+    {
+        if (inLhs.size() != inRhs.size()) {
+            return false;
+        }
+        for (Properties::iterator theLIt = inLhs.begin(),
+                    theRIt = inRhs.begin();
+                theLIt != inLhs.end();
+                ++theLIt, ++theRIt) {
+            if (*theLIt != *theRIt) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
 int
 main(int argc, char** argv)
 {
     if (argc <= 1 || (!strcmp(argv[1], "-h") || !strcmp(argv[1], "--help"))) {
         return 0;
     }
+    if (strchr(argv[1], 'f')) {
+        Fuzzer fuzzer(argc > 3 ? (unsigned int)atol(argv[3]) : 1);
+        return fuzzer.Run(argc > 2 ? (int)atof(argv[2]) : 100000);
+    }
 
     static char buf[1 << 20];
     char* ptr = buf;
@@ -227,6 +411,11 @@ main(int argc, char** argv)
     const bool  noparse = argc > 1 && strchr(argv[1], 'n');
     const bool  alloc   = argc > 1 && strchr(argv[1], 'a');
     const bool  useprop = argc > 1 && strchr(argv[1], 'p');
+    const bool  bufprop = argc > 1 && strchr(argv[1], 'b');
+    const bool  stats   = argc > 1 && strchr(argv[1], 's');
+    int64_t     count   = 0;
+    int64_t     bytes   = 0;
+    const int64_t start = microseconds();
 
     while ((nrd = read(0, ptr, end - ptr)) > 0) {
         end = ptr + nrd;
@@ -251,7 +440,9 @@ main(int argc, char** argv)
             if (! noparse || alloc) {
                 AbstractTest* const tst = useprop ?
                     Test::Load(myis.Set(ptr, noparse ? 0 : re - ptr)) :
-                    sReqHandler.Handle(ptr, noparse ? 0 : re - ptr);
+                    (bufprop ?
+                    Test::Load(ptr, noparse ? 0 : re - ptr) :
+                    sReqHandler.Handle(ptr, noparse ? 0 : re - ptr));
                 if (tst) {
                     if (! quiet) {
                         std::cout << "Parsed request:\n";
@@ -263,11 +454,19 @@ main(int argc, char** argv)
                     std::cout.write(ptr, re - ptr);
                 }
             }
+            count++;
+            bytes += re - ptr;
             ptr = re;
         }
         memmove(buf, ptr, end - ptr);
         ptr = buf + (end - ptr);
         end = buf + sizeof(buf);
     }
+    if (stats) {
+        const double elapsed = (microseconds() - start) * 1e-6;
+        std::cerr << "requests: " << count << " bytes: " << bytes <<
+            " sec: " << elapsed << " requests/sec: " <<
+            (elapsed > 0 ? count / elapsed : 0.) << "\n";
+    }
     return 0;
 }
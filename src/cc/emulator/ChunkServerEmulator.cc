@@ -42,7 +42,8 @@ ChunkServerEmulator::ChunkServerEmulator(
       ChunkServer(NetConnectionPtr(
         new NetConnection(this, this, false, false)), peerName),
       mPendingReqs(),
-      mOut(0)
+      mOut(0),
+      mRetiredFlag(false)
 {
     SetServerLocation(loc);
     SetRack(rack);
@@ -58,6 +59,14 @@ ChunkServerEmulator::~ChunkServerEmulator()
     ChunkServerEmulator::FailPendingOps();
 }
 
+void
+ChunkServerEmulator::SetWritableDrives(int numWritableDrives)
+{
+    const int delta = numWritableDrives - mNumWritableDrives;
+    mNumWritableDrives = numWritableDrives;
+    gLayoutManager.UpdateChunkWritesPerDrive(*this, 0, delta);
+}
+
 void
 ChunkServerEmulator::EnqueueSelf(MetaChunkRequest* r)
 {
@@ -92,14 +101,17 @@ ChunkServerEmulator::Dispatch()
             }
         } else if (r->op == META_CHUNK_DELETE) {
             MetaChunkDelete* const mcd = static_cast<MetaChunkDelete*>(r);
-            if (mNumChunks > 0) {
-                mNumChunks--;
-                mUsedSpace -= gLayoutEmulator.GetChunkSize(mcd->chunkId);
-                if (mUsedSpace < 0 || mNumChunks <= 0) {
-                    mUsedSpace = 0;
-                }
-                mAllocSpace = mUsedSpace;
+            NotHostingChunk(gLayoutEmulator.GetChunkSize(mcd->chunkId));
+        } else if (r->op == META_CHUNK_STALENOTIFY) {
+            MetaChunkStaleNotify* const mcs =
+                static_cast<MetaChunkStaleNotify*>(r);
+            ChunkIdQueue::ConstIterator it(mcs->staleChunkIds);
+            const chunkId_t*            id;
+            while ((id = it.Next())) {
+                NotHostingChunk(gLayoutEmulator.GetChunkSize(*id));
             }
+        } else if (r->op == META_CHUNK_RETIRE) {
+            mRetiredFlag = true;
         } else {
             KFS_LOG_STREAM_ERROR << "unexpected op: " << r->Show() <<
             KFS_LOG_EOM;
@@ -57,6 +57,18 @@ public:
         mUsedSpace += chunksize;
         mAllocSpace = mUsedSpace;
     }
+    void NotHostingChunk(size_t chunksize)
+    {
+        if (mNumChunks <= 0) {
+            return;
+        }
+        mNumChunks--;
+        mUsedSpace -= chunksize;
+        if (mUsedSpace < 0 || mNumChunks <= 0) {
+            mUsedSpace = 0;
+        }
+        mAllocSpace = mUsedSpace;
+    }
     void SetRebalancePlanOutFd(ostream* os)
     {
         mOut = os;
@@ -78,6 +90,11 @@ public:
         mAllocSpace = 0;
         mUsedSpace  = 0;
     }
+    void SetWritableDrives(int numWritableDrives);
+    // Set when the meta server tells the server to retire, the layout
+    // emulator then removes the server.
+    bool IsRetired() const
+        { return mRetiredFlag; }
 
 protected:
     virtual void EnqueueSelf(MetaChunkRequest* r);
@@ -86,6 +103,7 @@ private:
     typedef vector<MetaChunkRequest*> PendingReqs;
     PendingReqs mPendingReqs;
     ostream*    mOut;
+    bool        mRetiredFlag;
 private:
     ChunkServerEmulator(const ChunkServerEmulator&);
     ChunkServerEmulator& operator=(const ChunkServerEmulator&);
@@ -32,16 +32,23 @@
 #include "common/MsgLogger.h"
 #include "common/RequestParser.h"
 #include "common/StBuffer.h"
+#include "common/time.h"
 #include "meta/kfstree.h"
 #include "meta/util.h"
+#include "meta/AuditLog.h"
+#include "qcdio/QCUtils.h"
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <fcntl.h>
+#include <unistd.h>
 
 #include <algorithm>
 #include <cerrno>
+#include <cmath>
 #include <fstream>
+#include <sstream>
 #include <boost/bind.hpp>
 
 namespace KFS
@@ -51,6 +58,15 @@ using std::string;
 using std::ifstream;
 using std::for_each;
 using std::ofstream;
+using std::sort;
+using std::unique;
+using std::ostringstream;
+using std::min;
+using std::max;
+using std::binary_search;
+using std::istringstream;
+using std::getline;
+using std::make_pair;
 using boost::bind;
 
 static inline ChunkServerEmulator&
@@ -61,7 +77,9 @@ GetCSEmulator(ChunkServer& server)
 
 int
 LayoutEmulator::LoadChunkmap(
-    const string& chunkLocationFn, bool addChunksToReplicationChecker)
+    const string& chunkLocationFn,
+    bool          addChunksToReplicationChecker,
+    bool          replaceReplicasFlag)
 {
     ifstream file(chunkLocationFn.c_str());
     if (! file) {
@@ -79,7 +97,8 @@ LayoutEmulator::LoadChunkmap(
     line[0] = 0;
     while (file.getline(line, kMaxLineSize) &&
             (len = file.gcount()) < kMaxLineSize - 1 &&
-            Parse(line, len, addChunksToReplicationChecker, loc)) {
+            Parse(line, len, addChunksToReplicationChecker,
+                replaceReplicasFlag, loc)) {
         lineno++;
     }
     const bool badFlag = file.bad();
@@ -99,6 +118,7 @@ LayoutEmulator::Parse(
     const char*       line,
     size_t            size,
     bool              addChunksToReplicationChecker,
+    bool              replaceReplicasFlag,
     ServerLocation&   loc)
 {
     // format of the file:
@@ -122,6 +142,18 @@ LayoutEmulator::Parse(
         KFS_LOG_STREAM_ERROR << "no such chunk: " << cid << KFS_LOG_EOM;
         return true;
     }
+    if (replaceReplicasFlag) {
+        Servers srvs;
+        mChunkToServerMap.GetServers(*ci, srvs);
+        const size_t size = GetChunkSize(*ci);
+        for (Servers::const_iterator it = srvs.begin();
+                it != srvs.end();
+                ++it) {
+            if (mChunkToServerMap.RemoveServer(*it, *ci)) {
+                GetCSEmulator(**it).NotHostingChunk(size);
+            }
+        }
+    }
     for (int i = 0; i < numServers; i++) {
         while (p < end && (*p & 0xFF) <= ' ') {
             p++;
@@ -187,6 +219,10 @@ LayoutEmulator::ChunkReplicationDone(MetaChunkReplicate* req)
     if (req->srcLocation.IsValid() && req->dataServer) {
         req->dataServer->UpdateReplicationReadLoad(-1);
     }
+    const RackId srcRack       =
+        req->dataServer ? req->dataServer->GetRack() : RackId(-1);
+    const bool   crossRackFlag = req->dataServer &&
+        srcRack != req->server->GetRack();
     req->dataServer.reset();
     if (req->status != 0) {
         // Replication failed...we will try again later
@@ -210,8 +246,13 @@ LayoutEmulator::ChunkReplicationDone(MetaChunkReplicate* req)
     }
     const bool addedFlag = AddReplica(*ci, req->server);
     if (addedFlag) {
-        GetCSEmulator(*(req->server)).HostingChunk(
-            req->chunkId, GetChunkSize(*ci));
+        const size_t size = GetChunkSize(*ci);
+        GetCSEmulator(*(req->server)).HostingChunk(req->chunkId, size);
+        mBytesRebalanced += size;
+        if (crossRackFlag) {
+            mCrossRackBytesRebalanced += size;
+        }
+        mRackTraffic[make_pair(srcRack, req->server->GetRack())] += size;
     } else {
             KFS_LOG_STREAM_ERROR <<
                 "chunk: "        << req->chunkId <<
@@ -313,6 +354,16 @@ LayoutEmulator::AddServer(
     srv.InitSpace(totalSpace, usedSpace, mUseFsTotalSpaceFlag);
 
     mChunkToServerMap.AddServer(c);
+    // Network definition has no drive count, assume one writable drive, as
+    // otherwise the server can never be chosen as re-balance destination.
+    srv.SetWritableDrives(1);
+    // Emulated servers are added as slaves, account for them in order to
+    // keep the masters and slaves counts consistent on server down.
+    if (srv.CanBeChunkMaster()) {
+        mMastersCount++;
+    } else {
+        mSlavesCount++;
+    }
     mLoc2Server.insert(make_pair(loc, c));
     mChunkServers.push_back(c);
     RackInfos::iterator const it = find_if(
@@ -368,9 +419,22 @@ LayoutEmulator::RunChunkserverOps()
         if (mChunkServers.size() <= i) {
             break;
         }
-        if (&*mChunkServers[i] == &srv) {
-            UpdateSrvLoadAvg(srv, 0);
+        if (&*mChunkServers[i] != &srv) {
+            continue;
+        }
+        if (GetCSEmulator(srv).IsRetired()) {
+            // Retired server disconnects.
+            const ChunkServerPtr ptr = mChunkServers[i];
+            MarkServerDown(srv.GetServerLocation());
+            if (mChunkServers.size() <= i) {
+                break;
+            }
+            if (&*mChunkServers[i] != &srv) {
+                i--;
+            }
+            continue;
         }
+        UpdateSrvLoadAvg(srv, 0, IsInRebalancePartition(srv));
     }
     return opsCount;
 }
@@ -480,6 +544,176 @@ LayoutEmulator::BuildRebalancePlan()
     }
 }
 
+void
+LayoutEmulator::SetRebalancePartition(int idx, int count)
+{
+    // Assign racks to the partitions round robin. Each partition moves only
+    // the replicas hosted in its racks, and only to its racks. With disjoint
+    // racks sets the partitions' plans can not conflict with each other, and
+    // the rack aware placement constraints are preserved.
+    RackIds rackIds;
+    for (Servers::const_iterator it = mChunkServers.begin();
+            it != mChunkServers.end();
+            ++it) {
+        rackIds.push_back((*it)->GetRack());
+    }
+    sort(rackIds.begin(), rackIds.end());
+    rackIds.erase(unique(rackIds.begin(), rackIds.end()), rackIds.end());
+    mRebalanceSrcRackIds.clear();
+    for (size_t i = 0; i < rackIds.size(); i++) {
+        if ((int)(i % count) == idx) {
+            mRebalanceSrcRackIds.push_back(rackIds[i]);
+        }
+    }
+    for (Servers::const_iterator it = mChunkServers.begin();
+            it != mChunkServers.end();
+            ++it) {
+        UpdateSrvLoadAvg(**it, 0, IsInRebalancePartition(**it));
+    }
+}
+
+bool
+LayoutEmulator::IsInRebalancePartition(const ChunkServer& srv) const
+{
+    return (mRebalanceSrcRackIds.empty() ||
+        binary_search(mRebalanceSrcRackIds.begin(), mRebalanceSrcRackIds.end(),
+            srv.GetRack()));
+}
+
+int
+LayoutEmulator::BuildPartitionedRebalancePlan(
+    int numWorkers, const string& rebalancePlanFn)
+{
+    // The layout manager and the meta tree are process wide, therefore
+    // partitions are planned by the child processes, each with its own copy
+    // of the already loaded state.
+    if (numWorkers <= 1) {
+        return 0;
+    }
+    mPlanFile.flush();
+    vector<pid_t>  pids;
+    vector<string> planFileNames;
+    MsgLogger* const logger = MsgLogger::GetLogger();
+    int              status = 0;
+    for (int i = 0; i < numWorkers; i++) {
+        ostringstream os;
+        os << rebalancePlanFn << "." << i;
+        planFileNames.push_back(os.str());
+        if (logger) {
+            logger->PrepareToFork();
+        }
+        AuditLog::PrepareToFork();
+        const pid_t pid = fork();
+        if (pid == 0) {
+            // The logger's mutex remains locked in the child, turn off
+            // logging in order to prevent dead lock.
+            if (logger) {
+                logger->ChildAtFork();
+                logger->SetLogLevel(
+                    MsgLogger::LogLevel(MsgLogger::kLogLevelFATAL - 1));
+            }
+            AuditLog::ChildAtFork();
+            SetRebalancePartition(i, numWorkers);
+            int ret = SetRebalancePlanOutFile(planFileNames.back());
+            if (ret == 0) {
+                BuildRebalancePlan();
+                mPlanFile.close();
+                ret = mPlanFile.fail() ? -EIO : 0;
+            }
+            _exit(ret == 0 ? 0 : 1); // Child does not do graceful exit.
+        }
+        if (logger) {
+            logger->ForkDone();
+        }
+        AuditLog::ForkDone();
+        if (pid < 0) {
+            status = errno > 0 ? -errno : -1;
+            KFS_LOG_STREAM_ERROR << "fork: " << QCUtils::SysError(-status) <<
+            KFS_LOG_EOM;
+            break;
+        }
+        pids.push_back(pid);
+    }
+    for (vector<pid_t>::const_iterator it = pids.begin();
+            it != pids.end();
+            ++it) {
+        int   exitStatus = 0;
+        pid_t ret;
+        while ((ret = waitpid(*it, &exitStatus, 0)) < 0 && errno == EINTR)
+            {}
+        if (ret != *it || ! WIFEXITED(exitStatus) ||
+                WEXITSTATUS(exitStatus) != 0) {
+            KFS_LOG_STREAM_ERROR << "re-balance planner: " << *it <<
+                " status: " << exitStatus <<
+            KFS_LOG_EOM;
+            if (status == 0) {
+                status = -EIO;
+            }
+        }
+    }
+    // Execute partitions' plans. The moves executed are written into the plan
+    // file.
+    for (size_t i = 0; i < pids.size() && status == 0 && ! mStopFlag; i++) {
+        status = ApplyRebalancePlan(planFileNames[i]);
+        KFS_LOG_STREAM_START(MsgLogger::kLogLevelNOTICE, logStream);
+            ostream& os = logStream.GetStream();
+            os << "applied partition: " << i << " plan:";
+            ShowRebalanceStats(os, " ");
+        KFS_LOG_STREAM_END;
+    }
+    for (size_t i = 0; i < planFileNames.size(); i++) {
+        unlink(planFileNames[i].c_str());
+    }
+    return status;
+}
+
+int
+LayoutEmulator::ApplyRebalancePlan(const string& rebalancePlanFn)
+{
+    const int status = LoadRebalancePlan(rebalancePlanFn);
+    if (status != 0) {
+        return status;
+    }
+    ExecuteRebalancePlan();
+    // Reset the plan name, in order to allow to load the same plan again.
+    LoadRebalancePlan(string());
+    return 0;
+}
+
+void
+LayoutEmulator::ShowRebalanceStats(ostream& os, const char* prefix) const
+{
+    double sum   = 0;
+    double sumSq = 0;
+    double minU  = 1;
+    double maxU  = 0;
+    for (Servers::const_iterator it = mChunkServers.begin();
+            it != mChunkServers.end();
+            ++it) {
+        const double util = (*it)->GetSpaceUtilization(mUseFsTotalSpaceFlag);
+        sum   += util;
+        sumSq += util * util;
+        minU   = min(minU, util);
+        maxU   = max(maxU, util);
+    }
+    const size_t cnt  = mChunkServers.size();
+    const double avg  = cnt > 0 ? sum / cnt : 0.;
+    const double var  = cnt > 0 ? max(0., sumSq / cnt - avg * avg) : 0.;
+    const char*  pref = prefix ? prefix : "";
+    os <<
+        pref << "servers: "          << cnt <<
+        pref << "utilization:"
+        " average: "                 << avg <<
+        " min: "                     << (cnt > 0 ? minU : 0.) <<
+        " max: "                     << maxU <<
+        " variance: "                << var <<
+        " stddev: "                  << sqrt(var) <<
+        pref << "replicated chunks: " << mNumBlksRebalanced <<
+        pref << "bytes moved: "      << mBytesRebalanced <<
+        pref << "cross rack bytes: " << mCrossRackBytesRebalanced
+    ;
+}
+
 void
 LayoutEmulator::ExecuteRebalancePlan()
 {
@@ -920,6 +1154,571 @@ LayoutEmulator::RunFsck(
     return err;
 }
 
+bool
+LayoutEmulator::ChooseAllocationServers(
+    ChunkPlacement& placement,
+    int             numReplicas,
+    Servers&        servers)
+{
+    // Mimic AllocateChunk(): one replica per rack.
+    placement.clear();
+    placement.FindCandidates();
+    servers.clear();
+    for (; ;) {
+        const ChunkServerPtr cs = placement.GetNext(false);
+        if (cs && (! placement.IsUsingServerExcludes() ||
+                find(servers.begin(), servers.end(), cs) ==
+                    servers.end())) {
+            servers.push_back(cs);
+        }
+        if ((int)servers.size() >= numReplicas ||
+                placement.IsLastRack() ||
+                ! placement.NextRack()) {
+            break;
+        }
+    }
+    return ((int)servers.size() >= numReplicas);
+}
+
+void
+LayoutEmulator::AddBenchServers(
+    int     count,
+    int     numRacks,
+    int64_t totalSpace,
+    double  maxUtilization,
+    int     numWritableDrives)
+{
+    for (int i = 0, k = 0; i < count; k++) {
+        ostringstream hs;
+        hs << "10." << ((k >> 16) & 0xFF) << "." << ((k >> 8) & 0xFF) <<
+            "." << (k & 0xFF);
+        const ServerLocation loc(hs.str(), 22000);
+        if (mLoc2Server.find(loc) != mLoc2Server.end() ||
+                mDownServers.find(loc) != mDownServers.end()) {
+            continue;
+        }
+        AddServer(loc, i % numRacks, totalSpace, 0);
+        ChunkServerEmulator& srv = GetCSEmulator(*mChunkServers.back());
+        srv.HostingChunk(-1, (size_t)(totalSpace *
+            maxUtilization * Rand(1000) / 1000));
+        srv.SetWritableDrives(numWritableDrives);
+        UpdateSrvLoadAvg(srv, 0);
+        i++;
+    }
+}
+
+int
+LayoutEmulator::RunPlacementBenchmark(
+    int      numServers,
+    int      numRacks,
+    int      numWritableDrives,
+    double   maxUtilization,
+    int      numReplicas,
+    int64_t  numAllocations,
+    ostream& os)
+{
+    if (numServers <= 0 || numRacks <= 0 || numReplicas <= 0 ||
+            numAllocations <= 0 || numWritableDrives <= 0) {
+        KFS_LOG_STREAM_ERROR << "invalid placement benchmark parameters" <<
+        KFS_LOG_EOM;
+        return -EINVAL;
+    }
+    const int64_t kTotalSpace = int64_t(4) << 40;
+    AddBenchServers(numServers, numRacks, kTotalSpace, maxUtilization,
+        numWritableDrives);
+    typedef map<const ChunkServer*, int64_t> Counts;
+    Counts         counts;
+    vector<const ChunkServer*> chosen;
+    chosen.reserve((size_t)(numAllocations * numReplicas));
+    ChunkPlacement placement;
+    Servers        servers;
+    int64_t        shortCount = 0;
+    int64_t        sameRackCount = 0;
+    const int64_t  start = microseconds();
+    for (int64_t i = 0; i < numAllocations; i++) {
+        if (! ChooseAllocationServers(placement, numReplicas, servers)) {
+            shortCount++;
+        }
+        for (Servers::const_iterator it = servers.begin();
+                it != servers.end();
+                ++it) {
+            chosen.push_back(it->get());
+            for (Servers::const_iterator ni = it + 1;
+                    ni != servers.end();
+                    ++ni) {
+                if ((*ni)->GetRack() == (*it)->GetRack()) {
+                    sameRackCount++;
+                    break;
+                }
+            }
+        }
+    }
+    const int64_t elapsed = max(int64_t(1), microseconds() - start);
+    for (vector<const ChunkServer*>::const_iterator it = chosen.begin();
+            it != chosen.end();
+            ++it) {
+        counts[*it]++;
+    }
+    int64_t minCount = counts.empty() ? 0 : counts.begin()->second;
+    int64_t maxCount = minCount;
+    for (Counts::const_iterator it = counts.begin();
+            it != counts.end();
+            ++it) {
+        minCount = min(minCount, it->second);
+        maxCount = max(maxCount, it->second);
+    }
+    os <<
+        "servers: "          << numServers <<
+        " racks: "           << numRacks <<
+        " replicas: "        << numReplicas <<
+        " allocations: "     << numAllocations <<
+        "\nelapsed usec: "   << elapsed <<
+        " usec/allocation: " << (double)elapsed / numAllocations <<
+        " allocations/sec: " << numAllocations * 1e6 / elapsed <<
+        "\nreplicas chosen: " << chosen.size() <<
+        " short allocations: " << shortCount <<
+        " same rack replicas: " << sameRackCount <<
+        "\nservers used: "   << counts.size() <<
+        " replicas per server: min: " << minCount <<
+        " max: "             << maxCount <<
+        " avg: "             << (double)chosen.size() / numServers <<
+    "\n";
+    return 0;
+}
+
+int
+LayoutEmulator::AllocateBenchChunks(
+    int64_t     count,
+    int         numReplicas,
+    int         chunksPerFile,
+    BenchStats& stats)
+{
+    ChunkPlacement placement;
+    Servers        servers;
+    MetaFattr*     fa     = 0;
+    fid_t          fid    = -1;
+    chunkOff_t     offset = 0;
+    for (int64_t i = 0; i < count; i++) {
+        if (! fa ||
+                (chunkOff_t)chunksPerFile * (chunkOff_t)CHUNKSIZE <= offset) {
+            ostringstream os;
+            os << "layoutbench." << mNextFileNum++;
+            fid_t     todumpster = -1;
+            fid = 0;
+            const int status     = metatree.create(ROOTFID, os.str(), &fid,
+                numReplicas, true, KFS_STRIPED_FILE_TYPE_NONE, 0, 0, 0,
+                todumpster, kKfsUserRoot, kKfsGroupRoot, 0644,
+                kKfsUserRoot, kKfsGroupRoot, &fa);
+            if (status != 0) {
+                KFS_LOG_STREAM_ERROR << "create: " << os.str() <<
+                    " " << QCUtils::SysError(-status) <<
+                KFS_LOG_EOM;
+                return status;
+            }
+            offset = 0;
+        }
+        const chunkId_t chunkId = chunkID.genid();
+        const int       status  = metatree.assignChunkId(
+            fid, offset, chunkId, 1);
+        if (status != 0) {
+            KFS_LOG_STREAM_ERROR << "allocate: file: " << fid <<
+                " pos: " << offset <<
+                " " << QCUtils::SysError(-status) <<
+            KFS_LOG_EOM;
+            return status;
+        }
+        // Assume that the chunk is written in full.
+        offset += (chunkOff_t)CHUNKSIZE;
+        metatree.setFileSize(fa, offset);
+        CSMap::Entry* const entry = mChunkToServerMap.Find(chunkId);
+        if (! entry) {
+            KFS_LOG_STREAM_ERROR << "allocate: no such chunk: " << chunkId <<
+            KFS_LOG_EOM;
+            return -EFAULT;
+        }
+        // Only account for the server selection, the rest is book keeping.
+        const int64_t start = microseconds();
+        if (! ChooseAllocationServers(placement, numReplicas, servers)) {
+            stats.allocShortCount++;
+        }
+        stats.allocUsec += microseconds() - start;
+        stats.allocCount++;
+        for (Servers::const_iterator it = servers.begin();
+                it != servers.end();
+                ++it) {
+            if (AddReplica(*entry, *it)) {
+                ChunkServerEmulator& srv = GetCSEmulator(**it);
+                srv.HostingChunk(chunkId, CHUNKSIZE);
+                UpdateSrvLoadAvg(srv, 0);
+            }
+        }
+    }
+    return 0;
+}
+
+void
+LayoutEmulator::BenchServerDown(
+    const ServerLocation& loc,
+    bool                  restartFlag,
+    BenchStats&           stats)
+{
+    Loc2Server::const_iterator const it = mLoc2Server.find(loc);
+    if (it == mLoc2Server.end()) {
+        KFS_LOG_STREAM_ERROR <<
+            "server down: no such server: " << loc <<
+        KFS_LOG_EOM;
+        return;
+    }
+    if (restartFlag) {
+        // Save the server's replicas, in order to bring them back on restart.
+        const ChunkServerPtr& srv = it->second;
+        DownServer&           ds  = mDownServers[loc];
+        ds.rack           = srv->GetRack();
+        ds.totalSpace     = srv->GetTotalSpace(mUseFsTotalSpaceFlag);
+        ds.usedSpace      = srv->GetUsedSpace();
+        ds.writableDrives = max(1, srv->GetNumWritableDrives());
+        ds.chunkIds.clear();
+        mChunkToServerMap.First();
+        for (const CSMap::Entry* entry;
+                (entry = mChunkToServerMap.Next()); ) {
+            if (mChunkToServerMap.HasServer(srv, *entry)) {
+                ds.chunkIds.push_back(entry->GetChunkId());
+                ds.usedSpace -= GetChunkSize(*entry);
+            }
+        }
+        ds.usedSpace = max(int64_t(0), ds.usedSpace);
+    }
+    const int64_t start = microseconds();
+    MarkServerDown(loc);
+    stats.failUsec += microseconds() - start;
+    stats.failCount++;
+}
+
+int
+LayoutEmulator::BenchServerUp(const ServerLocation& loc)
+{
+    DownServers::iterator const it = mDownServers.find(loc);
+    if (it == mDownServers.end()) {
+        KFS_LOG_STREAM_ERROR <<
+            "server up: no such down server: " << loc <<
+        KFS_LOG_EOM;
+        return -ENOENT;
+    }
+    const DownServer& ds = it->second;
+    AddServer(loc, ds.rack, ds.totalSpace, ds.usedSpace);
+    const ChunkServerPtr srv = mChunkServers.back();
+    ChunkServerEmulator& cse = GetCSEmulator(*srv);
+    cse.SetWritableDrives(ds.writableDrives);
+    int count = 0;
+    for (vector<chunkId_t>::const_iterator ci = ds.chunkIds.begin();
+            ci != ds.chunkIds.end();
+            ++ci) {
+        CSMap::Entry* const entry = mChunkToServerMap.Find(*ci);
+        if (! entry || ! AddReplica(*entry, srv)) {
+            continue;
+        }
+        cse.HostingChunk(*ci, GetChunkSize(*entry));
+        CheckChunkReplication(*entry);
+        count++;
+    }
+    UpdateSrvLoadAvg(cse, 0);
+    mDownServers.erase(it);
+    return count;
+}
+
+void
+LayoutEmulator::GetDataAtRisk(DataAtRisk& risk)
+{
+    risk = DataAtRisk();
+    mChunkToServerMap.First();
+    for (const CSMap::Entry* entry; (entry = mChunkToServerMap.Next()); ) {
+        const MetaFattr* const fa       = entry->GetFattr();
+        const size_t           count    =
+            mChunkToServerMap.ServerCount(*entry);
+        const size_t           replicas =
+            (fa && fa->numReplicas > 0) ? (size_t)fa->numReplicas : 1;
+        if (count <= 0) {
+            risk.lost++;
+            risk.lostBytes += GetChunkSize(*entry);
+        } else if (count < replicas) {
+            risk.underReplicated++;
+            if (count == 1) {
+                risk.atRisk++;
+                risk.atRiskBytes += GetChunkSize(*entry);
+            }
+        }
+    }
+}
+
+static ostream&
+ShowDataAtRisk(ostream& os, const char* prefix, int64_t underReplicated,
+    int64_t atRisk, int64_t atRiskBytes, int64_t lost, int64_t lostBytes)
+{
+    return (os << prefix <<
+        " under replicated: " << underReplicated <<
+        " single replica: "   << atRisk <<
+        " bytes: "            << atRiskBytes <<
+        " lost: "             << lost <<
+        " bytes: "            << lostBytes <<
+    "\n");
+}
+
+void
+LayoutEmulator::RunRecovery(
+    ostream&    os,
+    int         riskSampleInterval,
+    double      roundTimeSec,
+    BenchStats& stats)
+{
+    PrepareRebalance(false);
+
+    const int     startBlks      = mNumBlksRebalanced;
+    const int64_t startBytes     = mBytesRebalanced;
+    const int64_t startSchedUsec = stats.schedUsec;
+    int64_t       round          = 0;
+    int64_t       lastRound      = 0;
+    int           idleRounds     = 0;
+    DataAtRisk    risk;
+    for (; ;) {
+        if (0 < riskSampleInterval && round % riskSampleInterval == 0) {
+            GetDataAtRisk(risk);
+            ostringstream prefix;
+            prefix << "round: " << round <<
+                " time: " << round * roundTimeSec;
+            ShowDataAtRisk(os, prefix.str().c_str(), risk.underReplicated,
+                risk.atRisk, risk.atRiskBytes, risk.lost, risk.lostBytes);
+            stats.riskSamples++;
+            stats.atRiskChunkRounds += risk.atRisk * riskSampleInterval;
+        }
+        if (mCleanupScheduledFlag) {
+            ScheduleCleanup();
+        }
+        const int64_t start = microseconds();
+        ChunkReplicationChecker();
+        stats.schedUsec += microseconds() - start;
+        stats.schedCount++;
+        const int    prev     = mNumBlksRebalanced;
+        const size_t opsCount = RunChunkserverOps();
+        round++;
+        if (prev != mNumBlksRebalanced) {
+            lastRound = round;
+        }
+        if (mStopFlag || mChunkServers.empty()) {
+            break;
+        }
+        if (opsCount <= 0 &&
+                mNumOngoingReplications <= 0 &&
+                ! mCleanupScheduledFlag &&
+                ! mChunkToServerMap.Front(
+                    CSMap::Entry::kStateCheckReplication)) {
+            // Let the next check pick up chunks that have no destination.
+            if (1 < ++idleRounds) {
+                break;
+            }
+        } else {
+            idleRounds = 0;
+        }
+    }
+    GetDataAtRisk(risk);
+    const int     replications = mNumBlksRebalanced - startBlks;
+    const int64_t schedUsec    = stats.schedUsec - startSchedUsec;
+    stats.rounds           += round;
+    stats.replicationCount += replications;
+    stats.lostChunks        = risk.lost;
+    os <<
+        "recovery:"
+        " rounds: "          << lastRound <<
+        " makespan sec: "    << lastRound * roundTimeSec <<
+        " replications: "    << replications <<
+        " bytes: "           << (mBytesRebalanced - startBytes) <<
+        " scheduling usec: " << schedUsec <<
+        " usec/replication: " <<
+            (replications > 0 ? (double)schedUsec / replications : 0.) <<
+    "\n";
+    ShowDataAtRisk(os, "remaining:", risk.underReplicated,
+        risk.atRisk, risk.atRiskBytes, risk.lost, risk.lostBytes);
+}
+
+void
+LayoutEmulator::ShowRackTraffic(ostream& os) const
+{
+    for (RackTraffic::const_iterator it = mRackTraffic.begin();
+            it != mRackTraffic.end();
+            ++it) {
+        os << "rack traffic: " << it->first.first <<
+            " -> "      << it->first.second <<
+            " bytes: "  << it->second <<
+        "\n";
+    }
+}
+
+static int64_t
+GetBenchIntArg(const vector<string>& args, size_t idx, int64_t defVal)
+{
+    return (idx < args.size() ?
+        (int64_t)strtoll(args[idx].c_str(), 0, 0) : defVal);
+}
+
+static double
+GetBenchDoubleArg(const vector<string>& args, size_t idx, double defVal)
+{
+    return (idx < args.size() ? atof(args[idx].c_str()) : defVal);
+}
+
+int
+LayoutEmulator::RunTraceBenchmark(
+    istream& trace,
+    ostream& os,
+    int      riskSampleInterval,
+    double   roundTimeSec)
+{
+    BenchStats     stats;
+    string         line;
+    vector<string> args;
+    int            lineNum = 0;
+    int            status  = 0;
+    while (status == 0 && ! mStopFlag && getline(trace, line)) {
+        lineNum++;
+        args.clear();
+        istringstream is(line);
+        string        arg;
+        while (is >> arg) {
+            args.push_back(arg);
+        }
+        if (args.empty() || args[0][0] == '#') {
+            continue;
+        }
+        os << "=== " << line << "\n";
+        const string&        cmd = args[0];
+        const ServerLocation loc(1 < args.size() ? args[1] : string(),
+            (int)GetBenchIntArg(args, 2, -1));
+        if (cmd == "servers") {
+            const int count = (int)GetBenchIntArg(args, 1, 0);
+            const int racks = (int)GetBenchIntArg(args, 2, 0);
+            if (count <= 0 || racks <= 0) {
+                status = -EINVAL;
+                break;
+            }
+            AddBenchServers(count, racks,
+                (int64_t)(GetBenchDoubleArg(args, 3, 4) * (int64_t(1) << 40)),
+                GetBenchDoubleArg(args, 4, 0) * 1e-2,
+                max(1, (int)GetBenchIntArg(args, 5, 12)));
+            os << "servers: " << mChunkServers.size() <<
+                " racks: " << mRacks.size() << "\n";
+        } else if (cmd == "allocate") {
+            const int64_t count     = GetBenchIntArg(args, 1, 0);
+            const int64_t usec      = stats.allocUsec;
+            const int64_t prevShort = stats.allocShortCount;
+            if (count <= 0) {
+                status = -EINVAL;
+                break;
+            }
+            status = AllocateBenchChunks(count,
+                max(1, (int)GetBenchIntArg(args, 2, 3)),
+                max(1, (int)GetBenchIntArg(args, 3, 1)), stats);
+            os <<
+                "allocations: "       << count <<
+                " usec/allocation: "  <<
+                    (double)(stats.allocUsec - usec) / count <<
+                " short allocations: " <<
+                    (stats.allocShortCount - prevShort) <<
+            "\n";
+        } else if (cmd == "fail" || cmd == "down") {
+            if (! loc.IsValid()) {
+                status = -EINVAL;
+                break;
+            }
+            const int64_t usec = stats.failUsec;
+            BenchServerDown(loc, cmd == "down", stats);
+            os << "server down usec: " << (stats.failUsec - usec) << "\n";
+        } else if (cmd == "up") {
+            if (! loc.IsValid()) {
+                status = -EINVAL;
+                break;
+            }
+            const int count = BenchServerUp(loc);
+            if (count < 0) {
+                status = count;
+                break;
+            }
+            os << "restarted replicas: " << count << "\n";
+        } else if (cmd == "failrack") {
+            const RackId           rack = (RackId)GetBenchIntArg(args, 1, -1);
+            vector<ServerLocation> locs;
+            for (Servers::const_iterator it = mChunkServers.begin();
+                    it != mChunkServers.end();
+                    ++it) {
+                if ((*it)->GetRack() == rack) {
+                    locs.push_back((*it)->GetServerLocation());
+                }
+            }
+            const int64_t usec = stats.failUsec;
+            for (vector<ServerLocation>::const_iterator it = locs.begin();
+                    it != locs.end();
+                    ++it) {
+                BenchServerDown(*it, false, stats);
+            }
+            os << "servers down: " << locs.size() <<
+                " usec: " << (stats.failUsec - usec) << "\n";
+        } else if (cmd == "decommission") {
+            if (! loc.IsValid()) {
+                status = -EINVAL;
+                break;
+            }
+            mAllowChunkServerRetireFlag = true;
+            status = RetireServer(loc, 0);
+        } else if (cmd == "recover") {
+            RunRecovery(os, riskSampleInterval, roundTimeSec, stats);
+        } else if (cmd == "rebalance") {
+            SetupForRebalancePlanning(GetBenchDoubleArg(args, 1, 10));
+            const int64_t start = microseconds();
+            BuildRebalancePlan();
+            os << "rebalance usec: " << (microseconds() - start) << "\n";
+            ShowRebalanceStats(os, "\n");
+            os << "\n";
+        } else if (cmd == "stats") {
+            DataAtRisk risk;
+            GetDataAtRisk(risk);
+            ShowRebalanceStats(os, "\n");
+            os << "\n";
+            ShowRackTraffic(os);
+            ShowDataAtRisk(os, "data:", risk.underReplicated,
+                risk.atRisk, risk.atRiskBytes, risk.lost, risk.lostBytes);
+        } else {
+            status = -EINVAL;
+        }
+    }
+    if (status != 0) {
+        KFS_LOG_STREAM_ERROR <<
+            "trace line: " << lineNum << ": " << line <<
+            " " << QCUtils::SysError(-status) <<
+        KFS_LOG_EOM;
+        return status;
+    }
+    os <<
+        "=== summary"
+        "\nallocations: "       << stats.allocCount <<
+        " usec/allocation: "    << (stats.allocCount > 0 ?
+            (double)stats.allocUsec / stats.allocCount : 0.) <<
+        " short allocations: "  << stats.allocShortCount <<
+        "\nserver failures: "   << stats.failCount <<
+        " usec/failure: "       << (stats.failCount > 0 ?
+            (double)stats.failUsec / stats.failCount : 0.) <<
+        "\nreplication checks: " << stats.schedCount <<
+        " usec/check: "         << (stats.schedCount > 0 ?
+            (double)stats.schedUsec / stats.schedCount : 0.) <<
+        " replications: "       << stats.replicationCount <<
+        " usec/replication: "   << (stats.replicationCount > 0 ?
+            (double)stats.schedUsec / stats.replicationCount : 0.) <<
+        "\nrecovery rounds: "   << stats.rounds <<
+        " time sec: "           << stats.rounds * roundTimeSec <<
+        " single replica chunk seconds: " <<
+            stats.atRiskChunkRounds * roundTimeSec <<
+        " lost chunks: "        << stats.lostChunks <<
+    "\n";
+    return 0;
+}
+
 LayoutEmulator gLayoutEmulator;
 LayoutManager& gLayoutManager = gLayoutEmulator;
 
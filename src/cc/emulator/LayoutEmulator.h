@@ -34,14 +34,18 @@
 #include <map>
 #include <vector>
 #include <fstream>
+#include <istream>
+#include <utility>
 #include "meta/LayoutManager.h"
 
 namespace KFS
 {
 using std::ofstream;
+using std::istream;
 using std::map;
 using std::vector;
 using std::string;
+using std::pair;
 
 class LayoutEmulator : public LayoutManager
 {
@@ -49,9 +53,14 @@ public:
     LayoutEmulator()
         : mVariationFromMean(0),
           mNumBlksRebalanced(0),
+          mBytesRebalanced(0),
+          mCrossRackBytesRebalanced(0),
           mStopFlag(false),
           mPlanFile(),
-          mLoc2Server()
+          mLoc2Server(),
+          mRackTraffic(),
+          mDownServers(),
+          mNextFileNum(0)
     {
         SetMinChunkserversToExitRecovery(0);
         ToggleRebalancing(true);
@@ -61,9 +70,13 @@ public:
         mPlanFile.close();
     }
     // Given a chunk->location data in a file, rebuild the chunk->location map.
+    // With replace replicas flag set the chunk locations in the file replace
+    // the existing ones, this is used to load the chunk map changes ("delta")
+    // since the previous chunk map was created.
     //
     int LoadChunkmap(const string& chunkLocationFn,
-        bool addChunksToReplicationChecker = false);
+        bool addChunksToReplicationChecker = false,
+        bool replaceReplicasFlag           = false);
     void AddServer(const ServerLocation& loc,
         int rack, uint64_t totalSpace, uint64_t usedSpace);
     void SetupForRebalancePlanning(
@@ -74,6 +87,14 @@ public:
     }
     int SetRebalancePlanOutFile(const string& rebalancePlanFn);
     void BuildRebalancePlan();
+    // Partition the racks between the specified number of worker processes,
+    // and plan re-balancing within each partition in parallel. The resulting
+    // plans are executed, and written into the re-balance plan out file.
+    int BuildPartitionedRebalancePlan(int numWorkers,
+        const string& rebalancePlanFn);
+    // Execute re-balance plan, for example previously created plan in order to
+    // create incremental plan.
+    int ApplyRebalancePlan(const string& rebalancePlanFn);
     bool ChunkReplicationDone(MetaChunkReplicate* req);
     void ExecuteRebalancePlan();
     void PrintChunkserverBlockCount(ostream& os) const;
@@ -87,20 +108,117 @@ public:
     {
         return mNumBlksRebalanced;
     }
+    void ClearRebalanceStats()
+    {
+        mNumBlksRebalanced        = 0;
+        mBytesRebalanced          = 0;
+        mCrossRackBytesRebalanced = 0;
+        mRackTraffic.clear();
+    }
+    // Plan quality metrics: space utilization variance, bytes moved, and
+    // cross rack bytes moved.
+    void ShowRebalanceStats(ostream& os, const char* prefix = "") const;
     void Stop()
     {
         mStopFlag = true;
     }
     int RunFsck(const string& fileName);
+    // Add emulated chunk servers, and measure chunk placement cost by
+    // choosing servers for the specified number of chunk allocations.
+    int RunPlacementBenchmark(int numServers, int numRacks,
+        int numWritableDrives, double maxUtilization, int numReplicas,
+        int64_t numAllocations, ostream& os);
+    // Replay workload trace, and report placement and recovery metrics.
+    // Trace commands, one per line, empty lines and lines starting with #
+    // are ignored:
+    // servers <count> <racks> [<space TB> [<max utilization %> [<drives>]]]
+    // allocate <chunks> [<replicas> [<chunks per file>]]
+    // fail <host> <port>         -- server is lost with all its replicas
+    // down <host> <port>         -- server goes down, but can be restarted
+    // up <host> <port>           -- restart server with its replicas
+    // failrack <rack>            -- all servers in the rack are lost
+    // decommission <host> <port> -- evacuate chunks, and retire server
+    // recover                    -- re-replicate until no work is left
+    // rebalance [<% variation from average utilization>]
+    // stats
+    // Recovery time model: every emulation round each server can complete
+    // up to max concurrent replications per node, and each replication of
+    // a chunk takes roundTimeSec.
+    int RunTraceBenchmark(istream& trace, ostream& os,
+        int riskSampleInterval, double roundTimeSec);
 private:
     typedef map<ServerLocation, ChunkServerPtr> Loc2Server;
+    typedef map<pair<RackId, RackId>, int64_t>  RackTraffic;
+    struct DownServer
+    {
+        DownServer()
+            : rack(-1),
+              totalSpace(0),
+              usedSpace(0),
+              writableDrives(1),
+              chunkIds()
+            {}
+        RackId            rack;
+        int64_t           totalSpace;
+        int64_t           usedSpace;
+        int               writableDrives;
+        vector<chunkId_t> chunkIds;
+    };
+    typedef map<ServerLocation, DownServer> DownServers;
+    struct BenchStats
+    {
+        BenchStats()
+            : allocCount(0),
+              allocUsec(0),
+              allocShortCount(0),
+              failCount(0),
+              failUsec(0),
+              schedUsec(0),
+              schedCount(0),
+              replicationCount(0),
+              rounds(0),
+              riskSamples(0),
+              atRiskChunkRounds(0),
+              lostChunks(0)
+            {}
+        int64_t allocCount;
+        int64_t allocUsec;
+        int64_t allocShortCount;
+        int64_t failCount;
+        int64_t failUsec;
+        int64_t schedUsec;
+        int64_t schedCount;
+        int64_t replicationCount;
+        int64_t rounds;
+        int64_t riskSamples;
+        int64_t atRiskChunkRounds;
+        int64_t lostChunks;
+    };
+    struct DataAtRisk
+    {
+        DataAtRisk()
+            : underReplicated(0),
+              atRisk(0),
+              atRiskBytes(0),
+              lost(0),
+              lostBytes(0)
+            {}
+        int64_t underReplicated;
+        int64_t atRisk;
+        int64_t atRiskBytes;
+        int64_t lost;
+        int64_t lostBytes;
+    };
     class PlacementVerifier;
 
     size_t RunChunkserverOps();
     void CalculateRebalaceThresholds();
     void PrepareRebalance(bool enableRebalanceFlag);
     bool Parse(const char* line, size_t size,
-        bool addChunksToReplicationChecker, ServerLocation& loc);
+        bool addChunksToReplicationChecker, bool replaceReplicasFlag,
+        ServerLocation& loc);
+    void SetRebalancePartition(int idx, int count);
+    bool IsInRebalancePartition(const ChunkServer& srv) const;
     void ShowPlacementError(
         ostream&            os,
         const CSMap::Entry& c,
@@ -118,16 +236,34 @@ private:
         bool                          reportAllFlag,
         PlacementVerifier&            verifier);
     size_t GetChunkSize(const CSMap::Entry& ci) const;
+    bool ChooseAllocationServers(ChunkPlacement& placement,
+        int numReplicas, Servers& servers);
+    void AddBenchServers(int count, int numRacks, int64_t totalSpace,
+        double maxUtilization, int numWritableDrives);
+    int AllocateBenchChunks(int64_t count, int numReplicas,
+        int chunksPerFile, BenchStats& stats);
+    void BenchServerDown(const ServerLocation& loc, bool restartFlag,
+        BenchStats& stats);
+    int BenchServerUp(const ServerLocation& loc);
+    void RunRecovery(ostream& os, int riskSampleInterval,
+        double roundTimeSec, BenchStats& stats);
+    void GetDataAtRisk(DataAtRisk& risk);
+    void ShowRackTraffic(ostream& os) const;
 
     // for the purposes of rebalancing, we compute the cluster
     // wide average space utilization; then we take into the
     // desired variation from mean to compute thresholds that determine
     // which nodes are candidates for migration.
-    double     mVariationFromMean;
-    int        mNumBlksRebalanced;
-    bool       mStopFlag;
-    ofstream   mPlanFile;
-    Loc2Server mLoc2Server;
+    double      mVariationFromMean;
+    int         mNumBlksRebalanced;
+    int64_t     mBytesRebalanced;
+    int64_t     mCrossRackBytesRebalanced;
+    bool        mStopFlag;
+    ofstream    mPlanFile;
+    Loc2Server  mLoc2Server;
+    RackTraffic mRackTraffic;
+    DownServers mDownServers;
+    int64_t     mNextFileNum;
 private:
     // No copy.
     LayoutEmulator(const LayoutEmulator&);
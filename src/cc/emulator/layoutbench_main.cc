@@ -0,0 +1,180 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Trace driven chunk placement and recovery benchmark. Replays chunk
+// allocation, server and rack failure, and decommission trace against the
+// layout emulator, and reports placement decision cost, recovery makespan,
+// replication traffic between racks, and data at risk over time.
+//
+//----------------------------------------------------------------------------
+
+#include "LayoutEmulator.h"
+#include "emulator_setup.h"
+
+#include "common/MsgLogger.h"
+#include "common/Properties.h"
+#include "common/MdStream.h"
+#include "meta/kfstree.h"
+#include "meta/AuditLog.h"
+
+#include <unistd.h>
+#include <stdlib.h>
+
+#include <iostream>
+#include <fstream>
+
+using std::string;
+using std::cout;
+using std::cerr;
+using std::cin;
+using std::ifstream;
+
+using namespace KFS;
+
+int
+main(int argc, char** argv)
+{
+    string  traceFn;
+    string  logdir;
+    string  cpdir("kfscp");
+    string  networkFn;
+    string  chunkmapFn("chunkmap.txt");
+    string  propsFn;
+    int     optchar;
+    int     riskSampleInterval = 10;
+    double  replicationRate    = 32 << 20;
+    bool    helpFlag           = false;
+
+    while ((optchar = getopt(argc, argv, "f:i:R:l:c:n:b:p:h")) != -1) {
+        switch (optchar) {
+            case 'f':
+                traceFn = optarg;
+                break;
+            case 'i':
+                riskSampleInterval = atoi(optarg);
+                break;
+            case 'R':
+                replicationRate = atof(optarg);
+                break;
+            case 'l':
+                logdir = optarg;
+                break;
+            case 'c':
+                cpdir = optarg;
+                break;
+            case 'n':
+                networkFn = optarg;
+                break;
+            case 'b':
+                chunkmapFn = optarg;
+                break;
+            case 'p':
+                propsFn = optarg;
+                break;
+            case 'h':
+                helpFlag = true;
+                break;
+            default:
+                cerr << "Unrecognized flag: " << (char)optchar << "\n";
+                helpFlag = true;
+                break;
+        }
+    }
+    if (helpFlag || replicationRate <= 0) {
+        cout <<
+        "Usage: " << argv[0] << "\n"
+            "[-f <trace file> (default stdin)]\n"
+            "[-i <data at risk sample interval in recovery rounds>"
+                " (default " << riskSampleInterval << ") 0 -- none]\n"
+            "[-R <single chunk replication rate bytes per second>"
+                " (default " << replicationRate << ")]\n"
+            "[-p <[meta server] configuration file> (default none)]\n"
+            "Optional initial file system and layout state,"
+            " the state is loaded only if network definition is specified:\n"
+            "[-n <network definition file name> (default none)]\n"
+            "[-l <log directory> (default kfslog)]\n"
+            "[-c <checkpoint directory> (default " << cpdir << ")]\n"
+            "[-b <chunkmap file> (default " << chunkmapFn << ")]\n"
+            "Trace commands, one per line:\n"
+            "servers <count> <racks> [<space TB> [<max utilization %>"
+                " [<writable drives>]]]\n"
+            "allocate <chunks> [<replicas> [<chunks per file>]]\n"
+            "fail <host> <port>\n"
+            "down <host> <port>\n"
+            "up <host> <port>\n"
+            "failrack <rack>\n"
+            "decommission <host> <port>\n"
+            "recover\n"
+            "rebalance [<% variation from average utilization>]\n"
+            "stats\n"
+            "Synthetic servers are named 10.x.x.x 22000\n"
+            "Recovery proceeds in rounds, each round every server completes"
+            " up to\nmax. concurrent replications per node, and each round"
+            " takes chunk size\ndivided by replication rate seconds.\n"
+        ;
+        return 1;
+    }
+
+    MdStream::Init();
+    MsgLogger::Init(0, MsgLogger::kLogLevelNOTICE);
+
+    Properties props;
+    int status = 0;
+    if (! propsFn.empty()) {
+        status = props.loadProperties(propsFn.c_str(), char('='), false);
+    }
+    ifstream traceFile;
+    if (status == 0 && ! traceFn.empty()) {
+        traceFile.open(traceFn.c_str());
+        if (! traceFile) {
+            const int err = errno;
+            KFS_LOG_STREAM_ERROR << traceFn << ": " << strerror(err) <<
+            KFS_LOG_EOM;
+            status = -1;
+        }
+    }
+    if (status == 0) {
+        // Start re-replication immediately when server goes down, unless
+        // configured otherwise.
+        if (! props.getValue(
+                "metaServer.serverDownReplicationDelay", (const char*)0)) {
+            props.setValue("metaServer.serverDownReplicationDelay", "0");
+        }
+        gLayoutEmulator.SetParameters(props);
+        if (networkFn.empty()) {
+            status = metatree.new_tree();
+        } else {
+            if (logdir.empty()) {
+                logdir = "kfslog";
+            }
+            status = EmulatorSetup(logdir, cpdir, networkFn, chunkmapFn);
+        }
+    }
+    if (status == 0) {
+        gLayoutEmulator.ClearRebalanceStats();
+        status = gLayoutEmulator.RunTraceBenchmark(
+            traceFn.empty() ? cin : traceFile, cout,
+            riskSampleInterval, CHUNKSIZE / replicationRate);
+    }
+    AuditLog::Stop();
+    MdStream::Cleanup();
+    return (status == 0 ? 0 : 1);
+}
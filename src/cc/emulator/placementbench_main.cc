@@ -0,0 +1,126 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Chunk placement benchmark. Creates the specified number of emulated
+// chunk servers, and measures the cost of choosing chunk servers for new
+// chunk allocations.
+//
+//----------------------------------------------------------------------------
+
+#include "LayoutEmulator.h"
+
+#include "common/MsgLogger.h"
+#include "common/Properties.h"
+#include "common/MdStream.h"
+#include "meta/AuditLog.h"
+
+#include <unistd.h>
+#include <stdlib.h>
+
+using std::string;
+using std::cout;
+using std::cerr;
+
+using namespace KFS;
+
+int
+main(int argc, char** argv)
+{
+    string  propsFn;
+    int     optchar;
+    int     numServers     = 10000;
+    int     numRacks       = 20;
+    int     numDrives      = 12;
+    int     numReplicas    = 3;
+    int64_t numAllocations = 100000;
+    double  maxUtilization = 80;
+    bool    helpFlag       = false;
+
+    while ((optchar = getopt(argc, argv, "s:r:w:k:n:u:p:h")) != -1) {
+        switch (optchar) {
+            case 's':
+                numServers = atoi(optarg);
+                break;
+            case 'r':
+                numRacks = atoi(optarg);
+                break;
+            case 'w':
+                numDrives = atoi(optarg);
+                break;
+            case 'k':
+                numReplicas = atoi(optarg);
+                break;
+            case 'n':
+                numAllocations = atoll(optarg);
+                break;
+            case 'u':
+                maxUtilization = atof(optarg);
+                break;
+            case 'p':
+                propsFn = optarg;
+                break;
+            case 'h':
+                helpFlag = true;
+                break;
+            default:
+                cerr << "Unrecognized flag: " << (char)optchar << "\n";
+                helpFlag = true;
+                break;
+        }
+    }
+    if (helpFlag) {
+        cout <<
+        "Usage: " << argv[0] << "\n"
+            "[-s <number of chunk servers> (default " << numServers << ")]\n"
+            "[-r <number of racks> (default " << numRacks << ")]\n"
+            "[-w <writable drives per server> (default " << numDrives <<
+                ")]\n"
+            "[-k <replicas per chunk> (default " << numReplicas << ")]\n"
+            "[-n <number of allocations> (default " << numAllocations <<
+                ")]\n"
+            "[-u <max. space utilization %> (default " << maxUtilization <<
+                "%) the server space utilization is chosen uniformly at"
+                " random between 0 and this value]\n"
+            "[-p <[meta server] configuration file> (default none)]\n"
+            "Use meta server configuration file to set chunk placement"
+            " parameters, for example\n"
+            "metaServer.sortCandidatesBySpaceUtilization = 1\n"
+        ;
+        return 1;
+    }
+
+    MdStream::Init();
+    MsgLogger::Init(0, MsgLogger::kLogLevelNOTICE);
+
+    Properties props;
+    int status = 0;
+    if (propsFn.empty() ||
+            (status = props.loadProperties(propsFn.c_str(), char('='), false))
+            == 0) {
+        gLayoutEmulator.SetParameters(props);
+        status = gLayoutEmulator.RunPlacementBenchmark(
+            numServers, numRacks, numDrives, maxUtilization * 1e-2,
+            numReplicas, numAllocations, cout);
+    }
+    AuditLog::Stop();
+    MdStream::Cleanup();
+    return (status == 0 ? 0 : 1);
+}
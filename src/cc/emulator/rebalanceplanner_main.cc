@@ -58,13 +58,16 @@ main(int argc, char** argv)
     string  chunkmapFn("chunkmap.txt");
     string  propsFn;
     string  chunkMapDir;
+    string  prevPlanFn;
+    string  deltaChunkmapFn;
     int     optchar;
+    int     numWorkers       = 1;
     int16_t minReplication   = -1;
     double  variationFromAvg = 0;
     bool    helpFlag         = false;
     bool    debugFlag        = false;
 
-    while ((optchar = getopt(argc, argv, "c:l:n:b:r:hp:o:dm:t:")) != -1) {
+    while ((optchar = getopt(argc, argv, "c:l:n:b:r:hp:o:dm:t:j:P:B:")) != -1) {
         switch (optchar) {
             case 'l':
                 logdir = optarg;
@@ -99,13 +102,22 @@ main(int argc, char** argv)
             case 'm':
                 minReplication = atoi(optarg);
                 break;
+            case 'j':
+                numWorkers = atoi(optarg);
+                break;
+            case 'P':
+                prevPlanFn = optarg;
+                break;
+            case 'B':
+                deltaChunkmapFn = optarg;
+                break;
             default:
                 cerr << "Unrecognized flag: " << (char)optchar << "\n";
                 helpFlag = true;
                 break;
         }
     }
-    if (helpFlag || rebalancePlanFn.empty()) {
+    if (helpFlag || rebalancePlanFn.empty() || numWorkers < 1) {
         cout <<
         "Usage: " << argv[0] << "\n"
             "[-l <log directory> (default " << logdir << ")]\n"
@@ -121,6 +133,13 @@ main(int argc, char** argv)
             "[-o <new chunk map output directory> (default none)]\n"
             "[-d debug -- print chunk layout before and after]\n"
             "[-m <min replicas per file> (default -1 -- no change)]\n"
+            "[-j <number of parallel planners> (default " << numWorkers <<
+                ") racks are partitioned between the planners]\n"
+            "[-P <previous re-balance plan> (default none)"
+                " apply before planning]\n"
+            "[-B <chunk map delta file> (default none)"
+                " replaces the chunks' replicas, applied after the previous"
+                " plan]\n"
             "To create network defininiton file and chunk map files:\n"
             "telnet to the meta server, and issue DUMP_CHUNKTOSERVERMAP\n"
             "followed by an empty line.\n"
@@ -157,6 +176,22 @@ main(int argc, char** argv)
         gLayoutEmulator.SetupForRebalancePlanning(variationFromAvg);
         status = EmulatorSetup(logdir, cpdir, networkFn, chunkmapFn,
             minReplication, minReplication > 1);
+        // Incremental planning: apply previously created plan and the chunk
+        // map changes since then, in order to plan only the remaining moves.
+        if (status == 0 && ! prevPlanFn.empty()) {
+            KFS_LOG_STREAM_NOTICE << "applying re-balance plan: " <<
+                prevPlanFn <<
+            KFS_LOG_EOM;
+            status = gLayoutEmulator.ApplyRebalancePlan(prevPlanFn);
+        }
+        if (status == 0 && ! deltaChunkmapFn.empty()) {
+            KFS_LOG_STREAM_NOTICE << "loading chunk map delta: " <<
+                deltaChunkmapFn <<
+            KFS_LOG_EOM;
+            status = gLayoutEmulator.LoadChunkmap(
+                deltaChunkmapFn, minReplication > 1, true);
+        }
+        gLayoutEmulator.ClearRebalanceStats();
         if (status == 0 &&
                 (status = gLayoutEmulator.SetRebalancePlanOutFile(
                     rebalancePlanFn)) == 0) {
@@ -166,16 +201,27 @@ main(int argc, char** argv)
             KFS_LOG_STREAM_NOTICE << "creating re-balance plan: " <<
                 rebalancePlanFn <<
             KFS_LOG_EOM;
-            gLayoutEmulator.BuildRebalancePlan();
+            if (numWorkers > 1) {
+                status = gLayoutEmulator.BuildPartitionedRebalancePlan(
+                    numWorkers, rebalancePlanFn);
+            }
+            // Serial pass moves the remaining chunks, including the moves
+            // between the partitions.
+            if (status == 0) {
+                gLayoutEmulator.BuildRebalancePlan();
+            }
             if (! chunkMapDir.empty()) {
                 gLayoutEmulator.DumpChunkToServerMap(chunkMapDir);
             }
             if (debugFlag) {
                 gLayoutEmulator.PrintChunkserverBlockCount(cout);
             }
-            KFS_LOG_STREAM_NOTICE << "replicated chunks: " <<
-                gLayoutEmulator.GetNumBlksRebalanced() <<
-            KFS_LOG_EOM;
+            KFS_LOG_STREAM_START(MsgLogger::kLogLevelNOTICE, logStream);
+                gLayoutEmulator.ShowRebalanceStats(
+                    logStream.GetStream(), " ");
+            KFS_LOG_STREAM_END;
+            gLayoutEmulator.ShowRebalanceStats(cout, "\n");
+            cout << "\n";
         }
     }
     AuditLog::Stop();
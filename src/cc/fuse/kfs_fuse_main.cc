@@ -26,6 +26,14 @@
 // files created with Reed-Solomon recovery, as well as simultaneous read and
 // write (O_RDWR) into the same file by a single writer.
 //
+// The file system runs multi-threaded, with large reads and writes. Per open
+// file read ahead and write behind are done by the client library: reads
+// and writes are issued at the kernel's max_read / max_write size, and the
+// client library keeps the next read ahead request in flight, and queues
+// writes up to the write behind size. Flush waits for the queued writes in
+// order to report write errors on close. The kernel caches attributes and
+// directory entries for the attr_timeout and entry_timeout seconds.
+//
 //----------------------------------------------------------------------------
 
 #include "libclient/KfsClient.h"
@@ -37,6 +45,7 @@
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 using std::string;
 using std::vector;
@@ -53,6 +62,13 @@ using KFS::KFS_STRIPED_FILE_TYPE_NONE;
 
 static KfsClient *client;
 
+// Large io and caching parameters, can be changed with the -o mount options
+// listed in usage().
+static size_t read_ahead_size   = size_t(4) << 20;
+static size_t write_behind_size = size_t(4) << 20;
+static size_t max_io_size       = size_t(1) << 20;
+static string fs_options;
+
 static inline kfsMode_t
 mode2kfs_mode(mode_t mode)
 {
@@ -173,8 +189,9 @@ fuse_write(const char *path, const char *buf, size_t nbytes, off_t off,
 static int
 fuse_flush(const char *path, struct fuse_file_info *finfo)
 {
-    // NO!
-    return 0;
+    // Wait for write behind to complete, and report the write errors, if
+    // any, to the close caller. Nothing is pending with read only files.
+    return client->Sync(finfo->fh);
 }
 
 static int
@@ -362,24 +379,39 @@ initkfs(char *addr)
     int port = atoi(cp + 1);
     if ((client = KFS::Connect(host, port)) == NULL)
         fatal("connect: %s:%d", host.c_str(), port);
+    // Default io buffer and read ahead sizes apply to all subsequently
+    // opened files.
+    client->SetDefaultIoBufferSize(write_behind_size);
+    client->SetDefaultReadAheadSize(read_ahead_size);
+    if ((size_t)client->GetMaxReadAheadSize() < read_ahead_size)
+        client->SetMaxReadAheadSize(read_ahead_size);
 }
 
 static struct fuse_args*
 get_fs_args(struct fuse_args* args)
 {
-#ifdef KFS_OS_NAME_DARWIN
-    return NULL;
-#else
     if (!args) {
         return NULL;
     }
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+#ifndef KFS_OS_NAME_DARWIN
+        "-obig_writes,max_write=%lu,max_readahead=%lu,"
+#endif
+        "entry_timeout=5,attr_timeout=5,negative_timeout=1"
+#ifndef KFS_OS_NAME_DARWIN
+        , (unsigned long)max_io_size, (unsigned long)max_io_size
+#endif
+    );
+    // User specified options follow the defaults, and override them.
+    string options(buf);
+    options += fs_options;
     args->argc = 2;
     args->argv = (char**)calloc(sizeof(char*), args->argc + 1);
     args->argv[0] = strdup("kfs_fuse");
-    args->argv[1] = strdup("-obig_writes");
+    args->argv[1] = strdup(options.c_str());
     args->allocated = 1;
     return args;
-#endif
 }
 
 static struct fuse_args*
@@ -397,6 +429,60 @@ get_mount_args(struct fuse_args* args, const char* options)
     return args;
 }
 
+static bool
+has_prefix(const string& token, const char* prefix)
+{
+    return token.compare(0, strlen(prefix), prefix) == 0;
+}
+
+static bool
+parse_size(const string& token, size_t* size)
+{
+    const char* const str = token.c_str() + token.find('=') + 1;
+    char* end = NULL;
+    const long long val = strtoll(str, &end, 0);
+    if (end == str || *end != 0 || val <= 0) {
+        return false;
+    }
+    *size = (size_t)val;
+    return true;
+}
+
+/*
+ * Sort out a single -o option: fuse file system (as opposed to mount)
+ * options go into fs_options, read ahead and write behind sizes are
+ * consumed, and the remaining ones are passed to mount.
+ */
+static int
+add_option(const string& token, vector<string>& opts, bool* readonly)
+{
+    if (token == "rrw") {
+        *readonly = false;
+        opts.push_back("rw");
+    } else if (has_prefix(token, "readahead=")) {
+        if (!parse_size(token, &read_ahead_size)) {
+            return -1;
+        }
+    } else if (has_prefix(token, "writebehind=")) {
+        if (!parse_size(token, &write_behind_size)) {
+            return -1;
+        }
+    } else if (has_prefix(token, "max_io=")) {
+        if (!parse_size(token, &max_io_size)) {
+            return -1;
+        }
+    } else if (has_prefix(token, "entry_timeout=") ||
+            has_prefix(token, "attr_timeout=") ||
+            has_prefix(token, "negative_timeout=") ||
+            token == "kernel_cache" || token == "auto_cache") {
+        fs_options += ",";
+        fs_options += token;
+    } else if (token != "rw") {
+        opts.push_back(token);
+    }
+    return 0;
+}
+
 /*
  * Run through the -o OPTIONS and interpret it as writable only if 'rrw' is
  * explicitly specified. We use 'rrw' instead of 'rw' because a 'default'
@@ -427,21 +513,14 @@ massage_options(char** opt_argv, int opt_argc, string* options, bool* readonly)
 
         end = cmdline.find_first_of(delim, start);
         if (end == string::npos) {
-            string token = cmdline.substr(start);
-            if (token == "rrw") {
-                *readonly = false;
-                opts.push_back("rw");
-            } else if (token != "rw") {
-                opts.push_back(token);
+            if (add_option(cmdline.substr(start), opts, readonly) < 0) {
+                return -1;
             }
             break;
         }
-        string token = cmdline.substr(start, end - start);
-        if (token == "rrw") {
-            *readonly = false;
-            opts.push_back("rw");
-        } else if (token != "rw") {
-            opts.push_back(token);
+        if (add_option(cmdline.substr(start, end - start),
+                opts, readonly) < 0) {
+            return -1;
         }
         start = end;
     }
@@ -514,7 +593,18 @@ usage(int e)
     //Undocumented option: 'rrw'. See massage_options() above.
     fprintf(stderr, "usage: kfs_fuse kfshost mountpoint [-o opt1[,opt2..]]\n"
                     "       eg: kfs_fuse 127.0.0.1:20000 "
-                           "/mnt/kfs -o allow_other,ro\n");
+                           "/mnt/kfs -o allow_other,ro\n"
+                    "       io and caching options:\n"
+                    "       max_io=<bytes>      kernel max read and write"
+                           " size, default 1MB\n"
+                    "       readahead=<bytes>   per file read ahead,"
+                           " default 4MB\n"
+                    "       writebehind=<bytes> per file write behind,"
+                           " default 4MB\n"
+                    "       entry_timeout=<sec>, attr_timeout=<sec>,"
+                           " negative_timeout=<sec>\n"
+                    "                           kernel cache timeouts,"
+                           " default 5, 5, 1\n");
     exit(e);
 }
 
@@ -540,6 +630,12 @@ main(int argc, char **argv)
             usage(1);
         }
     }
+    if (options.find("max_read=") == string::npos) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), ",max_read=%lu",
+            (unsigned long)max_io_size);
+        options.append(buf);
+    }
 
     //setsid(); // detach from console
 
@@ -41,8 +41,8 @@
 #include <istream>
 #include <limits>
 
-#include <boost/shared_ptr.hpp>
 #include "common/StdAllocator.h"
+#include "common/kfsatomic.h"
 
 namespace KFS
 {
@@ -52,7 +52,6 @@ using std::streambuf;
 using std::streamsize;
 using std::list;
 using std::numeric_limits;
-using boost::shared_ptr;
 
 namespace libkfsio
 {
@@ -85,8 +84,127 @@ bool SetIOBufferAllocator(IOBufferAllocator* allocator);
 class IOBufferData
 {
 public:
-    /// Data buffer that is ref-counted for sharing.
-    typedef shared_ptr<char> IOBufferBlockPtr;
+    ///
+    /// \class IOBufferBlockPtr
+    /// \brief Data buffer that is ref-counted for sharing.
+    /// Intrusive reference count, and the buffer deallocator are kept in a
+    /// single small block allocated with the pool allocator. Unlike
+    /// shared_ptr there is no weak reference count, and no separately
+    /// allocated control block.
+    class IOBufferBlockPtr
+    {
+    public:
+        IOBufferBlockPtr()
+            : mBlockPtr(0)
+            {}
+        template<typename T>
+        IOBufferBlockPtr(char* ptr, T deallocator)
+            : mBlockPtr(ptr ? BlockT<T>::Create(ptr, deallocator) : 0)
+            {}
+        IOBufferBlockPtr(const IOBufferBlockPtr& other)
+            : mBlockPtr(other.mBlockPtr)
+        {
+            if (mBlockPtr) {
+                mBlockPtr->Ref();
+            }
+        }
+        ~IOBufferBlockPtr()
+        {
+            if (mBlockPtr) {
+                mBlockPtr->UnRef();
+            }
+        }
+        IOBufferBlockPtr& operator=(const IOBufferBlockPtr& other)
+        {
+            IOBufferBlockPtr tmp(other);
+            swap(tmp);
+            return *this;
+        }
+        template<typename T>
+        void reset(char* ptr, T deallocator)
+        {
+            IOBufferBlockPtr tmp(ptr, deallocator);
+            swap(tmp);
+        }
+        void reset()
+        {
+            IOBufferBlockPtr tmp;
+            swap(tmp);
+        }
+        void swap(IOBufferBlockPtr& other)
+        {
+            Block* const tmp = mBlockPtr;
+            mBlockPtr = other.mBlockPtr;
+            other.mBlockPtr = tmp;
+        }
+        char* get() const
+            { return (mBlockPtr ? mBlockPtr->mPtr : 0); }
+        bool unique() const
+            { return (mBlockPtr && mBlockPtr->mRefCount == 1); }
+    private:
+        class Block
+        {
+        public:
+            typedef void (*DeleteFunc)(Block& block);
+            Block(char* ptr, DeleteFunc func)
+                : mPtr(ptr),
+                  mRefCount(1),
+                  mDeleteFunc(func)
+                {}
+            // The owner of the only reference is the only one that can
+            // change the reference count, therefore atomic update isn't
+            // required, and it is skipped in the most common case where the
+            // buffer isn't shared.
+            void Ref()
+            {
+                if (mRefCount == 1) {
+                    mRefCount = 2;
+                } else {
+                    SyncAddAndFetch(mRefCount, 1);
+                }
+            }
+            void UnRef()
+            {
+                if (mRefCount == 1 || SyncAddAndFetch(mRefCount, -1) == 0) {
+                    (*mDeleteFunc)(*this);
+                }
+            }
+            char* const      mPtr;
+            volatile int     mRefCount;
+            DeleteFunc const mDeleteFunc;
+        protected:
+            ~Block()
+                {}
+        };
+        template<typename T>
+        class BlockT : public Block
+        {
+        public:
+            typedef StdFastAllocator<BlockT> Allocator;
+            static Block* Create(char* ptr, const T& deallocator)
+            {
+                Allocator alloc;
+                return new (alloc.allocate(1)) BlockT(ptr, deallocator);
+            }
+        private:
+            T mDeallocator;
+
+            BlockT(char* ptr, const T& deallocator)
+                : Block(ptr, &BlockT::Delete),
+                  mDeallocator(deallocator)
+                {}
+            static void Delete(Block& block)
+            {
+                BlockT&    cur         = static_cast<BlockT&>(block);
+                char* const ptr        = cur.mPtr;
+                T           deallocator(cur.mDeallocator);
+                cur.~BlockT();
+                Allocator().deallocate(&cur, 1);
+                deallocator(ptr);
+            }
+        };
+        Block* mBlockPtr;
+    };
 
     IOBufferData();
     IOBufferData(int bufsz);
@@ -49,6 +49,7 @@
 #include <signal.h>
 #include <openssl/rand.h>
 #include <stdlib.h>
+#include <ctype.h>
 
 #include <cstdio>
 #include <cstdlib>
@@ -99,8 +100,14 @@ Connect(const char* propFile)
     if (p.loadProperties(propFile, '=', verbose) != 0) {
         return 0;
     }
-    return Connect(p.getValue("metaServer.name", ""),
-                   p.getValue("metaServer.port", -1));
+    KfsClient* const clnt = Connect(p.getValue("metaServer.name", ""),
+        p.getValue("metaServer.port", -1));
+    if (clnt) {
+        clnt->SetFollowerMetaServer(
+            p.getValue("metaServer.follower.name", ""),
+            p.getValue("metaServer.follower.port", -1));
+    }
+    return clnt;
 }
 
 KfsClient*
@@ -681,6 +688,67 @@ KfsClient::GetReadAheadSize(int fd) const
     return mImpl->GetReadAheadSize(fd);
 }
 
+ssize_t
+KfsClient::SetMaxReadAheadSize(size_t size)
+{
+    return mImpl->SetMaxReadAheadSize(size);
+}
+
+ssize_t
+KfsClient::GetMaxReadAheadSize() const
+{
+    return mImpl->GetMaxReadAheadSize();
+}
+
+ssize_t
+KfsClient::SetReadAheadMemoryBudget(size_t size)
+{
+    return mImpl->SetReadAheadMemoryBudget(size);
+}
+
+ssize_t
+KfsClient::GetReadAheadMemoryBudget() const
+{
+    return mImpl->GetReadAheadMemoryBudget();
+}
+
+void
+KfsClient::SetHedgedReadParameters(int minDelayMs, int latencyMultiplier)
+{
+    mImpl->SetHedgedReadParameters(minDelayMs, latencyMultiplier);
+}
+
+void
+KfsClient::SetAppendMaxChunksCount(int count)
+{
+    mImpl->SetAppendMaxChunksCount(count);
+}
+
+int
+KfsClient::GetAppendMaxChunksCount() const
+{
+    return mImpl->GetAppendMaxChunksCount();
+}
+
+void
+KfsClient::SetAllocateAheadCount(int count)
+{
+    mImpl->SetAllocateAheadCount(count);
+}
+
+int
+KfsClient::GetAllocateAheadCount() const
+{
+    return mImpl->GetAllocateAheadCount();
+}
+
+void
+KfsClient::GetHedgedReadStats(
+    int64_t& hedgedReadCount, int64_t& hedgedReadWinCount) const
+{
+    mImpl->GetHedgedReadStats(hedgedReadCount, hedgedReadWinCount);
+}
+
 void
 KfsClient::SetEOFMark(int fd, chunkOff_t offset)
 {
@@ -714,6 +782,12 @@ KfsClient::SetFileAttributeRevalidateTime(int secs)
     mImpl->SetFileAttributeRevalidateTime(secs);
 }
 
+void
+KfsClient::SetFollowerMetaServer(const string& host, int port)
+{
+    mImpl->SetFollowerMetaServer(ServerLocation(host, port));
+}
+
 int
 KfsClient::Chmod(int fd, kfsMode_t mode)
 {
@@ -874,6 +948,7 @@ private:
             }
             KfsOp::AddDefaultRequestHeaders(mEUser, mEGroup);
             AddUserHeader((uid_t)mEUser);
+            AddTenantHeader();
             const mode_t mask = umask(0);
             umask(mask);
             mUMask = mask & Permissions::kAccessModeMask;
@@ -909,6 +984,26 @@ private:
                 KfsOp::AddExtraRequestHeaders(hdr);
             }
         }
+        static void AddTenantHeader()
+        {
+            // Chunk server buffer manager qos tenant name. Only letters,
+            // digits, '-', and '_' are allowed.
+            const char* p = getenv("KFS_CLIENT_TENANT");
+            if (! p || ! *p) {
+                return;
+            }
+            const size_t kMaxTenantLen = 31;
+            string hdr("Tenant: ");
+            for (size_t i = 0; *p != 0 && i < kMaxTenantLen; p++, i++) {
+                const int c = *p & 0xFF;
+                if (! isalnum(c) && c != '-' && c != '_') {
+                    return;
+                }
+                hdr.push_back((char)c);
+            }
+            hdr += "\r\n";
+            KfsOp::AddExtraRequestHeaders(hdr);
+        }
         ~Globals()
             { Instance().Shutdown(); }
         int SetEUserAndEGroupSelf(kfsUid_t user, kfsGid_t group,
@@ -931,6 +1026,7 @@ private:
             KfsOp::SetExtraRequestHeaders(string());
             KfsOp::AddDefaultRequestHeaders(mEUser, mEGroup);
             AddUserHeader((uid_t)mEUser);
+            AddTenantHeader();
             return 0;
         }
         static Globals& GetInstance()
@@ -1046,6 +1142,9 @@ KfsClientImpl::KfsClientImpl()
       mIsInitialized(false),
       mMetaServerLoc(),
       mMetaServerSock(),
+      mFollowerMetaServerLoc(),
+      mFollowerMetaServerSock(),
+      mFollowerMetaServerRetryTime(0),
       mCmdSeqNum(0),
       mCwd("/"),
       mFileTable(),
@@ -1066,11 +1165,18 @@ KfsClientImpl::KfsClientImpl()
       mSlash("/"),
       mDefaultIoBufferSize(min(CHUNKSIZE, size_t(1) << 20)),
       mDefaultReadAheadSize(min(mDefaultIoBufferSize, size_t(1) << 20)),
+      mMaxReadAheadSize(0),
+      mReadAheadMemoryBudget(size_t(64) << 20),
+      mReadAheadAdaptiveBytes(0),
       mFailShortReadsFlag(true),
       mFileInstance(0),
       mProtocolWorker(0),
       mMaxNumRetriesPerOp(DEFAULT_NUM_RETRIES_PER_OP),
       mRetryDelaySec(RETRY_DELAY_SECS),
+      mHedgedReadMinDelayMs(2000),
+      mHedgedReadLatencyMultiplier(4),
+      mAppendMaxChunksCount(1),
+      mAllocateAheadCount(0),
       mDefaultOpTimeout(30),
       mFreeCondVarsHead(0),
       mEUser(kKfsUserNone),
@@ -3292,6 +3398,10 @@ KfsClientImpl::StartProtocolWorker()
     mProtocolWorker->SetMetaMaxRetryCount(mMaxNumRetriesPerOp);
     mProtocolWorker->SetTimeSecBetweenRetries(mRetryDelaySec);
     mProtocolWorker->SetMetaTimeSecBetweenRetries(mRetryDelaySec);
+    mProtocolWorker->SetHedgedReadParameters(
+        mHedgedReadMinDelayMs, mHedgedReadLatencyMultiplier);
+    mProtocolWorker->SetAppendMaxChunksCount(mAppendMaxChunksCount);
+    mProtocolWorker->SetAllocateAheadCount(mAllocateAheadCount);
     mProtocolWorker->Start();
 }
 
@@ -3489,6 +3599,97 @@ KfsClientImpl::GetDefaultReadAheadSize() const
     return mDefaultReadAheadSize;
 }
 
+ssize_t
+KfsClientImpl::SetMaxReadAheadSize(size_t size)
+{
+    QCStMutexLocker lock(mMutex);
+    mMaxReadAheadSize = min((size_t)numeric_limits<int>::max(),
+        size / CHECKSUM_BLOCKSIZE * CHECKSUM_BLOCKSIZE);
+    return mMaxReadAheadSize;
+}
+
+ssize_t
+KfsClientImpl::GetMaxReadAheadSize() const
+{
+    QCStMutexLocker lock(const_cast<KfsClientImpl*>(this)->mMutex);
+    return mMaxReadAheadSize;
+}
+
+ssize_t
+KfsClientImpl::SetReadAheadMemoryBudget(size_t size)
+{
+    QCStMutexLocker lock(mMutex);
+    mReadAheadMemoryBudget = size;
+    return mReadAheadMemoryBudget;
+}
+
+ssize_t
+KfsClientImpl::GetReadAheadMemoryBudget() const
+{
+    QCStMutexLocker lock(const_cast<KfsClientImpl*>(this)->mMutex);
+    return mReadAheadMemoryBudget;
+}
+
+void
+KfsClientImpl::SetHedgedReadParameters(int minDelayMs, int latencyMultiplier)
+{
+    QCStMutexLocker l(mMutex);
+    mHedgedReadMinDelayMs        = minDelayMs;
+    mHedgedReadLatencyMultiplier = latencyMultiplier;
+    if (mProtocolWorker) {
+        mProtocolWorker->SetHedgedReadParameters(
+            mHedgedReadMinDelayMs, mHedgedReadLatencyMultiplier);
+    }
+}
+
+void
+KfsClientImpl::SetAppendMaxChunksCount(int count)
+{
+    QCStMutexLocker l(mMutex);
+    mAppendMaxChunksCount = max(1, count);
+    if (mProtocolWorker) {
+        mProtocolWorker->SetAppendMaxChunksCount(mAppendMaxChunksCount);
+    }
+}
+
+int
+KfsClientImpl::GetAppendMaxChunksCount() const
+{
+    QCStMutexLocker l(const_cast<KfsClientImpl*>(this)->mMutex);
+    return mAppendMaxChunksCount;
+}
+
+void
+KfsClientImpl::SetAllocateAheadCount(int count)
+{
+    QCStMutexLocker l(mMutex);
+    mAllocateAheadCount = max(0, count);
+    if (mProtocolWorker) {
+        mProtocolWorker->SetAllocateAheadCount(mAllocateAheadCount);
+    }
+}
+
+int
+KfsClientImpl::GetAllocateAheadCount() const
+{
+    QCStMutexLocker l(const_cast<KfsClientImpl*>(this)->mMutex);
+    return mAllocateAheadCount;
+}
+
+void
+KfsClientImpl::GetHedgedReadStats(
+    int64_t& hedgedReadCount, int64_t& hedgedReadWinCount) const
+{
+    QCStMutexLocker l(const_cast<KfsClientImpl*>(this)->mMutex);
+    if (mProtocolWorker) {
+        mProtocolWorker->GetHedgedReadStats(
+            hedgedReadCount, hedgedReadWinCount);
+    } else {
+        hedgedReadCount    = 0;
+        hedgedReadWinCount = 0;
+    }
+}
+
 void
 KfsClientImpl::SetDefaultFullSparseFileSupport(bool flag)
 {
@@ -3514,6 +3715,15 @@ KfsClientImpl::SetFileAttributeRevalidateTime(int secs)
     mFileAttributeRevalidateTime = secs;
 }
 
+void
+KfsClientImpl::SetFollowerMetaServer(const ServerLocation& loc)
+{
+    QCStMutexLocker lock(mMutex);
+    mFollowerMetaServerSock.Close();
+    mFollowerMetaServerLoc       = loc;
+    mFollowerMetaServerRetryTime = 0;
+}
+
 ///
 /// Helper function that does the work for sending out an op to the
 /// server.
@@ -3980,6 +4190,13 @@ KfsClientImpl::ComputeFilesizes(vector<KfsFileAttr>& fattrs,
 void
 KfsClientImpl::DoMetaOpWithRetry(KfsOp *op)
 {
+    if ((op->op == CMD_LOOKUP ||
+            op->op == CMD_READDIR ||
+            op->op == CMD_GETPATHNAME) &&
+            mFollowerMetaServerLoc.IsValid() &&
+            DoFollowerMetaOp(op)) {
+        return;
+    }
     time_t start = time(0);
     for (int attempt = -1; ;) {
         if (! mMetaServerSock.IsGood()) {
@@ -4018,6 +4235,52 @@ KfsClientImpl::DoMetaOpWithRetry(KfsOp *op)
     KFS_LOG_EOM;
 }
 
+///
+/// Send read only op to the follower. Returns false if the op has to be
+/// re-sent to the primary meta server.
+///
+bool
+KfsClientImpl::DoFollowerMetaOp(KfsOp *op)
+{
+    const time_t now = time(0);
+    if (! mFollowerMetaServerSock.IsGood()) {
+        if (now < mFollowerMetaServerRetryTime) {
+            return false;
+        }
+        if (mFollowerMetaServerSock.Connect(mFollowerMetaServerLoc) < 0) {
+            KFS_LOG_STREAM_DEBUG <<
+                "follower: " << mFollowerMetaServerLoc <<
+                " connect failed" <<
+            KFS_LOG_EOM;
+            mFollowerMetaServerRetryTime = now + mRetryDelaySec;
+            return false;
+        }
+    }
+    op->status = 0;
+    const int res = DoOpCommon(op, &mFollowerMetaServerSock);
+    if (res < 0 && op->status == 0) {
+        op->status = res;
+    }
+    if (res < 0 || ! mFollowerMetaServerSock.IsGood() ||
+            op->status == -EHOSTUNREACH ||
+            op->status == -ETIMEDOUT) {
+        mFollowerMetaServerSock.Close();
+        mFollowerMetaServerRetryTime = now + mRetryDelaySec;
+    } else if (op->status != -EAGAIN &&
+            op->status != -EROFS &&
+            op->status != -ENOENT) {
+        return true;
+    }
+    KFS_LOG_STREAM_DEBUG <<
+        "follower: " << mFollowerMetaServerLoc <<
+        " " << op->Show() << " status: " << op->status <<
+        " retrying with primary" <<
+    KFS_LOG_EOM;
+    op->statusMsg.clear();
+    op->seq = nextSeq();
+    return false;
+}
+
 int
 KfsClientImpl::FindFreeFileTableEntry()
 {
@@ -4165,6 +4428,8 @@ KfsClientImpl::ReleaseFileTableEntry(int fte)
         " path: " << entry.pathname <<
     KFS_LOG_EOM;
     CancelPendingRead(entry);
+    // Return read ahead growth into the budget.
+    SetReadAheadWindow(entry, entry.readAheadSize);
     delete &entry;
 }
 
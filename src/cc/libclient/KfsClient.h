@@ -592,6 +592,67 @@ public:
     //
     ssize_t GetReadAheadSize(int fd) const;
 
+    ///
+    /// Set max adaptive read ahead size. The file read ahead size grows up
+    /// to this size while the file is read sequentially, and shrinks on
+    /// random access. The growth is disabled if the max size is less or
+    /// equal to the file read ahead size. The adaptive read ahead is off by
+    /// default (max size 0), and the file read ahead size is used as is.
+    /// The striped file read ahead stays multiple of the stripe size times
+    /// the number of stripes.
+    /// @param[in] desired max read ahead size
+    /// @retval actual max read ahead size
+    //
+    ssize_t SetMaxReadAheadSize(size_t size);
+    ssize_t GetMaxReadAheadSize() const;
+
+    ///
+    /// Set the memory limit for the read ahead growth beyond the file read
+    /// ahead size, shared by all open files. The default is 64MB.
+    /// @param[in] desired limit
+    /// @retval actual limit
+    //
+    ssize_t SetReadAheadMemoryBudget(size_t size);
+    ssize_t GetReadAheadMemoryBudget() const;
+
+    ///
+    /// Set hedged read parameters. The reads are issued to the replica with
+    /// the lowest measured latency. When a read takes longer than the max of
+    /// the min delay and the latency multiplier times the average latency of
+    /// the chunk server, the same read is issued to the next replica, the
+    /// first response that passes checksum verification is used, and the
+    /// other read is canceled. The defaults are 2 sec. and 4.
+    /// @param[in] min delay in milliseconds, <= 0 disables hedging
+    /// @param[in] latency multiplier
+    //
+    void SetHedgedReadParameters(int minDelayMs, int latencyMultiplier);
+    void GetHedgedReadStats(
+        int64_t& hedgedReadCount, int64_t& hedgedReadWinCount) const;
+
+    ///
+    /// Set the max number of chunks that a single record appender keeps open
+    /// for append at the same time. The records are sent to the chunk with
+    /// the least bytes pending, and the chunks are allocated ahead, while the
+    /// other chunks are still being appended to. The order of the records
+    /// appended by a single appender is not preserved with count greater
+    /// than 1. Has no effect on the files already opened for append.
+    /// @param[in] max number of chunks, default 1
+    //
+    void SetAppendMaxChunksCount(int count);
+    int GetAppendMaxChunksCount() const;
+
+    ///
+    /// Set the number of chunks past the chunk being written that the
+    /// sequential writer requests the meta server to allocate with each
+    /// chunk allocation past the end of file. The unused chunks are deleted
+    /// when the file is closed. The meta server limits the count with
+    /// metaServer.maxAllocateAheadCount. Has no effect on the files already
+    /// opened for write, and on striped files.
+    /// @param[in] number of chunks, default 0 -- no allocation ahead
+    //
+    void SetAllocateAheadCount(int count);
+    int GetAllocateAheadCount() const;
+
     int GetFileOrChunkInfo(kfsFileId_t fileId, kfsChunkId_t chunkId,
         KfsFileAttr& fattr, chunkOff_t& offset, int64_t& chunkVersion,
         vector<ServerLocation>& servers);
@@ -599,6 +660,17 @@ public:
     // Must be invoked before issuing the first read.
     int SetFullSparseFileSupport(int fd, bool flag);
     void SetFileAttributeRevalidateTime(int secs);
+    ///
+    /// Set read only follower meta server. Lookup, readdir, and get path name
+    /// requests are sent to the follower, and are re-sent to the primary
+    /// meta server if the follower is unavailable, stale, or the entry does
+    /// not exist. The follower's view of the name space might lag behind the
+    /// primary by the follower's max staleness.
+    /// @param[in] follower host name, empty or invalid port turns off the use
+    /// of the follower
+    /// @param[in] follower port
+    //
+    void SetFollowerMetaServer(const string& host, int port);
     int Chmod(const char* pathname, kfsMode_t mode);
     int Chmod(int fd, kfsMode_t mode);
     int Chown(const char* pathname, kfsUid_t user, kfsGid_t group);
@@ -208,6 +208,16 @@ struct FileTableEntry {
     int64_t              pending;
     vector<KfsFileAttr>* dirEntries;
     int                  ioBufferSize;
+    // Configured read ahead size. The read ahead buffer size is adjusted
+    // according to the access pattern, and can be larger or smaller than
+    // the configured size.
+    int                  readAheadSize;
+    // The position where the next sequential read is expected to start, the
+    // number of sequential reads, and the position where the read ahead
+    // can grow next.
+    chunkOff_t           readAheadNextPos;
+    chunkOff_t           readAheadGrowPos;
+    int                  readAheadSeqCount;
     ReadBuffer           buffer;
     ReadRequest*         mReadQueue[1];
 
@@ -228,6 +238,10 @@ struct FileTableEntry {
         pending(0),
         dirEntries(0),
         ioBufferSize(0),
+        readAheadSize(0),
+        readAheadNextPos(0),
+        readAheadGrowPos(0),
+        readAheadSeqCount(0),
         buffer()
         { mReadQueue[0] = 0; }
     ~FileTableEntry()
@@ -559,6 +573,17 @@ public:
     ssize_t GetDefaultReadAheadSize() const;
     ssize_t SetReadAheadSize(int fd, size_t size);
     ssize_t GetReadAheadSize(int fd) const;
+    ssize_t SetMaxReadAheadSize(size_t size);
+    ssize_t GetMaxReadAheadSize() const;
+    ssize_t SetReadAheadMemoryBudget(size_t size);
+    ssize_t GetReadAheadMemoryBudget() const;
+    void SetHedgedReadParameters(int minDelayMs, int latencyMultiplier);
+    void GetHedgedReadStats(
+        int64_t& hedgedReadCount, int64_t& hedgedReadWinCount) const;
+    void SetAppendMaxChunksCount(int count);
+    int GetAppendMaxChunksCount() const;
+    void SetAllocateAheadCount(int count);
+    int GetAllocateAheadCount() const;
 
     /// A read for an offset that is after the specified value will result in EOF
     void SetEOFMark(int fd, chunkOff_t offset);
@@ -571,6 +596,7 @@ public:
     // Must be invoked before issuing the first read.
     int SetFullSparseFileSupport(int fd, bool flag);
     void SetFileAttributeRevalidateTime(int secs);
+    void SetFollowerMetaServer(const ServerLocation& loc);
     int Chmod(const char* pathname, kfsMode_t mode);
     int Chmod(int fd, kfsMode_t mode);
     int Chown(const char* pathname, kfsUid_t user, kfsGid_t group);
@@ -600,6 +626,10 @@ private:
 
     /// a tcp socket that holds the connection with the server
     TcpSocket	mMetaServerSock;
+    /// optional read only follower meta server
+    ServerLocation mFollowerMetaServerLoc;
+    TcpSocket      mFollowerMetaServerSock;
+    time_t         mFollowerMetaServerRetryTime;
     /// seq # that we send in each command
     kfsSeq_t	mCmdSeqNum;
 
@@ -717,11 +747,18 @@ private:
     const string                   mSlash;
     size_t                         mDefaultIoBufferSize;
     size_t                         mDefaultReadAheadSize;
+    size_t                         mMaxReadAheadSize;
+    size_t                         mReadAheadMemoryBudget;
+    size_t                         mReadAheadAdaptiveBytes;
     bool                           mFailShortReadsFlag;
     unsigned int                   mFileInstance;
     KfsProtocolWorker*             mProtocolWorker;
     int                            mMaxNumRetriesPerOp;
     int                            mRetryDelaySec;
+    int                            mHedgedReadMinDelayMs;
+    int                            mHedgedReadLatencyMultiplier;
+    int                            mAppendMaxChunksCount;
+    int                            mAllocateAheadCount;
     int                            mDefaultOpTimeout;
     ReadRequestCondVar*            mFreeCondVarsHead;
     kfsUid_t                       mEUser;
@@ -785,6 +822,8 @@ private:
         int numStripes, int numRecoveryStripes, int stripeSize, int stripedType,
         bool forceTypeFlag, kfsMode_t mode);
     ssize_t SetReadAheadSize(FileTableEntry& inEntry, size_t inSize, bool optimalFlag = false);
+    void SetReadAheadWindow(FileTableEntry& inEntry, int inSize);
+    void UpdateReadAheadWindow(FileTableEntry& inEntry, int64_t inPos, int inSize);
     ssize_t SetIoBufferSize(FileTableEntry& entry, size_t size, bool optimalFlag = false);
     ssize_t SetOptimalIoBufferSize(FileTableEntry& entry, size_t size) {
         return SetIoBufferSize(entry, size, true);
@@ -845,6 +884,7 @@ private:
     /// Do the work for an op with the metaserver; if the metaserver
     /// dies in the middle, retry the op a few times before giving up.
     void DoMetaOpWithRetry(KfsOp *op);
+    bool DoFollowerMetaOp(KfsOp *op);
 
     /// Get a response from the server, where, the response is
     /// terminated by "\r\n\r\n".
@@ -43,6 +43,7 @@
 #include "common/kfsdecls.h"
 #include "common/MsgLogger.h"
 #include "common/StdAllocator.h"
+#include "common/StBuffer.h"
 #include "qcdio/QCUtils.h"
 #include "qcdio/qcstutils.h"
 #include "qcdio/QCDLList.h"
@@ -94,6 +95,7 @@ public:
           mNextSeqNum(
             (inInitialSeqNum < 0 ? -inInitialSeqNum : inInitialSeqNum) >> 1),
           mReadHeaderDoneFlag(false),
+          mShortRpcFormatFlag(false),
           mSleepingFlag(false),
           mDataReceivedFlag(false),
           mDataSentFlag(false),
@@ -113,7 +115,7 @@ public:
           mInFlightOpPtr(0),
           mOutstandingOpPtr(0),
           mCurOpIt(),
-          mIstream(),
+          mParseBuffer(),
           mOstream(),
           mProperties(),
           mStats(),
@@ -491,6 +493,7 @@ private:
     NetConnectionPtr   mConnPtr;
     kfsSeq_t           mNextSeqNum;
     bool               mReadHeaderDoneFlag;
+    bool               mShortRpcFormatFlag;
     bool               mSleepingFlag;
     bool               mDataReceivedFlag;
     bool               mDataSentFlag;
@@ -510,7 +513,7 @@ private:
     OpQueueEntry*      mInFlightOpPtr;
     OpQueueEntry*      mOutstandingOpPtr;
     OpQueue::iterator  mCurOpIt;
-    IOBuffer::IStream  mIstream;
+    StBufferT<char, 1> mParseBuffer;
     IOBuffer::WOStream mOstream;
     Properties         mProperties;
     Stats              mStats;
@@ -555,6 +558,8 @@ private:
         int           inRetryCount)
     {
         KfsOp& theOp = *inEntry.mOpPtr;
+        theOp.shortRpcFormatFlag =
+            mShortRpcFormatFlag && theOp.SupportsShortRpcFormat();
         theOp.Request(mOstream.Set(mConnPtr->GetOutBuffer()));
         mOstream.Reset();
         if (theOp.contentLength > 0) {
@@ -658,14 +663,32 @@ private:
         const int  theHdrLen = theIdx + 4;
         const char theSeparator     = ':';
         const bool theMultiLineFlag = false;
+        // The header is copied only if it spans more than one io buffer.
+        // The parse buffer grows to the max. header size, and stays there.
+        int               theLen = theHdrLen;
+        const char* const thePtr = inBuffer.CopyOutOrGetBufPtr(
+            mParseBuffer.Resize(theHdrLen), theLen);
         mProperties.clear();
         mProperties.loadProperties(
-            mIstream.Set(inBuffer, theHdrLen), theSeparator, theMultiLineFlag);
-        mIstream.Reset();
+            thePtr, theLen, theSeparator, theMultiLineFlag);
         inBuffer.Consume(theHdrLen);
         mReadHeaderDoneFlag = true;
-        mContentLength = mProperties.getValue("Content-length", 0);
-        const kfsSeq_t theOpSeq = mProperties.getValue("Cseq", kfsSeq_t(-1));
+        // Text and short format responses can be interleaved, as the requests
+        // sent prior to the short format acknowledgment are in text format.
+        const bool theShortRpcFormatFlag = mShortRpcFormatFlag &&
+            mProperties.getValue("c", (const char*)0);
+        mProperties.setIntBase(theShortRpcFormatFlag ? 16 : 10);
+        if (! mShortRpcFormatFlag) {
+            // Server responds with the version it will use, at most the
+            // version sent by the client.
+            const int theVers = mProperties.getValue("Short-rpc-fmt", 0);
+            mShortRpcFormatFlag =
+                0 < theVers && theVers <= KFS_SHORT_RPC_FORMAT_VERS;
+        }
+        mContentLength = mProperties.getValue(
+            theShortRpcFormatFlag ? "l" : "Content-length", 0);
+        const kfsSeq_t theOpSeq = mProperties.getValue(
+            theShortRpcFormatFlag ? "c" : "Cseq", kfsSeq_t(-1));
         if (mContentLength > mMaxContentLength) {
             KFS_LOG_STREAM_ERROR << mLogPrefix <<
                 "error: " << mServerLocation.ToString() <<
@@ -839,6 +862,7 @@ private:
         mConnPtr->SetOwningKfsCallbackObj(0);
         mConnPtr.reset();
         mReadHeaderDoneFlag = false;
+        mShortRpcFormatFlag = false;
         mContentLength      = 0;
     }
     void HandleOp(
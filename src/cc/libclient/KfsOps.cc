@@ -69,12 +69,16 @@ public:
         {}
     ostream& Insert(ostream& os) const
     {
-        return (os <<
+        os <<
             "Cseq: "                    << op.seq                << "\r\n"
             "Version: "                    "KFS/1.0"                "\r\n"
             "Client-Protocol-Version: " << KFS_CLIENT_PROTO_VERS << "\r\n"
-            << KfsOp::sExtraHeaders
-        );
+        ;
+        if (op.SupportsShortRpcFormat()) {
+            // Ask the chunk server to acknowledge short rpc format support.
+            os << "Short-rpc-fmt: " << KFS_SHORT_RPC_FORMAT_VERS << "\r\n";
+        }
+        return (os << KfsOp::sExtraHeaders);
     }
 private:
     const KfsOp& op;
@@ -332,12 +336,21 @@ AllocateOp::Request(ostream &os)
     if (invalidateAllFlag) {
         os << "Invalidate-all: 1\r\n";
     }
+    if (allocateAheadCount > 0 && ! append) {
+        os << "Allocate-ahead: " << allocateAheadCount << "\r\n";
+        if (allocateAheadOwner >= 0) {
+            os << "Allocate-ahead-owner: " << allocateAheadOwner << "\r\n";
+        }
+    }
     if (append) {
         os <<
             "Chunk-append: 1\r\n"
             "Space-reserve: " << spaceReservationSize << "\r\n"
             "Max-appenders: " << maxAppendersPerChunk << "\r\n"
         ;
+        if (appendNewChunkFlag) {
+            os << "Append-new-chunk: 1\r\n";
+        }
     }
     os << "\r\n";
 }
@@ -354,6 +367,12 @@ TruncateOp::Request(ostream &os)
     if (pruneBlksFromHead) {
         os << "Prune-from-head: 1\r\n";
     }
+    if (reclaimFlag) {
+        os << "Reclaim-chunks: 1\r\n";
+        if (allocateAheadOwner >= 0) {
+            os << "Allocate-ahead-owner: " << allocateAheadOwner << "\r\n";
+        }
+    }
     os << "\r\n";
 }
 
@@ -402,6 +421,17 @@ CloseOp::Request(ostream &os)
 void
 ReadOp::Request(ostream &os)
 {
+    if (shortRpcFormatFlag) {
+        os <<
+            "rd\r\n"
+            "c: " << HexIntFmt(seq)          << "\r\n"
+            "H: " << HexIntFmt(chunkId)      << "\r\n"
+            "V: " << HexIntFmt(chunkVersion) << "\r\n"
+            "O: " << HexIntFmt(offset)       << "\r\n"
+            "B: " << HexIntFmt(numBytes)     << "\r\n"
+        "\r\n";
+        return;
+    }
     os <<
         "READ\r\n"        << ReqHeaders(*this) <<
         "Chunk-handle: "  << chunkId           << "\r\n"
@@ -414,16 +444,30 @@ ReadOp::Request(ostream &os)
 void
 WriteIdAllocOp::Request(ostream &os)
 {
-    os <<
-        "WRITE_ID_ALLOC\r\n"  << ReqHeaders(*this)           <<
-        "Chunk-handle: "      << chunkId                     << "\r\n"
-        "Chunk-version: "     << chunkVersion                << "\r\n"
-        "Offset: "            << offset                      << "\r\n"
-        "Num-bytes: "         << numBytes                    << "\r\n"
-        "For-record-append: " << (isForRecordAppend ? 1 : 0) << "\r\n"
-        "Num-servers: "       << chunkServerLoc.size()       << "\r\n"
-        "Servers:"
-    ;
+    if (shortRpcFormatFlag) {
+        os <<
+            "wa\r\n"
+            "c: " << HexIntFmt(seq)                   << "\r\n"
+            "H: " << HexIntFmt(chunkId)               << "\r\n"
+            "V: " << HexIntFmt(chunkVersion)          << "\r\n"
+            "O: " << HexIntFmt(offset)                << "\r\n"
+            "B: " << HexIntFmt(numBytes)              << "\r\n"
+            "A: " << (isForRecordAppend ? 1 : 0)      << "\r\n"
+            "R: " << HexIntFmt(chunkServerLoc.size()) << "\r\n"
+            "S:"
+        ;
+    } else {
+        os <<
+            "WRITE_ID_ALLOC\r\n"  << ReqHeaders(*this)           <<
+            "Chunk-handle: "      << chunkId                     << "\r\n"
+            "Chunk-version: "     << chunkVersion                << "\r\n"
+            "Offset: "            << offset                      << "\r\n"
+            "Num-bytes: "         << numBytes                    << "\r\n"
+            "For-record-append: " << (isForRecordAppend ? 1 : 0) << "\r\n"
+            "Num-servers: "       << chunkServerLoc.size()       << "\r\n"
+            "Servers:"
+        ;
+    }
     for (vector<ServerLocation>::size_type i = 0; i < chunkServerLoc.size(); ++i) {
         os << chunkServerLoc[i].ToString() << ' ';
     }
@@ -469,30 +513,51 @@ ChunkSpaceReleaseOp::Request(ostream &os)
 void
 WritePrepareOp::Request(ostream &os)
 {
-    // one checksum over the whole data plus one checksum per 64K block
-    os <<
-        "WRITE_PREPARE\r\n"  << ReqHeaders(*this) <<
-        "Chunk-handle: "     << chunkId           << "\r\n"
-        "Chunk-version: "    << chunkVersion      << "\r\n"
-        "Offset: "           << offset            << "\r\n"
-        "Num-bytes: "        << numBytes          << "\r\n"
-        "Checksum: "         << checksum          << "\r\n"
-        "Checksum-entries: " << checksums.size()  << "\r\n"
-    ;
-    if (checksums.size() > 0) {
-        os << "Checksums: ";
-        for (uint32_t i = 0; i < checksums.size(); i++) {
-            os << checksums[i] << ' ';
+    if (shortRpcFormatFlag) {
+        // The chunk server computes per block checksums itself, and
+        // only uses the checksum over the whole data.
+        os <<
+            "wp\r\n"
+            "c: " << HexIntFmt(seq)              << "\r\n"
+            "H: " << HexIntFmt(chunkId)          << "\r\n"
+            "V: " << HexIntFmt(chunkVersion)     << "\r\n"
+            "O: " << HexIntFmt(offset)           << "\r\n"
+            "B: " << HexIntFmt(numBytes)         << "\r\n"
+            "K: " << HexIntFmt(checksum)         << "\r\n"
+        ;
+        if (replyRequestedFlag) {
+            os << "P: 1\r\n";
         }
-        os << "\r\n";
-    }
-    if (replyRequestedFlag) {
-        os << "Reply: 1\r\n";
+        os <<
+            "R: " << HexIntFmt(writeInfo.size()) << "\r\n"
+            "S:"
+        ;
+    } else {
+        // one checksum over the whole data plus one checksum per 64K block
+        os <<
+            "WRITE_PREPARE\r\n"  << ReqHeaders(*this) <<
+            "Chunk-handle: "     << chunkId           << "\r\n"
+            "Chunk-version: "    << chunkVersion      << "\r\n"
+            "Offset: "           << offset            << "\r\n"
+            "Num-bytes: "        << numBytes          << "\r\n"
+            "Checksum: "         << checksum          << "\r\n"
+            "Checksum-entries: " << checksums.size()  << "\r\n"
+        ;
+        if (checksums.size() > 0) {
+            os << "Checksums: ";
+            for (uint32_t i = 0; i < checksums.size(); i++) {
+                os << checksums[i] << ' ';
+            }
+            os << "\r\n";
+        }
+        if (replyRequestedFlag) {
+            os << "Reply: 1\r\n";
+        }
+        os <<
+            "Num-servers: " << writeInfo.size() << "\r\n"
+            "Servers:"
+        ;
     }
-    os <<
-        "Num-servers: " << writeInfo.size() << "\r\n"
-        "Servers:"
-    ;
     for (vector<WriteInfo>::size_type i = 0; i < writeInfo.size(); ++i) {
 	os << writeInfo[i].serverLoc.ToString() <<
 	    ' ' << writeInfo[i].writeId << ' ';
@@ -503,25 +568,48 @@ WritePrepareOp::Request(ostream &os)
 void
 WriteSyncOp::Request(ostream &os)
 {
-    os <<
-        "WRITE_SYNC\r\n"     << ReqHeaders(*this) <<
-        "Chunk-handle: "     << chunkId           << "\r\n"
-        "Chunk-version: "    << chunkVersion      << "\r\n"
-        "Offset: "           << offset            << "\r\n"
-        "Num-bytes: "        << numBytes          << "\r\n"
-        "Checksum-entries: " << checksums.size()  << "\r\n"
-    ;
-    if (checksums.size() > 0) {
-        os << "Checksums: ";
-        for (uint32_t i = 0; i < checksums.size(); i++) {
-            os << checksums[i] << ' ';
+    if (shortRpcFormatFlag) {
+        os <<
+            "ws\r\n"
+            "c: " << HexIntFmt(seq)              << "\r\n"
+            "H: " << HexIntFmt(chunkId)          << "\r\n"
+            "V: " << HexIntFmt(chunkVersion)     << "\r\n"
+            "O: " << HexIntFmt(offset)           << "\r\n"
+            "B: " << HexIntFmt(numBytes)         << "\r\n"
+        ;
+        if (! checksums.empty()) {
+            os << "E: " << HexIntFmt(checksums.size()) << "\r\n"
+                "C:";
+            for (uint32_t i = 0; i < checksums.size(); i++) {
+                os << ' ' << HexIntFmt(checksums[i]);
+            }
+            os << "\r\n";
         }
-        os << "\r\n";
+        os <<
+            "R: " << HexIntFmt(writeInfo.size()) << "\r\n"
+            "S:"
+        ;
+    } else {
+        os <<
+            "WRITE_SYNC\r\n"     << ReqHeaders(*this) <<
+            "Chunk-handle: "     << chunkId           << "\r\n"
+            "Chunk-version: "    << chunkVersion      << "\r\n"
+            "Offset: "           << offset            << "\r\n"
+            "Num-bytes: "        << numBytes          << "\r\n"
+            "Checksum-entries: " << checksums.size()  << "\r\n"
+        ;
+        if (checksums.size() > 0) {
+            os << "Checksums: ";
+            for (uint32_t i = 0; i < checksums.size(); i++) {
+                os << checksums[i] << ' ';
+            }
+            os << "\r\n";
+        }
+        os <<
+            "Num-servers: " << writeInfo.size() << "\r\n"
+            "Servers:"
+        ;
     }
-    os <<
-        "Num-servers: " << writeInfo.size() << "\r\n"
-        "Servers:"
-    ;
     for (vector<WriteInfo>::size_type i = 0; i < writeInfo.size(); ++i) {
 	os << writeInfo[i].serverLoc.ToString() <<
 	    ' ' << writeInfo[i].writeId << ' ';
@@ -591,17 +679,31 @@ LeaseRelinquishOp::Request(ostream &os)
 void
 RecordAppendOp::Request(ostream &os)
 {
-    os <<
-        "RECORD_APPEND\r\n" << ReqHeaders(*this) <<
-        "Chunk-handle: "    << chunkId           << "\r\n"
-        "Chunk-version: "   << chunkVersion      << "\r\n"
-        "Num-bytes: "       << contentLength     << "\r\n"
-        "Checksum: "        << checksum          << "\r\n"
-        "Offset: "          << offset            << "\r\n"
-        "File-offset: "       "-1"                  "\r\n"
-        "Num-servers: "     << writeInfo.size()  << "\r\n"
-        "Servers:"
-    ;
+    if (shortRpcFormatFlag) {
+        os <<
+            "ra\r\n"
+            "c: " << HexIntFmt(seq)              << "\r\n"
+            "H: " << HexIntFmt(chunkId)          << "\r\n"
+            "V: " << HexIntFmt(chunkVersion)     << "\r\n"
+            "B: " << HexIntFmt(contentLength)    << "\r\n"
+            "K: " << HexIntFmt(checksum)         << "\r\n"
+            "O: " << HexIntFmt(offset)           << "\r\n"
+            "R: " << HexIntFmt(writeInfo.size()) << "\r\n"
+            "S:"
+        ;
+    } else {
+        os <<
+            "RECORD_APPEND\r\n" << ReqHeaders(*this) <<
+            "Chunk-handle: "    << chunkId           << "\r\n"
+            "Chunk-version: "   << chunkVersion      << "\r\n"
+            "Num-bytes: "       << contentLength     << "\r\n"
+            "Checksum: "        << checksum          << "\r\n"
+            "Offset: "          << offset            << "\r\n"
+            "File-offset: "       "-1"                  "\r\n"
+            "Num-servers: "     << writeInfo.size()  << "\r\n"
+            "Servers:"
+        ;
+    }
     for (vector<WriteInfo>::size_type i = 0; i < writeInfo.size(); ++i) {
 	os << writeInfo[i].serverLoc.ToString() <<
 	    ' ' << writeInfo[i].writeId << ' ';
@@ -675,6 +777,13 @@ KfsOp::ParseResponseHeader(std::istream& is)
 void
 KfsOp::ParseResponseHeader(const Properties &prop)
 {
+    if (shortRpcFormatFlag) {
+        status        = prop.getValue("s", -1);
+        contentLength = prop.getValue("l", 0);
+        statusMsg     = prop.getValue("m", string());
+        ParseResponseHeaderSelf(prop);
+        return;
+    }
     // kfsSeq_t resSeq = prop.getValue("Cseq", (kfsSeq_t) -1);
     status = prop.getValue("Status", -1);
     contentLength = prop.getValue("Content-length", 0);
@@ -848,6 +957,29 @@ AllocateOp::ParseResponseHeaderSelf(const Properties &prop)
 		chunkServers.push_back(loc);
 	}
     }
+
+    allocateAhead.clear();
+    const string ahead = prop.getValue("Allocate-ahead", string());
+    if (ahead.empty()) {
+        return;
+    }
+    // <offset> <chunk id> <version> <# servers> <server location>...
+    istringstream ist(ahead);
+    AllocateAheadInfo info;
+    int               numServers = 0;
+    while ((ist >> info.fileOffset >> info.chunkId >> info.chunkVersion >>
+            numServers) && numServers > 0) {
+        ServerLocation loc;
+        info.chunkServers.clear();
+        for (int i = 0; i < numServers && (ist >> loc.hostname >> loc.port);
+                i++) {
+            info.chunkServers.push_back(loc);
+        }
+        if ((int)info.chunkServers.size() != numServers) {
+            break;
+        }
+        allocateAhead.push_back(info);
+    }
 }
 
 void
@@ -936,6 +1068,24 @@ ReadOp::ParseResponseHeaderSelf(const Properties &prop)
     string checksumStr;
     uint32_t nentries;
 
+    if (shortRpcFormatFlag) {
+        nentries    = prop.getValue("E", 0);
+        checksumStr = prop.getValue("C", "");
+        diskIOTime  = prop.getValue("D", 0.0);
+        drivename   = prop.getValue("d", "");
+        const char*       ptr = checksumStr.data();
+        const char* const end = ptr + checksumStr.size();
+        checksums.clear();
+        checksums.reserve(nentries);
+        for (uint32_t i = 0; i < nentries; i++) {
+            uint32_t cksum = 0;
+            if (! HexIntParser::Parse(ptr, end - ptr, cksum)) {
+                break;
+            }
+            checksums.push_back(cksum);
+        }
+        return;
+    }
     nentries = prop.getValue("Checksum-entries", 0);
     checksumStr = prop.getValue("Checksums", "");
     diskIOTime = prop.getValue("DiskIOtime", 0.0);
@@ -952,6 +1102,11 @@ ReadOp::ParseResponseHeaderSelf(const Properties &prop)
 void
 WriteIdAllocOp::ParseResponseHeaderSelf(const Properties &prop)
 {
+    if (shortRpcFormatFlag) {
+        writeIdStr                  = prop.getValue("W", string());
+        writePrepReplySupportedFlag = prop.getValue("P", 0) != 0;
+        return;
+    }
     writeIdStr                  = prop.getValue("Write-id", string());
     writePrepReplySupportedFlag = prop.getValue("Write-prepare-reply", 0) != 0;
 }
@@ -105,10 +105,15 @@ struct KfsOp {
     size_t   contentBufLen;
     char*    contentBuf;
     string   statusMsg; // optional, mostly for debugging
+    // Use short rpc format for the request and response. Set by KfsNetClient
+    // once the chunk server acknowledges short format support, and only
+    // for the ops that support it.
+    bool     shortRpcFormatFlag;
 
     KfsOp (KfsOp_t o, kfsSeq_t s)
         : op(o), seq(s), status(0), checksum(0), contentLength(0),
-          contentBufLen(0), contentBuf(0), statusMsg()
+          contentBufLen(0), contentBuf(0), statusMsg(),
+          shortRpcFormatFlag(false)
         {}
     // to allow dynamic-type-casting, make the destructor virtual
     virtual ~KfsOp() {
@@ -145,12 +150,17 @@ struct KfsOp {
     virtual void Request(ostream &os) = 0;
     virtual bool NextRequest(kfsSeq_t /* seq */, ostream& /* os */)
         { return false; }
+    // Chunk data ops that have short rpc format representation: short keys,
+    // and hex integer values.
+    virtual bool SupportsShortRpcFormat() const
+        { return false; }
 
     // Common parsing code: parse the response from string and fill
     // that into a properties structure.
     void ParseResponseHeader(istream& is);
     // Parse a response header from the server: This does the
     // default parsing of OK/Cseq/Status/Content-length.
+    // Short rpc format properties must be loaded with int base 16.
     void ParseResponseHeader(const Properties& prop);
 
     // Return information about op that can printed out for debugging.
@@ -604,7 +614,27 @@ struct AllocateOp : public KfsOp {
     int spaceReservationSize;
     // suggested max. # of concurrent appenders per chunk
     int maxAppendersPerChunk;
+    // append: allocate new chunk for this client only
+    bool appendNewChunkFlag;
     bool invalidateAllFlag;
+    // sequential write: the number of chunks past this one to allocate
+    int allocateAheadCount;
+    // sequential write: the writer id the chunks allocated ahead belong to
+    int64_t allocateAheadOwner;
+    struct AllocateAheadInfo
+    {
+        chunkOff_t             fileOffset;
+        kfsChunkId_t           chunkId;
+        int64_t                chunkVersion;
+        vector<ServerLocation> chunkServers; // master first
+        AllocateAheadInfo()
+            : fileOffset(-1),
+              chunkId(-1),
+              chunkVersion(-1),
+              chunkServers()
+            {}
+    };
+    vector<AllocateAheadInfo> allocateAhead; // result
     AllocateOp(kfsSeq_t s, kfsFileId_t f, const string &p) :
         KfsOp(CMD_ALLOCATE, s),
         fid(f),
@@ -617,7 +647,11 @@ struct AllocateOp : public KfsOp {
         append(false),
         spaceReservationSize(1 << 20),
         maxAppendersPerChunk(64),
-        invalidateAllFlag(false)
+        appendNewChunkFlag(false),
+        invalidateAllFlag(false),
+        allocateAheadCount(0),
+        allocateAheadOwner(-1),
+        allocateAhead()
         {}
     void Request(ostream &os);
     virtual void ParseResponseHeaderSelf(const Properties& prop);
@@ -626,6 +660,9 @@ struct AllocateOp : public KfsOp {
 
         os << "allocate: fid: " << fid << " offset: " << fileOffset <<
             (invalidateAllFlag ? " invalidate" : "") ;
+        if (allocateAheadCount > 0) {
+            os << " ahead: " << allocateAheadCount;
+        }
         return os.str();
     }
 };
@@ -635,9 +672,13 @@ struct TruncateOp : public KfsOp {
     kfsFileId_t fid;
     chunkOff_t  fileOffset;
     bool        pruneBlksFromHead;
+    // delete unused chunks allocated ahead starting from the offset
+    bool        reclaimFlag;
+    // the writer id the chunks to reclaim were allocated ahead for
+    int64_t     allocateAheadOwner;
     TruncateOp(kfsSeq_t s, const char *p, kfsFileId_t f, chunkOff_t o) :
         KfsOp(CMD_TRUNCATE, s), pathname(p), fid(f), fileOffset(o),
-        pruneBlksFromHead(false)
+        pruneBlksFromHead(false), reclaimFlag(false), allocateAheadOwner(-1)
     {
 
     }
@@ -647,6 +688,8 @@ struct TruncateOp : public KfsOp {
 
         if (pruneBlksFromHead)
             os << "prune blks from head: ";
+        else if (reclaimFlag)
+            os << "reclaim chunks: ";
         else
             os << "truncate: ";
         os << " fid: " << fid << " offset: " << fileOffset;
@@ -762,6 +805,8 @@ struct ReadOp : public KfsOp {
 
     }
     void Request(ostream &os);
+    virtual bool SupportsShortRpcFormat() const
+        { return true; }
     virtual void ParseResponseHeaderSelf(const Properties& prop);
 
     string Show() const {
@@ -800,6 +845,8 @@ struct WriteIdAllocOp : public KfsOp {
 
     }
     void Request(ostream &os);
+    virtual bool SupportsShortRpcFormat() const
+        { return true; }
     virtual void ParseResponseHeaderSelf(const Properties& prop);
     string Show() const {
         ostringstream os;
@@ -829,6 +876,8 @@ struct WritePrepareOp : public KfsOp {
           writeInfo()
         {}
     void Request(ostream &os);
+    virtual bool SupportsShortRpcFormat() const
+        { return true; }
     string Show() const {
         ostringstream os;
 
@@ -861,6 +910,8 @@ struct WriteSyncOp : public KfsOp {
           writeInfo()
         {}
     void Request(ostream &os);
+    virtual bool SupportsShortRpcFormat() const
+        { return true; }
     string Show() const {
         ostringstream os;
 
@@ -1002,6 +1053,8 @@ struct RecordAppendOp : public KfsOp {
 
     }
     void Request(ostream &os);
+    virtual bool SupportsShortRpcFormat() const
+        { return true; }
     string Show() const {
         ostringstream os;
 
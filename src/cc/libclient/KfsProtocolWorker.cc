@@ -53,6 +53,7 @@
 #include "WriteAppender.h"
 #include "Writer.h"
 #include "Reader.h"
+#include "ReplicaSelector.h"
 
 namespace KFS
 {
@@ -116,10 +117,13 @@ public:
           mMaxReadSize(inParameters.mMaxReadSize),
           mReadLeaseRetryTimeout(inParameters.mReadLeaseRetryTimeout),
           mLeaseWaitTimeout(inParameters.mLeaseWaitTimeout),
+          mAppendMaxChunksCount(inParameters.mAppendMaxChunksCount),
+          mAllocateAheadCount(inParameters.mAllocateAheadCount),
           mChunkServerInitialSeqNum(
             inParameters.mChunkServerInitialSeqNum > 0 ?
                 inParameters.mChunkServerInitialSeqNum :
                 GetInitalSeqNum(0x19885a10)),
+          mReplicaSelector(),
           mDoNotDeallocate(),
           mStopRequest(),
           mWorker(this, "KfsProtocolWorker"),
@@ -439,6 +443,34 @@ public:
         QCStMutexLocker theLock(mMutex);
         mOpTimeoutSec = inSecs;
     }
+    void SetAppendMaxChunksCount(
+        int inCount)
+    {
+        QCStMutexLocker theLock(mMutex);
+        mAppendMaxChunksCount = inCount;
+    }
+    void SetAllocateAheadCount(
+        int inCount)
+    {
+        QCStMutexLocker theLock(mMutex);
+        mAllocateAheadCount = inCount;
+    }
+    void SetHedgedReadParameters(
+        int inMinDelayMs,
+        int inLatencyMultiplier)
+    {
+        mReplicaSelector.SetHedgeParameters(
+            inMinDelayMs, inLatencyMultiplier);
+    }
+    void GetHedgedReadStats(
+        int64_t& outHedgedReadCount,
+        int64_t& outHedgedReadWinCount) const
+    {
+        ReplicaSelector::Stats theStats;
+        mReplicaSelector.GetStats(theStats);
+        outHedgedReadCount    = theStats.mHedgedReadCount;
+        outHedgedReadWinCount = theStats.mHedgedReadWinCount;
+    }
 private:
     class StopRequest : public Request
     {
@@ -752,7 +784,9 @@ private:
                 inOwner.mIdleTimeoutSec,
                 inLogPrefixPtr,
                 inOwner.mChunkServerInitialSeqNum,
-                inOwner.mPreAllocateFlag
+                inOwner.mPreAllocateFlag,
+                0, // inClientPoolPtr
+                inOwner.mAppendMaxChunksCount
               ),
               mWriteThreshold(inOwner.mWriteAppendThreshold),
               mPending(0),
@@ -974,7 +1008,8 @@ private:
                 inOwner.mIdleTimeoutSec,
                 inOwner.mMaxWriteSize,
                 inLogPrefixPtr,
-                inOwner.mChunkServerInitialSeqNum
+                inOwner.mChunkServerInitialSeqNum,
+                inOwner.mAllocateAheadCount
               ),
               mCurRequestPtr(0)
             { WorkQueue::Init(mWorkQueue); }
@@ -1265,7 +1300,8 @@ private:
                 inOwner.mReadLeaseRetryTimeout,
                 inOwner.mLeaseWaitTimeout,
                 inLogPrefixPtr,
-                inOwner.mChunkServerInitialSeqNum),
+                inOwner.mChunkServerInitialSeqNum,
+                &inOwner.mReplicaSelector),
               mCurRequestPtr(0),
               mAsyncReadStatus(0),
               mAsyncReadDoneCount(0)
@@ -1487,7 +1523,10 @@ private:
     const int         mMaxReadSize;
     const int         mReadLeaseRetryTimeout;
     const int         mLeaseWaitTimeout;
+    int               mAppendMaxChunksCount;
+    int               mAllocateAheadCount;
     int64_t           mChunkServerInitialSeqNum;
+    ReplicaSelector   mReplicaSelector;
     DoNotDeallocate   mDoNotDeallocate;
     StopRequest       mStopRequest;
     QCThread          mWorker;
@@ -1764,4 +1803,34 @@ KfsProtocolWorker::SetOpTimeoutSec(
     mImpl.SetOpTimeoutSec(inSecs);
 }
 
+void
+KfsProtocolWorker::SetAppendMaxChunksCount(
+    int inCount)
+{
+    mImpl.SetAppendMaxChunksCount(inCount);
+}
+
+void
+KfsProtocolWorker::SetAllocateAheadCount(
+    int inCount)
+{
+    mImpl.SetAllocateAheadCount(inCount);
+}
+
+void
+KfsProtocolWorker::SetHedgedReadParameters(
+    int inMinDelayMs,
+    int inLatencyMultiplier)
+{
+    mImpl.SetHedgedReadParameters(inMinDelayMs, inLatencyMultiplier);
+}
+
+void
+KfsProtocolWorker::GetHedgedReadStats(
+    int64_t& outHedgedReadCount,
+    int64_t& outHedgedReadWinCount) const
+{
+    mImpl.GetHedgedReadStats(outHedgedReadCount, outHedgedReadWinCount);
+}
+
 }} /* namespace client KFS */
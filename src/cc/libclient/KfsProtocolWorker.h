@@ -198,7 +198,9 @@ public:
             int         inMaxReadSize                 = 1 << 20,
             int         inReadLeaseRetryTimeout       = 3,
             int         inLeaseWaitTimeout            = 900,
-            int         inMaxMetaServerContentLength  = 1 << 20)
+            int         inMaxMetaServerContentLength  = 1 << 20,
+            int         inAppendMaxChunksCount        = 1,
+            int         inAllocateAheadCount          = 0)
             : mMetaMaxRetryCount(inMetaMaxRetryCount),
               mMetaTimeSecBetweenRetries(inMetaTimeSecBetweenRetries),
               mMetaOpTimeoutSec(inMetaOpTimeoutSec),
@@ -220,7 +222,9 @@ public:
               mMaxReadSize(inMaxReadSize),
               mReadLeaseRetryTimeout(inReadLeaseRetryTimeout),
               mLeaseWaitTimeout(inLeaseWaitTimeout),
-              mMaxMetaServerContentLength(inMaxMetaServerContentLength)
+              mMaxMetaServerContentLength(inMaxMetaServerContentLength),
+              mAppendMaxChunksCount(inAppendMaxChunksCount),
+              mAllocateAheadCount(inAllocateAheadCount)
             {}
             int         mMetaMaxRetryCount;
             int         mMetaTimeSecBetweenRetries;
@@ -244,6 +248,8 @@ public:
             int         mReadLeaseRetryTimeout;
             int         mLeaseWaitTimeout;
             int         mMaxMetaServerContentLength;
+            int         mAppendMaxChunksCount;
+            int         mAllocateAheadCount;
     };
     KfsProtocolWorker(
         std::string       inMetaHost,
@@ -276,6 +282,24 @@ public:
         int inSecs);
     void SetOpTimeoutSec(
         int inSecs);
+    // Max number of chunks that each write appender keeps open for append at
+    // the same time. Has no effect on already opened files.
+    void SetAppendMaxChunksCount(
+        int inCount);
+    // Number of chunks past the chunk being written that sequential writer
+    // asks meta server to allocate in a single allocation request. Has no
+    // effect on already opened files.
+    void SetAllocateAheadCount(
+        int inCount);
+    // The read is also issued to the next replica when it takes longer than
+    // max(min delay, latency multiplier * average server latency), and the
+    // first response wins. Min delay <= 0 disables hedging.
+    void SetHedgedReadParameters(
+        int inMinDelayMs,
+        int inLatencyMultiplier);
+    void GetHedgedReadStats(
+        int64_t& outHedgedReadCount,
+        int64_t& outHedgedReadWinCount) const;
 private:
     Impl& mImpl;
 private:
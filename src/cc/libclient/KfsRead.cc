@@ -581,6 +581,9 @@ KfsClientImpl::Read(
     int64_t       theLen           = min(theEof - thePos, (int64_t)inSize);
     const int     theSize          = (int)theLen;
     const bool    theSkipHolesFlag = theEntry.skipHoles;
+    if (theSize > 0) {
+        UpdateReadAheadWindow(theEntry, thePos, theSize);
+    }
     // Wait for prefetch with this buffer, if any.
     ReadRequest* const theReqPtr = ReadRequest::Find(
         theEntry, inBufPtr, (int64_t)inSize, thePos);
@@ -807,10 +810,89 @@ KfsClientImpl::SetReadAheadSize(
                 inOptimalFlag ? (1 << 20) * theAttr.numStripes : 0, theSize) +
             theStride - 1) / theStride * theStride;
     }
+    // Return the adaptive growth, if any, into the budget, and start with the
+    // new read ahead size.
+    SetReadAheadWindow(inEntry, inEntry.readAheadSize);
+    inEntry.readAheadSize     = max(0, theSize);
+    inEntry.readAheadSeqCount = 0;
     inEntry.buffer.SetBufSize(theSize);
     return inEntry.buffer.GetBufSize();
 }
 
+void
+KfsClientImpl::SetReadAheadWindow(
+    FileTableEntry& inEntry,
+    int             inSize)
+{
+    QCASSERT(mMutex.IsOwned());
+
+    const int theCurSize = inEntry.buffer.GetBufSize();
+    const int theBase    = inEntry.readAheadSize;
+    if (theCurSize == inSize) {
+        return;
+    }
+    // Only the growth beyond the configured read ahead size is accounted.
+    mReadAheadAdaptiveBytes -= max(0, theCurSize - theBase);
+    mReadAheadAdaptiveBytes += max(0, inSize - theBase);
+    inEntry.buffer.SetBufSize(inSize);
+}
+
+void
+KfsClientImpl::UpdateReadAheadWindow(
+    FileTableEntry& inEntry,
+    int64_t         inPos,
+    int             inSize)
+{
+    QCASSERT(mMutex.IsOwned());
+
+    const int theBase = inEntry.readAheadSize;
+    const int theCur  = inEntry.buffer.GetBufSize();
+    if (mMaxReadAheadSize <= 0) {
+        // Adaptive read ahead is disabled: use the configured size.
+        if (theBase < theCur) {
+            SetReadAheadWindow(inEntry, theBase);
+        }
+        return;
+    }
+    // Keep the adjusted striped file read ahead multiple of the stride, the
+    // same way as SetReadAheadSize() does.
+    const FileAttr& theAttr  = inEntry.fattr;
+    const int       theAlign = (
+            theAttr.striperType != KFS_STRIPED_FILE_TYPE_NONE &&
+            theAttr.stripeSize > 0 &&
+            theAttr.numStripes > 0) ?
+        theAttr.stripeSize * theAttr.numStripes : (int)CHECKSUM_BLOCKSIZE;
+    if (inPos != inEntry.readAheadNextPos) {
+        // Random access: fall back to the configured size, then halve the
+        // read ahead on every subsequent non sequential read, in order not
+        // to read and discard the data that is never used.
+        inEntry.readAheadSeqCount = 0;
+        const int theSize = theCur > theBase ? theBase :
+            theCur / 2 / theAlign * theAlign;
+        SetReadAheadWindow(inEntry, theSize);
+    } else if (inEntry.readAheadSeqCount++ > 0 && theBase > 0 &&
+            inEntry.readAheadGrowPos <= inPos) {
+        // Grow at most once per read ahead buffer consumed.
+        if (theCur < theBase) {
+            SetReadAheadWindow(inEntry, theBase);
+        } else if ((size_t)theCur < mMaxReadAheadSize) {
+            // Double the read ahead, and do not exceed the budget.
+            const int64_t theAvail = (int64_t)mReadAheadMemoryBudget -
+                (int64_t)mReadAheadAdaptiveBytes + (theCur - theBase);
+            const int64_t theMax   = min(
+                (int64_t)mMaxReadAheadSize, theBase + max(int64_t(0), theAvail)
+            );
+            const int     theSize  = (int)(
+                min(theMax, int64_t(theCur) * 2) / theAlign * theAlign);
+            if (theCur < theSize) {
+                SetReadAheadWindow(inEntry, theSize);
+            }
+        }
+        inEntry.readAheadGrowPos = inPos + inEntry.buffer.GetBufSize();
+    }
+    inEntry.readAheadNextPos = inPos + inSize;
+}
+
 ssize_t
 KfsClientImpl::GetReadAheadSize(
     int inFd) const
@@ -46,6 +46,7 @@
 #include "utils.h"
 #include "KfsClient.h"
 #include "RSStriper.h"
+#include "ReplicaSelector.h"
 
 namespace KFS
 {
@@ -83,18 +84,19 @@ public:
     };
 
     Impl(
-        Reader&     inOuter,
-        MetaServer& inMetaServer,
-        Completion* inCompletionPtr,
-        int         inMaxRetryCount,
-        int         inTimeSecBetweenRetries,
-        int         inOpTimeoutSec,
-        int         inIdleTimeoutSec,
-        int         inMaxReadSize,
-        int         inLeaseRetryTimeout,
-        int         inLeaseWaitTimeout,
-        string      inLogPrefix,
-        int64_t     inChunkServerInitialSeqNum)
+        Reader&          inOuter,
+        MetaServer&      inMetaServer,
+        Completion*      inCompletionPtr,
+        int              inMaxRetryCount,
+        int              inTimeSecBetweenRetries,
+        int              inOpTimeoutSec,
+        int              inIdleTimeoutSec,
+        int              inMaxReadSize,
+        int              inLeaseRetryTimeout,
+        int              inLeaseWaitTimeout,
+        string           inLogPrefix,
+        int64_t          inChunkServerInitialSeqNum,
+        ReplicaSelector* inReplicaSelectorPtr)
         : QCRefCountedObj(),
           mOuter(inOuter),
           mMetaServer(inMetaServer),
@@ -116,6 +118,7 @@ public:
           mOpenChunkBlockSize(0),
           mChunkServerInitialSeqNum(inChunkServerInitialSeqNum),
           mCompletionPtr(inCompletionPtr),
+          mReplicaSelectorPtr(inReplicaSelectorPtr),
           mLogPrefix(inLogPrefix),
           mStats(),
           mChunkServersStats(),
@@ -321,6 +324,7 @@ private:
             typedef vector<RequestEntry> Requests;
 
             time_t    mOpStartTime;
+            int64_t   mStartUsec;
             IOBuffer  mBuffer;
             IOBuffer  mTmpBuffer;
             RequestId mRequestId;
@@ -329,6 +333,7 @@ private:
             bool      mRetryIfFailsFlag;
             bool      mFailShortReadFlag;
             bool      mCancelFlag;
+            bool      mHedgedFlag;
 
             ReadOp(
                 int       inOpSize,
@@ -339,6 +344,7 @@ private:
                 bool      inFailShortReadFlag)
                 : KFS::client::ReadOp(-1, -1, -1),
                   mOpStartTime(0),
+                  mStartUsec(0),
                   mBuffer(),
                   mTmpBuffer(),
                   mRequestId(inRequestId),
@@ -346,7 +352,8 @@ private:
                   mRequests(),
                   mRetryIfFailsFlag(inRetryIfFailsFlag),
                   mFailShortReadFlag(inFailShortReadFlag),
-                  mCancelFlag(false)
+                  mCancelFlag(false),
+                  mHedgedFlag(false)
             {
                 Queue::Init(*this);
                 numBytes = inOpSize;
@@ -399,6 +406,21 @@ private:
                     int64_t(std::numeric_limits<int>::max())
                 ))
               ),
+              mHedgeServer(
+                inOuter.mNetManager,
+                string(), -1,
+                0, // inMaxRetryCount
+                0, // inTimeSecBetweenRetries,
+                inOuter.mOpTimeoutSec,
+                inOuter.mIdleTimeoutSec,
+                inSeqNum,
+                inLogPrefix.c_str(),
+                false, // inResetConnectionOnOpTimeoutFlag
+                int(min(
+                    int64_t(inOuter.mMaxReadSize) + (64 << 10),
+                    int64_t(std::numeric_limits<int>::max())
+                ))
+              ),
               mErrorCode(0),
               mRetryCount(0),
               mOpenChunkBlockFileOffset(-1),
@@ -410,12 +432,16 @@ private:
               mSizeOp(0, -1, 0),
               mLastOpPtr(0),
               mLastMetaOpPtr(0),
+              mHedgedOpPtr(0),
+              mHedgeWonOpPtr(0),
+              mHedgeLocation(),
               mChunkServerIdx(0),
               mLeaseRenewTime(Now() - 1),
               mLeaseExpireTime(mLeaseRenewTime),
               mLeaseWaitStartTime(0),
               mLeaseRetryCount(0),
               mSleepingFlag(false),
+              mHedgeTimerFlag(false),
               mClosingFlag(false),
               mChunkServerSetFlag(false),
               mStartReadRunningFlag(false),
@@ -428,9 +454,11 @@ private:
             Queue::Init(mPendingQueue);
             Queue::Init(mInFlightQueue);
             Queue::Init(mCompletionQueue);
+            Queue::Init(mHedgeQueue);
             Readers::Init(*this);
             Readers::PushFront(mOuter.mReaders, *this);
             mChunkServer.SetRetryConnectOnly(true);
+            mHedgeServer.SetRetryConnectOnly(true);
             mGetAllocOp.fileOffset  = -1;
             mGetAllocOp.chunkId     = -1;
             mLeaseAcquireOp.chunkId = -1;
@@ -444,6 +472,8 @@ private:
             ChunkServer::Stats theStats;
             mChunkServer.GetStats(theStats);
             mOuter.mChunkServersStats.Add(theStats);
+            mHedgeServer.GetStats(theStats);
+            mOuter.mChunkServersStats.Add(theStats);
             Readers::Remove(mOuter.mReaders, *this);
             if (mDeletedFlagPtr) {
                 *mDeletedFlagPtr = true;
@@ -738,6 +768,7 @@ private:
 
         Impl&                mOuter;
         ChunkServer          mChunkServer;
+        ChunkServer          mHedgeServer;
         int                  mErrorCode;
         int                  mRetryCount;
         Offset               mOpenChunkBlockFileOffset;
@@ -749,12 +780,16 @@ private:
         SizeOp               mSizeOp;
         KfsOp*               mLastOpPtr;
         KfsOp*               mLastMetaOpPtr;
+        ReadOp*              mHedgedOpPtr;
+        ReadOp*              mHedgeWonOpPtr;
+        ServerLocation       mHedgeLocation;
         size_t               mChunkServerIdx;
         time_t               mLeaseRenewTime;
         time_t               mLeaseExpireTime;
         time_t               mLeaseWaitStartTime;
         int                  mLeaseRetryCount;
         bool                 mSleepingFlag;
+        bool                 mHedgeTimerFlag;
         bool                 mClosingFlag;
         bool                 mChunkServerSetFlag;
         bool                 mStartReadRunningFlag;
@@ -766,6 +801,7 @@ private:
         ReadOp*              mPendingQueue[1];
         ReadOp*              mInFlightQueue[1];
         ReadOp*              mCompletionQueue[1];
+        ReadOp*              mHedgeQueue[1];
         ChunkReader*         mPrevPtr[1];
         ChunkReader*         mNextPtr[1];
 
@@ -932,6 +968,10 @@ private:
                     mGetAllocOp.chunkServers.begin(),
                     mGetAllocOp.chunkServers.end()
                 );
+                if (mOuter.mReplicaSelectorPtr) {
+                    mOuter.mReplicaSelectorPtr->Order(
+                        mGetAllocOp.chunkServers);
+                }
             }
             mChunkServerIdx = 0;
             StartRead();
@@ -1044,6 +1084,11 @@ private:
                 return;
             }
             mOuter.mStats.mOpsReadCount++;
+            if (mOuter.mReplicaSelectorPtr) {
+                inReadOp.mStartUsec = microseconds();
+                mOuter.mReplicaSelectorPtr->ReadStart(GetCurServer());
+                StartHedgeTimer();
+            }
             Enqueue(inReadOp, &inReadOp.mTmpBuffer);
         }
         void Done(
@@ -1055,6 +1100,26 @@ private:
                 inBufferPtr == &inOp.mTmpBuffer &&
                 Queue::IsInList(mInFlightQueue, inOp)
             );
+            const bool theHedgeLostFlag =
+                inCanceledFlag && &inOp == mHedgeWonOpPtr;
+            if (&inOp == mHedgedOpPtr) {
+                CancelHedge();
+            }
+            if (inOp.mStartUsec > 0) {
+                // Canceled read has no latency sample, unless it lost the race
+                // with the hedged read.
+                mOuter.mReplicaSelectorPtr->ReadDone(
+                    GetCurServer(),
+                    (inCanceledFlag && ! theHedgeLostFlag) ? int64_t(-1) :
+                        microseconds() - inOp.mStartUsec,
+                    inCanceledFlag ? theHedgeLostFlag : inOp.status < 0
+                );
+                inOp.mStartUsec = 0;
+            }
+            if (theHedgeLostFlag) {
+                // HedgeDone() completes the op with the hedged read result.
+                return;
+            }
             if (inOp.status == kErrorNoEntry &&
                     mGetAllocOp.status != kErrorNoEntry) {
                 inOp.status = kErrorIO;
@@ -1339,6 +1404,9 @@ private:
                 Done(mLeaseRelinquishOp, inCanceledFlag, inBufferPtr);
             } else if (&mSizeOp == inOpPtr) {
                 Done(mSizeOp, inCanceledFlag, inBufferPtr);
+            } else if (inOpPtr == Queue::Front(mHedgeQueue)) {
+                HedgeDone(*static_cast<ReadOp*>(inOpPtr),
+                    inCanceledFlag, inBufferPtr);
             } else if (inOpPtr->op == CMD_READ) {
                 Done(*static_cast<ReadOp*>(inOpPtr),
                     inCanceledFlag, inBufferPtr);
@@ -1361,6 +1429,9 @@ private:
             mChunkServer.Stop();
             mChunkServerSetFlag = false;
             QCASSERT(Queue::IsEmpty(mInFlightQueue));
+            mHedgeServer.Stop();
+            QCASSERT(Queue::IsEmpty(mHedgeQueue));
+            StopHedgeTimer();
             if (mSleepingFlag) {
                 mOuter.mNetManager.UnRegisterTimeoutHandler(this);
                 mSleepingFlag = false;
@@ -1567,6 +1638,7 @@ private:
                 (mRestartStartReadFlag ? "resetting restart flag" : "") <<
             KFS_LOG_EOM;
             mRestartStartReadFlag = false;
+            StopHedgeTimer();
             mSleepingFlag = true;
             mOuter.mStats.mSleepTimeSec += inSec;
             const bool kResetTimerFlag = true;
@@ -1574,8 +1646,173 @@ private:
             mOuter.mNetManager.RegisterTimeoutHandler(this);
             return true;
         }
+        const ServerLocation& GetCurServer() const
+        {
+            QCASSERT(mChunkServerIdx < mGetAllocOp.chunkServers.size());
+            return mGetAllocOp.chunkServers[mChunkServerIdx];
+        }
+        void StartHedgeTimer()
+        {
+            if (mHedgeTimerFlag || mSleepingFlag ||
+                    mChunkServerIdx + 1 >= mGetAllocOp.chunkServers.size()) {
+                return;
+            }
+            mHedgeTimerFlag = true;
+            const int  kHedgeCheckIntervalMs = 100;
+            const bool kResetTimerFlag       = true;
+            SetTimeoutInterval(kHedgeCheckIntervalMs, kResetTimerFlag);
+            mOuter.mNetManager.RegisterTimeoutHandler(this);
+        }
+        void StopHedgeTimer()
+        {
+            if (! mHedgeTimerFlag) {
+                return;
+            }
+            mHedgeTimerFlag = false;
+            mOuter.mNetManager.UnRegisterTimeoutHandler(this);
+        }
+        void HedgeRead()
+        {
+            // When the oldest read in flight exceeds the hedge delay, issue
+            // the same read to the next replica over the separate connection,
+            // and keep the original read in flight. The first response that
+            // passes verification wins, and the other read is canceled.
+            // Only one hedged read is in flight at a time, and a read is
+            // hedged at most once.
+            ReadOp* const theOpPtr = Queue::Front(mInFlightQueue);
+            if (! theOpPtr ||
+                    mChunkServerIdx + 1 >= mGetAllocOp.chunkServers.size()) {
+                StopHedgeTimer();
+                return;
+            }
+            if (theOpPtr->mHedgedFlag || theOpPtr->mStartUsec <= 0 ||
+                    ! Queue::IsEmpty(mHedgeQueue)) {
+                return;
+            }
+            const int64_t theDelay =
+                mOuter.mReplicaSelectorPtr->GetHedgeDelayUsec(GetCurServer());
+            if (theDelay < 0) {
+                StopHedgeTimer();
+                return;
+            }
+            const int64_t theElapsed = microseconds() - theOpPtr->mStartUsec;
+            if (theElapsed < theDelay) {
+                return;
+            }
+            const ServerLocation& theServer =
+                mGetAllocOp.chunkServers[mChunkServerIdx + 1];
+            KFS_LOG_STREAM_INFO << mLogPrefix <<
+                "hedged read:"
+                " chunk: "   << mGetAllocOp.chunkId <<
+                " pos: "     << theOpPtr->offset <<
+                " server: "  << mChunkServer.GetServerLocation() <<
+                " elapsed: " << theElapsed << " usec." <<
+                " delay: "   << theDelay << " usec." <<
+                " hedge: "   << theServer <<
+            KFS_LOG_EOM;
+            theOpPtr->mHedgedFlag = true;
+            ReadOp& theHedgeOp = *(new ReadOp(
+                (int)theOpPtr->numBytes,
+                theOpPtr->offset,
+                theOpPtr->mRequestId,
+                theOpPtr->mStriperRequestId,
+                theOpPtr->mRetryIfFailsFlag,
+                theOpPtr->mFailShortReadFlag
+            ));
+            theHedgeOp.chunkId      = theOpPtr->chunkId;
+            theHedgeOp.chunkVersion = theOpPtr->chunkVersion;
+            theHedgeOp.mOpStartTime = Now();
+            theHedgeOp.mStartUsec   = microseconds();
+            theHedgeOp.mHedgedFlag  = true;
+            Queue::PushBack(mHedgeQueue, theHedgeOp);
+            mHedgedOpPtr = theOpPtr;
+            mOuter.mStats.mHedgedReadCount++;
+            mOuter.mStats.mOpsReadCount++;
+            mOuter.mStats.mChunkOpsQueuedCount++;
+            mOuter.mReplicaSelectorPtr->Hedged();
+            mOuter.mReplicaSelectorPtr->ReadStart(theServer);
+            mHedgeLocation = theServer;
+            mHedgeServer.SetServer(mHedgeLocation);
+            if (! mHedgeServer.Enqueue(
+                    &theHedgeOp, this, &theHedgeOp.mTmpBuffer)) {
+                theHedgeOp.status = kErrorFault;
+                HedgeDone(theHedgeOp, false, &theHedgeOp.mTmpBuffer);
+            }
+        }
+        void CancelHedge()
+        {
+            ReadOp* const theOpPtr = Queue::Front(mHedgeQueue);
+            if (! theOpPtr) {
+                return;
+            }
+            if (! mHedgeServer.Cancel(theOpPtr, this)) {
+                mOuter.InternalError("failed to cancel hedged read");
+            }
+            if (theOpPtr == Queue::Front(mHedgeQueue)) {
+                // Not in the chunk server queue, delete it here.
+                HedgeDone(*theOpPtr, true, &theOpPtr->mTmpBuffer);
+            }
+        }
+        void HedgeDone(
+            ReadOp&   inOp,
+            bool      inCanceledFlag,
+            IOBuffer* inBufferPtr)
+        {
+            QCASSERT(
+                inBufferPtr == &inOp.mTmpBuffer &&
+                &inOp == Queue::Front(mHedgeQueue) &&
+                mHedgedOpPtr &&
+                Queue::IsInList(mInFlightQueue, *mHedgedOpPtr)
+            );
+            ReadOp& theOp = *mHedgedOpPtr;
+            mHedgedOpPtr = 0;
+            mOuter.mReplicaSelectorPtr->ReadDone(
+                mHedgeLocation,
+                inCanceledFlag ? int64_t(-1) :
+                    microseconds() - inOp.mStartUsec,
+                ! inCanceledFlag && inOp.status < 0
+            );
+            if (inCanceledFlag || inOp.status < 0 || ! VerifyChecksum(inOp) ||
+                    ! VerifyRead(inOp)) {
+                if (! inCanceledFlag) {
+                    KFS_LOG_STREAM_INFO << mLogPrefix <<
+                        "hedged read failure:"
+                        " chunk: "  << inOp.chunkId <<
+                        " pos: "    << inOp.offset <<
+                        " server: " << mHedgeLocation <<
+                        " status: " << inOp.status <<
+                        " msg: "    << inOp.statusMsg <<
+                    KFS_LOG_EOM;
+                }
+                // The original read remains in flight.
+                inOp.Delete(mHedgeQueue);
+                return;
+            }
+            // The hedged read won. Move its result into the original op's
+            // buffers, cancel the original read, and complete the original op.
+            theOp.status        = inOp.status;
+            theOp.statusMsg     = inOp.statusMsg;
+            theOp.contentLength = inOp.contentLength;
+            theOp.checksums.swap(inOp.checksums);
+            IOBuffer theData;
+            theData.Move(&inOp.mTmpBuffer);
+            inOp.Delete(mHedgeQueue);
+            mHedgeWonOpPtr = &theOp;
+            mChunkServer.Cancel(&theOp, this);
+            mHedgeWonOpPtr = 0;
+            theOp.mTmpBuffer.Clear();
+            theData.UseSpaceAvailable(&theOp.mBuffer, theData.BytesConsumable());
+            theOp.mTmpBuffer.Move(&theData);
+            mOuter.mStats.mHedgedReadWinCount++;
+            mOuter.mReplicaSelectorPtr->HedgeWon();
+            Done(theOp, false, &theOp.mTmpBuffer);
+        }
         virtual void Timeout()
         {
+            if (mHedgeTimerFlag && ! mSleepingFlag) {
+                HedgeRead();
+                return;
+            }
             KFS_LOG_STREAM_DEBUG << mLogPrefix << "timeout" <<
             KFS_LOG_EOM;
             if (mSleepingFlag) {
@@ -1795,6 +2032,7 @@ private:
     Offset              mOpenChunkBlockSize;
     int64_t             mChunkServerInitialSeqNum;
     Completion*         mCompletionPtr;
+    ReplicaSelector*    mReplicaSelectorPtr;
     string const        mLogPrefix;
     Stats               mStats;
     KfsNetClient::Stats mChunkServersStats;
@@ -2247,7 +2485,8 @@ Reader::Reader(
     int                 inLeaseRetryTimeout        /* = 3 */,
     int                 inLeaseWaitTimeout         /* = 900 */,
     const char*         inLogPrefixPtr             /* = 0 */,
-    int64_t             inChunkServerInitialSeqNum /* = 1 */)
+    int64_t             inChunkServerInitialSeqNum /* = 1 */,
+    ReplicaSelector*    inReplicaSelectorPtr       /* = 0 */)
     : mImpl(*new Reader::Impl(
         *this,
         inMetaServer,
@@ -2261,7 +2500,8 @@ Reader::Reader(
         inLeaseWaitTimeout,
         (inLogPrefixPtr && inLogPrefixPtr[0]) ?
             (inLogPrefixPtr + string(" ")) : string(),
-        inChunkServerInitialSeqNum
+        inChunkServerInitialSeqNum,
+        inReplicaSelectorPtr
     ))
 {
     mImpl.Ref();
@@ -38,6 +38,7 @@ class IOBuffer;
 
 namespace client
 {
+class ReplicaSelector;
 
 using std::string;
 using std::ostream;
@@ -89,7 +90,9 @@ public:
               mOpsReadCount(0),
               mRetriesCount(0),
               mReadCount(0),
-              mReadByteCount(0)
+              mReadByteCount(0),
+              mHedgedReadCount(0),
+              mHedgedReadWinCount(0)
             {}
         void Clear()
             { *this = Stats(); }
@@ -106,6 +109,8 @@ public:
             mRetriesCount          += inStats.mRetriesCount;
             mReadCount             += inStats.mReadCount;
             mReadByteCount         += inStats.mReadByteCount;
+            mHedgedReadCount       += inStats.mHedgedReadCount;
+            mHedgedReadWinCount    += inStats.mHedgedReadWinCount;
             return *this;
         }
         ostream& Display(
@@ -135,7 +140,11 @@ public:
                 "ReadCount"                << theDelimiterPtr <<
                     mReadCount             << theSeparatorPtr <<
                 "ReadByteCount"            << theDelimiterPtr <<
-                    mReadByteCount
+                    mReadByteCount         << theSeparatorPtr <<
+                "HedgedReadCount"          << theDelimiterPtr <<
+                    mHedgedReadCount       << theSeparatorPtr <<
+                "HedgedReadWinCount"       << theDelimiterPtr <<
+                    mHedgedReadWinCount
             ;
             return inStream;
         }
@@ -149,6 +158,8 @@ public:
         Counter mRetriesCount;
         Counter mReadCount;
         Counter mReadByteCount;
+        Counter mHedgedReadCount;
+        Counter mHedgedReadWinCount;
     };
     class Striper
     {
@@ -232,17 +243,18 @@ public:
     };
     typedef KfsNetClient MetaServer;
     Reader(
-        MetaServer& inMetaServer,
-        Completion* inCompletionPtr            = 0,
-        int         inMaxRetryCount            = 6,
-        int         inTimeSecBetweenRetries    = 15,
-        int         inOpTimeoutSec             = 30,
-        int         inIdleTimeoutSec           = 5 * 30,
-        int         inMaxReadSize              = 1 << 20,
-        int         inLeaseRetryTimeout        = 3,
-        int         inLeaseWaitTimeout         = 900,
-        const char* inLogPrefixPtr             = 0,
-        int64_t     inChunkServerInitialSeqNum = 1);
+        MetaServer&      inMetaServer,
+        Completion*      inCompletionPtr            = 0,
+        int              inMaxRetryCount            = 6,
+        int              inTimeSecBetweenRetries    = 15,
+        int              inOpTimeoutSec             = 30,
+        int              inIdleTimeoutSec           = 5 * 30,
+        int              inMaxReadSize              = 1 << 20,
+        int              inLeaseRetryTimeout        = 3,
+        int              inLeaseWaitTimeout         = 900,
+        const char*      inLogPrefixPtr             = 0,
+        int64_t          inChunkServerInitialSeqNum = 1,
+        ReplicaSelector* inReplicaSelectorPtr       = 0);
     virtual ~Reader();
     int Open(
         kfsFileId_t inFileId,
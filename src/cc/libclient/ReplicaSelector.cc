@@ -0,0 +1,189 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file ReplicaSelector.cc
+// \brief Chunk server read latency tracker.
+//
+//----------------------------------------------------------------------------
+
+#include "ReplicaSelector.h"
+
+#include "qcdio/qcstutils.h"
+
+#include <algorithm>
+
+namespace KFS
+{
+namespace client
+{
+
+using std::max;
+using std::stable_sort;
+
+class ReplicaSelector::CostCmp
+{
+public:
+    typedef pair<int64_t, size_t> Cost;
+    bool operator()(
+        const Cost& inLhs,
+        const Cost& inRhs) const
+        { return (inLhs.first < inRhs.first); }
+};
+
+ReplicaSelector::ReplicaSelector(
+    int inHedgeMinDelayMs,
+    int inHedgeLatencyMultiplier)
+    : mEntries(),
+      mHedgeMinDelayMs(inHedgeMinDelayMs),
+      mHedgeLatencyMultiplier(inHedgeLatencyMultiplier),
+      mStats(),
+      mMutex()
+{
+}
+
+ReplicaSelector::~ReplicaSelector()
+{
+}
+
+int64_t
+ReplicaSelector::GetCost(
+    const ServerLocation& inServer) const
+{
+    Entries::const_iterator const theIt = mEntries.find(MakeKey(inServer));
+    if (theIt == mEntries.end()) {
+        return 0;
+    }
+    const Entry& theEntry = theIt->second;
+    // The servers with no samples always go first, the reads in flight
+    // are accounted to spread the load while the first sample is pending.
+    return ((max(int64_t(0), theEntry.mAvgLatencyUsec) + 1) *
+        (theEntry.mInFlightCount + 1));
+}
+
+void
+ReplicaSelector::Order(
+    vector<ServerLocation>& ioServers) const
+{
+    if (ioServers.size() <= 1) {
+        return;
+    }
+    vector<CostCmp::Cost> theCosts;
+    theCosts.reserve(ioServers.size());
+    for (size_t i = 0; i < ioServers.size(); i++) {
+        theCosts.push_back(CostCmp::Cost(GetCost(ioServers[i]), i));
+    }
+    stable_sort(theCosts.begin(), theCosts.end(), CostCmp());
+    vector<ServerLocation> theServers;
+    theServers.reserve(ioServers.size());
+    for (size_t i = 0; i < theCosts.size(); i++) {
+        theServers.push_back(ioServers[theCosts[i].second]);
+    }
+    ioServers.swap(theServers);
+}
+
+void
+ReplicaSelector::ReadStart(
+    const ServerLocation& inServer)
+{
+    mEntries[MakeKey(inServer)].mInFlightCount++;
+}
+
+void
+ReplicaSelector::ReadDone(
+    const ServerLocation& inServer,
+    int64_t               inElapsedUsec,
+    bool                  inFailedFlag)
+{
+    Entries::iterator const theIt = mEntries.find(MakeKey(inServer));
+    if (theIt == mEntries.end()) {
+        return;
+    }
+    Entry& theEntry = theIt->second;
+    if (theEntry.mInFlightCount > 0) {
+        theEntry.mInFlightCount--;
+    }
+    if (inElapsedUsec < 0 && ! inFailedFlag) {
+        return;
+    }
+    int64_t theSample = max(int64_t(0), inElapsedUsec);
+    if (inFailedFlag) {
+        theSample = max(theSample, 2 * theEntry.mAvgLatencyUsec);
+    }
+    if (theEntry.mAvgLatencyUsec < 0) {
+        theEntry.mAvgLatencyUsec = theSample;
+    } else {
+        // Same weight as tcp smoothed round trip time estimator: 1/8.
+        theEntry.mAvgLatencyUsec +=
+            (theSample - theEntry.mAvgLatencyUsec) / 8;
+    }
+}
+
+int64_t
+ReplicaSelector::GetHedgeDelayUsec(
+    const ServerLocation& inServer) const
+{
+    const int theMinDelayMs = mHedgeMinDelayMs;
+    if (theMinDelayMs <= 0) {
+        return -1;
+    }
+    const int     theMultiplier   = mHedgeLatencyMultiplier;
+    const int64_t theMinDelayUsec = int64_t(theMinDelayMs) * 1000;
+    Entries::const_iterator const theIt = mEntries.find(MakeKey(inServer));
+    if (theIt == mEntries.end() || theIt->second.mAvgLatencyUsec < 0) {
+        return theMinDelayUsec;
+    }
+    return max(theMinDelayUsec,
+        theIt->second.mAvgLatencyUsec * max(1, theMultiplier));
+}
+
+void
+ReplicaSelector::Hedged()
+{
+    QCStMutexLocker theLock(mMutex);
+    mStats.mHedgedReadCount++;
+}
+
+void
+ReplicaSelector::HedgeWon()
+{
+    QCStMutexLocker theLock(mMutex);
+    mStats.mHedgedReadWinCount++;
+}
+
+void
+ReplicaSelector::SetHedgeParameters(
+    int inHedgeMinDelayMs,
+    int inHedgeLatencyMultiplier)
+{
+    QCStMutexLocker theLock(mMutex);
+    mHedgeMinDelayMs        = inHedgeMinDelayMs;
+    mHedgeLatencyMultiplier = inHedgeLatencyMultiplier;
+}
+
+void
+ReplicaSelector::GetStats(
+    Stats& outStats) const
+{
+    QCStMutexLocker theLock(mMutex);
+    outStats = mStats;
+}
+
+}} /* namespace client KFS */
@@ -0,0 +1,135 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file ReplicaSelector.h
+// \brief Chunk server read latency tracker used by the readers to pick the
+// chunk replica to read from, and to decide when to hedge a slow read.
+//
+//----------------------------------------------------------------------------
+
+#ifndef REPLICA_SELECTOR_H
+#define REPLICA_SELECTOR_H
+
+#include "common/kfsdecls.h"
+#include "qcdio/QCMutex.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+
+namespace KFS
+{
+namespace client
+{
+
+using std::string;
+using std::vector;
+using std::map;
+using std::pair;
+
+// Per chunk server exponentially weighted moving average read latency, and the
+// number of reads in flight. A single instance is shared by all readers of the
+// protocol worker, i.e. by all files opened by the client.
+// All methods, except the ones that explicitly state otherwise, must be
+// invoked from the protocol worker thread.
+class ReplicaSelector
+{
+public:
+    typedef int64_t Counter;
+    struct Stats
+    {
+        Stats()
+            : mHedgedReadCount(0),
+              mHedgedReadWinCount(0)
+            {}
+        Counter mHedgedReadCount;
+        Counter mHedgedReadWinCount;
+    };
+
+    ReplicaSelector(
+        int inHedgeMinDelayMs        = 2000,
+        int inHedgeLatencyMultiplier = 4);
+    ~ReplicaSelector();
+    // Order replicas by the expected read latency. Servers with no latency
+    // samples yet are preferred in order to get samples. The sort is stable in
+    // order to preserve the prior randomized order of the equivalent replicas.
+    void Order(
+        vector<ServerLocation>& ioServers) const;
+    void ReadStart(
+        const ServerLocation& inServer);
+    // Failure, including read timeout, is accounted as at least twice the
+    // current average latency. Negative elapsed time with no failure means
+    // that the read was canceled, and only the in flight count is updated.
+    void ReadDone(
+        const ServerLocation& inServer,
+        int64_t               inElapsedUsec,
+        bool                  inFailedFlag);
+    // Returns time in microseconds after which the read from the specified
+    // server should be hedged, or -1 if hedging is disabled.
+    int64_t GetHedgeDelayUsec(
+        const ServerLocation& inServer) const;
+    void Hedged();
+    void HedgeWon();
+    // Thread safe.
+    void SetHedgeParameters(
+        int inHedgeMinDelayMs,
+        int inHedgeLatencyMultiplier);
+    // Thread safe.
+    void GetStats(
+        Stats& outStats) const;
+private:
+    struct Entry
+    {
+        Entry()
+            : mAvgLatencyUsec(-1),
+              mInFlightCount(0)
+            {}
+        int64_t mAvgLatencyUsec;
+        int     mInFlightCount;
+    };
+    typedef pair<string, int> Key;
+    typedef map<Key, Entry>   Entries;
+    class CostCmp;
+    friend class CostCmp;
+
+    Entries         mEntries;
+    volatile int    mHedgeMinDelayMs;
+    volatile int    mHedgeLatencyMultiplier;
+    Stats           mStats;
+    mutable QCMutex mMutex;
+
+    static Key MakeKey(
+        const ServerLocation& inServer)
+        { return Key(inServer.hostname, inServer.port); }
+    int64_t GetCost(
+        const ServerLocation& inServer) const;
+private:
+    ReplicaSelector(
+        const ReplicaSelector& inSelector);
+    ReplicaSelector& operator=(
+        const ReplicaSelector& inSelector);
+};
+
+}}
+
+#endif /* REPLICA_SELECTOR_H */
@@ -141,7 +141,9 @@ public:
           mLastAppendActivityTime(0),
           mClientPoolPtr(inClientPoolPtr),
           mChunkServerPtr(0),
-          mNetManager(mMetaServer.GetNetManager())
+          mNetManager(mMetaServer.GetNetManager()),
+          mSprayerPtr(0),
+          mAllocationWaitFlag(false)
     {
         Impl::Reset();
         mChunkServer.SetRetryConnectOnly(true);
@@ -382,11 +384,28 @@ public:
     }
     bool GetPreAllocation() const
         {  return mPreAllocationFlag; }
-    bool GetErrorCode() const
+    int GetErrorCode() const
         { return mErrorCode; }
     void SetForcedAllocationInterval(
         int inInterval)
         { mForcedAllocationInterval = inInterval; }
+    void SetSprayer(
+        Sprayer* inSprayerPtr)
+        { mSprayerPtr = inSprayerPtr; }
+    kfsFileId_t GetFileId() const
+        { return mLookupOp.fattr.fileId; }
+    bool IsAllocating() const
+        { return (&mAllocOp == mCurOpPtr); }
+    void AllocationGranted()
+    {
+        if (! mAllocationWaitFlag) {
+            return;
+        }
+        mAllocationWaitFlag = false;
+        if (! mCurOpPtr && mOpenFlag) {
+            StartAppend();
+        }
+    }
 
 protected:
     virtual void OpDone(
@@ -510,6 +529,8 @@ private:
     ClientPool*             mClientPoolPtr;
     ChunkServer*            mChunkServerPtr;
     NetManager&             mNetManager;
+    Sprayer*                mSprayerPtr;
+    bool                    mAllocationWaitFlag;
 
     template<typename T> bool Dispatch(
         T&        inObj,
@@ -560,10 +581,11 @@ private:
     }
     void StartAppend()
     {
-        if (mSleepingFlag || mErrorCode) {
+        if (mSleepingFlag || mErrorCode || ! mOpenFlag) {
             return;
         }
-        mCurOpPtr = 0;
+        mCurOpPtr           = 0;
+        mAllocationWaitFlag = false;
         if (mClosingFlag && mWriteQueue.empty()) {
             if (! WasChunkServerDisconnected()) {
                 if (mAllocOp.chunkId > 0 && mSpaceAvailable > 0) {
@@ -810,10 +832,21 @@ private:
     void AllocateChunk()
     {
         assert(mLookupOp.fattr.fileId > 0);
+        if (mSprayerPtr && ! StartAllocation()) {
+            // Wait for the other chain's allocation to finish.
+            mAllocationWaitFlag = true;
+            return;
+        }
         Reset(mAllocOp);
         mSpaceAvailable = 0;
         chunkOff_t theOffset;
-        if (mSpaceReserveOp.status == -ENOSPC) {
+        if (mSprayerPtr) {
+            // Each chain appends to a chunk of its own, allocated past eof.
+            // The meta server append cache chunk shared by other clients is
+            // left alone.
+            theOffset = -1;
+            mSpaceReserveOp.status = 0;
+        } else if (mSpaceReserveOp.status == -ENOSPC) {
             theOffset = (mAllocOp.fileOffset + KFS::CHUNKSIZE) /
                 KFS::CHUNKSIZE * KFS::CHUNKSIZE;
             mSpaceReserveOp.status = 0;
@@ -822,6 +855,7 @@ private:
         }
         mAllocOp = AllocateOp(0, mLookupOp.fattr.fileId, mPathName);
         mAllocOp.append               = true;
+        mAllocOp.appendNewChunkFlag   = mSprayerPtr != 0;
         mAllocOp.chunkId              = 0;
         mAllocOp.fileOffset           = theOffset;
         mAllocOp.spaceReservationSize = max(
@@ -841,9 +875,12 @@ private:
         if (inOp.status != 0 || mAllocOp.chunkServers.empty()) {
             mAllocOp.chunkId = 0;
             HandleError();
-            return;
+        } else {
+            AllocateWriteId();
+        }
+        if (mSprayerPtr) {
+            AllocationDone();
         }
-        AllocateWriteId();
     }
     void CloseChunk()
     {
@@ -1438,6 +1475,8 @@ private:
         }
         FatalError();
     }
+    bool StartAllocation();
+    void AllocationDone();
     void FatalError(
         int inErrorCode = 0)
     {
@@ -1530,6 +1569,486 @@ private:
         const Impl& inAppender);
 };
 
+// Multi chunk append. The first chain is the outer appender's "primary"
+// state machine, it does file lookup or create, and the remaining chains are
+// opened by file id once the first one is open. Each record is sent to the
+// open chain with the least bytes pending, this effectively throttles the
+// chains with slow chunk servers, or the ones waiting for chunk allocation.
+class WriteAppender::Sprayer : public WriteAppender::Completion
+{
+public:
+    Sprayer(
+        WriteAppender& inOuter,
+        Impl&          inFirst,
+        MetaServer&    inMetaServer,
+        Completion*    inCompletionPtr,
+        int            inMaxRetryCount,
+        int            inWriteThreshold,
+        int            inTimeSecBetweenRetries,
+        int            inDefaultSpaceReservationSize,
+        int            inPreferredAppendSize,
+        int            inMaxPartialBuffersCount,
+        int            inOpTimeoutSec,
+        int            inIdleTimeoutSec,
+        bool           inPreAllocationFlag,
+        string         inLogPrefix,
+        int64_t        inChunkServerInitialSeqNum,
+        ClientPool*    inClientPoolPtr,
+        int            inMaxChunksCount)
+        : Completion(),
+          mOuter(inOuter),
+          mChains(),
+          mRecords(),
+          mCompletionPtr(inCompletionPtr),
+          mPathName(),
+          mLogPrefix(inLogPrefix),
+          mErrorCode(0),
+          mPending(0),
+          mNextChain(0),
+          mOpenChainsFlag(false),
+          mAllocatingPtr(0)
+    {
+        mChains.reserve(inMaxChunksCount);
+        mChains.push_back(Chain(inFirst));
+        for (int i = 1; i < inMaxChunksCount; i++) {
+            ostringstream theStream;
+            theStream << inLogPrefix << "c" << i << " ";
+            mChains.push_back(Chain(*new Impl(
+                inOuter,
+                inMetaServer,
+                this,
+                inMaxRetryCount,
+                inWriteThreshold,
+                inTimeSecBetweenRetries,
+                inDefaultSpaceReservationSize,
+                inPreferredAppendSize,
+                inMaxPartialBuffersCount,
+                inOpTimeoutSec,
+                inIdleTimeoutSec,
+                inPreAllocationFlag,
+                theStream.str(),
+                inChunkServerInitialSeqNum,
+                inClientPoolPtr
+            )));
+        }
+        for (Chains::iterator theIt = mChains.begin();
+                theIt != mChains.end();
+                ++theIt) {
+            theIt->mImplPtr->SetSprayer(this);
+            theIt->mImplPtr->Register(this);
+        }
+    }
+    virtual ~Sprayer()
+    {
+        for (Chains::iterator theIt = mChains.begin() + 1;
+                theIt != mChains.end();
+                ++theIt) {
+            delete theIt->mImplPtr;
+        }
+        Sprayer::Register(0);
+    }
+    int Open(
+        const char* inFileNamePtr,
+        int         inNumReplicas,
+        bool        inMakeDirsFlag)
+    {
+        if (mErrorCode) {
+            return mErrorCode;
+        }
+        if (! IsActive()) {
+            Reset();
+            mPathName = inFileNamePtr ? inFileNamePtr : "";
+        }
+        // The remaining chains are opened on the first chain open completion.
+        return mChains.front().mImplPtr->Open(
+            inFileNamePtr, inNumReplicas, inMakeDirsFlag);
+    }
+    int Open(
+        kfsFileId_t inFileId,
+        const char* inFileNamePtr)
+    {
+        if (mErrorCode) {
+            return mErrorCode;
+        }
+        if (! IsActive()) {
+            Reset();
+            mPathName = inFileNamePtr ? inFileNamePtr : "";
+        }
+        mOpenChainsFlag = true;
+        int theRet = 0;
+        for (Chains::iterator theIt = mChains.begin();
+                theIt != mChains.end() && theRet == 0 && mErrorCode == 0;
+                ++theIt) {
+            theRet = theIt->mImplPtr->Open(inFileId, inFileNamePtr);
+        }
+        return (mErrorCode ? mErrorCode : theRet);
+    }
+    int Close()
+    {
+        if (mErrorCode) {
+            return mErrorCode;
+        }
+        int theRet = 0;
+        for (size_t i = 0; i < mChains.size() && mErrorCode == 0; i++) {
+            const int theStatus = mChains[i].mImplPtr->Close();
+            if (theRet == 0) {
+                theRet = theStatus;
+            }
+        }
+        return (mErrorCode ? mErrorCode : theRet);
+    }
+    int Append(
+        IOBuffer& inBuffer,
+        int       inLength)
+    {
+        if (mErrorCode) {
+            return mErrorCode;
+        }
+        const size_t theCount = mChains.size();
+        size_t       theIdx   = mNextChain;
+        int          theMin   = -1;
+        for (size_t i = 0; i < theCount; i++) {
+            const size_t theCur   = (mNextChain + i) % theCount;
+            const Impl&  theChain = *mChains[theCur].mImplPtr;
+            if (! theChain.IsOpen() && ! theChain.IsOpening()) {
+                continue;
+            }
+            const int thePending = theChain.GetPendingSize();
+            if (theMin < 0 || thePending < theMin) {
+                theMin = thePending;
+                theIdx = theCur;
+            }
+        }
+        mNextChain = (theIdx + 1) % theCount;
+        Chain&    theChain  = mChains[theIdx];
+        const int theStatus = theChain.mImplPtr->Append(inBuffer, inLength);
+        if (theStatus <= 0 || mErrorCode) {
+            return (mErrorCode ? mErrorCode : theStatus);
+        }
+        theChain.mQueued += theStatus;
+        mPending         += theStatus;
+        if (mRecords.empty() || mRecords.back().mChainIdx != theIdx) {
+            mRecords.push_back(Record(theIdx, theStatus));
+        } else {
+            mRecords.back().mLength += theStatus;
+        }
+        return theStatus;
+    }
+    void Shutdown()
+    {
+        for (Chains::iterator theIt = mChains.begin();
+                theIt != mChains.end();
+                ++theIt) {
+            theIt->mImplPtr->Shutdown();
+        }
+        Reset();
+        mErrorCode = 0;
+    }
+    bool IsOpen() const
+        { return Any(&Impl::IsOpen); }
+    bool IsOpening() const
+        { return Any(&Impl::IsOpening); }
+    bool IsClosing() const
+        { return Any(&Impl::IsClosing); }
+    bool IsSleeping() const
+        { return Any(&Impl::IsSleeping); }
+    bool IsActive() const
+        { return Any(&Impl::IsActive); }
+    int GetPendingSize() const
+        { return mPending; }
+    int GetErrorCode() const
+    {
+        for (Chains::const_iterator theIt = mChains.begin();
+                theIt != mChains.end() && mErrorCode == 0;
+                ++theIt) {
+            const int theStatus = theIt->mImplPtr->GetErrorCode();
+            if (theStatus != 0) {
+                return theStatus;
+            }
+        }
+        return mErrorCode;
+    }
+    string GetServerLocation() const
+    {
+        string theRet;
+        for (Chains::const_iterator theIt = mChains.begin();
+                theIt != mChains.end();
+                ++theIt) {
+            if (theIt != mChains.begin()) {
+                theRet += " ";
+            }
+            theRet += theIt->mImplPtr->GetServerLocation();
+        }
+        return theRet;
+    }
+    int SetWriteThreshold(
+        int inThreshold)
+    {
+        int theRet = 0;
+        for (size_t i = 0; i < mChains.size(); i++) {
+            const int theStatus =
+                mChains[i].mImplPtr->SetWriteThreshold(inThreshold);
+            if (theRet == 0) {
+                theRet = theStatus;
+            }
+        }
+        return (mErrorCode ? mErrorCode : theRet);
+    }
+    void Register(
+        Completion* inCompletionPtr)
+    {
+        if (inCompletionPtr == mCompletionPtr) {
+            return;
+        }
+        if (mCompletionPtr) {
+            mCompletionPtr->Unregistered(mOuter);
+        }
+        mCompletionPtr = inCompletionPtr;
+    }
+    bool Unregister(
+        Completion* inCompletionPtr)
+    {
+        if (inCompletionPtr != mCompletionPtr) {
+            return false;
+        }
+        mCompletionPtr = 0;
+        return true;
+    }
+    void GetStats(
+        Stats&               outStats,
+        KfsNetClient::Stats& outChunkServersStats)
+    {
+        outStats.Clear();
+        outChunkServersStats.Clear();
+        for (Chains::iterator theIt = mChains.begin();
+                theIt != mChains.end();
+                ++theIt) {
+            Stats               theStats;
+            KfsNetClient::Stats theCsStats;
+            theIt->mImplPtr->GetStats(theStats, theCsStats);
+            outStats.Add(theStats);
+            outChunkServersStats.Add(theCsStats);
+        }
+    }
+    int SetPreAllocation(
+        bool inFlag)
+    {
+        int theRet = 0;
+        for (size_t i = 0; i < mChains.size(); i++) {
+            const int theStatus =
+                mChains[i].mImplPtr->SetPreAllocation(inFlag);
+            if (theRet == 0) {
+                theRet = theStatus;
+            }
+        }
+        return (mErrorCode ? mErrorCode : theRet);
+    }
+    bool GetPreAllocation() const
+        { return mChains.front().mImplPtr->GetPreAllocation(); }
+    void SetForcedAllocationInterval(
+        int inInterval)
+    {
+        for (Chains::iterator theIt = mChains.begin();
+                theIt != mChains.end();
+                ++theIt) {
+            theIt->mImplPtr->SetForcedAllocationInterval(inInterval);
+        }
+    }
+    bool StartAllocation(
+        Impl& inChain)
+    {
+        if (mAllocatingPtr && mAllocatingPtr != &inChain &&
+                mAllocatingPtr->IsAllocating()) {
+            return false;
+        }
+        mAllocatingPtr = &inChain;
+        return true;
+    }
+    void AllocationDone()
+    {
+        if (mErrorCode ||
+                (mAllocatingPtr && mAllocatingPtr->IsAllocating())) {
+            return;
+        }
+        // Give the waiting chains the chance to allocate in round robin
+        // order, the first one that starts allocation blocks the others.
+        const size_t theCount = mChains.size();
+        for (size_t i = 0; i < theCount && mErrorCode == 0; i++) {
+            mChains[(mNextChain + i) % theCount].mImplPtr->AllocationGranted();
+            if (mAllocatingPtr && mAllocatingPtr->IsAllocating()) {
+                break;
+            }
+        }
+    }
+    virtual void Done(
+        WriteAppender& inAppender,
+        int            inStatusCode)
+    {
+        QCRTASSERT(&inAppender == &mOuter);
+        if (mErrorCode == 0) {
+            if (inStatusCode != 0) {
+                Fail(inStatusCode);
+            } else {
+                UpdatePending();
+                OpenChains();
+                AllocationDone();
+            }
+        }
+        if (mCompletionPtr) {
+            mCompletionPtr->Done(mOuter, mErrorCode);
+        }
+    }
+private:
+    struct Chain
+    {
+        Chain(
+            Impl& inImpl)
+            : mImplPtr(&inImpl),
+              mQueued(0),
+              mDone(0)
+            {}
+        Impl* mImplPtr;
+        int   mQueued;
+        int   mDone;
+    };
+    struct Record
+    {
+        Record(
+            size_t inChainIdx,
+            int    inLength)
+            : mChainIdx(inChainIdx),
+              mLength(inLength)
+            {}
+        size_t mChainIdx;
+        int    mLength;
+    };
+    typedef vector<Chain> Chains;
+    typedef deque<Record> Records;
+
+    WriteAppender& mOuter;
+    Chains         mChains;
+    Records        mRecords;
+    Completion*    mCompletionPtr;
+    string         mPathName;
+    string const   mLogPrefix;
+    int            mErrorCode;
+    int            mPending;
+    size_t         mNextChain;
+    bool           mOpenChainsFlag;
+    Impl*          mAllocatingPtr;
+
+    bool Any(
+        bool (Impl::*inMethodPtr)() const) const
+    {
+        for (Chains::const_iterator theIt = mChains.begin();
+                theIt != mChains.end();
+                ++theIt) {
+            if ((theIt->mImplPtr->*inMethodPtr)()) {
+                return true;
+            }
+        }
+        return false;
+    }
+    void Reset()
+    {
+        for (Chains::iterator theIt = mChains.begin();
+                theIt != mChains.end();
+                ++theIt) {
+            theIt->mQueued = 0;
+            theIt->mDone   = 0;
+        }
+        mRecords.clear();
+        mPending        = 0;
+        mNextChain      = 0;
+        mOpenChainsFlag = false;
+        mAllocatingPtr  = 0;
+    }
+    void OpenChains()
+    {
+        Impl& theFirst = *mChains.front().mImplPtr;
+        if (mOpenChainsFlag || ! theFirst.IsOpen()) {
+            return;
+        }
+        mOpenChainsFlag = true;
+        const kfsFileId_t theFileId = theFirst.GetFileId();
+        for (Chains::iterator theIt = mChains.begin() + 1;
+                theIt != mChains.end() && mErrorCode == 0;
+                ++theIt) {
+            const int theStatus =
+                theIt->mImplPtr->Open(theFileId, mPathName.c_str());
+            if (theStatus != 0) {
+                KFS_LOG_STREAM_ERROR << mLogPrefix <<
+                    "chain: " << (theIt - mChains.begin()) <<
+                    " open failure: " << theStatus <<
+                KFS_LOG_EOM;
+            }
+        }
+    }
+    // Account the bytes appended by each chain, and advance the records
+    // queue head past the records appended by their respective chains.
+    void UpdatePending()
+    {
+        for (Chains::iterator theIt = mChains.begin();
+                theIt != mChains.end();
+                ++theIt) {
+            const int theRem = theIt->mImplPtr->GetPendingSize();
+            if (theRem < theIt->mQueued) {
+                theIt->mDone  += theIt->mQueued - theRem;
+                theIt->mQueued = theRem;
+            }
+        }
+        while (! mRecords.empty()) {
+            Record&   theRec   = mRecords.front();
+            Chain&    theChain = mChains[theRec.mChainIdx];
+            const int theDone  = min(theRec.mLength, theChain.mDone);
+            if (theDone <= 0) {
+                break;
+            }
+            theRec.mLength -= theDone;
+            theChain.mDone -= theDone;
+            mPending       -= theDone;
+            if (theRec.mLength > 0) {
+                break;
+            }
+            mRecords.pop_front();
+        }
+        QCRTASSERT(mPending >= 0);
+    }
+    void Fail(
+        int inStatusCode)
+    {
+        KFS_LOG_STREAM_ERROR << mLogPrefix <<
+            "chain failure: " << inStatusCode <<
+            " shutting down " << mChains.size() << " chains" <<
+            " pending: " << mPending <<
+        KFS_LOG_EOM;
+        mErrorCode = inStatusCode;
+        for (Chains::iterator theIt = mChains.begin();
+                theIt != mChains.end();
+                ++theIt) {
+            theIt->mImplPtr->Shutdown();
+        }
+        Reset();
+    }
+private:
+    Sprayer(
+        const Sprayer& inSprayer);
+    Sprayer& operator=(
+        const Sprayer& inSprayer);
+};
+
+bool
+WriteAppender::Impl::StartAllocation()
+{
+    return mSprayerPtr->StartAllocation(*this);
+}
+
+void
+WriteAppender::Impl::AllocationDone()
+{
+    mSprayerPtr->AllocationDone();
+}
+
 WriteAppender::WriteAppender(
     MetaServer& inMetaServer,
     Completion* inCompletionPtr               /* = 0 */,
@@ -1544,11 +2063,12 @@ WriteAppender::WriteAppender(
     const char* inLogPrefixPtr                /* = 0 */,
     int64_t     inChunkServerInitialSeqNum    /* = 1 */,
     bool        inPreAllocationFlag           /* = true */,
-    ClientPool* inClientPoolPtr               /* = 0 */)
+    ClientPool* inClientPoolPtr               /* = 0 */,
+    int         inMaxChunksCount              /* = 1 */)
     : mImpl(*new WriteAppender::Impl(
         *this,
         inMetaServer,
-        inCompletionPtr,
+        inMaxChunksCount > 1 ? 0 : inCompletionPtr,
         inMaxRetryCount,
         inWriteThreshold,
         inTimeSecBetweenRetries,
@@ -1562,7 +2082,27 @@ WriteAppender::WriteAppender(
             (inLogPrefixPtr + string(" ")) : string(),
         inChunkServerInitialSeqNum,
         inClientPoolPtr
-    ))
+    )),
+      mSprayerPtr(inMaxChunksCount > 1 ? new WriteAppender::Sprayer(
+        *this,
+        mImpl,
+        inMetaServer,
+        inCompletionPtr,
+        inMaxRetryCount,
+        inWriteThreshold,
+        inTimeSecBetweenRetries,
+        inDefaultSpaceReservationSize,
+        inPreferredAppendSize,
+        inMaxPartialBuffersCount,
+        inOpTimeoutSec,
+        inIdleTimeoutSec,
+        inPreAllocationFlag,
+        (inLogPrefixPtr && inLogPrefixPtr[0]) ?
+            (inLogPrefixPtr + string(" ")) : string(),
+        inChunkServerInitialSeqNum,
+        inClientPoolPtr,
+        inMaxChunksCount
+    ) : 0)
 {
 }
 
@@ -1570,6 +2110,7 @@ WriteAppender::WriteAppender(
 WriteAppender::~WriteAppender()
 {
     delete &mImpl;
+    delete mSprayerPtr;
 }
 
 int
@@ -1578,7 +2119,9 @@ WriteAppender::Open(
     int         inNumReplicas  /* = 3 */,
     bool        inMakeDirsFlag /* = false */)
 {
-    return mImpl.Open(inFileNamePtr, inNumReplicas, inMakeDirsFlag);
+    return (mSprayerPtr ?
+        mSprayerPtr->Open(inFileNamePtr, inNumReplicas, inMakeDirsFlag) :
+        mImpl.Open(inFileNamePtr, inNumReplicas, inMakeDirsFlag));
 }
 
 int
@@ -1586,13 +2129,15 @@ WriteAppender::Open(
     kfsFileId_t inFileId,
     const char* inFileNamePtr)
 {
-    return mImpl.Open(inFileId, inFileNamePtr);
+    return (mSprayerPtr ?
+        mSprayerPtr->Open(inFileId, inFileNamePtr) :
+        mImpl.Open(inFileId, inFileNamePtr));
 }
 
 int
 WriteAppender::Close()
 {
-    return mImpl.Close();
+    return (mSprayerPtr ? mSprayerPtr->Close() : mImpl.Close());
 }
 
 int
@@ -1600,76 +2145,92 @@ WriteAppender::Append(
     IOBuffer& inBuffer,
     int       inLength)
 {
-    return mImpl.Append(inBuffer, inLength);
+    return (mSprayerPtr ?
+        mSprayerPtr->Append(inBuffer, inLength) :
+        mImpl.Append(inBuffer, inLength));
 }
 
 void
 WriteAppender::Shutdown()
 {
-    mImpl.Shutdown();
+    if (mSprayerPtr) {
+        mSprayerPtr->Shutdown();
+    } else {
+        mImpl.Shutdown();
+    }
 }
 
 bool
 WriteAppender::IsOpen() const
 {
-    return mImpl.IsOpen();
+    return (mSprayerPtr ? mSprayerPtr->IsOpen() : mImpl.IsOpen());
 }
 
 bool
 WriteAppender::IsOpening() const
 {
-    return mImpl.IsOpening();
+    return (mSprayerPtr ? mSprayerPtr->IsOpening() : mImpl.IsOpening());
 }
 
 bool
 WriteAppender::IsClosing() const
 {
-    return mImpl.IsClosing();
+    return (mSprayerPtr ? mSprayerPtr->IsClosing() : mImpl.IsClosing());
 }
 
 bool
 WriteAppender::IsSleeping() const
 {
-    return mImpl.IsSleeping();
+    return (mSprayerPtr ? mSprayerPtr->IsSleeping() : mImpl.IsSleeping());
 }
 
 bool
 WriteAppender::IsActive() const
 {
-    return mImpl.IsActive();
+    return (mSprayerPtr ? mSprayerPtr->IsActive() : mImpl.IsActive());
 }
 
 int
 WriteAppender::GetPendingSize() const
 {
-    return mImpl.GetPendingSize();
+    return (mSprayerPtr ?
+        mSprayerPtr->GetPendingSize() :
+        mImpl.GetPendingSize());
 }
 
 int
 WriteAppender::GetErrorCode() const
 {
-    return mImpl.GetErrorCode();
+    return (mSprayerPtr ? mSprayerPtr->GetErrorCode() : mImpl.GetErrorCode());
 }
 
 int
 WriteAppender::SetWriteThreshold(
     int inThreshold)
 {
-    return mImpl.SetWriteThreshold(inThreshold);
+    return (mSprayerPtr ?
+        mSprayerPtr->SetWriteThreshold(inThreshold) :
+        mImpl.SetWriteThreshold(inThreshold));
 }
 
 void
 WriteAppender::Register(
     Completion* inCompletionPtr)
 {
-    mImpl.Register(inCompletionPtr);
+    if (mSprayerPtr) {
+        mSprayerPtr->Register(inCompletionPtr);
+    } else {
+        mImpl.Register(inCompletionPtr);
+    }
 }
 
 bool
 WriteAppender::Unregister(
     Completion* inCompletionPtr)
 {
-    return mImpl.Unregister(inCompletionPtr);
+    return (mSprayerPtr ?
+        mSprayerPtr->Unregister(inCompletionPtr) :
+        mImpl.Unregister(inCompletionPtr));
 }
 
 void
@@ -1677,33 +2238,47 @@ WriteAppender::GetStats(
     Stats&               outStats,
     KfsNetClient::Stats& outChunkServersStats)
 {
-    mImpl.GetStats(outStats, outChunkServersStats);
+    if (mSprayerPtr) {
+        mSprayerPtr->GetStats(outStats, outChunkServersStats);
+    } else {
+        mImpl.GetStats(outStats, outChunkServersStats);
+    }
 }
 
 string
 WriteAppender::GetServerLocation() const
 {
-    return mImpl.GetServerLocation();
+    return (mSprayerPtr ?
+        mSprayerPtr->GetServerLocation() :
+        mImpl.GetServerLocation());
 }
 
 int
 WriteAppender::SetPreAllocation(
     bool inFlag)
 {
-    return mImpl.SetPreAllocation(inFlag);
+    return (mSprayerPtr ?
+        mSprayerPtr->SetPreAllocation(inFlag) :
+        mImpl.SetPreAllocation(inFlag));
 }
 
 bool
 WriteAppender::GetPreAllocation() const
 {
-    return mImpl.GetPreAllocation();
+    return (mSprayerPtr ?
+        mSprayerPtr->GetPreAllocation() :
+        mImpl.GetPreAllocation());
 }
 
 void
 WriteAppender::SetForcedAllocationInterval(
     int inInterval)
 {
-    return mImpl.SetForcedAllocationInterval(inInterval);
+    if (mSprayerPtr) {
+        mSprayerPtr->SetForcedAllocationInterval(inInterval);
+    } else {
+        mImpl.SetForcedAllocationInterval(inInterval);
+    }
 }
 
 }
@@ -43,6 +43,14 @@ namespace client
 class ClientPool;
 
 // Kfs client write append state machine.
+// With max chunks count greater than one the appender keeps up to the
+// specified number of chunks open for append at the same time, each with its
+// own state machine, chunk server connection, and write queue, and sends every
+// record to the chunk with the least bytes pending. The chunk allocations are
+// serialized, and each chain always requests a new chunk, therefore the next
+// chunk is allocated while the other chains are still appending.
+// The records appended to different chunks are not ordered with respect to
+// each other, just like the records appended by different appenders.
 class WriteAppender
 {
 public:
@@ -165,7 +173,8 @@ public:
         const char* inLogPrefixPtr                = 0,
         int64_t     inChunkServerInitialSeqNum    = 1,
         bool        inPreAllocationFlag           = true,
-        ClientPool* inClientPoolPtr               = 0);
+        ClientPool* inClientPoolPtr               = 0,
+        int         inMaxChunksCount              = 1);
     virtual ~WriteAppender();
     int Open(
         const char* inFileNamePtr,
@@ -184,6 +193,9 @@ public:
     bool IsClosing()  const;
     bool IsSleeping() const;
     bool IsActive()   const;
+    // Bytes not yet appended, counting from the first record that was not
+    // appended, i.e. the records appended after that one are still counted
+    // as pending.
     int GetPendingSize() const;
     int GetErrorCode() const;
     int SetWriteThreshold(
@@ -203,7 +215,9 @@ public:
         int inInterval);
 private:
     class Impl;
-    Impl& mImpl;
+    class Sprayer;
+    Impl&          mImpl;
+    Sprayer* const mSprayerPtr;
 private:
     WriteAppender(
         const WriteAppender& inAppender);
@@ -30,6 +30,7 @@
 #include <cerrno>
 #include <sstream>
 #include <bitset>
+#include <map>
 #include <string.h>
 
 #include "kfsio/IOBuffer.h"
@@ -58,6 +59,8 @@ using std::string;
 using std::ostream;
 using std::ostringstream;
 using std::istringstream;
+using std::map;
+using std::vector;
 
 // Kfs client write state machine implementation.
 class Writer::Impl :
@@ -89,7 +92,8 @@ public:
         int         inIdleTimeoutSec,
         int         inMaxWriteSize,
         string      inLogPrefix,
-        int64_t     inChunkServerInitialSeqNum)
+        int64_t     inChunkServerInitialSeqNum,
+        int         inAllocateAheadCount)
         : QCRefCountedObj(),
           ITimeout(),
           KfsNetClient::OpOwner(),
@@ -126,7 +130,12 @@ public:
           mOpStartTime(0),
           mCompletionDepthCount(0),
           mStriperProcessCount(0),
-          mStriperPtr(0)
+          mStriperPtr(0),
+          mAllocateAheadCount(max(0, inAllocateAheadCount)),
+          mAllocateAheadOwner(inChunkServerInitialSeqNum),
+          mMaxWriteOffset(0),
+          mAllocateAheadRequestedFlag(false),
+          mAllocatedAhead()
         { Writers::Init(mWriters); }
     int Open(
         kfsFileId_t inFileId,
@@ -189,7 +198,11 @@ public:
         mTruncateOp.fid        = -1;
         mTruncateOp.pathname   = 0;
         mTruncateOp.fileOffset = mFileSize;
+        mTruncateOp.reclaimFlag = false;
         mRetryCount            = 0;
+        mMaxWriteOffset        = 0;
+        mAllocateAheadRequestedFlag = false;
+        mAllocatedAhead.clear();
         return StartWrite();
     }
     int Close()
@@ -284,6 +297,7 @@ public:
         }
         mClosingFlag = false;
         mBuffer.Clear();
+        mAllocatedAhead.clear();
     }
     void Shutdown()
     {
@@ -350,6 +364,21 @@ public:
 
 private:
     typedef KfsNetClient ChunkServer;
+    struct AllocatedAheadEntry
+    {
+        kfsChunkId_t           mChunkId;
+        int64_t                mChunkVersion;
+        vector<ServerLocation> mChunkServers;
+        time_t                 mTime;
+
+        AllocatedAheadEntry()
+            : mChunkId(-1),
+              mChunkVersion(-1),
+              mChunkServers(),
+              mTime(0)
+            {}
+    };
+    typedef map<Offset, AllocatedAheadEntry> AllocatedAhead;
 
     class ChunkWriter : private ITimeout, private KfsNetClient::OpOwner
     {
@@ -395,8 +424,12 @@ private:
                     mWriteSyncOp.seq    = seq;
                     mWritePrepareOp.seq = seq + 1;
                 }
+                mWritePrepareOp.shortRpcFormatFlag = shortRpcFormatFlag;
+                mWriteSyncOp.shortRpcFormatFlag    = shortRpcFormatFlag;
                 mWritePrepareOp.Request(inStream);
             }
+            virtual bool SupportsShortRpcFormat() const
+                { return true; }
             virtual bool NextRequest(
                 kfsSeq_t inSeqNum,
                 ostream& inStream)
@@ -783,7 +816,25 @@ private:
             mAllocOp.chunkVersion         = -1;
             mAllocOp.spaceReservationSize = 0;
             mAllocOp.maxAppendersPerChunk = 0;
+            mAllocOp.allocateAheadCount   = 0;
             mAllocOp.chunkServers.clear();
+            mAllocOp.allocateAhead.clear();
+            if (mOuter.GetAllocatedAhead(mAllocOp)) {
+                KFS_LOG_STREAM_DEBUG << mLogPrefix <<
+                    "allocated ahead:"
+                    " chunk: "   << mAllocOp.chunkId <<
+                    " version: " << mAllocOp.chunkVersion <<
+                    " offset: "  << mAllocOp.fileOffset <<
+                KFS_LOG_EOM;
+                AllocateWriteId();
+                return;
+            }
+            mAllocOp.allocateAheadCount =
+                mOuter.GetAllocateAheadCount(mAllocOp.fileOffset);
+            if (0 < mAllocOp.allocateAheadCount) {
+                mAllocOp.allocateAheadOwner = mOuter.mAllocateAheadOwner;
+                mOuter.mAllocateAheadRequestedFlag = true;
+            }
             mOuter.mStats.mChunkAllocCount++;
             EnqueueMeta(mAllocOp);
         }
@@ -802,6 +853,8 @@ private:
                 HandleError(inOp);
                 return;
             }
+            mOuter.SetAllocatedAhead(mAllocOp.allocateAhead);
+            mAllocOp.allocateAhead.clear();
             if (mAllocOp.invalidateAllFlag) {
                 // Report all writes completed. Completion does not expect the
                 // offset to match the original write offset with striper.
@@ -1314,6 +1367,11 @@ private:
     int                 mCompletionDepthCount;
     int                 mStriperProcessCount;
     Striper*            mStriperPtr;
+    const int           mAllocateAheadCount;
+    const int64_t       mAllocateAheadOwner;
+    Offset              mMaxWriteOffset;
+    bool                mAllocateAheadRequestedFlag;
+    AllocatedAhead      mAllocatedAhead;
     ChunkWriter*        mWriters[1];
 
     void InternalError(
@@ -1396,18 +1454,42 @@ private:
     }
     void SetFileSize()
     {
-        if (! mStriperPtr || mErrorCode != 0 || mTruncateOp.fid >= 0) {
+        if (mErrorCode != 0 || mTruncateOp.fid >= 0) {
             return;
         }
-        const Offset theSize = mStriperPtr->GetFileSize();
-        if (theSize < 0 || theSize <= mTruncateOp.fileOffset) {
-            return;
+        Offset theSize;
+        if (mStriperPtr) {
+            theSize = mStriperPtr->GetFileSize();
+            if (theSize < 0 || theSize <= mTruncateOp.fileOffset) {
+                return;
+            }
+        } else {
+            // Delete chunks allocated ahead, but not written into, in order
+            // to keep the file size consistent with the data written. The
+            // meta server does not wait for all allocations ahead to complete
+            // before responding, therefore delete all chunks past the last
+            // chunk written, if allocation ahead was requested. The meta
+            // server deletes only the chunks that are still unused, and were
+            // allocated ahead for this writer, identified by the owner id.
+            AllocatedAhead::const_iterator const theIt =
+                mAllocatedAhead.lower_bound(mMaxWriteOffset);
+            if (mAllocateAheadRequestedFlag) {
+                theSize = (mMaxWriteOffset + (Offset)CHUNKSIZE - 1) /
+                    (Offset)CHUNKSIZE * (Offset)CHUNKSIZE;
+            } else if (theIt == mAllocatedAhead.end()) {
+                mAllocatedAhead.clear();
+                return;
+            } else {
+                theSize = theIt->first;
+            }
         }
-        mOpStartTime           = mNetManager.Now();
-        mTruncateOp.pathname   = mPathName.c_str();
-        mTruncateOp.fid        = mFileId;
-        mTruncateOp.fileOffset = theSize;
-        mTruncateOp.status     = 0;
+        mOpStartTime                   = mNetManager.Now();
+        mTruncateOp.pathname           = mPathName.c_str();
+        mTruncateOp.fid                = mFileId;
+        mTruncateOp.fileOffset         = theSize;
+        mTruncateOp.reclaimFlag        = ! mStriperPtr;
+        mTruncateOp.allocateAheadOwner = mAllocateAheadOwner;
+        mTruncateOp.status             = 0;
         KFS_LOG_STREAM_DEBUG << mLogPrefix <<
             "meta +> " << mTruncateOp.Show() <<
         KFS_LOG_EOM;
@@ -1461,10 +1543,66 @@ private:
                 FatalError(mTruncateOp.status);
             }
         } else {
+            if (mTruncateOp.reclaimFlag) {
+                mAllocatedAhead.clear();
+                mAllocateAheadRequestedFlag = false;
+            }
             mRetryCount = 0;
             ReportCompletion();
         }
     }
+    int GetAllocateAheadCount(
+        Offset inFileOffset) const
+    {
+        // Allocate ahead only past the end of file, when the file is written
+        // sequentially, and all previously allocated ahead chunks are used.
+        return ((mStriperPtr || ! mAllocatedAhead.empty() ||
+                inFileOffset < mFileSize || inFileOffset < mMaxWriteOffset -
+                    mMaxWriteOffset % (Offset)CHUNKSIZE) ?
+            0 : mAllocateAheadCount
+        );
+    }
+    bool GetAllocatedAhead(
+        AllocateOp& inOp)
+    {
+        AllocatedAhead::iterator const theIt =
+            mAllocatedAhead.find(inOp.fileOffset);
+        if (theIt == mAllocatedAhead.end()) {
+            return false;
+        }
+        // Do not use allocations that are old enough for the write lease
+        // to expire, let the meta server re-issue the lease instead.
+        const bool theRetFlag = mNetManager.Now() <
+            theIt->second.mTime + LEASE_INTERVAL_SECS / 2;
+        if (theRetFlag) {
+            inOp.status       = 0;
+            inOp.chunkId      = theIt->second.mChunkId;
+            inOp.chunkVersion = theIt->second.mChunkVersion;
+            inOp.chunkServers.swap(theIt->second.mChunkServers);
+            inOp.masterServer = inOp.chunkServers.front();
+        }
+        mAllocatedAhead.erase(theIt);
+        return theRetFlag;
+    }
+    void SetAllocatedAhead(
+        vector<AllocateOp::AllocateAheadInfo>& inAllocateAhead)
+    {
+        const time_t theNow = mNetManager.Now();
+        for (vector<AllocateOp::AllocateAheadInfo>::iterator
+                theIt = inAllocateAhead.begin();
+                theIt != inAllocateAhead.end();
+                ++theIt) {
+            if (theIt->chunkServers.empty() ||
+                    theIt->fileOffset < mMaxWriteOffset) {
+                continue;
+            }
+            AllocatedAheadEntry& theEntry = mAllocatedAhead[theIt->fileOffset];
+            theEntry.mChunkId      = theIt->chunkId;
+            theEntry.mChunkVersion = theIt->chunkVersion;
+            theEntry.mTime         = theNow;
+            theEntry.mChunkServers.swap(theIt->chunkServers);
+        }
+    }
     bool Sleep(
         int inSec)
     {
@@ -1511,6 +1649,7 @@ private:
         );
         if (theQueuedCount > 0) {
             mOffset += theQueuedCount;
+            mMaxWriteOffset = max(mMaxWriteOffset, mOffset);
             StartQueuedWrite(theQueuedCount);
         }
     }
@@ -1740,7 +1879,8 @@ Writer::Writer(
     int                 inIdleTimeoutSec              /* = 5 * 30 */,
     int                 inMaxWriteSize                /* = 1 << 20 */,
     const char*         inLogPrefixPtr                /* = 0 */,
-    int64_t             inChunkServerInitialSeqNum    /* = 1 */)
+    int64_t             inChunkServerInitialSeqNum    /* = 1 */,
+    int                 inAllocateAheadCount          /* = 0 */)
     : mImpl(*new Writer::Impl(
         *this,
         inMetaServer,
@@ -1754,7 +1894,8 @@ Writer::Writer(
         inMaxWriteSize,
         (inLogPrefixPtr && inLogPrefixPtr[0]) ?
             (inLogPrefixPtr + string(" ")) : string(),
-        inChunkServerInitialSeqNum
+        inChunkServerInitialSeqNum,
+        inAllocateAheadCount
     ))
 {
     mImpl.Ref();
@@ -219,7 +219,8 @@ public:
         int         inIdleTimeoutSec           = 5 * 30,
         int         inMaxWriteSize             = 1 << 20,
         const char* inLogPrefixPtr             = 0,
-        int64_t     inChunkServerInitialSeqNum = 1);
+        int64_t     inChunkServerInitialSeqNum = 1,
+        int         inAllocateAheadCount       = 0);
     virtual ~Writer();
     int Open(
         kfsFileId_t inFileId,
@@ -49,6 +49,8 @@ using std::make_pair;
 using std::find_if;
 using std::iter_swap;
 using std::sort;
+using std::min;
+using std::max;
 using boost::bind;
 
 /*
@@ -71,6 +73,19 @@ using boost::bind;
  * for the initial chunk placement, unless using available space is forced by
  * the meta server configuration for initial chunk placement.
  *
+ * With large racks (or with the "last attempt" that considers all chunk
+ * servers) building the candidate list is linear in the number of servers,
+ * and dominates the allocation cost. For such racks the servers are chosen by
+ * rejection sampling instead: pick a server uniformly at random, and accept it
+ * with probability load / max load, where max load is the upper bound of the
+ * "load" of any candidate server, derived from the same thresholds that
+ * LayoutManager::IsCandidateServer() and IsCandidateServer() use. This
+ * yields exactly the same distribution as the list based selection, while
+ * the expected cost of choosing k servers does not depend on the rack size.
+ * If the sampling fails to find a candidate in a limited number of attempts,
+ * for example if the most servers in the rack cannot be used, then the
+ * selection reverts to building the candidate list.
+ *
  * To minimize network transfers between the rack the re-replication and
  * re-balancing attempts to choose re-replication source and destination withing
  * the same rack. If not enough different racks available, put chunk replicas
@@ -100,6 +115,10 @@ public:
           mServerExcludes(),
           mCandidateRacks(),
           mCandidates(),
+          mSampled(),
+          mSampleSources(0),
+          mSampleNext(0),
+          mSampleMaxLoad(0),
           mLoadAvgSum(0),
           mRackPos(0),
           mCandidatePos(0),
@@ -124,6 +143,7 @@ public:
         mUsingServerExcludesFlag = false;
         mCandidateRacks.clear();
         mCandidates.clear();
+        ResetSampling();
     }
     void clear()
     {
@@ -194,6 +214,17 @@ public:
     ChunkServerPtr GetNext(
         bool canIgnoreServerExcludesFlag)
     {
+        if (mSampleSources) {
+            ChunkServer* const srv = mSampleNext ? mSampleNext : Sample();
+            mSampleNext = 0;
+            if (srv) {
+                return srv->shared_from_this();
+            }
+            // Sampling failed, use the remaining candidates list.
+            const Sources& sources = *mSampleSources;
+            mSampleSources = 0;
+            FindCandidateServers(sources, false);
+        }
         if (mUsingServerExcludesFlag) {
             if (! canIgnoreServerExcludesFlag) {
                 return ChunkServerPtr();
@@ -278,7 +309,7 @@ public:
                     continue;
                 }
                 FindCandidateServers(it->getServers());
-                if (mCandidates.empty()) {
+                if (! HasCandidates()) {
                     continue;
                 }
                 mCurRackId = rackId;
@@ -317,12 +348,12 @@ public:
             const RackInfo& rack = *(mCandidateRacks[
                 mRackPos++].second);
             FindCandidateServers(rack.getServers());
-            if (! mCandidates.empty()) {
+            if (HasCandidates()) {
                 mCurRackId = rack.id();
                 break;
             }
         }
-        return (! mCandidates.empty());
+        return HasCandidates();
     }
 
     bool ExcludeServer(
@@ -671,6 +702,8 @@ private:
         > Candidates;
     typedef Servers Sources;
     enum { kSlaveScaleFracBits = LayoutManager::kSlaveScaleFracBits };
+    enum { kMinSampleSourcesSize = 128 };
+    enum { kMaxSampleAttempts    = 64 };
 
     LayoutManager&   mLayoutManager;
     const RackInfos& mRacks;
@@ -678,6 +711,10 @@ private:
     ServerExcludes   mServerExcludes;
     CandidateRacks   mCandidateRacks;
     Candidates       mCandidates;
+    ServerExcludes   mSampled;
+    const Sources*   mSampleSources;
+    ChunkServer*     mSampleNext;
+    int64_t          mSampleMaxLoad;
     int64_t          mLoadAvgSum;
     size_t           mRackPos;
     size_t           mCandidatePos;
@@ -712,7 +749,7 @@ private:
                 const RackInfo& rack = *(mCandidateRacks[
                     mRackPos++].second);
                 FindCandidateServers(rack.getServers());
-                if (! mCandidates.empty()) {
+                if (HasCandidates()) {
                     mCurRackId = rack.id();
                     return;
                 }
@@ -789,21 +826,82 @@ private:
                 mMaxSpaceUtilizationThreshold &&
             (! mForReplicationFlag ||
                 srv.GetNumChunkReplications() <
-                    mMaxReplicationsPerNode)
+                    srv.GetReplicationLimit(mMaxReplicationsPerNode))
         );
     }
+    bool HasCandidates() const
+        { return (mSampleNext || ! mCandidates.empty()); }
+    void ResetSampling()
+    {
+        mSampleSources = 0;
+        mSampleNext    = 0;
+        mSampleMaxLoad = 0;
+        mSampled.Clear();
+    }
+    int64_t GetMaxLoad()
+    {
+        const int64_t kLoadAvgFloor = 1;
+        if (mSortBySpaceUtilizationFlag) {
+            return ((int64_t)(mMaxSpaceUtilizationThreshold *
+                (int64_t(1) << (10 + kSlaveScaleFracBits)))
+                + kLoadAvgFloor);
+        }
+        if (mSortCandidatesByLoadAvgFlag) {
+            const int64_t slaveLoad = (
+                mLayoutManager.GetMaxGoodCandidateLoadAvg(false) *
+                mLayoutManager.GetSlavePlacementScale()
+            ) >> kSlaveScaleFracBits;
+            return (max(slaveLoad,
+                mLayoutManager.GetMaxGoodCandidateLoadAvg(true)) +
+                kLoadAvgFloor);
+        }
+        return kLoadAvgFloor;
+    }
+    ChunkServer* Sample()
+    {
+        const Sources& sources = *mSampleSources;
+        const int64_t  size    = (int64_t)sources.size();
+        for (int i = 0; i < kMaxSampleAttempts; i++) {
+            ChunkServer& srv = *(sources[(size_t)Rand(size)]);
+            if (! IsCandidateServer(srv) ||
+                    mServerExcludes.Find(&srv) ||
+                    mSampled.Find(&srv)) {
+                continue;
+            }
+            const int64_t load = GetLoad(srv);
+            if (load < mSampleMaxLoad && Rand(mSampleMaxLoad) >= load) {
+                continue;
+            }
+            mSampled.Insert(&srv);
+            return &srv;
+        }
+        return 0;
+    }
     void FindCandidateServers(
-        const Sources& sources)
+        const Sources& sources,
+        bool           useSamplingFlag = true)
     {
         mLoadAvgSum   = 0;
         mCandidatePos = 0;
         mCandidates.clear();
+        if (useSamplingFlag) {
+            ResetSampling();
+            if (kMinSampleSourcesSize <= sources.size()) {
+                mSampleSources = &sources;
+                mSampleMaxLoad = GetMaxLoad();
+                if ((mSampleNext = Sample())) {
+                    return;
+                }
+                mSampleSources = 0;
+            }
+        }
         for (typename Servers::const_iterator it = sources.begin();
                 it != sources.end();
                 ++it) {
             ChunkServer& srv = **it;
             if (! IsCandidateServer(srv) ||
-                    mServerExcludes.Find(&srv)) {
+                    mServerExcludes.Find(&srv) ||
+                    mSampled.Find(&srv)) {
                 continue;
             }
             const int64_t load = GetLoad(srv);
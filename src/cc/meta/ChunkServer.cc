@@ -47,6 +47,7 @@ namespace KFS
 using std::string;
 using std::istream;
 using std::max;
+using std::min;
 using std::make_pair;
 using std::pair;
 using std::hex;
@@ -111,6 +112,57 @@ private:
     HelloBufferQueueRunner& operator=(const HelloBufferQueueRunner&);
 };
 
+class PendingDeletesFlusher : public ITimeout
+{
+public:
+    static void Schedule()
+        { Instance().ScheduleSelf(); }
+    virtual void Timeout()
+    {
+        if (mRegisteredFlag) {
+            mRegisteredFlag = false;
+            globalNetManager().UnRegisterTimeoutHandler(this);
+        }
+        ChunkServer::FlushPendingDeletes();
+    }
+private:
+    bool mRegisteredFlag;
+
+    PendingDeletesFlusher()
+        : ITimeout(),
+          mRegisteredFlag(false)
+        {}
+    virtual ~PendingDeletesFlusher()
+    {
+        if (! mRegisteredFlag) {
+            return;
+        }
+        mRegisteredFlag = false;
+        globalNetManager().UnRegisterTimeoutHandler(this);
+    }
+    void ScheduleSelf()
+    {
+        if (mRegisteredFlag) {
+            return;
+        }
+        mRegisteredFlag = true;
+        globalNetManager().RegisterTimeoutHandler(this);
+        globalNetManager().Wakeup();
+    }
+    static PendingDeletesFlusher& Instance()
+    {
+        static PendingDeletesFlusher sPendingDeletesFlusher;
+        return sPendingDeletesFlusher;
+    }
+private:
+    PendingDeletesFlusher(const PendingDeletesFlusher&);
+    PendingDeletesFlusher& operator=(const PendingDeletesFlusher&);
+};
+
+// Bulk delete response has the status of each chunk that failed to delete,
+// keep the response within the max response content length.
+const int kMaxBulkDeleteChunks = 2 << 10;
+
 int ChunkServer::sHeartbeatTimeout     = 60;
 int ChunkServer::sHeartbeatInterval    = 20;
 int ChunkServer::sHeartbeatLogInterval = 1000;
@@ -125,9 +177,13 @@ size_t ChunkServer::sMaxChunksToEvacuate  = 2 << 10; // Max queue size
 // if sSrvLoadSamplerSampleCount > 0
 int ChunkServer::sSrvLoadSamplerSampleCount = 0;
 string ChunkServer::sSrvLoadPropName("Buffer-usec-wait-avg");
+int ChunkServer::sSrvLoadCounterId =
+    ChunkServerHeartbeat::Find(ChunkServer::sSrvLoadPropName.c_str());
+bool ChunkServer::sBinaryHeartbeatFlag = true;
+int ChunkServer::sMaxBulkDeleteChunks = kMaxBulkDeleteChunks;
 bool ChunkServer::sRestartCSOnInvalidClusterKeyFlag = false;
 ChunkServer::ChunkOpsInFlight ChunkServer::sChunkOpsInFlight;
-ChunkServer* ChunkServer::sChunkServersPtr[kChunkSrvListsCount] = { 0, 0 };
+ChunkServer* ChunkServer::sChunkServersPtr[kChunkSrvListsCount] = { 0, 0, 0 };
 int ChunkServer::sChunkServerCount = 0;
 int ChunkServer::sPendingHelloCount    = 0;
 int ChunkServer::sMinHelloWaitingBytes = 0;
@@ -172,6 +228,13 @@ void ChunkServer::SetParameters(const Properties& prop, int clientPort)
     sSrvLoadPropName = prop.getValue(
         "metaServer.chunkServer.srvLoadPropName",
         sSrvLoadPropName);
+    sSrvLoadCounterId = ChunkServerHeartbeat::Find(sSrvLoadPropName.c_str());
+    sBinaryHeartbeatFlag = prop.getValue(
+        "metaServer.chunkServer.binaryHeartbeat",
+        sBinaryHeartbeatFlag ? 1 : 0) != 0;
+    sMaxBulkDeleteChunks = min(kMaxBulkDeleteChunks, prop.getValue(
+        "metaServer.chunkServer.maxBulkDeleteChunks",
+        sMaxBulkDeleteChunks));
     sMaxChunksToEvacuate = max(size_t(1), prop.getValue(
         "metaServer.chunkServer.maxChunksToEvacuate",
         sMaxChunksToEvacuate));
@@ -244,11 +307,16 @@ ChunkServer::ChunkServer(const NetConnectionPtr& conn, const string& peerName)
       mNumAppendsWithWid(0),
       mNumChunkWriteReplications(0),
       mNumChunkReadReplications(0),
+      mReplicationCapacity(-1),
       mDispatchedReqs(),
       mReqsTimeoutQueue(),
       mLostChunks(0),
       mUptime(0),
       mHeartbeatProperties(),
+      mHeartbeatPropertiesStaleFlag(false),
+      mReplyProperties(),
+      mHeartbeatSeq(-1),
+      mHeartbeatCounterCount(0),
       mRestartScheduledFlag(false),
       mRestartQueuedFlag(false),
       mRestartScheduledTime(0),
@@ -262,6 +330,8 @@ ChunkServer::ChunkServer(const NetConnectionPtr& conn, const string& peerName)
       mLoadAvg(0),
       mCanBeCandidateServerFlag(false),
       mStaleChunksHexFormatFlag(false),
+      mBulkDeleteFlag(false),
+      mPendingDeletes(),
       mIStream(),
       mEvacuateCnt(0),
       mEvacuateBytes(0),
@@ -279,6 +349,7 @@ ChunkServer::ChunkServer(const NetConnectionPtr& conn, const string& peerName)
     assert(mNetConnection);
     ChunkServersList::Init(*this);
     PendingHelloList::Init(*this);
+    PendingDeleteList::Init(*this);
     ChunkServersList::PushBack(sChunkServersPtr, *this);
     SET_HANDLER(this, &ChunkServer::HandleRequest);
     mNetConnection->SetInactivityTimeout(sHeartbeatInterval);
@@ -302,6 +373,7 @@ ChunkServer::~ChunkServer()
         mNetConnection->Close();
     }
     RemoveFromPendingHelloList();
+    ClearPendingDeletes();
     delete mHelloOp;
     ChunkServersList::Remove(sChunkServersPtr, *this);
     sChunkServerCount--;
@@ -564,6 +636,7 @@ ChunkServer::ForceDown()
         mNetConnection.reset();
     }
     RemoveFromPendingHelloList();
+    ClearPendingDeletes();
     delete mHelloOp;
     mHelloOp      = 0;
     mDown         = true;
@@ -618,6 +691,7 @@ ChunkServer::Error(const char* errorMsg)
         mDownReason = "restart";
     }
     RemoveFromPendingHelloList();
+    ClearPendingDeletes();
     delete mHelloOp;
     mHelloOp      = 0;
     mDown         = true;
@@ -1020,13 +1094,17 @@ ChunkServer::HandleHelloMsg(IOBuffer* iobuf, int msgLen)
     mUptime                   = mHelloOp->uptime;
     mNumAppendsWithWid        = mHelloOp->numAppendsWithWid;
     mStaleChunksHexFormatFlag = mHelloOp->staleChunksHexFormatFlag;
+    mBulkDeleteFlag           = mHelloOp->bulkDeleteFlag;
     UpdateChunkWritesPerDrive((int)(mHelloOp->notStableAppendChunks.size() +
         mHelloOp->notStableChunks.size()), mNumWritableDrives);
     mLastHeartbeatSent = mLastHeard;
     mHeartbeatSent     = true;
     Enqueue(new MetaChunkHeartbeat(NextSeq(), shared_from_this(),
             IsRetiring() ? int64_t(1) :
-                (int64_t)mChunksToEvacuate.Size()),
+                (int64_t)mChunksToEvacuate.Size(),
+            sBinaryHeartbeatFlag ?
+                (int)ChunkServerHeartbeat::kSchemaVersion : 0,
+            mHeartbeatSeq),
         2 * sHeartbeatTimeout);
     // Emit message to time parse.
     KFS_LOG_STREAM_INFO << GetPeerName() <<
@@ -1098,12 +1176,22 @@ ChunkServer::HandleReply(IOBuffer* iobuf, int msgLen)
     // We got a response for a command we previously
     // sent.  So, match the response to its request and
     // resume request processing.
-    Properties prop;
-    const bool ok = ParseResponse(mIStream.Set(iobuf, msgLen), prop);
-    mIStream.Reset();
-    if (! ok) {
+    Properties& prop = mReplyProperties;
+    prop.clear();
+    if (! ParseResponse(*iobuf, msgLen, prop)) {
         return -1;
     }
+    // Binary heartbeat response has content.
+    const int contentLength = prop.getValue("Content-length", 0);
+    if (contentLength < 0 || kMaxRequestResponseHeader < contentLength) {
+        KFS_LOG_STREAM_ERROR << ServerID() <<
+            " invalid response content length: " << contentLength <<
+        KFS_LOG_EOM;
+        return -1;
+    }
+    if (iobuf->BytesConsumable() < msgLen + contentLength) {
+        return 1; // Need more data.
+    }
     // Message is ready to be pushed down.  So remove it.
     iobuf->Consume(msgLen);
 
@@ -1115,6 +1203,7 @@ ChunkServer::HandleReply(IOBuffer* iobuf, int msgLen)
         KFS_LOG_STREAM_INFO << ServerID() <<
             " unable to find command for response cseq: " << cseq <<
         KFS_LOG_EOM;
+        iobuf->Consume(contentLength);
         return 0;
     }
 
@@ -1122,25 +1211,68 @@ ChunkServer::HandleReply(IOBuffer* iobuf, int msgLen)
     op->statusMsg = prop.getValue("Status-message", "");
     op->status    = prop.getValue("Status",         -1);
     op->handleReply(prop);
-    if (op->op == META_CHUNK_HEARTBEAT) {
-        mTotalSpace        = prop.getValue("Total-space",           int64_t(0));
-        mTotalFsSpace      = prop.getValue("Total-fs-space",       int64_t(-1));
-        mUsedSpace         = prop.getValue("Used-space",            int64_t(0));
-        mNumChunks         = prop.getValue("Num-chunks",                     0);
-        mNumDrives         = prop.getValue("Num-drives",                     0);
-        mUptime            = prop.getValue("Uptime",                int64_t(0));
-        mLostChunks        = prop.getValue("Chunk-lost",            int64_t(0));
-        mNumCorruptChunks  = max(mNumCorruptChunks,
-            prop.getValue("Chunk-corrupted", int64_t(0)));
-        mNumAppendsWithWid = prop.getValue("Num-appends-with-wids", int64_t(0));
-        mEvacuateCnt       = prop.getValue("Evacuate",              int64_t(-1));
-        mEvacuateBytes     = prop.getValue("Evacuate-bytes",        int64_t(-1));
-        mEvacuateDoneCnt   = prop.getValue("Evacuate-done",         int64_t(-1));
-        mEvacuateDoneBytes = prop.getValue("Evacuate-done-bytes",   int64_t(-1));
-        mEvacuateInFlight  = prop.getValue("Evacuate-in-flight",    int64_t(-1));
+    const bool hbFlag      = op->op == META_CHUNK_HEARTBEAT;
+    bool       hbValidFlag = hbFlag;
+    if (! hbFlag && 0 < contentLength) {
+        istream& is = mIStream.Set(*iobuf, contentLength);
+        if (! op->handleReplyContent(is)) {
+            KFS_LOG_STREAM_ERROR << ServerID() <<
+                " invalid response content: " << op->statusMsg <<
+                " " << op->Show() <<
+            KFS_LOG_EOM;
+        }
+        mIStream.Reset();
+    }
+    if (hbValidFlag) {
+        mHeartbeatCounterCount = 0;
+        if (0 < contentLength && 0 < prop.getValue("Hb-fmt", 0)) {
+            hbValidFlag = ParseBinaryHeartbeat(*iobuf, contentLength, cseq);
+        } else {
+            mHeartbeatSeq = -1;
+        }
+    }
+    iobuf->Consume(contentLength);
+    if (hbFlag) {
+        // The server is responsive even if the heartbeat content is invalid,
+        // only the counters update is skipped in this case.
+        mHeartbeatSent    = false;
+        mHeartbeatSkipped =
+            mLastHeartbeatSent + sHeartbeatInterval < mLastHeard;
+    }
+    if (hbValidFlag) {
+        mTotalSpace        = GetHeartbeatValue(
+            prop, CS_HB_TOTAL_SPACE,           int64_t(0));
+        mTotalFsSpace      = GetHeartbeatValue(
+            prop, CS_HB_TOTAL_FS_SPACE,        int64_t(-1));
+        mUsedSpace         = GetHeartbeatValue(
+            prop, CS_HB_USED_SPACE,            int64_t(0));
+        mNumChunks         = GetHeartbeatValue(
+            prop, CS_HB_NUM_CHUNKS,            0);
+        mNumDrives         = GetHeartbeatValue(
+            prop, CS_HB_NUM_DRIVES,            0);
+        mUptime            = GetHeartbeatValue(
+            prop, CS_HB_UPTIME,                int64_t(0));
+        mLostChunks        = GetHeartbeatValue(
+            prop, CS_HB_CHUNK_LOST,            int64_t(0));
+        mNumCorruptChunks  = max(mNumCorruptChunks, GetHeartbeatValue(
+            prop, CS_HB_CHUNK_CORRUPTED,       int64_t(0)));
+        mNumAppendsWithWid = GetHeartbeatValue(
+            prop, CS_HB_NUM_APPENDS_WITH_WIDS, int64_t(0));
+        mEvacuateCnt       = GetHeartbeatValue(
+            prop, CS_HB_EVACUATE,              int64_t(-1));
+        mEvacuateBytes     = GetHeartbeatValue(
+            prop, CS_HB_EVACUATE_BYTES,        int64_t(-1));
+        mEvacuateDoneCnt   = GetHeartbeatValue(
+            prop, CS_HB_EVACUATE_DONE,         int64_t(-1));
+        mEvacuateDoneBytes = GetHeartbeatValue(
+            prop, CS_HB_EVACUATE_DONE_BYTES,   int64_t(-1));
+        mEvacuateInFlight  = GetHeartbeatValue(
+            prop, CS_HB_EVACUATE_IN_FLIGHT,    int64_t(-1));
+        mReplicationCapacity = min(16., GetHeartbeatValue(
+            prop, CS_HB_REPLICATION_CAPACITY,  -1.));
         UpdateChunkWritesPerDrive(
-            max(0, prop.getValue("Num-writable-chunks", 0)),
-                   prop.getValue("Num-wr-drives",       mNumDrives)
+            max(0, GetHeartbeatValue(prop, CS_HB_NUM_WRITABLE_CHUNKS, 0)),
+                   GetHeartbeatValue(prop, CS_HB_NUM_WR_DRIVES, mNumDrives)
         );
                 if (mEvacuateInFlight == 0) {
             mChunksToEvacuate.Clear();
@@ -1166,8 +1298,9 @@ ChunkServer::HandleReply(IOBuffer* iobuf, int msgLen)
             mPrevEvacuateDoneCnt        = mEvacuateDoneCnt;
             mPrevEvacuateDoneBytes      = mEvacuateDoneBytes;
         }
-        const int64_t srvLoad =
-            prop.getValue(sSrvLoadPropName, int64_t(0));
+        const int64_t srvLoad = mHeartbeatCounterCount <= 0 ?
+            prop.getValue(sSrvLoadPropName, int64_t(0)) :
+            GetHeartbeatValue(prop, sSrvLoadCounterId, int64_t(0));
         int64_t loadAvg;
         if (sSrvLoadSamplerSampleCount > 0) {
             if (mSrvLoadSampler.GetMaxSamples() !=
@@ -1193,10 +1326,10 @@ ChunkServer::HandleReply(IOBuffer* iobuf, int msgLen)
             loadAvg = 0;
         }
         mAllocSpace       = mUsedSpace + mNumChunkWrites * CHUNKSIZE;
-        mHeartbeatSent    = false;
-        mHeartbeatSkipped =
-            mLastHeartbeatSent + sHeartbeatInterval < now;
-        mHeartbeatProperties.swap(prop);
+        if (mHeartbeatCounterCount <= 0) {
+            mHeartbeatProperties.swap(prop);
+        }
+        mHeartbeatPropertiesStaleFlag = 0 < mHeartbeatCounterCount;
         if (mTotalFsSpace < mTotalSpace) {
             mTotalFsSpace = mTotalSpace;
         }
@@ -1208,7 +1341,7 @@ ChunkServer::HandleReply(IOBuffer* iobuf, int msgLen)
                 sHeartbeatLogInterval <= mLastHeard) {
             mLastHeartBeatLoggedTime = mLastHeard;
             string hbp;
-            mHeartbeatProperties.getList(hbp, " ", "");
+            HeartBeatProperties().getList(hbp, " ", "");
             KFS_LOG_STREAM_INFO <<
                 "===chunk=server: " << mLocation.hostname <<
                 ":" << mLocation.port <<
@@ -1230,30 +1363,90 @@ ChunkServer::HandleReply(IOBuffer* iobuf, int msgLen)
 /// Status: <status> \r\n
 /// {<other header/value pair>\r\n}*\r\n
 ///
-/// @param[in] buf Buffer containing the response
-/// @param[in] bufLen length of buf
+/// @param[in] iobuf Buffer containing the response
+/// @param[in] msgLen length of the response header
 /// @param[out] prop  Properties object with the response header/values
 ///
 bool
-ChunkServer::ParseResponse(istream& is, Properties &prop)
+ChunkServer::ParseResponse(IOBuffer& iobuf, int msgLen, Properties& prop)
 {
-    string token;
-    is >> token;
+    // Main thread's buffer.
+    static char tempBuf[kMaxRequestResponseHeader];
+
+    if (msgLen <= 0 || msgLen > kMaxRequestResponseHeader) {
+        KFS_LOG_STREAM_ERROR << ServerID() <<
+            " invalid response header length: " << msgLen <<
+        KFS_LOG_EOM;
+        return false;
+    }
+    // Copy only if the header spans more than one io buffer.
+    int               len = msgLen;
+    const char* const buf = iobuf.CopyOutOrGetBufPtr(tempBuf, len);
+    const char*       ptr = buf;
+    const char* const end = buf + len;
+    while (ptr < end && (*ptr & 0xFF) <= ' ') {
+        ptr++;
+    }
     // Response better start with OK
-    if (token.compare("OK") != 0) {
-        int maxLines = 32;
-        do {
-            KFS_LOG_STREAM_ERROR << ServerID() <<
-                " bad response header: " << token <<
-            KFS_LOG_EOM;
-        } while (--maxLines > 0 && getline(is, token));
+    if (end - ptr < 2 || ptr[0] != 'O' || ptr[1] != 'K' ||
+            (ptr + 2 < end && (ptr[2] & 0xFF) > ' ')) {
+        ShowLines(MsgLogger::kLogLevelERROR,
+            ServerID() + " bad response header: ", iobuf, msgLen, 32);
         return false;
     }
+    ptr += 2;
     const char separator = ':';
-    prop.loadProperties(is, separator, false);
+    prop.loadProperties(ptr, end - ptr, separator);
     return true;
 }
 
+bool
+ChunkServer::ParseBinaryHeartbeat(IOBuffer& iobuf, int len, seq_t cseq)
+{
+    // Main thread's buffer.
+    static char tempBuf[kMaxRequestResponseHeader];
+
+    int               bufLen = len;
+    const char* const buf    = iobuf.CopyOutOrGetBufPtr(tempBuf, bufLen);
+    bool              deltaFlag = false;
+    const int         count     = bufLen == len ?
+        ChunkServerHeartbeat::Decode(buf, bufLen,
+            mHeartbeatCounters, CS_HB_COUNTERS_COUNT, deltaFlag) : -1;
+    if (count < 0 || (deltaFlag && mHeartbeatSeq < 0)) {
+        KFS_LOG_STREAM_ERROR << ServerID() <<
+            " invalid binary heartbeat:"
+            " length: " << len <<
+            " count: "  << count <<
+            " delta: "  << deltaFlag <<
+        KFS_LOG_EOM;
+        // Request full heartbeat next time.
+        mHeartbeatSeq = -1;
+        return false;
+    }
+    mHeartbeatSeq          = cseq;
+    mHeartbeatCounterCount = count;
+    return true;
+}
+
+void
+ChunkServer::UpdateHeartbeatProperties() const
+{
+    mHeartbeatPropertiesStaleFlag = false;
+    mHeartbeatProperties.clear();
+    ostringstream os;
+    for (int i = 0; i < mHeartbeatCounterCount; i++) {
+        os.str(string());
+        const int scale = ChunkServerHeartbeat::GetScale(i);
+        if (scale == 1) {
+            os << mHeartbeatCounters[i];
+        } else {
+            os << mHeartbeatCounters[i] / (double)scale;
+        }
+        mHeartbeatProperties.setValue(
+            ChunkServerHeartbeat::GetName(i), os.str());
+    }
+}
+
 ///
 /// Request/responses are matched based on sequence #'s.
 ///
@@ -1286,6 +1479,10 @@ ChunkServer::Enqueue(MetaChunkRequest* r, int timeout /* = -1 */)
     if (r->submitCount++ == 0) {
         r->submitTime = microseconds();
     }
+    if (! mPendingDeletes.IsEmpty() && r->op != META_CHUNK_BULK_DELETE) {
+        // Preserve the RPC order: the deletes must be sent first.
+        FlushDeletes();
+    }
     if (mDown || ! mNetConnection || ! mNetConnection->IsGood()) {
         r->status = -EIO;
         r->resume();
@@ -1340,10 +1537,49 @@ ChunkServer::DeleteChunk(chunkId_t chunkId)
 {
     mAllocSpace = max((int64_t)0, mAllocSpace - (int64_t)CHUNKSIZE);
     mChunksToEvacuate.Erase(chunkId);
-    Enqueue(new MetaChunkDelete(NextSeq(), shared_from_this(), chunkId));
+    if (! mBulkDeleteFlag || sMaxBulkDeleteChunks <= 1 || mDown) {
+        Enqueue(new MetaChunkDelete(NextSeq(), shared_from_this(), chunkId));
+        return 0;
+    }
+    mPendingDeletes.PushBack(chunkId);
+    if ((int)mPendingDeletes.GetSize() >= sMaxBulkDeleteChunks) {
+        FlushDeletes();
+    } else if (! PendingDeleteList::IsInList(sChunkServersPtr, *this)) {
+        PendingDeleteList::PushBack(sChunkServersPtr, *this);
+        PendingDeletesFlusher::Schedule();
+    }
     return 0;
 }
 
+void
+ChunkServer::FlushDeletes()
+{
+    PendingDeleteList::Remove(sChunkServersPtr, *this);
+    if (mPendingDeletes.IsEmpty()) {
+        return;
+    }
+    MetaChunkBulkDelete* const r = new MetaChunkBulkDelete(
+        NextSeq(), shared_from_this(), mStaleChunksHexFormatFlag);
+    r->chunkIds.Swap(mPendingDeletes);
+    Enqueue(r);
+}
+
+void
+ChunkServer::ClearPendingDeletes()
+{
+    PendingDeleteList::Remove(sChunkServersPtr, *this);
+    mPendingDeletes.Clear();
+}
+
+/* static */ void
+ChunkServer::FlushPendingDeletes()
+{
+    ChunkServer* ptr;
+    while ((ptr = PendingDeleteList::Front(sChunkServersPtr))) {
+        ptr->FlushDeletes();
+    }
+}
+
 int
 ChunkServer::GetChunkSize(fid_t fid, chunkId_t chunkId, seq_t chunkVersion,
     const string &pathname, bool retryFlag)
@@ -1522,7 +1758,10 @@ ChunkServer::Heartbeat()
         mLastHeartbeatSent = now;
         Enqueue(new MetaChunkHeartbeat(NextSeq(), shared_from_this(),
                 IsRetiring() ? int64_t(1) :
-                    (int64_t)mChunksToEvacuate.Size()),
+                    (int64_t)mChunksToEvacuate.Size(),
+                sBinaryHeartbeatFlag ?
+                    (int)ChunkServerHeartbeat::kSchemaVersion : 0,
+                mHeartbeatSeq),
             2 * sHeartbeatTimeout);
         return ((sHeartbeatTimeout >= 0 &&
                 sHeartbeatTimeout < sHeartbeatInterval) ?
@@ -46,6 +46,7 @@
 #include "common/ValueSampler.h"
 #include "common/StdAllocator.h"
 #include "common/MsgLogger.h"
+#include "common/ChunkServerHeartbeat.h"
 #include "MetaRequest.h"
 
 #include <string>
@@ -282,6 +283,10 @@ public:
     /// An RPC request is enqueued and the call returns.
     /// When the server replies to the RPC, the request
     /// processing resumes.
+    /// If chunk server supports bulk delete, the chunk id is queued,
+    /// and sent with other queued chunk ids in a single bulk delete RPC
+    /// once the queue is full, before the next RPC to this server, or
+    /// at the end of the current network event loop iteration.
     /// @param[in] chunkId name of the chunk that is being
     ///  deleted.
     /// @retval 0 on success; -1 on failure
@@ -337,6 +342,15 @@ public:
         return mNumChunkReadReplications;
     }
 
+    /// Max. number of concurrent replications scaled by the replication
+    /// capacity that the chunk server reports in the heartbeat response. The
+    /// chunk server adjusts the capacity based on the client request latency
+    /// and disk queue depth.
+    int GetReplicationLimit(int maxCount) const {
+        return (mReplicationCapacity < 0 ? maxCount :
+            max(1, (int)(maxCount * mReplicationCapacity + 0.5)));
+    }
+
     void UpdateReplicationReadLoad(int count) {
         mNumChunkReadReplications += count;
         if (mNumChunkReadReplications < 0)
@@ -554,6 +568,9 @@ public:
         return mDownReason;
     }
     const Properties& HeartBeatProperties() const {
+        if (mHeartbeatPropertiesStaleFlag) {
+            UpdateHeartbeatProperties();
+        }
         return mHeartbeatProperties;
     }
     int64_t GetLoadAvg() const {
@@ -613,6 +630,7 @@ public:
         return sMaxHelloBufferBytes;
     }
     static bool RunHelloBufferQueue();
+    static void FlushPendingDeletes();
 
 protected:
     /// Enqueue a request to be dispatched to this server
@@ -655,7 +673,10 @@ protected:
     static bool   sRestartCSOnInvalidClusterKeyFlag;
     static int    sSrvLoadSamplerSampleCount;
     static string sSrvLoadPropName;
+    static int    sSrvLoadCounterId;
     static size_t sMaxChunksToEvacuate;
+    static bool   sBinaryHeartbeatFlag;
+    static int    sMaxBulkDeleteChunks;
 
     /// For record append's, can this node be a chunk master
     bool mCanBeChunkMaster;
@@ -737,6 +758,9 @@ protected:
     /// Track the # of chunk replications (write/read) that are going on this server
     int mNumChunkWriteReplications;
     int mNumChunkReadReplications;
+    /// Replication capacity reported by the chunk server, negative if not
+    /// reported.
+    double mReplicationCapacity;
 
     typedef multimap <
         time_t,
@@ -763,13 +787,23 @@ protected:
         StdFastAllocator<string>
     > LostChunkDirs;
 
-    enum { kChunkSrvListsCount = 2 };
+    enum { kChunkSrvListsCount = 3 };
     /// RPCs that we have sent to this chunk server.
     DispatchedReqs     mDispatchedReqs;
     ReqsTimeoutQueue   mReqsTimeoutQueue;
     int64_t            mLostChunks;
     int64_t            mUptime;
-    Properties         mHeartbeatProperties;
+    /// Heartbeat counters, the properties are created from the binary
+    /// heartbeat counters on demand.
+    mutable Properties mHeartbeatProperties;
+    mutable bool       mHeartbeatPropertiesStaleFlag;
+    /// Response header, re-used to parse responses without allocations.
+    Properties         mReplyProperties;
+    /// Last binary heartbeat sequence, and counters. The counters are the
+    /// base for the next delta encoded heartbeat.
+    seq_t              mHeartbeatSeq;
+    int                mHeartbeatCounterCount;
+    ChunkServerHeartbeat::Counter mHeartbeatCounters[CS_HB_COUNTERS_COUNT];
     bool               mRestartScheduledFlag;
     bool               mRestartQueuedFlag;
     time_t             mRestartScheduledTime;
@@ -783,6 +817,8 @@ protected:
     int64_t            mLoadAvg;
     bool               mCanBeCandidateServerFlag;
     bool               mStaleChunksHexFormatFlag;
+    bool               mBulkDeleteFlag;
+    ChunkIdQueue       mPendingDeletes;
     IOBuffer::IStream  mIStream;
     int64_t            mEvacuateCnt;
     int64_t            mEvacuateBytes;
@@ -811,11 +847,15 @@ protected:
 
     friend class QCDLListOp<ChunkServer, 0>;
     friend class QCDLListOp<ChunkServer, 1>;
+    friend class QCDLListOp<ChunkServer, 2>;
     typedef QCDLList<ChunkServer, 0> ChunkServersList;
     typedef QCDLList<ChunkServer, 1> PendingHelloList;
+    typedef QCDLList<ChunkServer, 2> PendingDeleteList;
 
     void AddToPendingHelloList();
     void RemoveFromPendingHelloList();
+    void FlushDeletes();
+    void ClearPendingDeletes();
     static int64_t GetHelloBytes(MetaHello* req = 0);
     static void PutHelloBytes(MetaHello* req);
 
@@ -868,7 +908,22 @@ protected:
     /// @param[in] bufLen length of buf
     /// @param[out] prop  Properties object with the response header/values
     ///
-    bool ParseResponse(istream& is, Properties &prop);
+    bool ParseResponse(IOBuffer& iobuf, int msgLen, Properties& prop);
+    bool ParseBinaryHeartbeat(IOBuffer& iobuf, int len, seq_t cseq);
+    void UpdateHeartbeatProperties() const;
+    template<typename T> T GetHeartbeatValue(
+        const Properties& prop, int id, T def) const
+    {
+        if (mHeartbeatCounterCount <= 0) {
+            return prop.getValue(ChunkServerHeartbeat::GetName(id), def);
+        }
+        if (id < 0 || mHeartbeatCounterCount <= id) {
+            return def;
+        }
+        const int scale = ChunkServerHeartbeat::GetScale(id);
+        return (scale == 1 ? (T)mHeartbeatCounters[id] :
+            (T)(mHeartbeatCounters[id] / (double)scale));
+    }
     ///
     /// The chunk server went down.  So, stop the network timer event;
     /// also, fail all the dispatched ops.
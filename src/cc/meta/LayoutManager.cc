@@ -61,6 +61,7 @@ using std::for_each;
 using std::find;
 using std::sort;
 using std::unique;
+using std::binary_search;
 using std::random_shuffle;
 using std::vector;
 using std::min;
@@ -600,6 +601,10 @@ ChunkLeases::ExpiredCleanup(
     }
     if (appendFlag) {
         arac.Invalidate(ci->GetFileId(), chunkId);
+    } else if (mTimerRunningFlag && ! stripedFileFlag &&
+            gLayoutManager.AllocateAheadExpired(ci->GetFileId(), chunkId)) {
+        // Unused chunk allocated ahead, will be deleted.
+        return true;
     }
     const bool leaseRelinquishFlag = true;
     gLayoutManager.MakeChunkStableInit(
@@ -1254,6 +1259,8 @@ LayoutManager::LayoutManager() :
     mInRackPlacementForAppendFlag(false),
     mInRackPlacementFlag(false),
     mAllocateDebugVerifyFlag(false),
+    mMaxAllocateAheadCount(8),
+    mRebalanceSrcRackIds(),
     mChunkEntryToChange(0),
     mFattrToChangeTo(0),
     mCSLoadAvgSum(0),
@@ -1592,6 +1599,9 @@ LayoutManager::SetParameters(const Properties& props, int clientPort)
     mAllocateDebugVerifyFlag = props.getValue(
         "metaServer.allocateDebugVerify",
         mAllocateDebugVerifyFlag ? 1 : 0) != 0;
+    mMaxAllocateAheadCount = max(0, props.getValue(
+        "metaServer.maxAllocateAheadCount",
+        mMaxAllocateAheadCount));
     mGetAllocOrderServersByLoadFlag = props.getValue(
         "metaServer.getAllocOrderServersByLoad",
         mGetAllocOrderServersByLoadFlag ? 1 : 0) != 0;
@@ -2975,7 +2985,8 @@ typedef LinearHash<
 > MetaFattrSet;
 
 void
-LayoutManager::Fsck(ostream& os, bool reportAbandonedFilesFlag)
+LayoutManager::Fsck(ostream& os, bool reportAbandonedFilesFlag,
+    int64_t maxFsckFiles, int64_t maxFsckTime, FsckProgress* progress)
 {
     // Do full scan, for added safety: the replication lists don't have to
     // be correct / up to date.
@@ -2989,20 +3000,25 @@ LayoutManager::Fsck(ostream& os, bool reportAbandonedFilesFlag)
         "Abandoned"
     };
     MetaFattrSet  files[kSetCount];
-    int64_t       maxFilesToReport       = mMaxFsckFiles;
+    int64_t       maxFilesToReport       = maxFsckFiles;
     const int64_t startTime              = microseconds();
     const int64_t pastEofRecoveryEndTime = startTime -
         mPastEofRecoveryDelay;
     const int64_t abandonedFileEndTime   = startTime -
         mFsckAbandonedFileTimeout;
-    const int64_t maxEndTime             = startTime + mMaxFsckTime;
+    const int64_t maxEndTime             = startTime + maxFsckTime;
     unsigned int  timeCheckCnt           = 0;
+    int64_t       chunksChecked          = 0;
     bool          timedOutFlag           = false;
     vector<MetaChunkInfo*> cblk;
     mChunkToServerMap.First();
     for (const CSMap::Entry* p;
             (p = mChunkToServerMap.Next()) &&
             maxFilesToReport > 0; ) {
+        if (progress) {
+            progress->chunksChecked  = ++chunksChecked;
+            progress->lostFilesCount = files[kLostSet].GetSize();
+        }
         const size_t serverCnt = mChunkToServerMap.ServerCount(*p);
         if (serverCnt <= 0 ||
                 (reportAbandonedFilesFlag &&
@@ -3086,11 +3102,14 @@ LayoutManager::Fsck(ostream& os, bool reportAbandonedFilesFlag)
     }
     if (maxFilesToReport <= 0) {
         os << "Warning: report limited to first: " <<
-            mMaxFsckFiles << " files\n";
+            maxFsckFiles << " files\n";
     }
     if (timedOutFlag) {
         os << "Warning: report limited due to reaching time"
-            " limit of: " << (mMaxFsckTime * 1e-6) << " seconds\n";
+            " limit of: " << (maxFsckTime * 1e-6) << " seconds\n";
+    }
+    if (progress) {
+        progress->lostFilesCount = files[kLostSet].GetSize();
     }
     os << "Fsck run time: " <<
         ((microseconds() - startTime) * 1e-6) << " sec.\n";
@@ -3117,6 +3136,7 @@ class LayoutManager::FilesChecker
 {
 public:
     typedef LayoutManager::ChunkPlacement ChunkPlacement;
+    typedef LayoutManager::FsckProgress   FsckProgress;
 
     enum Status
     {
@@ -3136,10 +3156,14 @@ public:
     FilesChecker(
         LayoutManager&  layoutManager,
         int64_t         maxFilesToReport,
-        ostream**       os)
+        int64_t         maxRunTime,
+        ostream**       os,
+        FsckProgress*   progress)
         : mLayoutManager(layoutManager),
           mPlacement(),
+          mProgress(progress),
           mStartTime(microseconds()),
+          mMaxRunTime(maxRunTime),
           mMaxToReportFileCount(maxFilesToReport),
           mPath(),
           mDepth(0),
@@ -3199,6 +3223,9 @@ public:
         mTotalFilesSize += fsize;
         mMaxChunkCount   = max(mMaxChunkCount, fa.chunkcount());
         mFileCount++;
+        if (mProgress) {
+            mProgress->filesChecked = mFileCount;
+        }
         if (fa.HasRecovery()) {
             mFilesWithRecoveryCount++;
         } else if (fa.IsStriped()) {
@@ -3214,6 +3241,9 @@ public:
         const MetaFattr&  fa)
     {
         mFileCounts[status]++;
+        if (status == kLost && mProgress) {
+            mProgress->lostFilesCount = mFileCounts[kLost];
+        }
         if (mOs[status] == 0 ||
                 mToReportFileCount++ >
                 mMaxToReportFileCount) {
@@ -3238,7 +3268,13 @@ public:
     void NoRack()               { mNoRackCount++; }
     void RecoveryBlock()        { mRecoveryBlock++; }
     void PartialRecoveryBlock() { mPartialRecoveryBlock++; }
-    void Chunk()                { mTotalChunkCount++; }
+    void Chunk()
+    {
+        mTotalChunkCount++;
+        if (mProgress) {
+            mProgress->chunksChecked = mTotalChunkCount;
+        }
+    }
     void ChunkLost()            { mChunkLostCount++; }
     void ChunkReplicas(size_t cnt)
     {
@@ -3247,6 +3283,7 @@ public:
     }
     ChunkPlacement& GetPlacement() { return mPlacement; }
     int64_t StartTime() const      { return mStartTime; }
+    int64_t MaxRunTime() const     { return mMaxRunTime; }
     int64_t GetFileCount() const   { return mFileCount; }
     int64_t ItemsCount() const
         { return (mTotalChunkCount + (int64_t)mFileCount); }
@@ -3361,9 +3398,11 @@ private:
 
     LayoutManager& mLayoutManager;
     ChunkPlacement mPlacement;
+    FsckProgress*  mProgress;
     ostream*       mOs[kStateCount];
     size_t         mFileCounts[kStateCount];
     const int64_t  mStartTime;
+    const int64_t  mMaxRunTime;
     const int64_t  mMaxToReportFileCount;
     Path           mPath;
     size_t         mDepth;
@@ -3455,7 +3494,7 @@ LayoutManager::CheckFile(
             }
             fsck.Chunk();
             if ((fsck.ItemsCount() & kScanCheckMask) == 0 &&
-                    fsck.StartTime() + mMaxFsckTime <
+                    fsck.StartTime() + fsck.MaxRunTime() <
                     microseconds()) {
                 stopFlag = true;
                 break;
@@ -3537,12 +3576,12 @@ LayoutManager::CheckFile(
         fsck.Report(status, de, fa);
     } else if (chunkBlockCount <= 0) {
         stopFlag = (fsck.ItemsCount() & kScanCheckMask) == 0 &&
-            fsck.StartTime() + mMaxFsckTime < microseconds();
+            fsck.StartTime() + fsck.MaxRunTime() < microseconds();
     }
     if (stopFlag) {
         ostringstream os;
         os << "exceeded fsck run time limit of " <<
-            (mMaxFsckTime * 1e-6) << " sec.";
+            (fsck.MaxRunTime() * 1e-6) << " sec.";
         fsck.Stop(os.str());
     }
 }
@@ -3555,14 +3594,23 @@ LayoutManager::FsckStreamCount(bool reportAbandonedFilesFlag) const
 }
 
 void
-LayoutManager::Fsck(ostream** os, bool reportAbandonedFilesFlag)
+LayoutManager::Fsck(ostream** os, bool reportAbandonedFilesFlag,
+    FsckProgress* progress, bool unlimitedFlag)
 {
+    const int64_t kUnlimited   = int64_t(1) << 62;
+    const int64_t maxFsckFiles = unlimitedFlag ? kUnlimited : mMaxFsckFiles;
+    const int64_t maxFsckTime  = unlimitedFlag ? kUnlimited : mMaxFsckTime;
+    if (progress) {
+        progress->filesCount  = GetNumFiles();
+        progress->chunksCount = mChunkToServerMap.Size();
+    }
     if (mFullFsckFlag) {
-        FilesChecker fsck(*this, mMaxFsckFiles, os);
+        FilesChecker fsck(*this, maxFsckFiles, maxFsckTime, os, progress);
         metatree.iterateDentries(fsck);
         fsck.Report(mChunkToServerMap.Size());
     } else if (os && os[0]) {
-        Fsck(*(os[0]), reportAbandonedFilesFlag);
+        Fsck(*(os[0]), reportAbandonedFilesFlag,
+            maxFsckFiles, maxFsckTime, progress);
     }
 }
 
@@ -4296,7 +4344,9 @@ LayoutManager::AllocateChunk(
         r->servers[i]->AllocateChunk(r, i == 0 ? r->leaseId : -1);
     }
     // Handle possible recursion ensure that request still valid.
-    if (! r->servers.empty() && r->appendChunk && r->status >= 0) {
+    // The chunk allocated for one client is not shared with the others.
+    if (! r->servers.empty() && r->appendChunk && r->status >= 0 &&
+            ! r->appendNewChunkFlag) {
         mARAChunkCache.RequestNew(*r);
     }
     return 0;
@@ -4953,13 +5003,19 @@ LayoutManager::IsValidLeaseIssued(const vector<MetaChunkInfo*>& c)
 int
 LayoutManager::LeaseRenew(MetaLeaseRenew *req)
 {
-    if (! mChunkToServerMap.Find(req->chunkId)) {
+    const CSMap::Entry* const ci = mChunkToServerMap.Find(req->chunkId);
+    if (! ci) {
         if (InRecovery()) {
             mChunkLeases.SetMaxLeaseId(req->leaseId + 1);
         }
         return -EINVAL;
     }
-    return mChunkLeases.Renew(req->chunkId, req->leaseId);
+    const int ret = mChunkLeases.Renew(req->chunkId, req->leaseId);
+    if (ret == 0 && req->leaseType == WRITE_LEASE) {
+        // Chunk server renews write lease only if the chunk is written.
+        AllocateAheadUsed(ci->GetFileId(), req->chunkId);
+    }
+    return ret;
 }
 
 ///
@@ -5526,6 +5582,7 @@ LayoutManager::LeaseCleanup()
 
     mChunkLeases.Timer(now, mLeaseOwnerDownExpireDelay,
         mARAChunkCache, mChunkToServerMap);
+    AllocateAheadCleanup();
     if (mAppendCacheCleanupInterval >= 0) {
         // Timing out the cache entries should now be redundant,
         // and is disabled by default, as the cache should not have
@@ -5781,6 +5838,12 @@ LayoutManager::CommitOrRollBackChunkVersion(MetaAllocate* r)
 int
 LayoutManager::LeaseRelinquish(MetaLeaseRelinquish *req)
 {
+    if (req->leaseType == WRITE_LEASE) {
+        const CSMap::Entry* const ci = mChunkToServerMap.Find(req->chunkId);
+        if (ci) {
+            AllocateAheadUsed(ci->GetFileId(), req->chunkId);
+        }
+    }
     return mChunkLeases.LeaseRelinquish(
         *req, mARAChunkCache, mChunkToServerMap);
 }
@@ -6790,6 +6853,296 @@ LayoutManager::GetChunkSizeDone(MetaChunkSize* req)
     return 0;
 }
 
+void
+LayoutManager::UpdateLastChunkSize(fid_t fid)
+{
+    MetaFattr* const fa = metatree.getFattr(fid);
+    if (! fa || fa->type != KFS_FILE || fa->IsStriped() ||
+            fa->filesize >= 0 || fa->nextChunkOffset() <= 0) {
+        return;
+    }
+    MetaChunkInfo* chunk = 0;
+    if (metatree.getalloc(fid,
+            fa->nextChunkOffset() - (chunkOff_t)CHUNKSIZE, &chunk) != 0 ||
+            ! chunk) {
+        return;
+    }
+    if (! IsChunkStable(chunk->chunkId) ||
+            mChunkLeases.HasWriteLease(chunk->chunkId)) {
+        // The size will be updated by the make stable completion.
+        return;
+    }
+    StTmp<Servers> serversTmp(mServers3Tmp);
+    Servers&       srvs = serversTmp.Get();
+    mChunkToServerMap.GetServers(GetCsEntry(*chunk), srvs);
+    for (Servers::const_iterator it = srvs.begin(); it != srvs.end(); ++it) {
+        if (! (*it)->IsDown()) {
+            (*it)->GetChunkSize(fid, chunk->chunkId, chunk->chunkVersion,
+                string());
+            break;
+        }
+    }
+}
+
+void
+LayoutManager::AllocateAheadStart(const MetaAllocate& req)
+{
+    pair<int, chunkOff_t>& entry = mAllocateAheadInFlight.insert(
+        make_pair(req.fid, make_pair(0, chunkOff_t(-1)))).first->second;
+    entry.first++;
+}
+
+/*
+ * Returns true if the chunks starting from the allocation offset were deleted
+ * while the allocation was in flight, i.e. the chunk must not be added to the
+ * file.
+ */
+bool
+LayoutManager::AllocateAheadInFlightDone(const MetaAllocate& req)
+{
+    AllocateAheadInFlight::iterator const it =
+        mAllocateAheadInFlight.find(req.fid);
+    if (it == mAllocateAheadInFlight.end()) {
+        return false;
+    }
+    const bool canceledFlag =
+        0 <= it->second.second && it->second.second <= req.offset;
+    if (--(it->second.first) <= 0) {
+        mAllocateAheadInFlight.erase(it);
+    }
+    return canceledFlag;
+}
+
+void
+LayoutManager::AllocateAheadDone(const MetaAllocate& req)
+{
+    mAllocateAheadChunks[make_pair(req.fid, req.offset)] =
+        make_pair(req.chunkId, req.allocateAheadOwner);
+}
+
+bool
+LayoutManager::IsAllocatedAhead(
+    fid_t fid, chunkOff_t offset, chunkId_t chunkId) const
+{
+    AllocateAheadChunks::const_iterator const it =
+        mAllocateAheadChunks.find(make_pair(fid, offset));
+    return (it != mAllocateAheadChunks.end() &&
+        it->second.first == chunkId &&
+        mChunkLeases.HasValidWriteLease(chunkId));
+}
+
+void
+LayoutManager::AllocateAheadUsed(fid_t fid, chunkId_t chunkId)
+{
+    if (mAllocateAheadChunks.empty()) {
+        return;
+    }
+    for (AllocateAheadChunks::iterator it = mAllocateAheadChunks.lower_bound(
+                make_pair(fid, chunkOff_t(-1)));
+            it != mAllocateAheadChunks.end() && it->first.first == fid;
+            ++it) {
+        if (it->second.first == chunkId) {
+            mAllocateAheadChunks.erase(it);
+            break;
+        }
+    }
+}
+
+/*
+ * Invoked by the lease cleaner when the write lease of a chunk expires. The
+ * chunk allocated ahead, and not used by the writer, is deleted along with all
+ * chunks past it, if all these chunks are also unused chunks allocated ahead
+ * for the same writer. Otherwise the chunk is made stable as any other chunk.
+ * Returns true if the chunk is scheduled for deletion. The delete re-checks
+ * the chunks when it executes, and makes stable the chunks it does not delete.
+ */
+bool
+LayoutManager::AllocateAheadExpired(fid_t fid, chunkId_t chunkId)
+{
+    if (mAllocateAheadChunks.empty()) {
+        return false;
+    }
+    AllocateAheadChunks::iterator it = mAllocateAheadChunks.lower_bound(
+        make_pair(fid, chunkOff_t(-1)));
+    while (it != mAllocateAheadChunks.end() && it->first.first == fid &&
+            it->second.first != chunkId) {
+        ++it;
+    }
+    if (it == mAllocateAheadChunks.end() || it->first.first != fid) {
+        return false;
+    }
+    const chunkOff_t offset = it->first.second;
+    const int64_t    owner  = it->second.second;
+    AllocateAheadReclaims::const_iterator const ri =
+        mAllocateAheadReclaims.find(fid);
+    if (ri != mAllocateAheadReclaims.end() && ri->second.second == owner &&
+            ri->second.first <= offset) {
+        return true;
+    }
+    if (AllocateAheadReclaimOffset(fid, offset, owner) != offset) {
+        mAllocateAheadChunks.erase(it);
+        return false;
+    }
+    KFS_LOG_STREAM_INFO <<
+        "allocated ahead unused:"
+        " fid: "    << fid <<
+        " chunk: "  << chunkId <<
+        " offset: " << offset <<
+        " owner: "  << owner <<
+    KFS_LOG_EOM;
+    mAllocateAheadReclaims[fid] = make_pair(offset, owner);
+    return true;
+}
+
+/*
+ * Returns the lowest offset, not less than the offset specified, starting from
+ * which all the file chunks are unused chunks allocated ahead for the owner,
+ * or -1 if the last chunk of the file is not such chunk.
+ */
+chunkOff_t
+LayoutManager::AllocateAheadReclaimOffset(
+    fid_t fid, chunkOff_t offset, int64_t owner)
+{
+    if (mAllocateAheadChunks.empty()) {
+        return -1;
+    }
+    MetaFattr* const fa = metatree.getFattr(fid);
+    if (! fa || fa->type != KFS_FILE || fa->IsStriped() ||
+            fa->nextChunkOffset() <= offset) {
+        return -1;
+    }
+    StTmp<vector<MetaChunkInfo*> > cinfoTmp(mChunkInfosTmp);
+    vector<MetaChunkInfo*>&        chunks = cinfoTmp.Get();
+    if (metatree.getalloc(fid, offset, chunks, 0) != 0) {
+        return -1;
+    }
+    chunkOff_t ret = -1;
+    for (vector<MetaChunkInfo*>::const_reverse_iterator
+            it = chunks.rbegin();
+            it != chunks.rend() && offset <= (*it)->offset;
+            ++it) {
+        AllocateAheadChunks::const_iterator const ci =
+            mAllocateAheadChunks.find(make_pair(fid, (*it)->offset));
+        if (ci == mAllocateAheadChunks.end() ||
+                ci->second.first != (*it)->chunkId ||
+                ci->second.second != owner) {
+            break;
+        }
+        ret = (*it)->offset;
+    }
+    return ret;
+}
+
+/*
+ * Invoked when the delete of the chunks allocated ahead for the owner,
+ * requested starting from the requested offset, completes. The chunks were
+ * deleted starting from the offset, if the offset is not negative. The
+ * owner's chunks with no write lease that were not deleted are made stable.
+ */
+void
+LayoutManager::AllocateAheadReclaimDone(
+    fid_t fid, int64_t owner, chunkOff_t requestedOffset, chunkOff_t offset,
+    int status)
+{
+    AllocateAheadReclaims::iterator const ri =
+        mAllocateAheadReclaims.find(fid);
+    if (ri != mAllocateAheadReclaims.end() && ri->second.second == owner &&
+            requestedOffset <= ri->second.first) {
+        if (status != 0) {
+            KFS_LOG_STREAM_ERROR <<
+                "allocated ahead chunks delete failure:"
+                " fid: "    << fid <<
+                " offset: " << requestedOffset <<
+                " owner: "  << owner <<
+                " status: " << status <<
+            KFS_LOG_EOM;
+        }
+        mAllocateAheadReclaims.erase(ri);
+    }
+    if (status == 0) {
+        // The allocations in flight were not sent to the writers yet, and
+        // can be canceled regardless of the owner.
+        AllocateAheadInFlight::iterator const it =
+            mAllocateAheadInFlight.find(fid);
+        if (it != mAllocateAheadInFlight.end() &&
+                (it->second.second < 0 ||
+                    requestedOffset < it->second.second)) {
+            it->second.second = requestedOffset;
+        }
+    }
+    const bool kBeginMakeStableFlag = false;
+    const bool kStripedFileFlag     = false;
+    const bool kAppendFlag          = false;
+    const bool kLeaseRelinquishFlag = true;
+    for (AllocateAheadChunks::iterator it = mAllocateAheadChunks.lower_bound(
+                make_pair(fid, requestedOffset));
+            it != mAllocateAheadChunks.end() && it->first.first == fid; ) {
+        if (status == 0 && 0 <= offset && offset <= it->first.second) {
+            mAllocateAheadChunks.erase(it++);
+            continue;
+        }
+        const chunkId_t chunkId = it->second.first;
+        if (it->second.second != owner ||
+                mChunkLeases.HasWriteLease(chunkId)) {
+            ++it;
+            continue;
+        }
+        mAllocateAheadChunks.erase(it++);
+        CSMap::Entry* const cmi = mChunkToServerMap.Find(chunkId);
+        if (! cmi || cmi->GetFileId() != fid) {
+            continue;
+        }
+        MakeChunkStableInit(
+            *cmi,
+            cmi->GetChunkInfo()->chunkVersion,
+            string(),
+            kBeginMakeStableFlag,
+            -1,
+            false,
+            0,
+            kStripedFileFlag,
+            kAppendFlag,
+            kLeaseRelinquishFlag
+        );
+    }
+}
+
+/*
+ * Delete the unused chunks allocated ahead found by the lease cleanup, and
+ * discard the entries with no write lease, i.e. the chunks that were deleted,
+ * or made stable.
+ */
+void
+LayoutManager::AllocateAheadCleanup()
+{
+    if (! mAllocateAheadReclaims.empty()) {
+        const vector<pair<fid_t, pair<chunkOff_t, int64_t> > > reclaims(
+            mAllocateAheadReclaims.begin(), mAllocateAheadReclaims.end());
+        for (vector<pair<fid_t, pair<chunkOff_t, int64_t> > >::const_iterator
+                it = reclaims.begin();
+                it != reclaims.end();
+                ++it) {
+            MetaTruncate& req = *(new MetaTruncate());
+            req.fid                = it->first;
+            req.offset             = it->second.first;
+            req.allocateAheadOwner = it->second.second;
+            req.reclaimChunksFlag  = true;
+            req.reclaimExpiredFlag = true;
+            submit_request(&req);
+        }
+    }
+    for (AllocateAheadChunks::iterator it = mAllocateAheadChunks.begin();
+            it != mAllocateAheadChunks.end(); ) {
+        if (mChunkLeases.HasWriteLease(it->second.first) ||
+                mAllocateAheadReclaims.find(it->first.first) !=
+                    mAllocateAheadReclaims.end()) {
+            ++it;
+        } else {
+            mAllocateAheadChunks.erase(it++);
+        }
+    }
+}
+
 bool
 LayoutManager::IsChunkStable(chunkId_t chunkId)
 {
@@ -6913,7 +7266,8 @@ LayoutManager::ReplicateChunk(
                 reason     = "evacuation recovery";
                 dataServer = c;
             } else if (ds.GetReplicationReadLoad() <
-                    mMaxConcurrentReadReplicationsPerNode &&
+                    ds.GetReplicationLimit(
+                        mMaxConcurrentReadReplicationsPerNode) &&
                     (ds.IsResponsiveServer() ||
                         servers.size() <= 1)) {
                 dataServer = *iter;
@@ -6931,7 +7285,8 @@ LayoutManager::ReplicateChunk(
                 ++si) {
             ChunkServer& ss = **si;
             if (ss.GetReplicationReadLoad() >=
-                    mMaxConcurrentReadReplicationsPerNode ||
+                    ss.GetReplicationLimit(
+                        mMaxConcurrentReadReplicationsPerNode) ||
                     ! ss.IsResponsiveServer()) {
                 continue;
             }
@@ -7113,7 +7468,8 @@ LayoutManager::CanReplicateChunkNow(
                 recoveryInfo &&
                 servers.size() == 1 &&
                 servers.front()->GetReplicationReadLoad() >=
-                    mMaxConcurrentReadReplicationsPerNode &&
+                    servers.front()->GetReplicationLimit(
+                        mMaxConcurrentReadReplicationsPerNode) &&
                 servers.front()->IsEvacuationScheduled(chunkId) &&
                 fa->numReplicas == 1 &&
                 fa->HasRecovery())) {
@@ -7415,7 +7771,8 @@ LayoutManager::CountServersAvailForReReplication() const
             continue;
         }
         if (cs.GetNumChunkReplications() >=
-                mMaxConcurrentWriteReplicationsPerNode) {
+                cs.GetReplicationLimit(
+                    mMaxConcurrentWriteReplicationsPerNode)) {
             continue;
         }
         anyAvail++;
@@ -7737,7 +8094,8 @@ LayoutManager::ChunkReplicationDone(MetaChunkReplicate* req)
             (int64_t)mChunkServers.size() *
                 mMaxConcurrentWriteReplicationsPerNode) ||
             (req->server->GetNumChunkReplications() * 5 / 4 <
-                mMaxConcurrentWriteReplicationsPerNode &&
+                req->server->GetReplicationLimit(
+                    mMaxConcurrentWriteReplicationsPerNode) &&
             ! req->server->IsRetiring() &&
             ! req->server->IsDown())) {
         mChunkReplicator.ScheduleNext();
@@ -8418,23 +8776,28 @@ LayoutManager::RebalanceServers()
                 ++it) {
             ChunkServer& srv = **it;
             if (srv.GetReplicationReadLoad() <
-                    mMaxConcurrentReadReplicationsPerNode &&
+                    srv.GetReplicationLimit(
+                        mMaxConcurrentReadReplicationsPerNode) &&
                     srv.IsResponsiveServer()) {
                 srcCnt++;
             }
-            if (srvPos < 0 &&
+            const bool canMoveFlag = mRebalanceSrcRackIds.empty() ||
+                binary_search(mRebalanceSrcRackIds.begin(),
+                    mRebalanceSrcRackIds.end(), srv.GetRack());
+            if (srvPos < 0 && canMoveFlag &&
                     (placement.IsServerExcluded(srv) &&
                     placement.GetExcludedServersCount() <
                     mChunkServers.size())) {
                 srvPos = (int)(it - srvs.begin());
             }
             if (! placement.ExcludeServerAndRack(srv, cid) &&
+                        canMoveFlag &&
                         rackPos < 0 &&
                         placement.SearchCandidateRacks()
                         ) {
                 rackPos = (int)(it - srvs.begin());
             }
-            if (srvPos >= 0 || rackPos >= 0) {
+            if (srvPos >= 0 || rackPos >= 0 || ! canMoveFlag) {
                 continue;
             }
             const double util =
@@ -8720,7 +9083,8 @@ LayoutManager::ExecuteRebalancePlan(
     size_t                  curScan = chunksToMove.Size();
     while (maxScan > 0 && curScan > 0) {
         if (c->GetNumChunkReplications() >=
-                mMaxConcurrentWriteReplicationsPerNode) {
+                c->GetReplicationLimit(
+                    mMaxConcurrentWriteReplicationsPerNode)) {
             mRebalanceCtrs.PlanNoDest();
             break;
         }
@@ -8764,7 +9128,8 @@ LayoutManager::ExecuteRebalancePlan(
                 break;
             }
             if ((*ci)->GetReplicationReadLoad() <
-                    mMaxConcurrentReadReplicationsPerNode &&
+                    (*ci)->GetReplicationLimit(
+                        mMaxConcurrentReadReplicationsPerNode) &&
                     (*ci)->IsResponsiveServer()) {
                 srcCnt++;
             }
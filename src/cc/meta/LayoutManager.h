@@ -821,6 +821,27 @@ public:
     int WritePendingMakeStable(ostream& os) const;
     void CancelPendingMakeStable(fid_t fid, chunkId_t chunkId);
     int GetChunkSizeDone(MetaChunkSize* req);
+    /// Request the last chunk size, if the file size is not known, in order
+    /// to restore the file size after the chunks past the end are deleted.
+    void UpdateLastChunkSize(fid_t fid);
+    /// Chunks allocated ahead for sequential writers tracking. The chunk is
+    /// considered used once the writer allocates it, or the chunk server
+    /// renews or relinquishes its write lease. The unused chunks at the end
+    /// of the file are deleted by the lease cleaner when their write leases
+    /// expire, or by the writer on close. Only the chunks allocated ahead for
+    /// the same writer (owner), that are still unused at the time the delete
+    /// executes, are deleted.
+    void AllocateAheadStart(const MetaAllocate& req);
+    bool AllocateAheadInFlightDone(const MetaAllocate& req);
+    void AllocateAheadDone(const MetaAllocate& req);
+    bool IsAllocatedAhead(fid_t fid, chunkOff_t offset,
+        chunkId_t chunkId) const;
+    void AllocateAheadUsed(fid_t fid, chunkId_t chunkId);
+    bool AllocateAheadExpired(fid_t fid, chunkId_t chunkId);
+    chunkOff_t AllocateAheadReclaimOffset(
+        fid_t fid, chunkOff_t offset, int64_t owner);
+    void AllocateAheadReclaimDone(fid_t fid, int64_t owner,
+        chunkOff_t requestedOffset, chunkOff_t offset, int status);
     bool IsChunkStable(chunkId_t chunkId);
     const char* AddNotStableChunk(
         const ChunkServerPtr& server,
@@ -882,8 +903,13 @@ public:
     /// Check the replication level of all the blocks and report
     /// back files that are under-replicated.
     /// Returns true if the system is healthy.
+    typedef MetaFsck::Progress FsckProgress;
     int  FsckStreamCount(bool reportAbandonedFilesFlag) const;
-    void Fsck(ostream** os, bool reportAbandonedFilesFlag);
+    /// With unlimitedFlag set the fsck run time and the number of files
+    /// reported are not limited, intended to be used by the background
+    /// fsck, where the output is streamed to the client as it goes.
+    void Fsck(ostream** os, bool reportAbandonedFilesFlag,
+        FsckProgress* progress = 0, bool unlimitedFlag = false);
 
     /// For monitoring purposes, dump out state of all the
     /// connected chunk servers.
@@ -908,6 +934,7 @@ public:
     /// @param[in] chunkId  the chunk for which leases need to be cleaned up
     /// @param[in] v   the placement/lease info for the chunk
     void LeaseCleanup(chunkId_t chunkId, CSMap::Entry &v);
+    void AllocateAheadCleanup();
     bool ExpiredLeaseCleanup(chunkId_t chunkId);
 
     /// Handler that loops thru the chunk->location map and determines
@@ -1020,6 +1047,8 @@ public:
     bool HasEnoughFreeBuffers(MetaRequest* req = 0);
     int GetMaxResponseSize() const
         { return mMaxResponseSize; }
+    int GetMaxAllocateAheadCount() const
+        { return mMaxAllocateAheadCount; }
     int GetReadDirLimit() const
         { return mReadDirLimit; }
     void ChangeIoBufPending(int64_t delta)
@@ -1040,6 +1069,13 @@ public:
     bool GetUseFsTotalSpaceFlag() const
         { return mUseFsTotalSpaceFlag; }
     int64_t GetSlavePlacementScale();
+    int64_t GetMaxGoodCandidateLoadAvg(bool masterFlag)
+    {
+        UpdateGoodCandidateLoadAvg();
+        return (masterFlag ?
+            mCSMaxGoodMasterCandidateLoadAvg :
+            mCSMaxGoodSlaveCandidateLoadAvg);
+    }
     int GetMaxConcurrentWriteReplicationsPerNode() const
         { return mMaxConcurrentWriteReplicationsPerNode; }
     const Servers& GetChunkServers() const
@@ -1423,6 +1459,31 @@ protected:
         StdFastAllocator<pair<pair<fid_t, chunkOff_t>, chunkId_t> >
     > StripedFilesAllocationsInFlight;
 
+    // Chunks allocated ahead, not yet used by the writers, and the writer
+    // (owner) ids the chunks were allocated for.
+    typedef map<
+        pair<fid_t, chunkOff_t>,
+        pair<chunkId_t, int64_t>,
+        less<pair<fid_t, chunkOff_t> >,
+        StdFastAllocator<pair<
+            const pair<fid_t, chunkOff_t>, pair<chunkId_t, int64_t> > >
+    > AllocateAheadChunks;
+    // Offsets and owners of the unused chunks allocated ahead to be deleted.
+    typedef map<
+        fid_t,
+        pair<chunkOff_t, int64_t>,
+        less<fid_t>,
+        StdFastAllocator<pair<const fid_t, pair<chunkOff_t, int64_t> > >
+    > AllocateAheadReclaims;
+    // Allocations ahead in flight count, and the offset starting from which
+    // the writer deleted the chunks while the allocations were in flight.
+    typedef map<
+        fid_t,
+        pair<int, chunkOff_t>,
+        less<fid_t>,
+        StdFastAllocator<pair<const fid_t, pair<int, chunkOff_t> > >
+    > AllocateAheadInFlight;
+
     class FilesChecker;
 
     /// A counter to track the # of ongoing chunk replications
@@ -1487,6 +1548,9 @@ protected:
     CSMap mChunkToServerMap;
 
     StripedFilesAllocationsInFlight mStripedFilesAllocationsInFlight;
+    AllocateAheadChunks             mAllocateAheadChunks;
+    AllocateAheadReclaims           mAllocateAheadReclaims;
+    AllocateAheadInFlight           mAllocateAheadInFlight;
 
     /// chunks to which a lease has been handed out; whenever we
     /// cleanup the leases, this set is walked
@@ -1672,6 +1736,11 @@ protected:
     bool    mInRackPlacementForAppendFlag;
     bool    mInRackPlacementFlag;
     bool    mAllocateDebugVerifyFlag;
+    int     mMaxAllocateAheadCount;
+    // Sorted list of racks; if not empty re-balance moves only the replicas
+    // hosted in these racks. Used by the layout emulator to partition
+    // re-balance planning.
+    RackIds mRebalanceSrcRackIds;
 
     CSMap::Entry* mChunkEntryToChange;
     MetaFattr*    mFattrToChangeTo;
@@ -1899,7 +1968,9 @@ protected:
     void CSMapUnitTest(const Properties& props);
     int64_t GetMaxCSUptime() const;
     bool ReadRebalancePlan(size_t nread);
-    void Fsck(ostream &os, bool reportAbandonedFilesFlag);
+    void Fsck(ostream &os, bool reportAbandonedFilesFlag,
+        int64_t maxFilesToReport, int64_t maxFsckTime,
+        FsckProgress* progress);
     void CheckFile(
         FilesChecker&     fsck,
         const MetaDentry& de,
@@ -33,6 +33,7 @@
 #include "ChildProcessTracker.h"
 #include "NetDispatch.h"
 #include "Restorer.h"
+#include "Replay.h"
 #include "AuditLog.h"
 
 #include "kfsio/Globals.h"
@@ -45,6 +46,7 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <signal.h>
 #include <unistd.h>
 #include <string.h>
@@ -57,17 +59,21 @@
 namespace KFS {
 
 using std::map;
+using std::hex;
 using std::string;
 using std::istringstream;
 using std::ifstream;
 using std::min;
 using std::max;
+using std::find;
 using std::make_pair;
 using std::numeric_limits;
 using KFS::libkfsio::globals;
 
 static bool    gWormMode = false;
 static string  gChunkmapDumpDir(".");
+static bool    gFollowerMode = false;
+static int     gFollowerMaxStalenessSec = 30;
 static const char* const ftypes[] = { "empty", "file", "dir" };
 
 static bool
@@ -120,6 +126,60 @@ setChunkmapDumpDir(string d)
     gChunkmapDumpDir = d;
 }
 
+/*
+ * Set follower mode. In follower mode the tree is updated by tailing the log
+ * written by the primary meta server, and only the read only requests are
+ * serviced.
+ */
+void
+setFollowerMode(bool value, int maxStalenessSec)
+{
+    gFollowerMode            = value;
+    gFollowerMaxStalenessSec = maxStalenessSec;
+}
+
+/*
+ * Returns false and sets the request status if the request cannot be serviced
+ * by the follower.
+ */
+static bool
+IsFollowerRequestAllowed(MetaRequest& r)
+{
+    switch (r.op) {
+        case META_LOOKUP:
+        case META_LOOKUP_PATH:
+        case META_READDIR:
+        case META_GETPATHNAME:
+            break;
+        case META_READDIRPLUS:
+        case META_GETALLOC:
+        case META_GETLAYOUT:
+            // Chunk servers do not connect to the follower, the chunk
+            // locations and the last chunk sizes are not known.
+            r.status    = -EROFS;
+            r.statusMsg = "follower has no chunk locations";
+            return false;
+        case META_PING:
+        case META_STATS:
+        case META_UPSERVERS:
+        case META_GET_REQUEST_COUNTERS:
+        case META_DISCONNECT:
+            return true;
+        default:
+            r.status    = -EROFS;
+            r.statusMsg = "read only follower";
+            return false;
+    }
+    if (replayer.getTailErrorFlag() ||
+            replayer.getTailTime() + gFollowerMaxStalenessSec <
+                globalNetManager().Now()) {
+        r.status    = -EAGAIN;
+        r.statusMsg = "follower is stale";
+        return false;
+    }
+    return true;
+}
+
 inline static bool
 OkHeader(const MetaRequest* op, ostream &os, bool checkStatus = true)
 {
@@ -1489,11 +1549,96 @@ MetaGetlayout::handle()
  * manager tells us where the data has been placed; the process for
  * the request is therefore complete.
  */
+MetaAllocate::~MetaAllocate()
+{
+    delete pendingLeaseRelinquish;
+    assert(allocateAhead.empty());
+    for (vector<MetaAllocate*>::const_iterator it = allocateAheadDone.begin();
+            it != allocateAheadDone.end();
+            ++it) {
+        delete *it;
+    }
+}
+
+/*
+ * Allocate the chunks past the requested one for sequential writer, in
+ * order to reduce the number of allocation round trips. Each allocation
+ * is submitted as a separate request, and runs concurrently with the
+ * requested allocation. The response to the requested allocation does not
+ * wait for the allocations ahead: it includes only the ones completed by
+ * then. The layout manager tracks the chunks allocated ahead, and reclaims
+ * the ones that the writer has not used by the time the write leases
+ * expire.
+ */
+void
+MetaAllocate::StartAllocateAhead()
+{
+    if (allocateAheadCount <= 0 || ! allocateAhead.empty() ||
+            ! allocateAheadDone.empty() ||
+            allocateAheadFlag || status != 0 || appendChunk ||
+            invalidateAllFlag || stripedFileFlag) {
+        return;
+    }
+    const int cnt = min(allocateAheadCount,
+        gLayoutManager.GetMaxAllocateAheadCount());
+    allocateAhead.reserve(max(0, cnt));
+    for (int i = 1; i <= cnt; i++) {
+        MetaAllocate& req = *(new MetaAllocate(
+            opSeqno, fid, offset + (chunkOff_t)CHUNKSIZE * i));
+        req.clientProtoVers    = clientProtoVers;
+        req.clientIp           = clientIp;
+        req.euser              = euser;
+        req.egroup             = egroup;
+        req.clientHost         = clientHost;
+        req.pathname           = pathname;
+        req.allocateAheadOwner = allocateAheadOwner;
+        req.allocateAheadFlag  = true;
+        req.clnt               = this;
+        allocateAhead.push_back(&req);
+    }
+    // The allocation might complete synchronously, and remove itself from
+    // the in flight list, therefore iterate over the copy.
+    const vector<MetaAllocate*> reqs(allocateAhead);
+    for (vector<MetaAllocate*>::const_iterator it = reqs.begin();
+            it != reqs.end();
+            ++it) {
+        submit_request(*it);
+    }
+}
+
+/*
+ * The allocations ahead that are still in flight complete on their own, and
+ * get deleted by the dispatcher.
+ */
+void
+MetaAllocate::DetachAllocateAhead()
+{
+    for (vector<MetaAllocate*>::const_iterator it = allocateAhead.begin();
+            it != allocateAhead.end();
+            ++it) {
+        MetaAllocate& req = **it;
+        if (req.pendingLeaseRelinquish && req.clnt == &req) {
+            // Lease relinquish completion saves and restores the client.
+            req.pendingLeaseRelinquish->clnt = 0;
+        } else {
+            req.clnt = 0;
+        }
+    }
+    allocateAhead.clear();
+}
+
 /* virtual */ void
 MetaAllocate::handle()
 {
     suspended = false;
     if (layoutDone) {
+        if (allocateAheadFlag) {
+            if (status == 0) {
+                gLayoutManager.AllocateAheadDone(*this);
+            }
+        } else {
+            DetachAllocateAhead();
+        }
         return;
     }
     KFS_LOG_STREAM_DEBUG << "Starting layout for req: " << opSeqno <<
@@ -1510,7 +1655,7 @@ MetaAllocate::handle()
         }
         return;
     }
-    if (gLayoutManager.VerifyAllOpsPermissions()) {
+    if (gLayoutManager.VerifyAllOpsPermissions() && ! allocateAheadFlag) {
         SetEUserAndEGroup(*this);
     }
     if (appendChunk) {
@@ -1520,8 +1665,10 @@ MetaAllocate::handle()
             status    = -EINVAL;
             return;
         }
-        // pick a chunk for which a write lease exists
-        status = gLayoutManager.AllocateChunkForAppend(this);
+        // pick a chunk for which a write lease exists, unless the client
+        // asks for a chunk of its own
+        status = appendNewChunkFlag ?
+            -1 : gLayoutManager.AllocateChunkForAppend(this);
         if (status == 0) {
             // all good
             KFS_LOG_STREAM_DEBUG <<
@@ -1559,6 +1706,13 @@ MetaAllocate::handle()
         // we have a problem
         return;
     }
+    if (status == -EEXIST && allocateAheadFlag &&
+            ! gLayoutManager.IsAllocatedAhead(fid, offset, chunkId)) {
+        // Leave the existing chunk alone, the writer will get the lease
+        // when it needs it. The chunk allocated ahead earlier, that still
+        // has valid write lease, is returned to the writer again.
+        return;
+    }
     permissions = *fa;
     if (stripedFileFlag && appendChunk) {
         status    = -EINVAL;
@@ -1603,6 +1757,10 @@ MetaAllocate::handle()
     int ret;
     if (status == -EEXIST) {
         initialChunkVersion = chunkVersion;
+        if (! allocateAheadFlag) {
+            // The writer uses the chunk allocated ahead, if any.
+            gLayoutManager.AllocateAheadUsed(fid, chunkId);
+        }
         bool isNewLease = false;
         // Get a (new) lease if possible
         status = gLayoutManager.GetChunkWriteLease(this, isNewLease);
@@ -1614,6 +1772,8 @@ MetaAllocate::handle()
             KFS_LOG_STREAM_DEBUG << "Got valid lease for req:" << opSeqno <<
             KFS_LOG_EOM;
             // we got a valid lease.  so, return
+            StartAllocateAhead();
+            DetachAllocateAhead();
             return;
         }
         // new lease and chunkservers have been notified
@@ -1628,6 +1788,12 @@ MetaAllocate::handle()
     // If all allocate ops fail synchronously (all servers are down), then
     // the op is not suspended, and can proceed immediately.
     suspended =! layoutDone;
+    if (suspended) {
+        if (allocateAheadFlag && initialChunkVersion < 0) {
+            gLayoutManager.AllocateAheadStart(*this);
+        }
+        StartAllocateAhead();
+    }
 }
 
 void
@@ -1659,6 +1825,13 @@ MetaAllocate::LayoutDone(int64_t chunkAllocProcessTime)
             }
         }
     }
+    if (allocateAheadFlag && wasSuspended && initialChunkVersion < 0 &&
+            gLayoutManager.AllocateAheadInFlightDone(*this) && status == 0) {
+        // The writer deleted the chunks past the end of the file while the
+        // allocation was in flight.
+        statusMsg = "allocate ahead canceled";
+        status    = -ECANCELED;
+    }
     // Ensure that the op isn't stale.
     // Invalidate all replicas might make it stale if it comes while this op
     // is in flight. Do not do any cleanup if the op is invalid: all required
@@ -1790,6 +1963,22 @@ MetaAllocate::LayoutDone(int64_t chunkAllocProcessTime)
 int
 MetaAllocate::logOrLeaseRelinquishDone(int code, void* data)
 {
+    if (code == EVENT_CMD_DONE && data != this &&
+            data != pendingLeaseRelinquish && ! allocateAhead.empty() &&
+            find(allocateAhead.begin(), allocateAhead.end(), data) !=
+                allocateAhead.end()) {
+        MetaAllocate* const req = reinterpret_cast<MetaAllocate*>(data);
+        KFS_LOG_STREAM(req->status == 0 ?
+                MsgLogger::kLogLevelDEBUG : MsgLogger::kLogLevelINFO) <<
+            "allocate ahead done: " << req->Show() <<
+            " status: "             << req->status <<
+            " "                     << req->statusMsg <<
+        KFS_LOG_EOM;
+        allocateAhead.erase(
+            find(allocateAhead.begin(), allocateAhead.end(), req));
+        allocateAheadDone.push_back(req);
+        return 0;
+    }
     if (code != EVENT_CMD_DONE ||
             (data != this && data != pendingLeaseRelinquish)) {
         panic("MetaChunkAllocate::logDone invalid invocation");
@@ -1856,6 +2045,7 @@ MetaAllocate::Show() const
         " client: "   << clientHost  <<
         " replicas: " << numReplicas <<
         " append: "   << appendChunk <<
+        " ahead: "    << allocateAheadCount <<
         " log: "      << logFlag
     ;
     for (Servers::const_iterator i = servers.begin();
@@ -1875,6 +2065,13 @@ MetaChunkVersChange::handle()
 /* virtual */ void
 MetaTruncate::handle()
 {
+    if (reclaimExpiredFlag) {
+        // Meta server internal request: the chunks were allocated on behalf
+        // of the writer, no permission checks.
+        mtime = microseconds();
+        reclaimAllocatedAhead(kKfsUserRoot, kKfsGroupRoot);
+        return;
+    }
     if (gWormMode && ! IsWormMutationAllowed(pathname.GetStr())) {
         statusMsg = "worm mode";
         status    = -EPERM;
@@ -1892,10 +2089,36 @@ MetaTruncate::handle()
         status = metatree.pruneFromHead(fid, offset, &mtime, eu, egroup);
         return;
     }
+    if (reclaimChunksFlag) {
+        reclaimAllocatedAhead(eu, egroup);
+        return;
+    }
     const string path(pathname.GetStr());
     status = metatree.truncate(fid, offset, path, &mtime, eu, egroup);
 }
 
+/*
+ * The chunks might have been used, or other writers might have added chunks
+ * past the offset since the request was issued, therefore delete only the
+ * chunks that are still unused chunks allocated ahead for the owner, at the
+ * end of the file. The offset is set to the offset the chunks are deleted
+ * from, or -1 if there is nothing to delete, for the log and replay.
+ */
+void
+MetaTruncate::reclaimAllocatedAhead(kfsUid_t eu, kfsGid_t eg)
+{
+    const chunkOff_t requestedOffset = offset;
+    offset = gLayoutManager.AllocateAheadReclaimOffset(
+        fid, requestedOffset, allocateAheadOwner);
+    status = offset < 0 ? 0 :
+        metatree.reclaimChunks(fid, offset, &mtime, eu, eg);
+    gLayoutManager.AllocateAheadReclaimDone(
+        fid, allocateAheadOwner, requestedOffset, offset, status);
+    if (status == 0 && 0 <= offset) {
+        gLayoutManager.UpdateLastChunkSize(fid);
+    }
+}
+
 /* virtual */ void
 MetaRename::handle()
 {
@@ -2373,6 +2596,15 @@ static int DoFork(int childTimeLimit)
     return ret;
 }
 
+// Background fsck children run for a long time, and do not prevent other
+// child processes from starting.
+static size_t
+GetForegroundChildProcessCount()
+{
+    return (gChildProcessTracker.GetProcessCount() -
+        MetaFsck::GetBackgroundRunningCount());
+}
+
 /* virtual */ void
 MetaDumpChunkToServerMap::handle()
 {
@@ -2381,7 +2613,7 @@ MetaDumpChunkToServerMap::handle()
         pid = -1;
         return; // Child finished.
     }
-    if (gChildProcessTracker.GetProcessCount() > 0) {
+    if (GetForegroundChildProcessCount() > 0) {
         statusMsg = "another child process running";
         status    = -EAGAIN;
         return;
@@ -2422,7 +2654,38 @@ MetaDumpChunkReplicationCandidates::handle()
 MetaFsck::handle()
 {
     suspended = false;
+    if (trackerFlag) {
+        // Background fsck child finished.
+        sBackgroundRunningCount--;
+        if (pid == sBackground.pid) {
+            sBackground.pid    = -1;
+            sBackground.status = status;
+        }
+        KFS_LOG_STREAM(status == 0 ?
+                MsgLogger::kLogLevelINFO :
+                MsgLogger::kLogLevelERROR) <<
+            "background fsck: " << sBackground.id <<
+            " pid: "            << pid <<
+            " exit status: "    << status <<
+        KFS_LOG_EOM;
+        pid    = -1;
+        status = 0;
+        return;
+    }
     resp.Clear();
+    if (pid <= 0 && 0 <= sBackground.fd && sBackground.pid <= 0 &&
+            sBackground.accessTime + sBackgroundIdleTimeoutSec <
+                globalNetManager().Now()) {
+        CloseBackground();
+    }
+    if (0 <= fsckId) {
+        ReadBackground();
+        return;
+    }
+    if (backgroundFlag) {
+        StartBackground();
+        return;
+    }
     if (pid > 0) {
         if (! HasEnoughIoBuffersForResponse(*this)) {
             return;
@@ -2508,7 +2771,7 @@ MetaFsck::handle()
         }
         return;
     }
-    if (gChildProcessTracker.GetProcessCount() > 0) {
+    if (GetForegroundChildProcessCount() > 0) {
         statusMsg = "another child process running";
         status    = -EAGAIN;
         return;
@@ -2596,6 +2859,177 @@ MetaFsck::handle()
     gChildProcessTracker.Track(pid, this);
 }
 
+void
+MetaFsck::StartBackground()
+{
+    if (gChildProcessTracker.GetProcessCount() > 0) {
+        statusMsg = "another child process running";
+        status    = -EAGAIN;
+        return;
+    }
+    const int cnt = gLayoutManager.FsckStreamCount(
+        reportAbandonedFilesFlag);
+    if (cnt <= 0) {
+        statusMsg = "internal error";
+        status    = -EINVAL;
+        return;
+    }
+    // Discard the previous background fsck output, if any.
+    CloseBackground();
+    const string name = sTmpName + ".XXXXXX";
+    StBufferT<char, 128> buf;
+    char* const ptr = buf.Resize(name.size() + 1);
+    strcpy(ptr, name.c_str());
+    const int tfd = mkstemp(ptr);
+    if (tfd < 0) {
+        status    = errno > 0 ? -errno : -EINVAL;
+        statusMsg = "failed to create temporary file";
+        return;
+    }
+    // The progress counters are updated by the child, and read by the
+    // parent, therefore the counters must be in the shared memory.
+    void* const mem = mmap(0, sizeof(Progress), PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        status    = errno > 0 ? -errno : -ENOMEM;
+        statusMsg = "failed to allocate shared memory";
+        close(tfd);
+        unlink(ptr);
+        return;
+    }
+    Progress* const fsckProgress = new (mem) Progress();
+    // No time limit by default, the background fsck of a large file system
+    // can run for hours.
+    if ((pid = DoFork(sBackgroundMaxTimeSec)) == 0) {
+        // Write all output into single stream, in order to stream the
+        // files as these are found. The summary comes last.
+        StBufferT<ostream*, 8> streamsPtrBuf;
+        ostream** const streams = streamsPtrBuf.Resize(cnt + 1);
+        ofstream        stream(ptr);
+        close(tfd);
+        unlink(ptr);
+        bool failedFlag = ! stream;
+        if (! failedFlag) {
+            for (int i = 0; i < cnt; i++) {
+                streams[i] = &stream;
+            }
+            streams[cnt] = 0;
+            gLayoutManager.Fsck(streams, reportAbandonedFilesFlag,
+                fsckProgress, true);
+            stream.flush();
+            stream.close();
+            failedFlag = ! stream;
+        }
+        _exit(failedFlag ? 3 : 0); // Child does not do graceful close.
+    }
+    if (pid < 0) {
+        status    = errno > 0 ? -errno : -EINVAL;
+        statusMsg = "fork failure";
+        close(tfd);
+        unlink(ptr);
+        munmap(mem, sizeof(Progress));
+        return;
+    }
+    sBackground.id         = sBackgroundNextId++;
+    sBackground.pid        = pid;
+    sBackground.fd         = tfd;
+    sBackground.status     = 0;
+    sBackground.accessTime = globalNetManager().Now();
+    sBackground.progress   = fsckProgress;
+    KFS_LOG_STREAM_INFO << "background fsck: " << sBackground.id <<
+        " pid: " << pid <<
+    KFS_LOG_EOM;
+    MetaFsck* const tracker = new MetaFsck();
+    tracker->trackerFlag = true;
+    tracker->pid         = pid;
+    tracker->suspended   = true;
+    gChildProcessTracker.Track(pid, tracker);
+    sBackgroundRunningCount++;
+    pid          = -1;
+    fsckId       = sBackground.id;
+    fsckPos      = 0;
+    fsckSize     = 0;
+    fsckDoneFlag = false;
+    progress     = *fsckProgress;
+}
+
+void
+MetaFsck::ReadBackground()
+{
+    if (fsckId != sBackground.id || sBackground.fd < 0) {
+        statusMsg = "no such background fsck";
+        status    = -ENOENT;
+        return;
+    }
+    sBackground.accessTime = globalNetManager().Now();
+    if (! HasEnoughIoBuffersForResponse(*this)) {
+        return;
+    }
+    // Get the done flag prior to the size, the output size is final if the
+    // child has exited.
+    fsckDoneFlag = sBackground.pid <= 0;
+    fsckStatus   = fsckDoneFlag ? sBackground.status : 0;
+    progress     = *sBackground.progress;
+    struct stat st = {0};
+    if (fstat(sBackground.fd, &st) < 0) {
+        status    = errno > 0 ? -errno : -EIO;
+        statusMsg = QCUtils::SysError(-status);
+        return;
+    }
+    fsckSize = st.st_size;
+    if (fsckPos < 0 || fsckSize < fsckPos) {
+        statusMsg = "invalid fsck output position";
+        status    = -EINVAL;
+        return;
+    }
+    const int maxReadSize = (int)min(fsckSize - fsckPos, (int64_t)min(
+        gLayoutManager.GetMaxResponseSize(), sMaxFsckResponseSize));
+    if (maxReadSize <= 0) {
+        if (fsckDoneFlag && fsckStatus != 0 && fsckPos == fsckSize) {
+            // Keep the partial output, and mark its end, the output of the
+            // failed or killed fsck is incomplete.
+            ostream& os = sWOStream.Set(resp);
+            os << "\nWARNING: background fsck failure: exit status: " <<
+                fsckStatus << " output is incomplete\n";
+            os.flush();
+            if (! os) {
+                resp.Clear();
+                statusMsg = "out of io buffers";
+                status    = -ENOMEM;
+            }
+            sWOStream.Reset();
+        }
+        return;
+    }
+    if (lseek(sBackground.fd, fsckPos, SEEK_SET) != fsckPos) {
+        status    = errno > 0 ? -errno : -EIO;
+        statusMsg = QCUtils::SysError(-status);
+        return;
+    }
+    const int nRead = resp.Read(sBackground.fd, maxReadSize);
+    if (nRead < 0) {
+        status    = nRead;
+        statusMsg = QCUtils::SysError(-status);
+        resp.Clear();
+    }
+}
+
+void
+MetaFsck::CloseBackground()
+{
+    if (sBackground.fd < 0) {
+        return;
+    }
+    KFS_LOG_STREAM_INFO << "background fsck: " << sBackground.id <<
+        " closing" <<
+    KFS_LOG_EOM;
+    close(sBackground.fd);
+    munmap(sBackground.progress, sizeof(*sBackground.progress));
+    // The child, if still running, is tracked by the corresponding tracker
+    // request, its output is discarded.
+    sBackground = Background();
+}
+
 void
 MetaFsck::SetParameters(const Properties& props)
 {
@@ -2603,10 +3037,20 @@ MetaFsck::SetParameters(const Properties& props)
         "metaServer.fsck.tmpfile",             sTmpName);
     sMaxFsckResponseSize = props.getValue(
         "metaServer.fsck.maxFsckResponseSize", sMaxFsckResponseSize);
+    sBackgroundMaxTimeSec = props.getValue(
+        "metaServer.fsck.backgroundMaxTimeSec", sBackgroundMaxTimeSec);
+    sBackgroundIdleTimeoutSec = props.getValue(
+        "metaServer.fsck.backgroundIdleTimeoutSec",
+        sBackgroundIdleTimeoutSec);
 }
 
-string MetaFsck::sTmpName("/tmp/kfsfsck.tmp");
-int    MetaFsck::sMaxFsckResponseSize(20 << 20);
+string               MetaFsck::sTmpName("/tmp/kfsfsck.tmp");
+int                  MetaFsck::sMaxFsckResponseSize(20 << 20);
+int                  MetaFsck::sBackgroundMaxTimeSec(0);
+int                  MetaFsck::sBackgroundIdleTimeoutSec(10 * 60);
+int64_t              MetaFsck::sBackgroundNextId(1);
+int                  MetaFsck::sBackgroundRunningCount(0);
+MetaFsck::Background MetaFsck::sBackground;
 
 /* virtual */ void
 MetaCheckLeases::handle()
@@ -2859,6 +3303,10 @@ submit_request(MetaRequest *r)
         // accumulate processing time.
         r->processTime = start - r->processTime;
     }
+    if (gFollowerMode && ! IsFollowerRequestAllowed(*r)) {
+        oplog.dispatch(r);
+        return;
+    }
     r->handle();
     if (r->suspended) {
         r->processTime = microseconds() - r->processTime;
@@ -3034,6 +3482,12 @@ MetaTruncate::log(ostream &file) const
     if (pruneBlksFromHead) {
         file << "pruneFromHead/file/" << fid << "/offset/" << offset
             << "/mtime/" << ShowTime(mtime) << '\n';
+    } else if (reclaimChunksFlag) {
+        if (offset < 0) {
+            return 0; // Nothing was deleted.
+        }
+        file << "reclaim/file/" << fid << "/offset/" << offset
+            << "/mtime/" << ShowTime(mtime) << '\n';
     } else {
         file << "truncate/file/" << fid << "/offset/" << offset
             << "/mtime/" << ShowTime(mtime) << '\n';
@@ -3730,6 +4184,30 @@ MetaAllocate::responseSelf(ostream &os)
     if (master) {
         os << "Master: " << master->GetServerLocation() << "\r\n";
     }
+    if (! allocateAheadDone.empty()) {
+        os << "Allocate-ahead:";
+        for (vector<MetaAllocate*>::const_iterator
+                it = allocateAheadDone.begin();
+                it != allocateAheadDone.end();
+                ++it) {
+            const MetaAllocate& req = **it;
+            if (req.status != 0 || ! req.master) {
+                continue;
+            }
+            // Master first.
+            os << ' ' << req.offset << ' ' << req.chunkId <<
+                ' ' << req.chunkVersion << ' ' << req.servers.size() <<
+                ' ' << req.master->GetServerLocation();
+            for (Servers::const_iterator si = req.servers.begin();
+                    si != req.servers.end();
+                    ++si) {
+                if (*si != req.master) {
+                    os << ' ' << (*si)->GetServerLocation();
+                }
+            }
+        }
+        os << "\r\n";
+    }
     os << "Num-replicas: " << servers.size() << "\r\n";
     if (! servers.empty()) {
         os << "Replicas:";
@@ -3890,6 +4368,20 @@ MetaFsck::response(ostream &os, IOBuffer& buf)
     if (! OkHeader(this, os)) {
         return;
     }
+    if (0 <= fsckId) {
+        os <<
+            "Fsck-id: "             << fsckId                  << "\r\n"
+            "Fsck-pos: "            << fsckPos                 << "\r\n"
+            "Fsck-size: "           << fsckSize                << "\r\n"
+            "Fsck-done: "           << (fsckDoneFlag ? 1 : 0)  << "\r\n"
+            "Fsck-status: "         << fsckStatus              << "\r\n"
+            "Fsck-files: "          << progress.filesCount     << "\r\n"
+            "Fsck-files-checked: "  << progress.filesChecked   << "\r\n"
+            "Fsck-chunks: "         << progress.chunksCount    << "\r\n"
+            "Fsck-chunks-checked: " << progress.chunksChecked  << "\r\n"
+            "Fsck-lost-files: "     << progress.lostFilesCount << "\r\n"
+        ;
+    }
     os  << "Content-length: " << resp.BytesConsumable() << "\r\n\r\n";
     os.flush();
     buf.Move(&resp);
@@ -4012,8 +4504,14 @@ MetaChunkHeartbeat::request(ostream &os)
     "Cseq: " << opSeqno << "\r\n"
     "Version: KFS/1.0\r\n"
     "Num-evacuate: " << evacuateCount << "\r\n"
-    "\r\n"
     ;
+    if (0 < hbFormat) {
+        os <<
+        "Hb-fmt: "  << hbFormat  << "\r\n"
+        "Hb-base: " << hbBaseSeq << "\r\n"
+        ;
+    }
+    os << "\r\n";
 }
 
 static inline char*
@@ -4032,35 +4530,24 @@ ChunkIdToString(chunkId_t id, bool hexFormatFlag, char* end)
     return toString(id, end);
 }
 
-void
-MetaChunkStaleNotify::request(ostream& os, IOBuffer& buf)
+static void
+ChunkIdsRequestContent(ostream& os, IOBuffer& buf,
+    const ChunkIdQueue& chunkIds, bool hexFormatFlag)
 {
-    const size_t count = staleChunkIds.GetSize();
-    os <<
-        "STALE_CHUNKS \r\n"
-        "Cseq: " << opSeqno << "\r\n"
-        "Version: KFS/1.0\r\n"
-        "Num-chunks: " << count << "\r\n"
-    ;
-    if (evacuatedFlag) {
-        os << "Evacuated: 1\r\n";
-    }
-    if (hexFormatFlag) {
-        os << "HexFormat: 1\r\n";
-    }
-    const int   kBufEnd = 30;
-    char        tmpBuf[kBufEnd + 1];
-    char* const end = tmpBuf + kBufEnd + 1;
+    const size_t count   = chunkIds.GetSize();
+    const int    kBufEnd = 30;
+    char         tmpBuf[kBufEnd + 1];
+    char* const  end = tmpBuf + kBufEnd + 1;
     if (count <= 1) {
         char* const p   = count < 1 ? end - 1 :
-            ChunkIdToString(staleChunkIds.Front(), hexFormatFlag, end);
+            ChunkIdToString(chunkIds.Front(), hexFormatFlag, end);
         size_t      len = end - p - 1;
         os << "Content-length: " << len << "\r\n\r\n";
         os.write(p, len);
         return;
     }
 
-    ChunkIdQueue::ConstIterator it(staleChunkIds);
+    ChunkIdQueue::ConstIterator it(chunkIds);
     const chunkId_t*            id;
     IOBuffer                    ioBuf;
     IOBufferWriter              writer(ioBuf);
@@ -4086,6 +4573,89 @@ MetaChunkStaleNotify::request(ostream& os, IOBuffer& buf)
     }
 }
 
+void
+MetaChunkStaleNotify::request(ostream& os, IOBuffer& buf)
+{
+    os <<
+        "STALE_CHUNKS \r\n"
+        "Cseq: " << opSeqno << "\r\n"
+        "Version: KFS/1.0\r\n"
+        "Num-chunks: " << staleChunkIds.GetSize() << "\r\n"
+    ;
+    if (evacuatedFlag) {
+        os << "Evacuated: 1\r\n";
+    }
+    if (hexFormatFlag) {
+        os << "HexFormat: 1\r\n";
+    }
+    ChunkIdsRequestContent(os, buf, staleChunkIds, hexFormatFlag);
+}
+
+void
+MetaChunkBulkDelete::request(ostream& os, IOBuffer& buf)
+{
+    os <<
+        "DELETE_CHUNKS \r\n"
+        "Cseq: " << opSeqno << "\r\n"
+        "Version: KFS/1.0\r\n"
+        "Num-chunks: " << chunkIds.GetSize() << "\r\n"
+    ;
+    if (hexFormatFlag) {
+        os << "HexFormat: 1\r\n";
+    }
+    ChunkIdsRequestContent(os, buf, chunkIds, hexFormatFlag);
+}
+
+bool
+MetaChunkBulkDelete::handleReplyContent(istream& is)
+{
+    // Chunk id in hex, and status pairs of the chunks that chunk server
+    // failed to delete.
+    failedChunks.reserve(max(0, numFailed));
+    chunkId_t chunkId = -1;
+    int       chunkStatus = 0;
+    for (int i = 0; i < numFailed; i++) {
+        if (! (is >> hex >> chunkId >> dec >> chunkStatus)) {
+            is.clear();
+            statusMsg = "invalid bulk delete response content";
+            status    = -EINVAL;
+            return false;
+        }
+        failedChunks.push_back(make_pair(chunkId, chunkStatus));
+    }
+    return true;
+}
+
+/* virtual */ void
+MetaChunkBulkDelete::handle()
+{
+    if (status < 0) {
+        KFS_LOG_STREAM_INFO << server->ServerID() <<
+            " bulk delete failed:"
+            " count: "  << chunkIds.GetSize() <<
+            " status: " << status <<
+            " "         << statusMsg <<
+        KFS_LOG_EOM;
+        return;
+    }
+    if (numFailed <= 0) {
+        return;
+    }
+    KFS_LOG_STREAM_INFO << server->ServerID() <<
+        " bulk delete:"
+        " count: "  << chunkIds.GetSize() <<
+        " failed: " << numFailed <<
+    KFS_LOG_EOM;
+    for (FailedChunks::const_iterator it = failedChunks.begin();
+            it != failedChunks.end();
+            ++it) {
+        KFS_LOG_STREAM_DEBUG << server->ServerID() <<
+            " delete chunk: " << it->first <<
+            " status: "       << it->second <<
+        KFS_LOG_EOM;
+    }
+}
+
 void
 MetaChunkRetire::request(ostream &os)
 {
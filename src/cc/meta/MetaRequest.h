@@ -49,10 +49,12 @@
 #include <vector>
 #include <map>
 #include <iomanip>
+#include <boost/shared_ptr.hpp>
 
 namespace KFS {
 
 using std::ostream;
+using std::istream;
 using std::vector;
 using std::map;
 using std::pair;
@@ -90,6 +92,7 @@ using std::oct;
     f(CHUNK_HEARTBEAT) /* Periodic heartbeat from meta->chunk */ \
     f(CHUNK_ALLOCATE) /* Allocate chunk RPC from meta->chunk */ \
     f(CHUNK_DELETE)  /* Delete chunk RPC from meta->chunk */ \
+    f(CHUNK_BULK_DELETE) /* Delete chunks batch RPC from meta->chunk */ \
     f(CHUNK_STALENOTIFY) /* Stale chunk notification RPC from meta->chunk */ \
     f(BEGIN_MAKE_CHUNK_STABLE) \
     f(CHUNK_MAKE_STABLE) /* Notify a chunkserver to make a chunk stable */ \
@@ -860,6 +863,9 @@ struct MetaAllocate: public MetaRequest, public  KfsCallbackObj {
     int                  spaceReservationSize;
     //!< Suggested max # of concurrent appenders per chunk
     int                  maxAppendersPerChunk;
+    //!< Write append only: allocate new chunk for this client, without
+    //!< using or changing the append chunk cache.
+    bool                 appendNewChunkFlag;
     //!< Server(s) on which this chunk has been placed
     Servers              servers;
     //!< For replication, the master that runs the transaction
@@ -873,6 +879,15 @@ struct MetaAllocate: public MetaRequest, public  KfsCallbackObj {
     chunkOff_t           chunkBlockStart;
     Permissions          permissions;
     MetaLeaseRelinquish* pendingLeaseRelinquish;
+    //!< Sequential write: the number of chunks past the requested chunk to
+    //!< allocate in addition to the requested chunk.
+    int                  allocateAheadCount;
+    //!< Sequential write: the writer id the chunks allocated ahead belong
+    //!< to, only the writer's own unused chunks are reclaimed on close.
+    int64_t              allocateAheadOwner;
+    bool                 allocateAheadFlag;     // Allocate ahead "child".
+    vector<MetaAllocate*> allocateAhead;        // In flight.
+    vector<MetaAllocate*> allocateAheadDone;    // Completed, sent to client.
     string               responseStr; // Cached response
     // With StringBufT instead of string the append allocation (presently
     // the most frequent allocation type) saves malloc() calls.
@@ -892,6 +907,7 @@ struct MetaAllocate: public MetaRequest, public  KfsCallbackObj {
           appendChunk(false),
           spaceReservationSize(1 << 20),
           maxAppendersPerChunk(64),
+          appendNewChunkFlag(false),
           servers(),
           master(),
           numServerReplies(0),
@@ -902,14 +918,18 @@ struct MetaAllocate: public MetaRequest, public  KfsCallbackObj {
           chunkBlockStart(-1),
           permissions(),
           pendingLeaseRelinquish(0),
+          allocateAheadCount(0),
+          allocateAheadOwner(-1),
+          allocateAheadFlag(false),
+          allocateAhead(),
+          allocateAheadDone(),
           responseStr(),
           clientHost(),
           pathname()
     {
         SET_HANDLER(this, &MetaAllocate::logOrLeaseRelinquishDone);
     }
-    virtual ~MetaAllocate()
-        { delete pendingLeaseRelinquish; }
+    virtual ~MetaAllocate();
     virtual void handle();
     virtual int log(ostream &file) const;
     virtual void response(ostream &os);
@@ -917,9 +937,12 @@ struct MetaAllocate: public MetaRequest, public  KfsCallbackObj {
     void responseSelf(ostream &os);
     void LayoutDone(int64_t chunkAllocProcessTime);
     int logOrLeaseRelinquishDone(int code, void *data);
+    void StartAllocateAhead();
+    void DetachAllocateAhead();
     bool Validate()
     {
-        return (fid >= 0 && (offset >= 0 || appendChunk));
+        return (fid >= 0 && (offset >= 0 || appendChunk) &&
+            allocateAheadCount >= 0);
     }
     template<typename T> static T& ParserDef(T& parser)
     {
@@ -931,7 +954,10 @@ struct MetaAllocate: public MetaRequest, public  KfsCallbackObj {
         .Def("Client-host",              &MetaAllocate::clientHost                      )
         .Def("Space-reserve",            &MetaAllocate::spaceReservationSize, int(1<<20))
         .Def("Max-appenders",            &MetaAllocate::maxAppendersPerChunk,    int(64))
+        .Def("Append-new-chunk",         &MetaAllocate::appendNewChunkFlag,        false)
         .Def("Invalidate-all",           &MetaAllocate::invalidateAllFlag,         false)
+        .Def("Allocate-ahead",           &MetaAllocate::allocateAheadCount,       int(0))
+        .Def("Allocate-ahead-owner",     &MetaAllocate::allocateAheadOwner, int64_t(-1))
         ;
     }
 };
@@ -945,6 +971,14 @@ struct MetaTruncate: public MetaRequest {
     //!< set if the blks from the beginning of the file to the offset have
     //!< to be deleted.
     bool            pruneBlksFromHead;
+    //!< set if the unused chunks allocated ahead by the writer starting from
+    //!< the offset have to be deleted.
+    bool            reclaimChunksFlag;
+    //!< set if the meta server reclaims the chunks allocated ahead that
+    //!< write leases expired unused.
+    bool            reclaimExpiredFlag;
+    //!< the writer id the chunks to reclaim were allocated ahead for.
+    int64_t         allocateAheadOwner;
     StringBufT<256> pathname; //!< full pathname for file being truncated
     int64_t         mtime;
     MetaTruncate()
@@ -952,18 +986,22 @@ struct MetaTruncate: public MetaRequest {
           fid(-1),
           offset(-1),
           pruneBlksFromHead(false),
+          reclaimChunksFlag(false),
+          reclaimExpiredFlag(false),
+          allocateAheadOwner(-1),
           pathname(),
           mtime()
         {}
     virtual void handle();
+    void reclaimAllocatedAhead(kfsUid_t eu, kfsGid_t eg);
     virtual int log(ostream &file) const;
     virtual void response(ostream &os);
     virtual string Show() const
     {
         ostringstream os;
         os <<
-            (pruneBlksFromHead ?
-                "prune from head:" : "truncate:") <<
+            (pruneBlksFromHead ? "prune from head:" :
+                (reclaimChunksFlag ? "reclaim chunks:" : "truncate:")) <<
             " path: "   << pathname <<
             " fid: "    << fid <<
             " offset: " << offset
@@ -981,6 +1019,8 @@ struct MetaTruncate: public MetaRequest {
         .Def("Offset",          &MetaTruncate::offset,          chunkOff_t(-1))
         .Def("Pathname",        &MetaTruncate::pathname                       )
         .Def("Prune-from-head", &MetaTruncate::pruneBlksFromHead,        false)
+        .Def("Reclaim-chunks",  &MetaTruncate::reclaimChunksFlag,        false)
+        .Def("Allocate-ahead-owner", &MetaTruncate::allocateAheadOwner, int64_t(-1))
         ;
     }
 };
@@ -1239,6 +1279,7 @@ struct MetaHello : public MetaRequest, public ServerLocation {
     ChunkInfos      notStableAppendChunks;
     int             bytesReceived;
     bool            staleChunksHexFormatFlag;
+    bool            bulkDeleteFlag;
     MetaHello()
         : MetaRequest(META_HELLO, false),
           ServerLocation(),
@@ -1261,7 +1302,8 @@ struct MetaHello : public MetaRequest, public ServerLocation {
           notStableChunks(),
           notStableAppendChunks(),
           bytesReceived(0),
-          staleChunksHexFormatFlag(false)
+          staleChunksHexFormatFlag(false),
+          bulkDeleteFlag(false)
         {}
     virtual void handle();
     virtual int log(ostream &file) const;
@@ -1294,6 +1336,7 @@ struct MetaHello : public MetaRequest, public ServerLocation {
         .Def("Content-length",               &MetaHello::contentLength,            int(0))
         .Def("Content-int-base",             &MetaHello::contentIntBase,          int(10))
         .Def("Stale-chunks-hex-format",      &MetaHello::staleChunksHexFormatFlag, false)
+        .Def("Bulk-delete",                  &MetaHello::bulkDeleteFlag,           false)
         ;
     }
 };
@@ -1441,6 +1484,8 @@ struct MetaChunkRequest: public MetaRequest {
     virtual int  log(ostream& /* file */) const { return 0; }
     virtual void request(ostream& os, IOBuffer& /* buf */) { request(os); }
     virtual void handleReply(const Properties& prop) {}
+    //!< parse the response content, if any, invoked after handleReply().
+    virtual bool handleReplyContent(istream& /* is */) { return true; }
     virtual void handle() {}
     void resume()
     {
@@ -1487,6 +1532,41 @@ struct MetaChunkDelete: public MetaChunkRequest {
     }
 };
 
+/*!
+ * \brief Bulk delete RPC from meta server to chunk server. Carries the ids of
+ * the chunks to delete; the reply has the status of the chunks that chunk
+ * server failed to delete.
+ */
+struct MetaChunkBulkDelete: public MetaChunkRequest {
+    typedef vector<pair<chunkId_t, int> > FailedChunks;
+
+    ChunkIdQueue chunkIds;
+    bool         hexFormatFlag;
+    int          numFailed;
+    FailedChunks failedChunks;
+    MetaChunkBulkDelete(seq_t n, const ChunkServerPtr& s, bool hexFmtFlag)
+        : MetaChunkRequest(META_CHUNK_BULK_DELETE, n, false, s, -1),
+          chunkIds(),
+          hexFormatFlag(hexFmtFlag),
+          numFailed(0),
+          failedChunks()
+        {}
+    virtual void handle();
+    virtual void request(ostream& os, IOBuffer& buf);
+    virtual void handleReply(const Properties& prop)
+    {
+        numFailed = prop.getValue("Num-failed", 0);
+    }
+    virtual bool handleReplyContent(istream& is);
+    virtual string Show() const
+    {
+        ostringstream os;
+
+        os << "meta->chunk bulk delete: count: " << chunkIds.GetSize();
+        return os.str();
+    }
+};
+
 struct MetaChunkVersChange;
 
 /*!
@@ -1643,10 +1723,14 @@ struct MetaChunkSize: public MetaChunkRequest {
  */
 struct MetaChunkHeartbeat: public MetaChunkRequest {
     int64_t evacuateCount;
+    int     hbFormat;  // max. binary heartbeat version, 0 -- text only
+    seq_t   hbBaseSeq; // last binary heartbeat received, delta encoding base
     MetaChunkHeartbeat(seq_t n, const ChunkServerPtr& s,
-            int64_t evacuateCnt)
+            int64_t evacuateCnt, int fmt = 0, seq_t baseSeq = -1)
         : MetaChunkRequest(META_CHUNK_HEARTBEAT, n, false, s, -1),
-          evacuateCount(evacuateCnt)
+          evacuateCount(evacuateCnt),
+          hbFormat(fmt),
+          hbBaseSeq(baseSeq)
         {}
     virtual void request(ostream &os);
     virtual string Show() const
@@ -2082,9 +2166,36 @@ struct MetaDumpChunkReplicationCandidates: public MetaRequest {
  * a list of files that have blocks missing.
 */
 struct MetaFsck: public MetaRequest {
+    // Fsck progress counters. The background fsck places the counters into
+    // the memory shared with the parent process, in order to let the parent
+    // report the progress while the fsck is running.
+    struct Progress
+    {
+        Progress()
+            : filesCount(0),
+              filesChecked(0),
+              chunksCount(0),
+              chunksChecked(0),
+              lostFilesCount(0)
+            {}
+        volatile int64_t filesCount;
+        volatile int64_t filesChecked;
+        volatile int64_t chunksCount;
+        volatile int64_t chunksChecked;
+        volatile int64_t lostFilesCount;
+    };
+
     MetaFsck()
         : MetaRequest(META_FSCK, false),
           reportAbandonedFilesFlag(true),
+          backgroundFlag(false),
+          fsckId(-1),
+          fsckPos(-1),
+          fsckSize(-1),
+          fsckDoneFlag(false),
+          fsckStatus(0),
+          progress(),
+          trackerFlag(false),
           pid(-1),
           fd(),
           resp()
@@ -2094,28 +2205,74 @@ struct MetaFsck: public MetaRequest {
     virtual void response(ostream &os, IOBuffer& buf);
     virtual string Show() const
     {
-        return "fsck";
+        return (trackerFlag ? "background fsck" : "fsck");
     }
     bool Validate()
     {
         return true;
     }
+    // The background fsck runs in the child process, and writes its output
+    // into the temporary file as it goes. The request with background flag
+    // set starts the fsck and returns its id. The subsequent requests with
+    // the fsck id and position set return the output starting from the
+    // specified position, and the fsck progress. If the fsck child fails or
+    // gets killed, the partial output is still returned, followed by the
+    // failure marker, and the non zero fsck status.
     template<typename T> static T& ParserDef(T& parser)
     {
         return MetaRequest::ParserDef(parser)
         .Def("Report-Abandoned-Files", &MetaFsck::reportAbandonedFilesFlag)
+        .Def("Fsck-background",        &MetaFsck::backgroundFlag          )
+        .Def("Fsck-id",                &MetaFsck::fsckId,     int64_t(-1) )
+        .Def("Fsck-pos",               &MetaFsck::fsckPos,    int64_t(-1) )
         ;
     }
     static void SetParameters(const Properties& props);
+    static int GetBackgroundRunningCount()
+        { return sBackgroundRunningCount; }
 private:
     typedef vector<int> Fds;
+    struct Background
+    {
+        Background()
+            : id(-1),
+              pid(-1),
+              fd(-1),
+              status(0),
+              accessTime(0),
+              progress(0)
+            {}
+        int64_t       id;
+        int           pid;
+        int           fd;
+        int           status;
+        time_t        accessTime;
+        Progress*     progress;
+    };
 
     bool          reportAbandonedFilesFlag;
+    bool          backgroundFlag;
+    int64_t       fsckId;
+    int64_t       fsckPos;
+    int64_t       fsckSize;
+    bool          fsckDoneFlag;
+    int           fsckStatus;
+    Progress      progress;
+    bool          trackerFlag;
     int           pid;
     Fds           fd;
     IOBuffer      resp;
-    static string sTmpName;
-    static int    sMaxFsckResponseSize;
+    static string     sTmpName;
+    static int        sMaxFsckResponseSize;
+    static int        sBackgroundMaxTimeSec;
+    static int        sBackgroundIdleTimeoutSec;
+    static int64_t    sBackgroundNextId;
+    static int        sBackgroundRunningCount;
+    static Background sBackground;
+
+    void StartBackground();
+    void ReadBackground();
+    static void CloseBackground();
 };
 
 /*!
@@ -2562,6 +2719,7 @@ void setMD5SumFn(const char *md5sumFn);
 void setWORMMode(bool value);
 void setMaxReplicasPerFile(int16_t value);
 void setChunkmapDumpDir(string dir);
+void setFollowerMode(bool value, int maxStalenessSec);
 void CheckIfIoBuffersAvailable();
 void SetRequestParameters(const Properties& props);
 
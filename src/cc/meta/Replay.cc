@@ -47,6 +47,8 @@
 namespace KFS
 {
 using std::ostringstream;
+using std::istringstream;
+using std::streamsize;
 using std::atoi;
 
 Replay replayer;
@@ -526,6 +528,29 @@ replay_truncate(DETokenizer& c)
     return (ok && status == 0);
 }
 
+/*!
+ * \brief replay reclaim of the unused chunks allocated ahead
+ * format: reclaim/file/<fileID>/offset/<offset>{/mtime/<time>}
+ */
+static bool
+replay_reclaim(DETokenizer& c)
+{
+    fid_t fid;
+    chunkOff_t offset;
+    int status = 0;
+    int64_t mtime;
+
+    c.pop_front();
+    bool ok = pop_fid(fid, "file", c, true);
+    ok = pop_fid(offset, "offset", c, ok);
+    bool gottime = pop_time(mtime, "mtime", c, ok);
+    if (ok) {
+        status = metatree.reclaimChunks(fid, offset,
+            gottime ? &mtime : 0);
+    }
+    return (ok && status == 0);
+}
+
 /*!
  * \brief replay prune blks from head of file
  * format: pruneFromHead/file/<fileID>/offset/<offset>{/mtime/<time>}
@@ -842,6 +867,7 @@ get_entry_map()
     e.add_parser("truncate", replay_truncate);
     e.add_parser("coalesce", replay_coalesce);
     e.add_parser("pruneFromHead", replay_pruneFromHead);
+    e.add_parser("reclaim", replay_reclaim);
     e.add_parser("setrep", replay_setrep);
     e.add_parser("size", replay_size);
     e.add_parser("setmtime", replay_setmtime);
@@ -999,12 +1025,181 @@ Replay::playLogs(int last, bool includeLastLogFlag)
     }
     if (status == 0) {
         oplog.setLog(i);
-        } else {
+        tailNumber = i;
+    } else {
         appendToLastLogFlag = false;
     }
+    if (file.is_open()) {
+        file.close();
+    }
+    return status;
+}
+
+/*!
+ * \brief apply complete log lines accumulated in the tail buffer
+ * \return  zero if successful, negative otherwise
+ */
+int
+Replay::tailEntries(bool& lastEntryChecksumFlag)
+{
+    const size_t pos = tailBuf.rfind('\n');
+    if (pos == string::npos) {
+        return 0;
+    }
+    istringstream is(tailBuf.substr(0, pos + 1));
+    tailBuf.erase(0, pos + 1);
+
+    MdStream&    mds = oplog.getMdStream();
+    DiskEntry&   entrymap = get_entry_map();
+    DETokenizer  tokenizer(is);
+    tokenizer.setIntBase(tailIntBase);
+
+    seq_t opcount = oplog.checkpointed();
+    int   status  = 0;
+    while (tokenizer.next(&mds)) {
+        if (lastEntryChecksumFlag) {
+            KFS_LOG_STREAM_FATAL <<
+                "error " << path <<
+                ": entry past the last line checksum: " <<
+                tokenizer.getEntry() <<
+            KFS_LOG_EOM;
+            status = -EINVAL;
+            break;
+        }
+        if (! entrymap.parse(tokenizer)) {
+            KFS_LOG_STREAM_FATAL <<
+                "error " << path <<
+                ":" << tokenizer.getEntryCount() <<
+                ":" << tokenizer.getEntry() <<
+            KFS_LOG_EOM;
+            status = -EINVAL;
+            break;
+        }
+        lastEntryChecksumFlag = ! restoreChecksum.empty();
+        if (lastEntryChecksumFlag) {
+            const string md = mds.GetMd();
+            if (md != restoreChecksum) {
+                KFS_LOG_STREAM_FATAL <<
+                    "error " << path <<
+                    ":" << tokenizer.getEntryCount() <<
+                    ":" << tokenizer.getEntry() <<
+                    ": checksum mismatch:"
+                    " expectd:" << restoreChecksum <<
+                    " computed: " << md <<
+                KFS_LOG_EOM;
+                status = -EINVAL;
+                break;
+            }
+            restoreChecksum.clear();
+        }
+    }
+    opcount += tokenizer.getEntryCount();
+    oplog.set_seqno(opcount);
+    tailIntBase = tokenizer.getIntBase();
     return status;
 }
 
+int
+Replay::tailLog()
+{
+    if (tailErrorFlag) {
+        return -EINVAL;
+    }
+    const size_t kReadSize = 4 << 20;
+    if (tailReadBuf.size() < kReadSize) {
+        tailReadBuf.resize(kReadSize);
+    }
+    char* const  buf       = &tailReadBuf[0];
+    int          status    = 0;
+    for (; ;) {
+        if (! file.is_open()) {
+            const string logfn = oplog.logfile(tailNumber);
+            if (! file_exists(logfn)) {
+                // The primary has not started the next log yet.
+                tailTime = time(0);
+                break;
+            }
+            if ((status = openlog(logfn)) != 0) {
+                break;
+            }
+            MdStream& mds = oplog.getMdStream();
+            mds.Reset();
+            mds.SetWriteTrough(true);
+            restoreChecksum.clear();
+            lastLineChecksumFlag = false;
+            tailBuf.clear();
+            tailIntBase = 10;
+        }
+        // Clear eof, to read what was appended since the last read.
+        file.clear();
+        file.read(buf, kReadSize);
+        const streamsize cnt = file.gcount();
+        if (file.bad()) {
+            const int err = errno;
+            KFS_LOG_STREAM_FATAL <<
+                path << ": " << QCUtils::SysError(err) <<
+            KFS_LOG_EOM;
+            status = err > 0 ? -err : -EIO;
+            break;
+        }
+        if (cnt <= 0) {
+            tailTime = time(0);
+            break;
+        }
+        tailBuf.append(buf, (size_t)cnt);
+        bool lastEntryChecksumFlag = false;
+        if ((status = tailEntries(lastEntryChecksumFlag)) != 0) {
+            break;
+        }
+        if (lastEntryChecksumFlag) {
+            // The log is complete, move to the next one.
+            if (! tailBuf.empty()) {
+                KFS_LOG_STREAM_FATAL <<
+                    "error " << path <<
+                    ": data past the last line checksum" <<
+                KFS_LOG_EOM;
+                status = -EINVAL;
+                break;
+            }
+            file.close();
+            tailNumber++;
+        }
+    }
+    if (status != 0) {
+        // The state of the tree is unknown, the tree must be re-created
+        // from the checkpoint, by restarting.
+        tailErrorFlag = true;
+        if (file.is_open()) {
+            file.close();
+        }
+    }
+    return status;
+}
+
+int
+Replay::stopTail()
+{
+    if (tailErrorFlag) {
+        return -EINVAL;
+    }
+    if (! tailBuf.empty()) {
+        KFS_LOG_STREAM_ERROR <<
+            path << ": incomplete last line: " << tailBuf.size() <<
+            " bytes" <<
+        KFS_LOG_EOM;
+        return -EAGAIN;
+    }
+    appendToLastLogFlag = file.is_open();
+    number              = tailNumber;
+    lastLogIntBase      = tailIntBase;
+    if (appendToLastLogFlag) {
+        file.close();
+    }
+    string().swap(tailReadBuf);
+    oplog.setLog(number);
+    return 0;
+}
+
 int
 Replay::getLastLog(int& last)
 {
@@ -27,6 +27,7 @@
 
 #include <string>
 #include <fstream>
+#include <time.h>
 
 namespace KFS
 {
@@ -41,7 +42,13 @@ public:
           path(),
           number(-1),
           lastLogIntBase(-1),
-          appendToLastLogFlag(false)
+          appendToLastLogFlag(false),
+          tailNumber(0),
+          tailIntBase(10),
+          tailBuf(),
+          tailReadBuf(),
+          tailTime(0),
+          tailErrorFlag(false)
         {}
     ~Replay()
         {}
@@ -55,16 +62,32 @@ public:
     int playAllLogs() { return playLogs(true); }
     bool getAppendToLastLogFlag() const { return appendToLastLogFlag; }
     int getLastLogIntBase() const { return lastLogIntBase; }
+    //!< follower mode: apply the entries appended to the log since the
+    //!< last call, and advance to the next log when the current one is
+    //!< complete. The logs are written by the primary meta server.
+    int tailLog();
+    //!< time when the tail caught up with the end of the log
+    time_t getTailTime() const { return tailTime; }
+    bool getTailErrorFlag() const { return tailErrorFlag; }
+    //!< stop tailing, and setup the state for the log writer
+    int stopTail();
 private:
     ifstream file;   //!< the log file being replayed
     string   path;   //!< path name for log file
     int      number; //!< sequence number for log file
     int      lastLogIntBase;
     bool     appendToLastLogFlag;
+    int      tailNumber;  //!< log file being tailed
+    int      tailIntBase;
+    string   tailBuf;     //!< incomplete last line
+    string   tailReadBuf; //!< log read buffer, re-used by every tail poll
+    time_t   tailTime;
+    bool     tailErrorFlag;
 
     int playLogs(int lastlog, bool includeLastLogFlag);
     int playlog(bool& lastEntryChecksumFlag);
     int getLastLog(int& lastlog);
+    int tailEntries(bool& lastEntryChecksumFlag);
 private:
     // No copy.
     Replay(const Replay&);
@@ -42,6 +42,7 @@ using std::for_each;
 using std::lower_bound;
 using std::set;
 using std::max;
+using std::min;
 using std::make_pair;
 
 const string kParentDir("..");
@@ -1864,6 +1865,63 @@ Tree::truncate(fid_t file, chunkOff_t offset, const string& path,
     return 0;
 }
 
+/*
+ * Delete the chunks allocated ahead by a sequential writer, that the writer
+ * did not use. Unlike truncate, the file size is set to "unknown", and
+ * will be updated from the new last chunk, as the logical eof is somewhere in
+ * the last chunk.
+ */
+int
+Tree::reclaimChunks(fid_t file, chunkOff_t offset, const int64_t* mtime,
+    kfsUid_t euser /* = kKfsUserRoot */, kfsGid_t egroup /* = kKfsGroupRoot */)
+{
+    MetaFattr* const fa = getFattr(file);
+
+    if (! fa) {
+        return -ENOENT;
+    }
+    if (fa->type != KFS_FILE) {
+        return -EISDIR;
+    }
+    if (offset < 0 || offset != chunkStartOffset(offset)) {
+        return -EINVAL;
+    }
+    if (! fa->CanWrite(euser, egroup)) {
+        return -EACCES;
+    }
+    if (fa->IsStriped()) {
+        return -EACCES;
+    }
+    if (fa->nextChunkOffset() <= offset) {
+        return 0;
+    }
+
+    StTmp<vector<MetaChunkInfo*> > cinfoTmp(mChunkInfosTmp);
+    vector<MetaChunkInfo*>&        chunkInfo = cinfoTmp.Get();
+    getalloc(fa->id(), chunkInfo);
+    assert(fa->chunkcount() == (int64_t)chunkInfo.size());
+
+    MetaChunkInfoSt const first(fa, offset);
+    vector<MetaChunkInfo *>::iterator m = lower_bound(
+        chunkInfo.begin(), chunkInfo.end(), &first, &ChunkInfo_compare);
+    fa->nextChunkOffset() = m == chunkInfo.begin() ?
+        chunkOff_t(0) : (*(m - 1))->offset + (chunkOff_t)CHUNKSIZE;
+    while (m != chunkInfo.end()) {
+        (*m)->DeleteChunk();
+        ++m;
+        fa->chunkcount()--;
+        UpdateNumChunks(-1);
+    }
+    setFileSize(fa, min(getFileSize(fa), fa->nextChunkOffset()));
+    if (fa->chunkcount() > 0) {
+        invalidateFileSize(fa);
+    }
+    if (mtime) {
+        fa->mtime = *mtime;
+    }
+    return 0;
+}
+
 /*!
  * \brief check whether one directory is a descendant of another
  * \param[in] src file ID of possible ancestor
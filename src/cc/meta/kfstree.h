@@ -613,6 +613,18 @@ public:
      */
     int pruneFromHead(fid_t file, chunkOff_t offset, const int64_t* mtime,
         kfsUid_t euser = kKfsUserRoot, kfsGid_t egroup = kKfsGroupRoot);
+    /*
+     * \brief Delete the unused chunks, allocated ahead by the sequential
+     * writer, starting from the specified chunk boundary, and invalidate
+     * the file size.
+     * \param[in] file  The id of the file
+     * \param[in] offset    The chunk boundary starting from which the chunks
+     *          should be deleted.
+     * \param[in] mtime Modification time
+     * \retval 0 on success; -errno on failure
+     */
+    int reclaimChunks(fid_t file, chunkOff_t offset, const int64_t* mtime,
+        kfsUid_t euser = kKfsUserRoot, kfsGid_t egroup = kKfsGroupRoot);
     void invalidatePathCache(const string& pathname, const string& name,
         const MetaFattr* fa, bool removeDirPrefixFlag = false);
     // PathListerT can be used as argument to build path.
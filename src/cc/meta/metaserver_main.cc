@@ -44,6 +44,7 @@
 #include "Replay.h"
 #include "Restorer.h"
 #include "AuditLog.h"
+#include "common/time.h"
 
 #include <sys/resource.h>
 #include <signal.h>
@@ -147,6 +148,13 @@ public:
             mRestartChunkServersFlag = false;
             gLayoutManager.ScheduleRestartChunkServers();
         }
+        if (mFollowerFlag) {
+            const int64_t now = microseconds() / 1000;
+            if (mFollowerNextPollMs <= now) {
+                mFollowerNextPollMs = now + mFollowerPollIntervalMs;
+                replayer.tailLog();
+            }
+        }
         if (! mSetParametersFlag) {
             return;
         }
@@ -163,6 +171,10 @@ public:
         SetParameters(mProperties);
         gLayoutManager.SetParameters(mProperties);
         mSetParametersCount++;
+        if (mFollowerFlag &&
+                mProperties.getValue("metaServer.follower", 1) == 0) {
+            Promote();
+        }
     }
 private:
     MetaServer()
@@ -181,7 +193,11 @@ private:
           mMinReplicasPerFile(1),
           mIsPathToFidCacheEnabled(false),
           mLogRotateIntervalSec(600),
-          mMaxLockedMemorySize(0)
+          mMaxLockedMemorySize(0),
+          mFollowerFlag(false),
+          mFollowerPollIntervalMs(100),
+          mFollowerMaxStalenessSec(30),
+          mFollowerNextPollMs(0)
         {}
     ~MetaServer()
     {
@@ -263,6 +279,8 @@ private:
         return (ret + "/" + fileName);
     }
     bool Startup(bool createEmptyFsFlag);
+    void StartPrimary();
+    bool Promote();
 
     // This is to get settings from the core file.
     string     mFileName;
@@ -285,6 +303,12 @@ private:
     bool       mIsPathToFidCacheEnabled;
     int        mLogRotateIntervalSec;
     int64_t    mMaxLockedMemorySize;
+    // Follower mode: tail the log written by the primary, and service
+    // read only requests.
+    bool       mFollowerFlag;
+    int        mFollowerPollIntervalMs;
+    int        mFollowerMaxStalenessSec;
+    int64_t    mFollowerNextPollMs;
 
     static MetaServer sInstance;
 } MetaServer::sInstance;
@@ -322,6 +346,12 @@ MetaServer::SetParameters(const Properties& props)
     metatree.setUpdatePathSpaceUsage(props.getValue(
         "metaServer.updateDirSizes",
         metatree.getUpdatePathSpaceUsageFlag() ? 1 : 0) != 0);
+
+    mFollowerPollIntervalMs = max(1, props.getValue(
+        "metaServer.follower.pollIntervalMs", mFollowerPollIntervalMs));
+    mFollowerMaxStalenessSec = max(1, props.getValue(
+        "metaServer.follower.maxStalenessSec", mFollowerMaxStalenessSec));
+    setFollowerMode(mFollowerFlag, mFollowerMaxStalenessSec);
 }
 
 ///
@@ -425,6 +455,11 @@ MetaServer::Startup(const Properties& props, bool createEmptyFsFlag)
     KFS_LOG_EOM;
     mLogDir = props.getValue("metaServer.logDir", mLogDir);
     mCPDir = props.getValue("metaServer.cpDir", mCPDir);
+    mFollowerFlag = props.getValue("metaServer.follower",
+        mFollowerFlag ? 1 : 0) != 0;
+    if (mFollowerFlag) {
+        KFS_LOG_STREAM_INFO << "follower mode" << KFS_LOG_EOM;
+    }
     // By default, path->fid cache is disabled.
     mIsPathToFidCacheEnabled = (props.getValue("metaServer.enablePathToFidCache",
         mIsPathToFidCacheEnabled ? 1 : 0)) != 0;
@@ -472,6 +507,11 @@ MetaServer::Startup(bool createEmptyFsFlag)
 
     int status;
     errno = 0;
+    if (mFollowerFlag && ! file_exists(LASTCP)) {
+        KFS_LOG_STREAM_FATAL << "follower: no checkpoint: " << LASTCP <<
+        KFS_LOG_EOM;
+        return false;
+    }
     if (! createEmptyFsFlag || file_exists(LASTCP)) {
         Restorer r;
         status = r.rebuild(LASTCP, mMinReplicasPerFile) ? 0 : -EIO;
@@ -495,7 +535,9 @@ MetaServer::Startup(bool createEmptyFsFlag)
         return false;
     }
     KFS_LOG_STREAM_INFO << "replaying logs" << KFS_LOG_EOM;
-    status = replayer.playAllLogs();
+    // The follower replays only complete logs here, the last log might be
+    // being written by the primary, and is handled by the log tail.
+    status = mFollowerFlag ? replayer.playLogs() : replayer.playAllLogs();
     if (status != 0) {
         KFS_LOG_STREAM_FATAL << "log replay failed: " <<
             QCUtils::SysError(-status) <<
@@ -510,6 +552,23 @@ MetaServer::Startup(bool createEmptyFsFlag)
     if (mIsPathToFidCacheEnabled) {
         metatree.enablePathToFidCache();
     }
+    if (mFollowerFlag) {
+        if ((status = replayer.tailLog()) != 0) {
+            KFS_LOG_STREAM_FATAL << "follower: log tail failed: " <<
+                QCUtils::SysError(-status) <<
+            KFS_LOG_EOM;
+            return false;
+        }
+        setFollowerMode(mFollowerFlag, mFollowerMaxStalenessSec);
+        return true;
+    }
+    StartPrimary();
+    return true;
+}
+
+void
+MetaServer::StartPrimary()
+{
     // empty the dumpster dir on startup; if it doesn't exist, create it
     // whatever is in the dumpster needs to be nuked anyway; if we
     // remove all the file entries from that dir, the space for the
@@ -519,6 +578,33 @@ MetaServer::Startup(bool createEmptyFsFlag)
     logger_init(mLogRotateIntervalSec);
     checkpointer_init();
     gLayoutManager.InitRecoveryStartTime();
+}
+
+///
+/// Switch from follower to primary. The primary must be stopped prior to
+/// promotion, the remaining log entries written by the primary are applied,
+/// and the log writer appends to the last log, if it is incomplete.
+///
+bool
+MetaServer::Promote()
+{
+    int status = replayer.tailLog();
+    if (status == 0) {
+        status = replayer.stopTail();
+    }
+    if (status != 0) {
+        KFS_LOG_STREAM_ERROR << "follower promotion failed: " <<
+            QCUtils::SysError(-status) <<
+        KFS_LOG_EOM;
+        return false;
+    }
+    mFollowerFlag = false;
+    setFollowerMode(mFollowerFlag, mFollowerMaxStalenessSec);
+    KFS_LOG_STREAM_INFO << "promoted to primary:"
+        " log: "    << replayer.logno() <<
+        " append: " << replayer.getAppendToLastLogFlag() <<
+    KFS_LOG_EOM;
+    StartPrimary();
     return true;
 }
 
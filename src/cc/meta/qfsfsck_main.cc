@@ -58,38 +58,17 @@ using std::istringstream;
 const string KFS_VERSION_STR = "KFS/1.0";
 
 static bool
-getFsckInfo(string metahost, int metaport,
-    bool reportAbandonedFilesFlag, int timeoutSec)
+fsckRpc(TcpSocket& sock, const string& req, int timeoutSec,
+    Properties& prop, boost::scoped_array<char>& buf, int& contentLength)
 {
-    TcpSocket sock;
-    ServerLocation loc(metahost, metaport);
-    int ret, len;
-    Properties prop;
-    boost::scoped_array<char> buf;
-
-    ret = sock.Connect(loc);
-
-    if (ret < 0) {
-        cout << "Unable to connect to metaserver...exiting\n";
-        return false;
-    }
-
-    ostringstream os;
-    os <<
-        "FSCK\r\n"
-        "Version: " << KFS_VERSION_STR << "\r\n"
-        "Cseq: "    << 1               << "\r\n"
-        "Report-Abandoned-Files: " <<
-            (reportAbandonedFilesFlag ? 1 : 0) << "\r\n"
-    "\r\n";
-    const string str = os.str();
-    ret = sock.DoSynchSend(str.c_str(), str.length());
+    int ret = sock.DoSynchSend(req.c_str(), req.length());
     if (ret <= 0) {
         cout << "Unable to send fsck rpc to metaserver\n";
         return false;
     }
 
     // get the response and get the data
+    int len;
     buf.reset(new char[MAX_RPC_HEADER_LEN]);
     int nread = RecvResponseHeader(buf.get(), MAX_RPC_HEADER_LEN, &sock,
         timeoutSec > 0 ? timeoutSec : 1000, &len);
@@ -101,6 +80,7 @@ getFsckInfo(string metahost, int metaport,
     istringstream ist(buf.get());
     const char kSeparator = ':';
 
+    prop.clear();
     prop.loadProperties(ist, kSeparator, false);
     const int status = prop.getValue("Status", 0);
     if (status < 0) {
@@ -113,13 +93,16 @@ getFsckInfo(string metahost, int metaport,
         return false;
     }
 
-    const int contentLength = prop.getValue("Content-length", 0);
-    if (contentLength <= 0) {
+    contentLength = prop.getValue("Content-length", 0);
+    if (contentLength < 0) {
         cout << "invalid meta server fsck reply\n";
         return false;
     }
     // Get the body
     buf.reset(new char[contentLength + 1]);
+    if (contentLength <= 0) {
+        return true;
+    }
     struct timeval timeout = {timeoutSec > 0 ? timeoutSec : 1000, 0};
     nread = sock.DoSynchRecv(buf.get(), contentLength, timeout);
     if (nread < contentLength) {
@@ -127,6 +110,39 @@ getFsckInfo(string metahost, int metaport,
             nread << "\n";
         return false;
     }
+    return true;
+}
+
+static bool
+getFsckInfo(string metahost, int metaport,
+    bool reportAbandonedFilesFlag, int timeoutSec)
+{
+    TcpSocket sock;
+    ServerLocation loc(metahost, metaport);
+    Properties prop;
+    boost::scoped_array<char> buf;
+
+    if (sock.Connect(loc) < 0) {
+        cout << "Unable to connect to metaserver...exiting\n";
+        return false;
+    }
+
+    ostringstream os;
+    os <<
+        "FSCK\r\n"
+        "Version: " << KFS_VERSION_STR << "\r\n"
+        "Cseq: "    << 1               << "\r\n"
+        "Report-Abandoned-Files: " <<
+            (reportAbandonedFilesFlag ? 1 : 0) << "\r\n"
+    "\r\n";
+    int contentLength = 0;
+    if (! fsckRpc(sock, os.str(), timeoutSec, prop, buf, contentLength)) {
+        return false;
+    }
+    if (contentLength <= 0) {
+        cout << "invalid meta server fsck reply\n";
+        return false;
+    }
     cout.write(buf.get(), contentLength);
     const char* const okHdrs[] = {
         "Total lost files: 0\n",
@@ -144,6 +160,97 @@ getFsckInfo(string metahost, int metaport,
     return false;
 }
 
+// Start fsck in the background on the meta server, and stream its output
+// as it goes. The meta server runs the background fsck with no time and no
+// reported files count limits. The progress is reported to stderr.
+static bool
+getBackgroundFsckInfo(string metahost, int metaport,
+    bool reportAbandonedFilesFlag, int timeoutSec, int pollIntervalSec)
+{
+    TcpSocket sock;
+    ServerLocation loc(metahost, metaport);
+    Properties prop;
+    boost::scoped_array<char> buf;
+
+    if (sock.Connect(loc) < 0) {
+        cout << "Unable to connect to metaserver...exiting\n";
+        return false;
+    }
+
+    int     seq           = 1;
+    int64_t fsckId        = -1;
+    int64_t pos           = 0;
+    int     contentLength = 0;
+    for (; ;) {
+        ostringstream os;
+        os <<
+            "FSCK\r\n"
+            "Version: " << KFS_VERSION_STR << "\r\n"
+            "Cseq: "    << seq++           << "\r\n"
+            "Report-Abandoned-Files: " <<
+                (reportAbandonedFilesFlag ? 1 : 0) << "\r\n"
+        ;
+        if (fsckId < 0) {
+            os << "Fsck-background: 1\r\n";
+        } else {
+            os <<
+                "Fsck-id: "  << fsckId << "\r\n"
+                "Fsck-pos: " << pos    << "\r\n"
+            ;
+        }
+        os << "\r\n";
+        if (! fsckRpc(sock, os.str(), timeoutSec, prop, buf, contentLength)) {
+            return false;
+        }
+        if (fsckId < 0) {
+            fsckId = prop.getValue("Fsck-id", int64_t(-1));
+            if (fsckId < 0) {
+                cout << "invalid meta server fsck reply\n";
+                return false;
+            }
+            continue;
+        }
+        if (prop.getValue("Fsck-pos", int64_t(-1)) != pos) {
+            cout << "invalid meta server fsck reply\n";
+            return false;
+        }
+        cout.write(buf.get(), contentLength);
+        pos += contentLength;
+        const bool    doneFlag  = prop.getValue("Fsck-done", 0) != 0;
+        const int64_t size      = prop.getValue("Fsck-size", int64_t(-1));
+        const int64_t lostFiles = prop.getValue("Fsck-lost-files",
+            int64_t(-1));
+        if (doneFlag && size <= pos) {
+            cout.flush();
+            const int fsckStatus = prop.getValue("Fsck-status", 0);
+            if (fsckStatus != 0) {
+                cout << "Background fsck failed, exit status: " <<
+                    fsckStatus << "\n";
+                return false;
+            }
+            if (lostFiles == 0) {
+                cout << "Filesystem is HEALTHY\n";
+                return true;
+            }
+            return false;
+        }
+        if (pos < size) {
+            continue;
+        }
+        cout.flush();
+        cerr << "fsck progress:"
+            " files: "  <<
+                prop.getValue("Fsck-files-checked", int64_t(0)) <<
+            " of "      << prop.getValue("Fsck-files", int64_t(0)) <<
+            " chunks: " <<
+                prop.getValue("Fsck-chunks-checked", int64_t(0)) <<
+            " of "      << prop.getValue("Fsck-chunks", int64_t(0)) <<
+            " lost files: " << lostFiles <<
+        "\n";
+        sleep(pollIntervalSec > 0 ? pollIntervalSec : 1);
+    }
+}
+
 static int
 restoreCheckpoint(const string& lockfn, bool allowEmptyCheckpointFlag)
 {
@@ -173,8 +280,9 @@ FsckMain(int argc, char** argv)
     bool   reportAbandonedFilesFlag = true;
     bool   allowEmptyCheckpointFlag = false;
     int    timeoutSec = 60 * 25;
+    int    backgroundPollIntervalSec = -1;
 
-    while ((optchar = getopt(argc, argv, "hl:c:m:p:L:a:t:s:e:")) != -1) {
+    while ((optchar = getopt(argc, argv, "hl:c:m:p:L:a:t:s:e:b:")) != -1) {
         switch (optchar) {
             case 'L':
                 lockFn = optarg;
@@ -201,6 +309,9 @@ FsckMain(int argc, char** argv)
             case 'e':
                 allowEmptyCheckpointFlag = atoi(optarg) != 0;
                 break;
+            case 'b':
+                backgroundPollIntervalSec = atoi(optarg);
+                break;
             case 'h':
                 help = true;
                 break;
@@ -221,6 +332,8 @@ FsckMain(int argc, char** argv)
             "[-a {0|1} report abandoned files (default 1)]\n"
             "[-t <timeout seconds> default 25 min]\n"
             "[-e {0|1} allow empty checkpoint]\n"
+            "[-b <poll interval seconds> run fsck in the background on the"
+                " meta server, and stream the output]\n"
         ;
         return status;
     }
@@ -228,8 +341,12 @@ FsckMain(int argc, char** argv)
     MdStream::Init();
     KFS::MsgLogger::Init(0, MsgLogger::kLogLevelINFO);
 
-    const bool ok = metahost.empty() || metaport < 0 ||
-        getFsckInfo(metahost, metaport, reportAbandonedFilesFlag, timeoutSec);
+    const bool ok = metahost.empty() || metaport < 0 || (
+        backgroundPollIntervalSec < 0 ?
+        getFsckInfo(metahost, metaport, reportAbandonedFilesFlag,
+            timeoutSec) :
+        getBackgroundFsckInfo(metahost, metaport, reportAbandonedFilesFlag,
+            timeoutSec, backgroundPollIntervalSec));
     if ((logdir.empty() && cpdir.empty()) || ! ok) {
         return (ok ? 0 : 1);
     }
@@ -32,6 +32,7 @@
 #include "qcdebug.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/uio.h>
@@ -81,6 +82,7 @@ public:
           mIoVecPerThreadCount(0),
           mFreeFdHead(kFreeFdEnd),
           mReqWaitersCount(0),
+          mDeleteBatchInFlightCount(0),
           mDebugTracerPtr(0),
           mIoStartObserverPtr(0),
           mRunFlag(false),
@@ -158,6 +160,17 @@ public:
         const char*    inFileNamePtr,
         IoCompletion*  inIoCompletionPtr,
         Time           inTimeWaitNanoSec);
+    EnqueueStatus DeleteBatch(
+        const char*    inFileNamesPtr,
+        size_t         inFileNamesLength,
+        IoCompletion*  inIoCompletionPtr,
+        Time           inTimeWaitNanoSec);
+    EnqueueStatus PunchHole(
+        const char*    inFileNamePtr,
+        int64_t        inOffset,
+        int64_t        inLength,
+        IoCompletion*  inIoCompletionPtr,
+        Time           inTimeWaitNanoSec);
     EnqueueStatus GetFsSpaceAvailable(
         const char*    inPathNamePtr,
         IoCompletion*  inIoCompletionPtr,
@@ -171,7 +184,10 @@ public:
         const char*    inFileName1Ptr,
         const char*    inFileName2Ptr,
         IoCompletion*  inIoCompletionPtr,
-        Time           inTimeWaitNanoSec);
+        Time           inTimeWaitNanoSec,
+        size_t         inFileName1Length = 0,
+        int64_t        inOffset          = 0,
+        int64_t        inLength          = 0);
 
     static bool IsBarrierReqType(
         ReqType inReqType)
@@ -193,7 +209,9 @@ public:
         return (
             IsBarrierReqType(inReqType) ||
             inReqType == kReqTypeGetFsAvailable ||
-            inReqType == kReqTypeCheckDirReadable
+            inReqType == kReqTypeCheckDirReadable ||
+            inReqType == kReqTypeDeleteBatch ||
+            inReqType == kReqTypePunchHole
         );
     }
 private:
@@ -216,6 +234,8 @@ private:
               mBufferCount(0),
               mFileIdx(0),
               mBlockIdx(0),
+              mOffset(0),
+              mLength(0),
               mIoCompletionPtr(0)
             {}
         ~Request()
@@ -231,6 +251,8 @@ private:
         int           mBufferCount;
         uint64_t      mFileIdx:16;
         uint64_t      mBlockIdx:48;
+        int64_t       mOffset; // Byte range of the punch hole request.
+        int64_t       mLength;
         IoCompletion* mIoCompletionPtr;
     };
 
@@ -383,6 +405,7 @@ private:
     int              mIoVecPerThreadCount;
     int              mFreeFdHead;
     int              mReqWaitersCount;
+    int              mDeleteBatchInFlightCount;
     DebugTracer*     mDebugTracerPtr;
     IoStartObserver* mIoStartObserverPtr;
     bool             mRunFlag;
@@ -1111,6 +1134,12 @@ QCDiskQueue::Queue::Run(
             mWorkCond.NotifyAll(); // Wake up other threads after barrier req.
         }
         theBarrierFlag = mBarrierFlag;
+        // Batch delete is not a barrier, wait for all batch deletes in
+        // flight to complete before processing barrier request, in order to
+        // preserve name space operations order.
+        while (mBarrierFlag && mDeleteBatchInFlightCount > 0 && mRunFlag) {
+            mWorkCond.Wait(mMutex);
+        }
         if (theReqPtr) {
             QCASSERT(mPendingCloseHead == kEndOfPendingCloseList);
             const FileIdx theFileIdx = theReqPtr->mFileIdx;
@@ -1469,6 +1498,8 @@ QCDiskQueue::Queue::ProcessMeta(
     QCASSERT(
         mMutex.IsOwned() &&
         (inReq.mReqType == kReqTypeDelete ||
+         inReq.mReqType == kReqTypeDeleteBatch ||
+         inReq.mReqType == kReqTypePunchHole ||
          inReq.mReqType == kReqTypeRename ||
          inReq.mReqType == kReqTypeGetFsAvailable ||
          inReq.mReqType == kReqTypeCheckDirReadable) &&
@@ -1478,9 +1509,14 @@ QCDiskQueue::Queue::ProcessMeta(
     const char* const theNamePtr       = GetBuffersPtr(inReq)[0];
     const ReqType     theReqType       = inReq.mReqType;
     const size_t      theNextNameStart = inReq.mBlockIdx;
+    const int64_t     theOffset        = inReq.mOffset;
+    const int64_t     theLength        = inReq.mLength;
     const RequestId   theReqId         = GetRequestId(inReq);
     const int         theBlockSize     = mBlockSize;
     QCASSERT(theNamePtr);
+    if (theReqType == kReqTypeDeleteBatch) {
+        mDeleteBatchInFlightCount++;
+    }
     QCStMutexUnlocker theUnlock(mMutex);
 
     Trace("process: meta", inReq);
@@ -1505,6 +1541,39 @@ QCDiskQueue::Queue::ProcessMeta(
                 theError  = kErrorDelete;
             }
             break;
+        case kReqTypeDeleteBatch:
+            // The list is terminated by an empty name. Attempt to delete all
+            // files, and report the first error, if any.
+            for (const char* thePtr = theNamePtr; *thePtr; ) {
+                if (unlink(thePtr)) {
+                    if (theError == kErrorNone) {
+                        theSysErr = errno;
+                        theError  = kErrorDelete;
+                    }
+                } else {
+                    theRetCount++;
+                }
+                thePtr += strlen(thePtr) + 1;
+            }
+            break;
+        case kReqTypePunchHole: {
+                const int theFd = open(theNamePtr, O_RDWR);
+                if (theFd < 0) {
+                    theSysErr = errno;
+                } else {
+                    theSysErr = QCUtils::ReleaseFileSpace(
+                        theFd, theOffset, theLength);
+                    if (close(theFd) && theSysErr == 0) {
+                        theSysErr = errno;
+                    }
+                }
+                if (theSysErr) {
+                    theError = kErrorPunchHole;
+                } else {
+                    theRetCount = theLength;
+                }
+            }
+            break;
         case kReqTypeRename:
             if (rename(theNamePtr, theNamePtr + theNextNameStart)) {
                 theSysErr = errno;
@@ -1543,6 +1612,12 @@ QCDiskQueue::Queue::ProcessMeta(
     }
 
     theUnlock.Lock();
+    if (theReqType == kReqTypeDeleteBatch) {
+        QCASSERT(mDeleteBatchInFlightCount > 0);
+        if (--mDeleteBatchInFlightCount <= 0 && mBarrierFlag) {
+            mWorkCond.NotifyAll(); // Wake up barrier request thread.
+        }
+    }
     RequestComplete(inReq, theError, theSysErr, theRetCount, false, theBlkIdx);
 }
 
@@ -1722,6 +1797,51 @@ QCDiskQueue::Queue::Delete(
     );
 }
 
+    QCDiskQueue::EnqueueStatus
+QCDiskQueue::Queue::DeleteBatch(
+    const char*                inFileNamesPtr,
+    size_t                     inFileNamesLength,
+    QCDiskQueue::IoCompletion* inIoCompletionPtr,
+    QCDiskQueue::Time          inTimeWaitNanoSec)
+{
+    if (! inFileNamesPtr || inFileNamesLength <= 0 || ! *inFileNamesPtr ||
+            inFileNamesPtr[inFileNamesLength - 1] != 0) {
+        return EnqueueStatus(kRequestIdNone, kErrorParameter);
+    }
+    return EnqueueMeta(
+        kReqTypeDeleteBatch,
+        inFileNamesPtr,
+        0,
+        inIoCompletionPtr,
+        inTimeWaitNanoSec,
+        inFileNamesLength
+    );
+}
+
+    QCDiskQueue::EnqueueStatus
+QCDiskQueue::Queue::PunchHole(
+    const char*                inFileNamePtr,
+    int64_t                    inOffset,
+    int64_t                    inLength,
+    QCDiskQueue::IoCompletion* inIoCompletionPtr,
+    QCDiskQueue::Time          inTimeWaitNanoSec)
+{
+    if (! inFileNamePtr || ! *inFileNamePtr || inOffset < 0 ||
+            inLength <= 0) {
+        return EnqueueStatus(kRequestIdNone, kErrorParameter);
+    }
+    return EnqueueMeta(
+        kReqTypePunchHole,
+        inFileNamePtr,
+        0,
+        inIoCompletionPtr,
+        inTimeWaitNanoSec,
+        0,
+        inOffset,
+        inLength
+    );
+}
+
     QCDiskQueue::EnqueueStatus
 QCDiskQueue::Queue::GetFsSpaceAvailable(
     const char*                inPathNamePtr,
@@ -1764,7 +1884,10 @@ QCDiskQueue::Queue::EnqueueMeta(
     const char*                inFileName1Ptr,
     const char*                inFileName2Ptr,
     QCDiskQueue::IoCompletion* inIoCompletionPtr,
-    QCDiskQueue::Time          inTimeWaitNanoSec)
+    QCDiskQueue::Time          inTimeWaitNanoSec,
+    size_t                     inFileName1Length,
+    int64_t                    inOffset,
+    int64_t                    inLength)
 {
     if (! IsMetaReqType(inReqType)) {
         return EnqueueStatus(kRequestIdNone, kErrorParameter);
@@ -1777,13 +1900,21 @@ QCDiskQueue::Queue::EnqueueMeta(
     if (! theReqPtr) {
         return EnqueueStatus(kRequestIdNone, kErrorOutOfRequests);
     }
-    const size_t theFileName1Len =
-        inFileName1Ptr ? strlen(inFileName1Ptr) + 1 : 0;
+    // If the length is specified, then the name is a list of null terminated
+    // names, add extra null to mark the end of the list.
+    const size_t theFileName1Len = inFileName1Length > 0 ?
+        inFileName1Length + 1 :
+        (inFileName1Ptr ? strlen(inFileName1Ptr) + 1 : 0);
     const size_t theFileName2Len =
         inFileName2Ptr ? strlen(inFileName2Ptr) + 1 : 0;
     char* const  theFileNamesPtr = (theFileName1Len + theFileName2Len > 0) ?
         new char[theFileName1Len + theFileName2Len] : 0;
-    memcpy(theFileNamesPtr, inFileName1Ptr, theFileName1Len);
+    if (inFileName1Length > 0) {
+        memcpy(theFileNamesPtr, inFileName1Ptr, inFileName1Length);
+        theFileNamesPtr[inFileName1Length] = 0;
+    } else {
+        memcpy(theFileNamesPtr, inFileName1Ptr, theFileName1Len);
+    }
     memcpy(theFileNamesPtr + theFileName1Len, inFileName2Ptr,
         theFileName2Len);
 
@@ -1792,6 +1923,8 @@ QCDiskQueue::Queue::EnqueueMeta(
     theReq.mBufferCount     = 0;
     theReq.mFileIdx         = mFileCount - 1;
     theReq.mBlockIdx        = inFileName2Ptr ? theFileName1Len : 0;
+    theReq.mOffset          = inOffset;
+    theReq.mLength          = inLength;
     theReq.mIoCompletionPtr = inIoCompletionPtr;
     GetBuffersPtr(theReq)[0] = theFileNamesPtr;
     Enqueue(theReq);
@@ -1908,6 +2041,7 @@ QCDiskQueue::ToString(
         case kErrorRename:               return "rename";
         case kErrorGetFsAvailable:       return "get fs available";
         case kErrorCheckDirReadable:     return "dir readable";
+        case kErrorPunchHole:            return "punch hole";
         default:                         return "invalid error code";
     }
 }
@@ -2113,6 +2247,35 @@ QCDiskQueue::Delete(
     );
 }
 
+    QCDiskQueue::EnqueueStatus
+QCDiskQueue::DeleteBatch(
+        const char*                inFileNamesPtr,
+        size_t                     inFileNamesLength,
+        QCDiskQueue::IoCompletion* inIoCompletionPtr,
+        QCDiskQueue::Time          inTimeWaitNanoSec /* = -1 */)
+{
+    return (mQueuePtr ?
+        mQueuePtr->DeleteBatch(inFileNamesPtr, inFileNamesLength,
+            inIoCompletionPtr, inTimeWaitNanoSec) :
+        EnqueueStatus(kRequestIdNone, kErrorParameter)
+    );
+}
+
+    QCDiskQueue::EnqueueStatus
+QCDiskQueue::PunchHole(
+        const char*                inFileNamePtr,
+        int64_t                    inOffset,
+        int64_t                    inLength,
+        QCDiskQueue::IoCompletion* inIoCompletionPtr,
+        QCDiskQueue::Time          inTimeWaitNanoSec /* = -1 */)
+{
+    return (mQueuePtr ?
+        mQueuePtr->PunchHole(inFileNamePtr, inOffset, inLength,
+            inIoCompletionPtr, inTimeWaitNanoSec) :
+        EnqueueStatus(kRequestIdNone, kErrorParameter)
+    );
+}
+
     QCDiskQueue::EnqueueStatus
 QCDiskQueue::GetFsSpaceAvailable(
         const char*                inPathNamePtr,
@@ -63,6 +63,8 @@ public:
         kReqTypeGetFsAvailable   = 9,
         kReqTypeCheckDirReadable = 10,
         kReqTypeClose            = 11,
+        kReqTypeDeleteBatch      = 12,
+        kReqTypePunchHole        = 13,
         kReqTypeMax
     };
 
@@ -88,7 +90,8 @@ public:
         kErrorDelete               = 17,
         kErrorRename               = 18,
         kErrorGetFsAvailable       = 19,
-        kErrorCheckDirReadable     = 20
+        kErrorCheckDirReadable     = 20,
+        kErrorPunchHole            = 21
     };
 
     enum { kRequestIdNone = -1 };
@@ -383,6 +386,31 @@ public:
         IoCompletion*  inIoCompletionPtr,
         Time           inTimeWaitNanoSec = -1);
 
+    // Delete list of files. The file names are null terminated, and
+    // inFileNamesLength includes all terminating nulls. Unlike Delete() the
+    // request is not a barrier: reads and writes are processed concurrently
+    // with the delete. The barrier requests (open, create, rename, delete)
+    // wait for all batch deletes in flight to complete, therefore the order
+    // of the name space operations is preserved.
+    // On success the io byte count in the completion is the number of files
+    // deleted.
+    EnqueueStatus DeleteBatch(
+        const char*    inFileNamesPtr,
+        size_t         inFileNamesLength,
+        IoCompletion*  inIoCompletionPtr,
+        Time           inTimeWaitNanoSec = -1);
+
+    // Deallocate file space in the specified byte range, the file size does
+    // not change, and the range reads as zeros. The request is not a barrier.
+    // The caller must ensure that no reads or writes in the range are in
+    // flight.
+    EnqueueStatus PunchHole(
+        const char*    inFileNamePtr,
+        int64_t        inOffset,
+        int64_t        inLength,
+        IoCompletion*  inIoCompletionPtr,
+        Time           inTimeWaitNanoSec = -1);
+
     EnqueueStatus GetFsSpaceAvailable(
         const char*    inFileNamePtr,
         IoCompletion*  inIoCompletionPtr,
@@ -174,6 +174,75 @@ private:
     Partition*   mNextPtr[1];
 };
 
+// Per thread buffer cache. The cache mutex is normally only acquired by the
+// owning thread, and is therefore not contended. The lock order is the cache
+// mutex first, then the pool mutex. The pool only "try locks" the caches of
+// the other threads while holding the pool mutex, see ReclaimThreadCaches(),
+// and Destroy() drains the caches with the pool mutex released.
+class QCIoBufferPool::ThreadCache
+{
+public:
+    typedef QCDLList<ThreadCache, 0> List;
+
+    ThreadCache(
+        QCIoBufferPool& inPool)
+        : mMutex(),
+          mPool(inPool),
+          mBufsPtr(0),
+          mCount(0),
+          mCapacity(0),
+          mDetachedFlag(false),
+          mOrphanFlag(false)
+        { List::Init(*this); }
+    ~ThreadCache()
+        { delete [] mBufsPtr; }
+    void SetCapacity(
+        int inCapacity)
+    {
+        QCASSERT(mCount == 0);
+        if (inCapacity == mCapacity) {
+            return;
+        }
+        delete [] mBufsPtr;
+        mBufsPtr  = inCapacity > 0 ? new char*[inCapacity] : 0;
+        mCapacity = inCapacity > 0 ? inCapacity : 0;
+    }
+    char* Get()
+        { return (mCount > 0 ? mBufsPtr[--mCount] : 0); }
+    bool Put(
+        char* inBufPtr)
+    {
+        if (mCount >= mCapacity) {
+            return false;
+        }
+        mBufsPtr[mCount++] = inBufPtr;
+        return true;
+    }
+    bool IsFull() const
+        { return (mCount >= mCapacity); }
+
+    QCMutex         mMutex;
+    QCIoBufferPool& mPool;
+    char**          mBufsPtr;
+    int             mCount;
+    int             mCapacity;
+    // Protected by the pool mutex. The detached cache is being drained by
+    // Destroy(), and the orphan cache's thread has exited while the cache
+    // was detached, and has to be deleted by Destroy().
+    bool            mDetachedFlag;
+    bool            mOrphanFlag;
+private:
+    ThreadCache*    mPrevPtr[1];
+    ThreadCache*    mNextPtr[1];
+    friend class QCDLListOp<ThreadCache, 0>;
+    friend class QCDLListOp<const ThreadCache, 0>;
+private:
+    ThreadCache(
+        const ThreadCache& inCache);
+    ThreadCache& operator=(
+        const ThreadCache& inCache);
+};
+
 typedef QCDLList<QCIoBufferPool::Client, 0> QCIoBufferPoolClientList;
 
 QCIoBufferPool::Client::Client()
@@ -190,23 +259,38 @@ QCIoBufferPool::Client::Unregister()
 
 QCIoBufferPool::QCIoBufferPool()
     : mMutex(),
+      mThreadCacheKey(),
+      mThreadCacheKeyFlag(false),
+      mThreadCacheSize(0),
       mBufferSize(0),
       mFreeCnt(0),
       mTotalCnt(0)
 {
     QCIoBufferPoolClientList::Init(mClientListPtr);
     Partition::List::Init(mPartitionListPtr);
+    ThreadCache::List::Init(mThreadCacheListPtr);
 }
 
 QCIoBufferPool::~QCIoBufferPool()
 {
-    QCStMutexLocker theLock(mMutex);
     QCIoBufferPool::Destroy();
+    QCStMutexLocker theLock(mMutex);
     while (! QCIoBufferPoolClientList::IsEmpty(mClientListPtr)) {
         Client& theClient = *QCIoBufferPoolClientList::PopBack(mClientListPtr);
         QCASSERT(theClient.mPoolPtr == this);
         theClient.mPoolPtr = 0;
     }
+    if (mThreadCacheKeyFlag) {
+        // Deleting the key does not invoke the thread specific destructors.
+        const int theErr = pthread_key_delete(mThreadCacheKey);
+        if (theErr) {
+            QCUtils::FatalError("pthread_key_delete", theErr);
+        }
+        mThreadCacheKeyFlag = false;
+    }
+    while (! ThreadCache::List::IsEmpty(mThreadCacheListPtr)) {
+        delete ThreadCache::List::PopBack(mThreadCacheListPtr);
+    }
 }
 
 int
@@ -214,57 +298,117 @@ QCIoBufferPool::Create(
     int          inPartitionCount,
     int          inPartitionBufferCount,
     int          inBufferSize,
-    bool         inLockMemoryFlag)
+    bool         inLockMemoryFlag,
+    int          inThreadCacheBufferCount /* = 0 */)
 {
-    QCStMutexLocker theLock(mMutex);
     Destroy();
+    QCStMutexLocker theLock(mMutex);
     mBufferSize = inBufferSize;
     int theErr = 0;
+    if (inThreadCacheBufferCount > 0 && ! mThreadCacheKeyFlag) {
+        theErr = pthread_key_create(&mThreadCacheKey, &DeleteThreadCache);
+        if (theErr) {
+            return theErr;
+        }
+        mThreadCacheKeyFlag = true;
+    }
     for (int i = 0; i < inPartitionCount; i++) {
         Partition& thePart = *(new Partition());
         Partition::List::PushBack(mPartitionListPtr, thePart);
         theErr = thePart.Create(
             inPartitionBufferCount, inBufferSize, inLockMemoryFlag);
         if (theErr) {
-            Destroy();
+            // The thread caches are not enabled yet, and are empty.
+            DeletePartitions();
             break;
         }
         mFreeCnt  += thePart.GetFreeCount();
         mTotalCnt += thePart.GetTotalCount();
     }
+    if (theErr == 0) {
+        // Cache of one buffer only adds overhead, as no batching is possible.
+        mThreadCacheSize = inThreadCacheBufferCount > 1 ?
+            inThreadCacheBufferCount : 0;
+    }
     return theErr;
 }
 
 void
 QCIoBufferPool::Destroy()
 {
+    // The buffers in the thread caches belong to the partitions, and must be
+    // discarded before the partitions are deleted. Locking a cache mutex while
+    // holding the pool mutex would violate the lock order, therefore detach
+    // the caches under the pool mutex, then drain each cache with only its
+    // mutex held.
+    QCASSERT(! mMutex.IsOwned());
+    ThreadCache* theCachesPtr[1];
+    ThreadCache::List::Init(theCachesPtr);
+    {
+        QCStMutexLocker theLock(mMutex);
+        mThreadCacheSize = 0;
+        ThreadCache* theCachePtr;
+        while ((theCachePtr = ThreadCache::List::PopFront(
+                mThreadCacheListPtr))) {
+            theCachePtr->mDetachedFlag = true;
+            ThreadCache::List::PushBack(theCachesPtr, *theCachePtr);
+        }
+    }
+    // The detached caches are not deleted by the thread exit, and the list is
+    // not modified until the pool mutex is acquired again.
+    ThreadCache::List::Iterator theIt(theCachesPtr);
+    ThreadCache* theCachePtr;
+    while ((theCachePtr = theIt.Next())) {
+        QCStMutexLocker theCacheLock(theCachePtr->mMutex);
+        theCachePtr->mCount = 0;
+        theCachePtr->SetCapacity(0);
+    }
     QCStMutexLocker theLock(mMutex);
+    while ((theCachePtr = ThreadCache::List::PopFront(theCachesPtr))) {
+        if (theCachePtr->mOrphanFlag) {
+            delete theCachePtr;
+        } else {
+            theCachePtr->mDetachedFlag = false;
+            ThreadCache::List::PushBack(mThreadCacheListPtr, *theCachePtr);
+        }
+    }
+    DeletePartitions();
+}
+
+void
+QCIoBufferPool::DeletePartitions()
+{
+    QCASSERT(mMutex.IsOwned());
     while (! Partition::List::IsEmpty(mPartitionListPtr)) {
         delete Partition::List::PopBack(mPartitionListPtr);
     }
     mBufferSize = 0;
     mFreeCnt    = 0;
+    mTotalCnt   = 0;
 }
 
 char*
 QCIoBufferPool::Get(
     QCIoBufferPool::RefillReqId inRefillReqId /* = kRefillReqIdUndefined */)
 {
+    ThreadCache* const theCachePtr = GetThreadCache();
+    if (theCachePtr) {
+        QCStMutexLocker theCacheLock(theCachePtr->mMutex);
+        char* theBufPtr = theCachePtr->Get();
+        if (! theBufPtr) {
+            QCStMutexLocker theLock(mMutex);
+            Refill(*theCachePtr);
+            theBufPtr = theCachePtr->Get();
+        }
+        if (theBufPtr) {
+            return theBufPtr;
+        }
+    }
     QCStMutexLocker theLock(mMutex);
     if (mFreeCnt <= 0 && ! TryToRefill(inRefillReqId, 1)) {
         return 0;
     }
-    QCASSERT(mFreeCnt >= 1);
-    // Always start from the first partition, to try to keep next
-    // partitions full, and be able to reclaim these if needed.
-    Partition::List::Iterator theItr(mPartitionListPtr);
-    Partition* thePtr;
-    while ((thePtr = theItr.Next()) && thePtr->IsEmpty())
-        {}
-    char* const theBufPtr = thePtr ? thePtr->Get() : 0;
-    QCASSERT(theBufPtr && mFreeCnt > 0);
-    mFreeCnt--;
-    return theBufPtr;
+    return GetSelf();
 }
 
 bool
@@ -276,6 +420,16 @@ QCIoBufferPool::Get(
     if (inBufCnt <= 0) {
         return true;
     }
+    ThreadCache* const theCachePtr = GetThreadCache();
+    if (theCachePtr) {
+        QCStMutexLocker theCacheLock(theCachePtr->mMutex);
+        if (inBufCnt <= theCachePtr->mCount) {
+            for (int i = 0; i < inBufCnt; i++) {
+                inIt.Put(theCachePtr->Get());
+            }
+            return true;
+        }
+    }
     QCStMutexLocker theLock(mMutex);
     if (mFreeCnt < inBufCnt && ! TryToRefill(inRefillReqId, inBufCnt)) {
         return false;
@@ -302,6 +456,19 @@ QCIoBufferPool::Put(
     if (! inBufPtr) {
         return;
     }
+    // Bypass the cache if invoked from the client's Release(), in order
+    // to make the released buffers available for the pending refill.
+    ThreadCache* const theCachePtr = mMutex.IsOwned() ? 0 : GetThreadCache();
+    if (theCachePtr) {
+        QCStMutexLocker theCacheLock(theCachePtr->mMutex);
+        if (theCachePtr->IsFull() && theCachePtr->mCapacity > 0) {
+            QCStMutexLocker theLock(mMutex);
+            Flush(*theCachePtr, theCachePtr->mCapacity / 2);
+        }
+        if (theCachePtr->Put(inBufPtr)) {
+            return;
+        }
+    }
     QCStMutexLocker theLock(mMutex);
     PutSelf(inBufPtr);
 }
@@ -314,6 +481,20 @@ QCIoBufferPool::Put(
     if (inBufCnt < 0) {
         return;
     }
+    ThreadCache* const theCachePtr = mMutex.IsOwned() ? 0 : GetThreadCache();
+    if (theCachePtr) {
+        QCStMutexLocker theCacheLock(theCachePtr->mMutex);
+        if (theCachePtr->mCount + inBufCnt <= theCachePtr->mCapacity) {
+            for (int i = 0; i < inBufCnt; i++) {
+                char* const theBufPtr = inIt.Get();
+                if (! theBufPtr) {
+                    break;
+                }
+                theCachePtr->Put(theBufPtr);
+            }
+            return;
+        }
+    }
     QCStMutexLocker theLock(mMutex);
     for (int i = 0; i < inBufCnt; i++) {
         char* const theBufPtr = inIt.Get();
@@ -350,6 +531,22 @@ QCIoBufferPool::UnRegister(
     return true;
 }
 
+char*
+QCIoBufferPool::GetSelf()
+{
+    QCASSERT(mMutex.IsOwned() && mFreeCnt > 0);
+    // Always start from the first partition, to try to keep next
+    // partitions full, and be able to reclaim these if needed.
+    Partition::List::Iterator theItr(mPartitionListPtr);
+    Partition* thePtr;
+    while ((thePtr = theItr.Next()) && thePtr->IsEmpty())
+        {}
+    char* const theBufPtr = thePtr ? thePtr->Get() : 0;
+    QCASSERT(theBufPtr && mFreeCnt > 0);
+    mFreeCnt--;
+    return theBufPtr;
+}
+
 void
 QCIoBufferPool::PutSelf(
     char* inBufPtr)
@@ -372,6 +569,10 @@ QCIoBufferPool::TryToRefill(
     int                         inBufCnt)
 {
     QCASSERT(mMutex.IsOwned());
+    ReclaimThreadCaches();
+    if (mFreeCnt >= inBufCnt) {
+        return true;
+    }
     if (inReqId == kRefillReqIdUndefined) {
         return false;
     }
@@ -387,11 +588,136 @@ QCIoBufferPool::TryToRefill(
     return (mFreeCnt >= inBufCnt);
 }
 
+QCIoBufferPool::ThreadCache*
+QCIoBufferPool::GetThreadCache()
+{
+    // The key flag is only changed by Create() and the destructor, the cache
+    // size is protected by the pool mutex. The cache capacity is updated with
+    // both the cache and the pool mutexes held, see Refill(), therefore the
+    // existing cache can be used without checking the cache size.
+    if (! mThreadCacheKeyFlag) {
+        return 0;
+    }
+    ThreadCache* theCachePtr = reinterpret_cast<ThreadCache*>(
+        pthread_getspecific(mThreadCacheKey));
+    if (theCachePtr) {
+        return theCachePtr;
+    }
+    QCStMutexLocker theLock(mMutex);
+    if (mThreadCacheSize <= 0 || ! mThreadCacheKeyFlag) {
+        return 0;
+    }
+    theCachePtr = new ThreadCache(*this);
+    const int theErr = pthread_setspecific(mThreadCacheKey, theCachePtr);
+    if (theErr) {
+        delete theCachePtr;
+        return 0;
+    }
+    ThreadCache::List::PushBack(mThreadCacheListPtr, *theCachePtr);
+    return theCachePtr;
+}
+
+void
+QCIoBufferPool::Refill(
+    QCIoBufferPool::ThreadCache& inCache)
+{
+    QCASSERT(mMutex.IsOwned() && inCache.mMutex.IsOwned() &&
+        inCache.mCount == 0);
+    if (inCache.mCapacity != mThreadCacheSize) {
+        inCache.SetCapacity(mThreadCacheSize);
+    }
+    // Fill half of the cache, in order to leave room for the subsequent puts.
+    int theCnt = inCache.mCapacity / 2;
+    if (mFreeCnt < theCnt) {
+        theCnt = mFreeCnt;
+    }
+    while (theCnt-- > 0) {
+        inCache.Put(GetSelf());
+    }
+}
+
+void
+QCIoBufferPool::Flush(
+    QCIoBufferPool::ThreadCache& inCache,
+    int                          inBufCnt)
+{
+    QCASSERT(mMutex.IsOwned() && inCache.mMutex.IsOwned());
+    for (int i = 0; i < inBufCnt; i++) {
+        char* const theBufPtr = inCache.Get();
+        if (! theBufPtr) {
+            break;
+        }
+        PutSelf(theBufPtr);
+    }
+}
+
+void
+QCIoBufferPool::ReclaimThreadCaches()
+{
+    QCASSERT(mMutex.IsOwned());
+    ThreadCache::List::Iterator theIt(mThreadCacheListPtr);
+    ThreadCache* theCachePtr;
+    while ((theCachePtr = theIt.Next())) {
+        // The owner might hold its cache mutex, and wait for the pool mutex.
+        // Skip such cache, as it is about to be either refilled or flushed.
+        if (! theCachePtr->mMutex.TryLock()) {
+            continue;
+        }
+        Flush(*theCachePtr, theCachePtr->mCount);
+        theCachePtr->mMutex.Unlock();
+    }
+}
+
+int
+QCIoBufferPool::GetThreadCachesBufferCount()
+{
+    QCASSERT(mMutex.IsOwned());
+    // The counts are read without acquiring the cache mutexes, as the
+    // result is only used for the stats and the load estimates.
+    int theRet = 0;
+    ThreadCache::List::Iterator theIt(mThreadCacheListPtr);
+    const ThreadCache* theCachePtr;
+    while ((theCachePtr = theIt.Next())) {
+        theRet += theCachePtr->mCount;
+    }
+    return theRet;
+}
+
+bool
+QCIoBufferPool::RemoveThreadCache(
+    QCIoBufferPool::ThreadCache& inCache)
+{
+    QCStMutexLocker theCacheLock(inCache.mMutex);
+    QCStMutexLocker theLock(mMutex);
+    Flush(inCache, inCache.mCount);
+    if (inCache.mDetachedFlag) {
+        // Destroy() is draining the cache, and deletes it when done.
+        inCache.mOrphanFlag = true;
+        return false;
+    }
+    ThreadCache::List::Remove(mThreadCacheListPtr, inCache);
+    return true;
+}
+
+/* static */ void
+QCIoBufferPool::DeleteThreadCache(
+    void* inCachePtr)
+{
+    ThreadCache* const theCachePtr =
+        reinterpret_cast<ThreadCache*>(inCachePtr);
+    if (! theCachePtr) {
+        return;
+    }
+    if (theCachePtr->mPool.RemoveThreadCache(*theCachePtr)) {
+        delete theCachePtr;
+    }
+}
+
 int
 QCIoBufferPool::GetFreeBufferCount()
 {
     QCStMutexLocker theLock(mMutex);
-    return mFreeCnt;
+    return (mFreeCnt + GetThreadCachesBufferCount());
 }
 
 int
@@ -405,5 +731,5 @@ int
 QCIoBufferPool::GetUsedBufferCount()
 {
     QCStMutexLocker theLock(mMutex);
-    return (mTotalCnt - mFreeCnt);
+    return (mTotalCnt - mFreeCnt - GetThreadCachesBufferCount());
 }
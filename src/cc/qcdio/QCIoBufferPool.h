@@ -30,6 +30,12 @@
 // to satisfy request the "clients" are asked to release the specified number
 // of buffers before declaring allocation failure.
 // All buffer allocations are atomic -- all or nothing.
+// Optionally each thread can have its own small buffer cache ("magazine"),
+// in order to reduce the pool mutex contention. Single buffer get and put
+// are served from the calling thread's cache, with batched transfers between
+// the cache and the partitions, which act as the global depot. The buffers
+// in the thread caches are accounted as free, and are reclaimed before the
+// "clients" are asked to release buffers.
 //
 //----------------------------------------------------------------------------
 
@@ -38,6 +44,7 @@
 
 #include "QCMutex.h"
 
+#include <pthread.h>
 
 class QCIoBufferPool
 {
@@ -103,7 +110,8 @@ public:
         int          inPartitionCount,
         int          inPartitionBufferCount,
         int          inBufferSize,
-        bool         inLockMemoryFlag);
+        bool         inLockMemoryFlag,
+        int          inThreadCacheBufferCount = 0);
     void Destroy();
     char* Get(
         RefillReqId inRefillReqId = kRefillReqIdUndefined);
@@ -128,18 +136,37 @@ public:
 
 private:
     class Partition;
-    QCMutex    mMutex;
-    Client*    mClientListPtr[1];
-    Partition* mPartitionListPtr[1];
-    int        mBufferSize;
-    int        mFreeCnt;
-    int        mTotalCnt;
+    class ThreadCache;
+    QCMutex       mMutex;
+    Client*       mClientListPtr[1];
+    Partition*    mPartitionListPtr[1];
+    ThreadCache*  mThreadCacheListPtr[1];
+    pthread_key_t mThreadCacheKey;
+    bool          mThreadCacheKeyFlag;
+    int           mThreadCacheSize;
+    int           mBufferSize;
+    int           mFreeCnt;
+    int           mTotalCnt;
 
     bool TryToRefill(
         RefillReqId inReqId,
         int         inBufCnt);
+    char* GetSelf();
     void PutSelf(
         char* inBufPtr);
+    void DeletePartitions();
+    ThreadCache* GetThreadCache();
+    void Refill(
+        ThreadCache& inCache);
+    void Flush(
+        ThreadCache& inCache,
+        int          inBufCnt);
+    void ReclaimThreadCaches();
+    int GetThreadCachesBufferCount();
+    bool RemoveThreadCache(
+        ThreadCache& inCache);
+    static void DeleteThreadCache(
+        void* inCachePtr);
 
     // No copies.
     QCIoBufferPool( const QCIoBufferPool& inPool);
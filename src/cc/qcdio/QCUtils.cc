@@ -166,6 +166,43 @@ QCUtils::ReserveFileSpace(
     return (inFd < 0 ? -EINVAL : 0);
 }
 
+/* static */ int
+QCUtils::ReleaseFileSpace(
+    int     inFd,
+    int64_t inOffset,
+    int64_t inLength)
+{
+    if (inFd < 0 || inOffset < 0 || inLength < 0) {
+        return EINVAL;
+    }
+    if (inLength == 0) {
+        return 0;
+    }
+#if defined(FALLOC_FL_PUNCH_HOLE) && defined(FALLOC_FL_KEEP_SIZE)
+    if (fallocate(inFd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+            (off_t)inOffset, (off_t)inLength) == 0) {
+        return 0;
+    }
+    const int theErr = errno;
+    if (theErr != EOPNOTSUPP && theErr != ENOSYS) {
+        return theErr;
+    }
+#endif
+#if defined(QC_USE_XFS_RESVSP) && defined(XFS_IOC_UNRESVSP64)
+    if (platform_test_xfs_fd(inFd)) {
+        xfs_flock64_t theResv = {0};
+        theResv.l_whence = 0;
+        theResv.l_start  = inOffset;
+        theResv.l_len    = inLength;
+        if (xfsctl(0, inFd, XFS_IOC_UNRESVSP64, &theResv)) {
+            return (errno ? errno : EIO);
+        }
+        return 0;
+    }
+#endif /* QC_USE_XFS_RESVSP */
+    return EOPNOTSUPP;
+}
+
 /* static */ int
 QCUtils::AllocateFileSpace(
     int      inFd,
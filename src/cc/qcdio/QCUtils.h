@@ -52,6 +52,13 @@ struct QCUtils
         int     inFd,
         int64_t inSize);
 
+    // Deallocate file space in the specified range without changing the file
+    // size. Returns 0 on success, or system error code.
+    static int ReleaseFileSpace(
+        int     inFd,
+        int64_t inOffset,
+        int64_t inLength);
+
     static int AllocateFileSpace(
         const char* inFileNamePtr,
         int64_t     inSize,
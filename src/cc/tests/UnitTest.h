@@ -0,0 +1,59 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Unit tests run by ctest common helpers. The test reports the first
+// failed check with Fail(), and returns the status from main() with
+// TestDone().
+//
+//----------------------------------------------------------------------------
+
+#ifndef TESTS_UNIT_TEST_H
+#define TESTS_UNIT_TEST_H
+
+#include <iostream>
+
+namespace KFS
+{
+namespace UnitTest
+{
+
+inline int
+Fail(
+    const char* inMsgPtr)
+{
+    std::cerr << "FAILED: " << inMsgPtr << std::endl;
+    return 1;
+}
+
+inline int
+TestDone(
+    int inStatus)
+{
+    if (inStatus == 0) {
+        std::cout << "PASSED" << std::endl;
+    }
+    return inStatus;
+}
+
+} // namespace UnitTest
+} // namespace KFS
+
+#endif /* TESTS_UNIT_TEST_H */
@@ -0,0 +1,177 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Allocate ahead with two writers test: the first writer writes the
+// first chunk, and the second writer writes the chunk past the chunks
+// allocated ahead for the first writer. The first writer's close must not
+// delete the second writer's chunks, and the second writer's close must
+// delete only its own unused chunks allocated ahead. Requires running file
+// system.
+//----------------------------------------------------------------------------
+
+#include "common/MsgLogger.h"
+#include "libclient/KfsClient.h"
+#include "tests/UnitTest.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+#include <vector>
+
+using std::cout;
+using std::vector;
+
+using namespace KFS;
+using KFS::UnitTest::Fail;
+using KFS::UnitTest::TestDone;
+
+const int        kAllocateAheadCount = 2;
+const size_t     kWriteSize          = 1 << 20;
+const chunkOff_t kSecondOffset       =
+    (chunkOff_t)CHUNKSIZE * (kAllocateAheadCount + 1);
+
+static void
+FillBuffer(
+    vector<char>& inBuf,
+    int           inSeed)
+{
+    inBuf.resize(kWriteSize);
+    for (size_t i = 0; i < inBuf.size(); i++) {
+        inBuf[i] = (char)((i * 7 + inSeed) & 0xFF);
+    }
+}
+
+static int
+WriteAt(
+    KfsClient&          inClient,
+    int                 inFd,
+    chunkOff_t          inOffset,
+    const vector<char>& inBuf)
+{
+    if (inClient.Seek(inFd, inOffset) != inOffset ||
+            inClient.Write(inFd, &inBuf[0], inBuf.size()) !=
+                (ssize_t)inBuf.size() ||
+            inClient.Sync(inFd) != 0) {
+        return Fail("write");
+    }
+    return 0;
+}
+
+static int
+Verify(
+    KfsClient&          inClient,
+    const char*         inPathPtr,
+    chunkOff_t          inOffset,
+    const vector<char>& inBuf)
+{
+    const int theFd = inClient.Open(inPathPtr, O_RDONLY);
+    if (theFd < 0) {
+        return Fail("open for read");
+    }
+    // The chunks are partially filled.
+    inClient.SkipHolesInFile(theFd);
+    vector<char> theBuf(inBuf.size());
+    int          theRet = 0;
+    if (inClient.Seek(theFd, inOffset) != inOffset ||
+            inClient.Read(theFd, &theBuf[0], theBuf.size()) !=
+                (ssize_t)theBuf.size() ||
+            memcmp(&theBuf[0], &inBuf[0], theBuf.size()) != 0) {
+        theRet = Fail("read data mismatch");
+    }
+    inClient.Close(theFd);
+    return theRet;
+}
+
+static int
+TestTwoWriters(
+    KfsClient&  inFirst,
+    KfsClient&  inSecond,
+    const char* inPathPtr)
+{
+    inFirst.Remove(inPathPtr);
+    inFirst.SetAllocateAheadCount(kAllocateAheadCount);
+    inSecond.SetAllocateAheadCount(kAllocateAheadCount);
+    vector<char> theFirstBuf;
+    vector<char> theSecondBuf;
+    FillBuffer(theFirstBuf, 1);
+    FillBuffer(theSecondBuf, 2);
+    const int theFirstFd = inFirst.Create(inPathPtr, 1);
+    if (theFirstFd < 0) {
+        return Fail("create");
+    }
+    if (WriteAt(inFirst, theFirstFd, 0, theFirstBuf) != 0) {
+        inFirst.Close(theFirstFd);
+        return 1;
+    }
+    const int theSecondFd = inSecond.Open(inPathPtr, O_WRONLY, 1);
+    if (theSecondFd < 0) {
+        inFirst.Close(theFirstFd);
+        return Fail("open second writer");
+    }
+    int theRet = WriteAt(inSecond, theSecondFd, kSecondOffset, theSecondBuf);
+    // The first writer deletes its unused chunks allocated ahead on close,
+    // the chunks past these chunks belong to the second writer, and must
+    // not be deleted.
+    if (inFirst.Close(theFirstFd) != 0 && theRet == 0) {
+        theRet = Fail("close first writer");
+    }
+    if (inSecond.Close(theSecondFd) != 0 && theRet == 0) {
+        theRet = Fail("close second writer");
+    }
+    if (theRet != 0) {
+        return theRet;
+    }
+    theRet = Verify(inFirst, inPathPtr, 0, theFirstBuf) |
+        Verify(inFirst, inPathPtr, kSecondOffset, theSecondBuf);
+    KfsFileAttr theAttr;
+    if (theRet == 0 && (inFirst.Stat(inPathPtr, theAttr) != 0 ||
+            theAttr.fileSize != kSecondOffset + (chunkOff_t)kWriteSize)) {
+        theRet = Fail("file size, the second writer's unused chunks"
+            " allocated ahead are not deleted");
+    }
+    return theRet;
+}
+
+int
+main(
+    int    argc,
+    char** argv)
+{
+    if (argc < 4) {
+        cout << "Usage: " << argv[0] << " <meta host> <meta port> <path>\n"
+            "Allocate ahead with two writers test.\n";
+        return 1;
+    }
+    MsgLogger::Init(0, MsgLogger::kLogLevelINFO);
+    KfsClient* const theFirstPtr  = Connect(argv[1], atoi(argv[2]));
+    KfsClient* const theSecondPtr = Connect(argv[1], atoi(argv[2]));
+    int              theRet       = 0;
+    if (! theFirstPtr || ! theSecondPtr) {
+        theRet = Fail("connect");
+    } else {
+        theRet = TestTwoWriters(*theFirstPtr, *theSecondPtr, argv[3]);
+    }
+    delete theFirstPtr;
+    delete theSecondPtr;
+    return TestDone(theRet);
+}
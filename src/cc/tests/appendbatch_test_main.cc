@@ -0,0 +1,224 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Record append replication batch test: the batch entries created by
+// the write master are parsed at every replication chain position, and the
+// batch commit advances the commit offset only for the in order "in
+// progress" appends.
+//----------------------------------------------------------------------------
+
+#include "chunk/AppendBatch.h"
+#include "tests/UnitTest.h"
+
+#include <errno.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+
+using std::map;
+using std::ostringstream;
+using std::string;
+
+using namespace KFS;
+using KFS::UnitTest::Fail;
+using KFS::UnitTest::TestDone;
+
+struct TestWIdState
+{
+    TestWIdState()
+        : mOffset(-1),
+          mAppendCount(0),
+          mStatus(0)
+        {}
+    int64_t  mOffset;
+    uint64_t mAppendCount;
+    int      mStatus;
+};
+typedef map<int64_t, TestWIdState> TestWriteIdState;
+
+const uint32_t kNumServers       = 3;
+const int      kAppendCount      = 4;
+const int      kInProgressStatus = -EAGAIN;
+
+// Write ids at chain position i of the append k are 100 * (i + 1) + k.
+static string
+MakeServers(
+    int inAppend)
+{
+    ostringstream theStream;
+    for (uint32_t i = 0; i < kNumServers; i++) {
+        theStream << (i == 0 ? "" : " ") <<
+            "10.0.0." << i << " " << (20000 + i) << " " <<
+            (100 * (i + 1) + inAppend);
+    }
+    return theStream.str();
+}
+
+static string
+MakeBatch()
+{
+    ostringstream theStream;
+    for (int k = 0; k < kAppendCount; k++) {
+        if (k != 0) {
+            theStream << ' ';
+        }
+        AppendBatchEntry(theStream, size_t(10 + k), kfsSeq_t(1000 + k),
+            MakeServers(k), kNumServers);
+    }
+    return theStream.str();
+}
+
+static int
+TestParser()
+{
+    const string theBatch = MakeBatch();
+    for (uint32_t i = 0; i < kNumServers; i++) {
+        AppendBatchParser theParser(theBatch, kNumServers, int(i));
+        for (int k = 0; k < kAppendCount; k++) {
+            size_t   theLength  = 0;
+            kfsSeq_t theSeq     = -1;
+            int64_t  theWriteId = -1;
+            if (! theParser.Next(theLength, theSeq, theWriteId)) {
+                return Fail("parse batch entry");
+            }
+            if (theLength != size_t(10 + k) || theSeq != kfsSeq_t(1000 + k) ||
+                    theWriteId != int64_t(100 * (i + 1) + k)) {
+                return Fail("batch entry mismatch");
+            }
+        }
+        size_t   theLength  = 0;
+        kfsSeq_t theSeq     = -1;
+        int64_t  theWriteId = -1;
+        if (theParser.Next(theLength, theSeq, theWriteId)) {
+            return Fail("parse past the batch end");
+        }
+    }
+    // Entry truncated in the middle of the write ids list.
+    const string theTruncated = theBatch.substr(0, theBatch.rfind(' '));
+    AppendBatchParser theParser(theTruncated, kNumServers, 1);
+    size_t   theLength  = 0;
+    kfsSeq_t theSeq     = -1;
+    int64_t  theWriteId = -1;
+    int      theCount   = 0;
+    while (theParser.Next(theLength, theSeq, theWriteId)) {
+        theCount++;
+    }
+    if (theCount != kAppendCount - 1) {
+        return Fail("truncated batch");
+    }
+    return 0;
+}
+
+static void
+BatchBegin(
+    TestWriteIdState& inState,
+    int               inReplicationPos,
+    int64_t           inOffset)
+{
+    inState.clear();
+    int64_t theOffset = inOffset;
+    for (int k = 0; k < kAppendCount; k++) {
+        TestWIdState& theWs = inState[100 * (inReplicationPos + 1) + k];
+        theWs.mStatus = kInProgressStatus;
+        theWs.mOffset = theOffset;
+        theOffset += 10 + k;
+    }
+}
+
+static int
+TestCommit()
+{
+    const string     theBatch          = MakeBatch();
+    const int        theReplicationPos = 2;
+    const int64_t    theStartOffset    = 1 << 20;
+    TestWriteIdState theState;
+    BatchBegin(theState, theReplicationPos, theStartOffset);
+    int64_t  theCommitOffset = theStartOffset;
+    uint64_t theCommitCount  = 0;
+    int64_t  theWriteId      = -1;
+    if (! AppendBatchCommit(theBatch, kAppendCount, kNumServers,
+            theReplicationPos, kInProgressStatus, theState,
+            theCommitOffset, theCommitCount, theWriteId)) {
+        return Fail("batch commit");
+    }
+    if (theCommitOffset != theStartOffset + 10 + 11 + 12 + 13 ||
+            theCommitCount != uint64_t(kAppendCount)) {
+        return Fail("batch commit offset or count");
+    }
+    for (TestWriteIdState::const_iterator theIt = theState.begin();
+            theIt != theState.end();
+            ++theIt) {
+        if (theIt->second.mAppendCount != 1) {
+            return Fail("write id append count");
+        }
+    }
+    // Out of order: the commit offset is past the batch start.
+    BatchBegin(theState, theReplicationPos, theStartOffset);
+    theCommitOffset = theStartOffset + 1;
+    theCommitCount  = 0;
+    if (AppendBatchCommit(theBatch, kAppendCount, kNumServers,
+            theReplicationPos, kInProgressStatus, theState,
+            theCommitOffset, theCommitCount, theWriteId) ||
+            theCommitCount != 0) {
+        return Fail("out of order batch commit");
+    }
+    // The third append is not in progress.
+    BatchBegin(theState, theReplicationPos, theStartOffset);
+    theState[100 * (theReplicationPos + 1) + 2].mStatus = 0;
+    theCommitOffset = theStartOffset;
+    theCommitCount  = 0;
+    if (AppendBatchCommit(theBatch, kAppendCount, kNumServers,
+            theReplicationPos, kInProgressStatus, theState,
+            theCommitOffset, theCommitCount, theWriteId) ||
+            theCommitCount != 2 ||
+            theWriteId != 100 * (theReplicationPos + 1) + 2) {
+        return Fail("commit of append not in progress");
+    }
+    // Unknown write id: the batch is committed at another chain position.
+    BatchBegin(theState, theReplicationPos, theStartOffset);
+    theCommitOffset = theStartOffset;
+    theCommitCount  = 0;
+    if (AppendBatchCommit(theBatch, kAppendCount, kNumServers,
+            1, kInProgressStatus, theState,
+            theCommitOffset, theCommitCount, theWriteId) ||
+            theCommitCount != 0) {
+        return Fail("commit with unknown write id");
+    }
+    // Batch count exceeds the number of entries.
+    BatchBegin(theState, theReplicationPos, theStartOffset);
+    theCommitOffset = theStartOffset;
+    theCommitCount  = 0;
+    if (AppendBatchCommit(theBatch, kAppendCount + 1, kNumServers,
+            theReplicationPos, kInProgressStatus, theState,
+            theCommitOffset, theCommitCount, theWriteId)) {
+        return Fail("commit of malformed batch");
+    }
+    return 0;
+}
+
+int
+main(
+    int    /* argc */,
+    char** /* argv */)
+{
+    return TestDone(TestParser() | TestCommit());
+}
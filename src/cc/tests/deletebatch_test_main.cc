@@ -0,0 +1,205 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Disk queue batch delete test: all files in the batch are deleted in
+// order, and the name space (barrier) requests queued after the batch are
+// executed after the batch completes. The chunk server relies on this to
+// re-create the chunk file with the same name as the stale chunk file queued
+// for deletion.
+//----------------------------------------------------------------------------
+
+#include "qcdio/QCDiskQueue.h"
+#include "qcdio/QCIoBufferPool.h"
+#include "qcdio/QCMutex.h"
+#include "qcdio/qcstutils.h"
+#include "tests/UnitTest.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+using std::string;
+using KFS::UnitTest::Fail;
+using KFS::UnitTest::TestDone;
+
+class Completion : public QCDiskQueue::IoCompletion
+{
+public:
+    Completion()
+        : QCDiskQueue::IoCompletion(),
+          mMutex(),
+          mCond(),
+          mDoneFlag(false),
+          mError(QCDiskQueue::kErrorNone),
+          mSysError(0),
+          mIoBytes(-1)
+        {}
+    virtual ~Completion()
+        {}
+    virtual bool Done(
+        QCDiskQueue::RequestId      /* inRequestId */,
+        QCDiskQueue::FileIdx        /* inFileIdx */,
+        QCDiskQueue::BlockIdx       /* inStartBlockIdx */,
+        QCDiskQueue::InputIterator& /* inBufferItr */,
+        int                         /* inBufferCount */,
+        QCDiskQueue::Error          inCompletionCode,
+        int                         inSysErrorCode,
+        int64_t                     inIoBytes)
+    {
+        QCStMutexLocker theLocker(mMutex);
+        mDoneFlag = true;
+        mError    = inCompletionCode;
+        mSysError = inSysErrorCode;
+        mIoBytes  = inIoBytes;
+        mCond.Notify();
+        return true;
+    }
+    void Wait()
+    {
+        QCStMutexLocker theLocker(mMutex);
+        while (! mDoneFlag) {
+            mCond.Wait(mMutex);
+        }
+    }
+    QCMutex            mMutex;
+    QCCondVar          mCond;
+    bool               mDoneFlag;
+    QCDiskQueue::Error mError;
+    int                mSysError;
+    int64_t            mIoBytes;
+};
+
+static bool
+CreateFile(
+    const string& inName)
+{
+    const int theFd = open(inName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (theFd < 0 || write(theFd, inName.data(), inName.size()) !=
+            (ssize_t)inName.size()) {
+        perror(inName.c_str());
+        return false;
+    }
+    close(theFd);
+    return true;
+}
+
+static bool
+FileExists(
+    const string& inName)
+{
+    struct stat theStat;
+    return (stat(inName.c_str(), &theStat) == 0);
+}
+
+int
+main(
+    int    /* argc */,
+    char** /* argv */)
+{
+    char theTmpl[] = "/tmp/deletebatch_test.XXXXXX";
+    const char* const theDirPtr = mkdtemp(theTmpl);
+    if (! theDirPtr) {
+        perror("mkdtemp");
+        return 1;
+    }
+    const string theDir(theDirPtr);
+    const int    kFileCount = 16;
+    string       theNames;
+    for (int i = 0; i < kFileCount; i++) {
+        char theBuf[32];
+        snprintf(theBuf, sizeof(theBuf), "/%d.%d.1", i + 1, (i + 1) * 10);
+        const string theName = theDir + theBuf;
+        if (! CreateFile(theName)) {
+            return 1;
+        }
+        theNames.append(theName.c_str(), theName.size() + 1);
+    }
+    // The last name in the batch does not exist: the batch must delete all
+    // other files, and report the error.
+    const string theMissing = theDir + "/missing";
+    theNames.append(theMissing.c_str(), theMissing.size() + 1);
+    // The file to rename into the first file in the batch.
+    const string theFirst = theDir + "/1.10.1";
+    const string theNew   = theDir + "/new";
+    if (! CreateFile(theNew)) {
+        return 1;
+    }
+
+    QCIoBufferPool theBufferPool;
+    if (theBufferPool.Create(1, 64, 4 << 10, false) != 0) {
+        return Fail("buffer pool create");
+    }
+    QCDiskQueue theQueue;
+    const int   kThreadCount = 4;
+    int         theStatus    = theQueue.Start(
+        kThreadCount, 64, 16, 1, 0, theBufferPool);
+    if (theStatus != 0) {
+        return Fail("disk queue start");
+    }
+    Completion theBatchDone;
+    Completion theRenameDone;
+    const QCDiskQueue::EnqueueStatus theBatchStatus = theQueue.DeleteBatch(
+        theNames.data(), theNames.size(), &theBatchDone);
+    // Rename is a barrier, and must wait for the batch delete to complete,
+    // otherwise the batch would delete the renamed file.
+    const QCDiskQueue::EnqueueStatus theRenameStatus = theQueue.Rename(
+        theNew.c_str(), theFirst.c_str(), &theRenameDone);
+    int theRet = 0;
+    if (theBatchStatus.IsError() || theRenameStatus.IsError()) {
+        theRet = Fail("enqueue");
+    } else {
+        theBatchDone.Wait();
+        theRenameDone.Wait();
+        if (theBatchDone.mError != QCDiskQueue::kErrorDelete) {
+            theRet = Fail("batch delete must report missing file error");
+        } else if (theBatchDone.mIoBytes != kFileCount) {
+            theRet = Fail("batch delete count mismatch");
+        } else if (theRenameDone.mError != QCDiskQueue::kErrorNone) {
+            theRet = Fail("rename");
+        } else if (! FileExists(theFirst) || FileExists(theNew)) {
+            theRet = Fail("rename executed before batch delete");
+        } else {
+            for (const char* thePtr = theNames.c_str() + theFirst.size() + 1;
+                    thePtr < theNames.data() + theNames.size();
+                    thePtr += strlen(thePtr) + 1) {
+                if (FileExists(thePtr)) {
+                    theRet = Fail("file not deleted");
+                    break;
+                }
+            }
+        }
+    }
+    // Empty list is invalid.
+    if (theRet == 0 && theQueue.DeleteBatch(
+            theNames.data(), 0, &theBatchDone).IsGood()) {
+        theRet = Fail("empty batch accepted");
+    }
+    theQueue.Stop();
+    unlink(theFirst.c_str());
+    rmdir(theDir.c_str());
+    return TestDone(theRet);
+}
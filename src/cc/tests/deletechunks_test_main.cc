@@ -0,0 +1,177 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Meta server bulk chunk delete rpc test: DELETE_CHUNKS request
+// header and chunk ids content in both decimal and hex formats, and the chunk
+// server reply with the failed chunks status parsing.
+//----------------------------------------------------------------------------
+
+#include "meta/MetaRequest.h"
+#include "common/Properties.h"
+#include "kfsio/IOBuffer.h"
+#include "tests/UnitTest.h"
+
+#include <errno.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::hex;
+using std::istringstream;
+using std::ostringstream;
+using std::string;
+using std::vector;
+
+using namespace KFS;
+using KFS::UnitTest::Fail;
+using KFS::UnitTest::TestDone;
+
+static int
+TestRequest(
+    int  inCount,
+    bool inHexFormatFlag)
+{
+    MetaChunkBulkDelete theReq(1234, ChunkServerPtr(), inHexFormatFlag);
+    vector<chunkId_t>   theIds;
+    for (int i = 0; i < inCount; i++) {
+        const chunkId_t theId = (chunkId_t)i * 1000003 + 17;
+        theReq.chunkIds.PushBack(theId);
+        theIds.push_back(theId);
+    }
+    ostringstream theStream;
+    IOBuffer      theBuf;
+    theReq.request(theStream, theBuf);
+    string theMsg = theStream.str();
+    const int theBufLen = theBuf.BytesConsumable();
+    if (0 < theBufLen) {
+        string theContent(theBufLen, ' ');
+        theBuf.CopyOut(&theContent[0], theBufLen);
+        theMsg += theContent;
+    }
+    const string kFirstLine = "DELETE_CHUNKS \r\n";
+    const size_t theHeaderEnd = theMsg.find("\r\n\r\n");
+    if (theMsg.compare(0, kFirstLine.size(), kFirstLine) != 0 ||
+            theHeaderEnd == string::npos) {
+        return Fail("request header");
+    }
+    Properties theProps;
+    const char kSeparator = ':';
+    theProps.loadProperties(theMsg.data() + kFirstLine.size(),
+        theHeaderEnd + 2 - kFirstLine.size(), kSeparator);
+    const string theContent = theMsg.substr(theHeaderEnd + 4);
+    if (theProps.getValue("Cseq", -1) != 1234 ||
+            theProps.getValue("Num-chunks", -1) != inCount ||
+            theProps.getValue("HexFormat", 0) != (inHexFormatFlag ? 1 : 0) ||
+            theProps.getValue("Content-length", -1) !=
+                (int)theContent.size()) {
+        return Fail("request header fields");
+    }
+    istringstream theIs(theContent);
+    if (inHexFormatFlag) {
+        theIs >> hex;
+    }
+    for (int i = 0; i < inCount; i++) {
+        chunkId_t theId = -1;
+        if (! (theIs >> theId) || theId != theIds[i]) {
+            return Fail("request chunk ids content");
+        }
+    }
+    chunkId_t theId = -1;
+    if (theIs >> theId) {
+        return Fail("request extra content");
+    }
+    return 0;
+}
+
+static int
+TestReply(
+    const char* inNumFailedPtr,
+    const char* inContentPtr,
+    int         inExpectedCount,
+    bool        inValidFlag)
+{
+    MetaChunkBulkDelete theReq(1, ChunkServerPtr(), true);
+    Properties          theProps;
+    theReq.status = 0;
+    if (inNumFailedPtr) {
+        theProps.setValue("Num-failed", inNumFailedPtr);
+    }
+    theReq.handleReply(theProps);
+    istringstream theIs(inContentPtr);
+    const bool    theOkFlag = theReq.handleReplyContent(theIs);
+    if (theOkFlag != inValidFlag) {
+        return Fail("reply content status");
+    }
+    if (! inValidFlag) {
+        return (theReq.status == -EINVAL ? 0 :
+            Fail("invalid reply content status"));
+    }
+    if (theReq.status != 0 ||
+            (int)theReq.failedChunks.size() != inExpectedCount) {
+        return Fail("reply failed chunks count");
+    }
+    return 0;
+}
+
+int
+main(
+    int    /* argc */,
+    char** /* argv */)
+{
+    int theRet = 0;
+    const int kCounts[] = { 0, 1, 2, 100, 2 << 10 };
+    for (size_t i = 0; theRet == 0 && i < sizeof(kCounts) / sizeof(kCounts[0]);
+            i++) {
+        theRet = TestRequest(kCounts[i], false) |
+            TestRequest(kCounts[i], true);
+    }
+    if (theRet == 0) {
+        // Failed chunk ids are in hex, and status in decimal.
+        MetaChunkBulkDelete theReq(1, ChunkServerPtr(), true);
+        Properties          theProps;
+        theProps.setValue("Num-failed", "2");
+        theReq.status = 0;
+        theReq.handleReply(theProps);
+        istringstream theIs("1a -2\nff -5\n");
+        if (! theReq.handleReplyContent(theIs) ||
+                theReq.numFailed != 2 ||
+                theReq.failedChunks.size() != 2 ||
+                theReq.failedChunks[0].first  != 0x1a ||
+                theReq.failedChunks[0].second != -2 ||
+                theReq.failedChunks[1].first  != 0xff ||
+                theReq.failedChunks[1].second != -5) {
+            theRet = Fail("reply failed chunks");
+        }
+    }
+    if (theRet == 0) {
+        theRet =
+            TestReply(0,   "",              0, true)  |
+            TestReply("0", "",              0, true)  |
+            TestReply("1", "10 -2\n",       1, true)  |
+            // Truncated content.
+            TestReply("3", "10 -2\n11 -2\n", 0, false) |
+            TestReply("1", "10",            0, false) |
+            // Invalid chunk id.
+            TestReply("1", "zz -2\n",       0, false);
+    }
+    return TestDone(theRet);
+}
@@ -0,0 +1,169 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Chunk server binary heartbeat encoding test: full and delta encoded
+// heartbeats round trip, and the decoder rejects truncated heartbeats, schema
+// version mismatch, and more counters than the schema has.
+//----------------------------------------------------------------------------
+
+#include "common/ChunkServerHeartbeat.h"
+#include "tests/UnitTest.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <limits>
+
+using std::numeric_limits;
+
+using namespace KFS;
+using KFS::UnitTest::Fail;
+using KFS::UnitTest::TestDone;
+
+typedef ChunkServerHeartbeat::Counter Counter;
+
+static void
+SetCounters(
+    Counter* inCountersPtr,
+    int      inSeed)
+{
+    for (int i = 0; i < CS_HB_COUNTERS_COUNT; i++) {
+        inCountersPtr[i] = Counter(i) * 1000003 * inSeed - 17 * i;
+    }
+    inCountersPtr[0] = numeric_limits<Counter>::max() - inSeed;
+    inCountersPtr[1] = numeric_limits<Counter>::min() + inSeed;
+    inCountersPtr[2] = -inSeed;
+}
+
+static int
+TestNames()
+{
+    for (int i = 0; i < CS_HB_COUNTERS_COUNT; i++) {
+        if (ChunkServerHeartbeat::Find(ChunkServerHeartbeat::GetName(i)) !=
+                i) {
+            return Fail("counter name lookup");
+        }
+    }
+    return 0;
+}
+
+static int
+TestRoundTrip()
+{
+    Counter theBase[CS_HB_COUNTERS_COUNT];
+    Counter theCur[CS_HB_COUNTERS_COUNT];
+    Counter theDecoded[CS_HB_COUNTERS_COUNT];
+    char    theBuf[ChunkServerHeartbeat::kMaxEncodedSize];
+    bool    theDeltaFlag = true;
+
+    // Full heartbeat.
+    SetCounters(theBase, 1);
+    int theLen = ChunkServerHeartbeat::Encode(
+        theBase, 0, CS_HB_COUNTERS_COUNT, theBuf);
+    if (theLen <= 0 || ChunkServerHeartbeat::kMaxEncodedSize < theLen) {
+        return Fail("full encode length");
+    }
+    memset(theDecoded, 0xFF, sizeof(theDecoded));
+    if (ChunkServerHeartbeat::Decode(theBuf, theLen,
+                theDecoded, CS_HB_COUNTERS_COUNT, theDeltaFlag) !=
+                CS_HB_COUNTERS_COUNT ||
+            theDeltaFlag ||
+            memcmp(theDecoded, theBase, sizeof(theBase)) != 0) {
+        return Fail("full decode");
+    }
+    // Delta heartbeat: decoded in place over the previous heartbeat values.
+    SetCounters(theCur, 3);
+    theCur[5] = theBase[5];
+    theLen = ChunkServerHeartbeat::Encode(
+        theCur, theBase, CS_HB_COUNTERS_COUNT, theBuf);
+    if (theLen <= 0 || ChunkServerHeartbeat::kMaxEncodedSize < theLen) {
+        return Fail("delta encode length");
+    }
+    if (ChunkServerHeartbeat::Decode(theBuf, theLen,
+                theDecoded, CS_HB_COUNTERS_COUNT, theDeltaFlag) !=
+                CS_HB_COUNTERS_COUNT ||
+            ! theDeltaFlag ||
+            memcmp(theDecoded, theCur, sizeof(theCur)) != 0) {
+        return Fail("delta decode");
+    }
+    // Unchanged counters are one byte each.
+    theLen = ChunkServerHeartbeat::Encode(
+        theCur, theCur, CS_HB_COUNTERS_COUNT, theBuf);
+    if (theLen != 2 + (CS_HB_COUNTERS_COUNT < 0x80 ? 1 : 2) +
+            CS_HB_COUNTERS_COUNT) {
+        return Fail("empty delta encode length");
+    }
+    return 0;
+}
+
+static int
+TestInvalid()
+{
+    Counter theCur[CS_HB_COUNTERS_COUNT];
+    Counter theDecoded[CS_HB_COUNTERS_COUNT];
+    char    theBuf[ChunkServerHeartbeat::kMaxEncodedSize + 1];
+    bool    theDeltaFlag = false;
+
+    // Truncated heartbeat.
+    SetCounters(theCur, 5);
+    int theLen = ChunkServerHeartbeat::Encode(
+        theCur, 0, CS_HB_COUNTERS_COUNT, theBuf);
+    for (int theTruncLen = 0; theTruncLen < theLen; theTruncLen++) {
+        if (ChunkServerHeartbeat::Decode(theBuf, theTruncLen,
+                theDecoded, CS_HB_COUNTERS_COUNT, theDeltaFlag) != -1) {
+            return Fail("truncated heartbeat accepted");
+        }
+    }
+    // Trailing garbage.
+    theBuf[theLen] = 0;
+    if (ChunkServerHeartbeat::Decode(theBuf, theLen + 1,
+            theDecoded, CS_HB_COUNTERS_COUNT, theDeltaFlag) != -1) {
+        return Fail("trailing bytes accepted");
+    }
+    // Schema version mismatch: the version is the first byte.
+    theBuf[0] = (char)(ChunkServerHeartbeat::kSchemaVersion + 1);
+    if (ChunkServerHeartbeat::Decode(theBuf, theLen,
+            theDecoded, CS_HB_COUNTERS_COUNT, theDeltaFlag) != -1) {
+        return Fail("bad schema version accepted");
+    }
+    // The older peer might send fewer counters, but not more than the
+    // schema has.
+    const int kCount = CS_HB_COUNTERS_COUNT - 3;
+    theLen = ChunkServerHeartbeat::Encode(theCur, 0, kCount, theBuf);
+    if (ChunkServerHeartbeat::Decode(theBuf, theLen,
+                theDecoded, CS_HB_COUNTERS_COUNT, theDeltaFlag) != kCount ||
+            memcmp(theDecoded, theCur, kCount * sizeof(theCur[0])) != 0) {
+        return Fail("fewer counters decode");
+    }
+    if (ChunkServerHeartbeat::Decode(theBuf, theLen,
+            theDecoded, kCount - 1, theDeltaFlag) != -1) {
+        return Fail("more counters than max accepted");
+    }
+    return 0;
+}
+
+int
+main(
+    int    /* argc */,
+    char** /* argv */)
+{
+    return TestDone(TestNames() | TestRoundTrip() | TestInvalid());
+}
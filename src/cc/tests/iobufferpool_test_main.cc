@@ -0,0 +1,151 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Io buffer pool per thread cache test: multiple threads get and put
+// buffers through their caches, and exit while the pool is being destroyed.
+// The cache mutex, then pool mutex lock order must be maintained by all
+// paths, including the thread exit and Destroy(), otherwise the test
+// deadlocks, and is terminated by the alarm.
+//----------------------------------------------------------------------------
+
+#include "qcdio/QCIoBufferPool.h"
+#include "qcdio/QCMutex.h"
+#include "qcdio/qcstutils.h"
+#include "qcdio/QCThread.h"
+#include "tests/UnitTest.h"
+
+#include <unistd.h>
+
+#include <vector>
+
+using std::vector;
+
+using KFS::UnitTest::Fail;
+using KFS::UnitTest::TestDone;
+
+class TestThread : public QCRunnable
+{
+public:
+    TestThread(
+        QCIoBufferPool& inPool,
+        QCMutex&        inMutex,
+        QCCondVar&      inCond,
+        int&            inDoneCount)
+        : QCRunnable(),
+          mPool(inPool),
+          mMutex(inMutex),
+          mCond(inCond),
+          mDoneCount(inDoneCount),
+          mThread(this, "TestThread")
+        {}
+    virtual ~TestThread()
+        {}
+    void Start()
+        { mThread.Start(); }
+    void Join()
+        { mThread.Join(); }
+    virtual void Run()
+    {
+        const int kIterationCount = 2000;
+        const int kBufCount       = 4;
+        char*     theBufs[kBufCount];
+        for (int i = 0; i < kIterationCount; i++) {
+            for (int k = 0; k < kBufCount; k++) {
+                theBufs[k] = mPool.Get();
+            }
+            for (int k = 0; k < kBufCount; k++) {
+                mPool.Put(theBufs[k]);
+            }
+        }
+        // Exit with the buffers in the cache: the thread cache destructor
+        // returns these to the pool.
+        QCStMutexLocker theLock(mMutex);
+        mDoneCount++;
+        mCond.Notify();
+    }
+private:
+    QCIoBufferPool& mPool;
+    QCMutex&        mMutex;
+    QCCondVar&      mCond;
+    int&            mDoneCount;
+    QCThread        mThread;
+};
+
+static int
+TestRound(
+    QCIoBufferPool& inPool)
+{
+    const int kThreadCount         = 8;
+    const int kPartitionCount      = 2;
+    const int kPartitionBufCount   = 256;
+    const int kThreadCacheBufCount = 16;
+    if (inPool.Create(kPartitionCount, kPartitionBufCount, 4 << 10, false,
+            kThreadCacheBufCount) != 0) {
+        return Fail("create");
+    }
+    QCMutex   theMutex;
+    QCCondVar theCond;
+    int       theDoneCount = 0;
+    vector<TestThread*> theThreads;
+    for (int i = 0; i < kThreadCount; i++) {
+        theThreads.push_back(
+            new TestThread(inPool, theMutex, theCond, theDoneCount));
+        theThreads.back()->Start();
+    }
+    int theRet = 0;
+    {
+        QCStMutexLocker theLock(theMutex);
+        while (theDoneCount < kThreadCount) {
+            theCond.Wait(theMutex);
+        }
+    }
+    // All buffers are either in the pool, or in the thread caches.
+    if (inPool.GetFreeBufferCount() != kPartitionCount * kPartitionBufCount ||
+            inPool.GetUsedBufferCount() != 0) {
+        theRet = Fail("buffer count");
+    }
+    // Destroy races with the threads exit.
+    inPool.Destroy();
+    for (size_t i = 0; i < theThreads.size(); i++) {
+        theThreads[i]->Join();
+        delete theThreads[i];
+    }
+    if (theRet == 0 && (inPool.GetFreeBufferCount() != 0 ||
+            inPool.GetTotalBufferCount() != 0)) {
+        theRet = Fail("buffer count after destroy");
+    }
+    return theRet;
+}
+
+int
+main(
+    int    /* argc */,
+    char** /* argv */)
+{
+    // Fail, instead of hanging, on deadlock.
+    alarm(120);
+    QCIoBufferPool thePool;
+    int            theRet = 0;
+    for (int i = 0; theRet == 0 && i < 200; i++) {
+        theRet = TestRound(thePool);
+    }
+    return TestDone(theRet);
+}
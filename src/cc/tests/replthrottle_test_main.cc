@@ -0,0 +1,204 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Chunk server replication throttle test: the capacity additive
+// increase up to the max. capacity above 1, multiplicative decrease down to
+// the min. capacity with congestion, and the paused replicators resume in
+// order as the token bucket fills up.
+//----------------------------------------------------------------------------
+
+#include "chunk/ReplicationThrottle.h"
+#include "common/Properties.h"
+#include "tests/UnitTest.h"
+
+#include <stdint.h>
+#include <math.h>
+
+#include <vector>
+
+using std::vector;
+
+using namespace KFS;
+using KFS::UnitTest::Fail;
+using KFS::UnitTest::TestDone;
+
+class Replicator
+{
+public:
+    Replicator(
+        int          inId,
+        vector<int>& inResumed)
+        : mId(inId),
+          mResumed(inResumed)
+        {}
+    void Resume()
+        { mResumed.push_back(mId); }
+private:
+    const int    mId;
+    vector<int>& mResumed;
+};
+
+typedef ReplicationThrottleT<Replicator> Throttle;
+
+const int64_t kSec = 1000 * 1000;
+
+static bool
+IsEqual(
+    double inVal,
+    double inExpected)
+{
+    return (fabs(inVal - inExpected) < 1e-9);
+}
+
+static int
+TestAimd()
+{
+    Properties theProps;
+    theProps.setValue("chunkServer.replicationThrottle.intervalSec", "1");
+    theProps.setValue(
+        "chunkServer.replicationThrottle.targetClientLatencyUsec", "1000");
+    theProps.setValue(
+        "chunkServer.replicationThrottle.targetDiskQueueDepth", "8");
+    theProps.setValue("chunkServer.replicationThrottle.minCapacity", "0.1");
+    // The default max. capacity is 1, allow the increase above 1.
+    theProps.setValue("chunkServer.replicationThrottle.maxCapacity", "2");
+    theProps.setValue("chunkServer.replicationThrottle.increasePerSec",
+        "0.25");
+    theProps.setValue("chunkServer.replicationThrottle.decreaseFactor",
+        "0.5");
+    Throttle theThrottle(0);
+    theThrottle.SetParameters(theProps);
+    if (! IsEqual(theThrottle.GetCapacity(), 1)) {
+        return Fail("initial capacity");
+    }
+    int64_t theNow      = 0;
+    int64_t theReqCount = 0;
+    int64_t theReqUsecs = 0;
+    // Not busy: 100 usec latency, increase up to the max. capacity.
+    const double kIncrease[] = { 1.25, 1.5, 1.75, 2, 2, 2 };
+    for (size_t i = 0; i < sizeof(kIncrease) / sizeof(kIncrease[0]); i++) {
+        theNow      += kSec;
+        theReqCount += 10;
+        theReqUsecs += 10 * 100;
+        theThrottle.Update(theNow, theReqCount, theReqUsecs, 1);
+        if (! IsEqual(theThrottle.GetCapacity(), kIncrease[i])) {
+            return Fail("additive increase");
+        }
+    }
+    // No update before the interval ends.
+    theThrottle.Update(theNow + kSec / 2, theReqCount + 10,
+        theReqUsecs + 10 * 5000, 1);
+    if (! IsEqual(theThrottle.GetCapacity(), 2)) {
+        return Fail("update before interval end");
+    }
+    // Client latency above the target: decrease down to the min. capacity.
+    const double kDecrease[] = { 1, 0.5, 0.25, 0.125, 0.1, 0.1 };
+    for (size_t i = 0; i < sizeof(kDecrease) / sizeof(kDecrease[0]); i++) {
+        theNow      += kSec;
+        theReqCount += 10;
+        theReqUsecs += 10 * 5000;
+        theThrottle.Update(theNow, theReqCount, theReqUsecs, 1);
+        if (! IsEqual(theThrottle.GetCapacity(), kDecrease[i])) {
+            return Fail("multiplicative decrease on client latency");
+        }
+    }
+    // Recover, then disk queue depth above the target with no client
+    // requests.
+    theNow += kSec;
+    theThrottle.Update(theNow, theReqCount, theReqUsecs, 1);
+    if (! IsEqual(theThrottle.GetCapacity(), 0.35)) {
+        return Fail("increase with no client requests");
+    }
+    theNow += kSec;
+    theThrottle.Update(theNow, theReqCount, theReqUsecs, 16);
+    if (! IsEqual(theThrottle.GetCapacity(), 0.175)) {
+        return Fail("multiplicative decrease on disk queue depth");
+    }
+    // Disabled throttle reports capacity 1.
+    theProps.setValue("chunkServer.replicationThrottle.enabled", "0");
+    theThrottle.SetParameters(theProps);
+    if (! IsEqual(theThrottle.GetCapacity(), 1)) {
+        return Fail("disabled capacity");
+    }
+    return 0;
+}
+
+static int
+TestPauseResume()
+{
+    Properties  theProps;
+    Throttle    theThrottle(0);
+    vector<int> theResumed;
+    Replicator  theRepl1(1, theResumed);
+    Replicator  theRepl2(2, theResumed);
+    Replicator  theRepl3(3, theResumed);
+    theThrottle.SetParameters(theProps);
+    // No bandwidth limit and capacity 1: never pause.
+    if (theThrottle.Pause(theRepl1, 1 << 20, 0) || theThrottle.IsWaiting()) {
+        return Fail("pause with no bandwidth limit");
+    }
+    theProps.setValue("chunkServer.replicationThrottle.maxBytesPerSec",
+        "1000");
+    theThrottle.SetParameters(theProps);
+    if (! IsEqual(theThrottle.GetBytesPerSec(), 1000)) {
+        return Fail("bandwidth limit");
+    }
+    // The token bucket is empty: the first replicator pauses, and the second
+    // one waits behind it in order to preserve the order.
+    if (! theThrottle.Pause(theRepl1, 500, 0) ||
+            ! theThrottle.Pause(theRepl2, 100, 0) ||
+            ! theThrottle.IsWaiting()) {
+        return Fail("pause with empty token bucket");
+    }
+    if (theThrottle.Resume(kSec * 3 / 10) != 0 || ! theResumed.empty()) {
+        return Fail("resume before token bucket refill");
+    }
+    if (theThrottle.Resume(kSec * 6 / 10) != 2 * kSec * 6 / 10 ||
+            theResumed.size() != 2 ||
+            theResumed[0] != 1 || theResumed[1] != 2 ||
+            theThrottle.IsWaiting()) {
+        return Fail("resume order");
+    }
+    // Removed replicator is not resumed.
+    theResumed.clear();
+    if (! theThrottle.Pause(theRepl3, 1000, kSec * 6 / 10)) {
+        return Fail("pause after resume");
+    }
+    theThrottle.Remove(theRepl3);
+    if (theThrottle.IsWaiting() ||
+            theThrottle.Resume(kSec * 10) != 0 || ! theResumed.empty()) {
+        return Fail("remove");
+    }
+    // The bucket holds at most one second worth of tokens.
+    if (theThrottle.Pause(theRepl1, 1000, kSec * 20) ||
+            ! theThrottle.Pause(theRepl2, 1, kSec * 20)) {
+        return Fail("token bucket burst limit");
+    }
+    return 0;
+}
+
+int
+main(
+    int    /* argc */,
+    char** /* argv */)
+{
+    return TestDone(TestAimd() | TestPauseResume());
+}
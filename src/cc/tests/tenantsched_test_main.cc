@@ -0,0 +1,194 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/18
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Chunk server buffer manager tenant scheduler test: the waiting
+// clients are granted buffers in proportion to the tenant weights, and the
+// disk io requests of the tenant that is over its bandwidth limit wait while
+// the other tenants and the non disk io requests proceed.
+//----------------------------------------------------------------------------
+
+#include "chunk/BufferManager.h"
+#include "common/Properties.h"
+#include "tests/UnitTest.h"
+
+#include <string.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::ostringstream;
+using std::string;
+using std::vector;
+
+using namespace KFS;
+using KFS::UnitTest::Fail;
+using KFS::UnitTest::TestDone;
+
+class TestClient : public BufferManager::Client
+{
+public:
+    TestClient(
+        int          inId,
+        vector<int>& inGranted)
+        : BufferManager::Client(),
+          mId(inId),
+          mGranted(inGranted)
+        {}
+    virtual ~TestClient()
+        {}
+    virtual void Granted(
+        ByteCount /* inByteCount */)
+        { mGranted.push_back(mId); }
+private:
+    const int    mId;
+    vector<int>& mGranted;
+};
+
+static void
+SetTenant(
+    BufferManager& inManager,
+    TestClient&    inClient,
+    const char*    inNamePtr)
+{
+    inManager.SetTenant(inClient, inNamePtr, strlen(inNamePtr));
+}
+
+static int
+TestWeights()
+{
+    const int  kClientCount = 40;
+    const char kPrefix[]    = "chunkServer.bufferManager.qos.";
+    Properties theProps;
+    theProps.setValue(string(kPrefix) + "tenant.a.weight", "3");
+    theProps.setValue(string(kPrefix) + "tenant.b.weight", "1");
+    BufferManager theManager(true);
+    theManager.Init(0, 100, 100, 0);
+    theManager.SetQosParameters(theProps);
+    vector<int> theGranted;
+    // The default tenant client holds all buffers but one, all other
+    // clients have to wait.
+    TestClient  theHog(-1, theGranted);
+    if (! theManager.Get(theHog, 99)) {
+        return Fail("initial get");
+    }
+    vector<TestClient*> theClients;
+    int                 theRet = 0;
+    for (int i = 0; theRet == 0 && i < 2 * kClientCount; i++) {
+        const int theTenant = i % 2;
+        theClients.push_back(new TestClient(theTenant, theGranted));
+        SetTenant(theManager, *theClients.back(), theTenant == 0 ? "a" : "b");
+        if (theManager.Get(*theClients.back(), 1)) {
+            theRet = Fail("get with no buffers available granted");
+        }
+    }
+    if (theRet == 0 && theManager.GetWaitingCount() != 2 * kClientCount) {
+        theRet = Fail("waiting count");
+    }
+    theManager.Put(theHog, 99);
+    theManager.Timeout();
+    if (theRet == 0 && ((int)theGranted.size() != 2 * kClientCount ||
+            theManager.GetWaitingCount() != 0)) {
+        theRet = Fail("all waiting clients granted");
+    }
+    // Tenant "a" with weight 3 gets 3/4 of the grants while both tenants
+    // have clients waiting.
+    int theACount = 0;
+    for (int i = 0; theRet == 0 && i < kClientCount; i++) {
+        if (theGranted[i] == 0) {
+            theACount++;
+        }
+    }
+    if (theRet == 0 && (theACount < kClientCount * 3 / 4 - 1 ||
+            kClientCount * 3 / 4 + 1 < theACount)) {
+        theRet = Fail("weighted fair queuing grant order");
+    }
+    for (size_t i = 0; i < theClients.size(); i++) {
+        theClients[i]->Unregister();
+        delete theClients[i];
+    }
+    theHog.Unregister();
+    return theRet;
+}
+
+static int
+TestThrottle()
+{
+    const char kPrefix[] = "chunkServer.bufferManager.qos.";
+    Properties theProps;
+    theProps.setValue(string(kPrefix) + "tenant.slow.maxBytesPerSec", "1000");
+    BufferManager theManager(true);
+    theManager.Init(0, 1 << 24, 1 << 24, 0);
+    theManager.SetQosParameters(theProps);
+    vector<int> theGranted;
+    TestClient  theSlow1(1, theGranted);
+    TestClient  theSlow2(2, theGranted);
+    TestClient  theSlow3(3, theGranted);
+    TestClient  theFast(4, theGranted);
+    SetTenant(theManager, theSlow1, "slow");
+    SetTenant(theManager, theSlow2, "slow");
+    SetTenant(theManager, theSlow3, "slow");
+    SetTenant(theManager, theFast,  "fast");
+    int theRet = 0;
+    // The bucket has one second worth of tokens, the request larger than that
+    // is granted, and puts the bucket deep into "debt".
+    if (! theManager.GetForDiskIo(theSlow1, 1 << 20)) {
+        theRet = Fail("disk io within the tenant limit");
+    }
+    if (theRet == 0 && theManager.GetForDiskIo(theSlow2, 1)) {
+        theRet = Fail("disk io over the tenant limit granted");
+    }
+    if (theRet == 0 && (! theManager.Get(theSlow3, 1 << 10) ||
+            ! theManager.GetForDiskIo(theFast, 1 << 20))) {
+        theRet = Fail("non disk io or other tenant disk io throttled");
+    }
+    theManager.Timeout();
+    if (theRet == 0 && (! theGranted.empty() || ! theSlow2.IsWaiting())) {
+        theRet = Fail("throttled client granted");
+    }
+    ostringstream theStream;
+    theManager.ShowTenants(theStream);
+    const string theStats = theStream.str();
+    const size_t thePos   = theStats.find("Tenant-slow:");
+    if (theRet == 0 && (thePos == string::npos ||
+            theStats.find(",throttled=1,", thePos) == string::npos ||
+            theStats.find(",waiting=1", thePos) == string::npos)) {
+        theRet = Fail("tenant stats");
+    }
+    theSlow2.CancelRequest();
+    if (theRet == 0 && (theSlow2.IsWaiting() ||
+            theManager.GetWaitingCount() != 0)) {
+        theRet = Fail("cancel request");
+    }
+    theSlow1.Unregister();
+    theSlow2.Unregister();
+    theSlow3.Unregister();
+    theFast.Unregister();
+    return theRet;
+}
+
+int
+main(
+    int    /* argc */,
+    char** /* argv */)
+{
+    return TestDone(TestWeights() | TestThrottle());
+}
@@ -109,7 +109,7 @@ public:
             if (! theRetPtr) {
                 return 0;
             }
-            if (mFetchAttributesFlag && outStatPtr) {
+            if (mFetchAttributesFlag) {
                 if (mFileName.empty()) {
                     mFileName.assign(mDirName.data(), mDirName.length());
                     if (! mFileName.empty() && *(mFileName.rbegin()) != '/') {
@@ -212,6 +212,12 @@ public:
         const int64_t thePos = lseek(inFd, inOffset, inWhence);
         return (thePos < 0 ? RetErrno(errno) : thePos);
     }
+    virtual int Truncate(
+        int     inFd,
+        int64_t inSize)
+    {
+        return Errno(ftruncate(inFd, (off_t)inSize));
+    }
     virtual int Stat(
         const string& inFileName,
         StatBuf&      outStatBuf)
@@ -259,7 +265,8 @@ public:
         } else {
             outName.clear();
         }
-        return RetErrno(theDirIt.GetError());
+        const int theErr = theDirIt.GetError();
+        return (theErr == 0 ? 0 : RetErrno(theErr));
     }
     virtual int Glob(
         const string& inPattern,
@@ -269,6 +276,12 @@ public:
     {
         return glob(inPattern.c_str(), inFlags, inErrFuncPtr, inGlobPtr);
     }
+    virtual int Mkdir(
+        const string& inDirName,
+        kfsMode_t     inMode)
+    {
+        return Errno(mkdir(inDirName.c_str(), (mode_t)inMode));
+    }
     virtual int Chmod(
         const string& inPathName,
         kfsMode_t     inMode)
@@ -363,6 +376,7 @@ public:
                     outName.clear();
                     return;
                 }
+                outName = mAttrs[mCur].filename;
                 ToStat(mAttrs[mCur++], mStatBuf);
                 outStatBufPtr = &mStatBuf;
                 return;
@@ -472,6 +486,12 @@ public:
     {
         return KfsClient::Seek(inFd, inOffset, inWhence);
     }
+    virtual int Truncate(
+        int     inFd,
+        int64_t inSize)
+    {
+        return KfsClient::Truncate(inFd, (chunkOff_t)inSize);
+    }
     virtual int Stat(
         const string& inFileName,
         StatBuf&      outStat)
@@ -523,6 +543,12 @@ public:
         theIt.Next(outName, outStatPtr);
         return 0;
     }
+    virtual int Mkdir(
+        const string& inDirName,
+        kfsMode_t     inMode)
+    {
+        return KfsClient::Mkdir(inDirName.c_str(), inMode);
+    }
     virtual int Chmod(
         const string& inPathName,
         kfsMode_t     inMode)
@@ -115,6 +115,9 @@ public:
         int     inFd,
         int64_t inOffset,
         int     inWhence) = 0;
+    virtual int Truncate(
+        int     inFd,
+        int64_t inSize) = 0;
     virtual int Stat(
         const string& inFileName,
         StatBuf&      outStat) = 0;
@@ -133,6 +136,9 @@ public:
         int           inFlags,
         int (*inErrFuncPtr) (const char* inErrPathPtr, int inErrno),
         glob_t*        inGlobPtr) = 0;
+    virtual int Mkdir(
+        const string& inDirName,
+        kfsMode_t     inMode) = 0;
     virtual int Chmod(
         const string& inPathName,
         kfsMode_t     inMode) = 0;
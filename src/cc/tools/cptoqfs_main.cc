@@ -138,10 +138,12 @@ CpToKfs::Run(int argc, char **argv)
     int                 maxRetry   = -1;
     int                 retryDelay = -1;
     int                 opTimeout  = -1;
+    int                 appendMaxChunks = -1;
+    int                 allocateAhead   = -1;
     int                 optchar;
 
     while ((optchar = getopt(argc, argv,
-            "d:hk:p:s:W:r:vniatxXb:w:u:y:z:R:D:T:S")) != -1) {
+            "d:hk:p:s:W:r:vniatxXb:w:u:y:z:R:D:T:Sc:A:")) != -1) {
         switch (optchar) {
             case 'd':
                 sourcePath = optarg;
@@ -215,6 +217,12 @@ CpToKfs::Run(int argc, char **argv)
             case 'X':
                 mCreateExclusiveFlag = true;
                 break;
+            case 'c':
+                appendMaxChunks = (int)atof(optarg);
+                break;
+            case 'A':
+                allocateAhead = (int)atof(optarg);
+                break;
           default:
                 help = true;
                 break;
@@ -247,6 +255,10 @@ CpToKfs::Run(int argc, char **argv)
             " [-D] -- op retry delay, default -1 -- qfs client default\n"
             " [-T] -- op timeout, default -1 -- qfs client default\n"
             " [-X] -- create exclusive\n"
+            " [-c] -- append: max number of chunks to append to in parallel,"
+                " default -1 -- qfs client default\n"
+            " [-A] -- number of chunks to allocate ahead with sequential"
+                " write, default -1 -- qfs client default\n"
         ;
         return(-1);
     }
@@ -273,6 +285,12 @@ CpToKfs::Run(int argc, char **argv)
     if (mKfsBufSize >= 0) {
         mKfsClient->SetDefaultIoBufferSize(mKfsBufSize);
     }
+    if (appendMaxChunks > 0) {
+        mKfsClient->SetAppendMaxChunksCount(appendMaxChunks);
+    }
+    if (allocateAhead >= 0) {
+        mKfsClient->SetAllocateAheadCount(allocateAhead);
+    }
 
     struct stat statInfo;
     statInfo.st_mode = S_IFREG;
@@ -26,7 +26,12 @@
 
 #include "FileSystem.h"
 #include "common/MsgLogger.h"
+#include "common/time.h"
+#include "libclient/KfsClient.h"
 #include "qcdio/QCUtils.h"
+#include "qcdio/QCThread.h"
+#include "qcdio/QCMutex.h"
+#include "qcdio/qcstutils.h"
 
 #include <unistd.h>
 #include <stdlib.h>
@@ -37,8 +42,12 @@
 
 #include <string>
 #include <vector>
+#include <deque>
+#include <set>
 #include <ostream>
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <algorithm>
 
 namespace KFS
@@ -52,14 +61,25 @@ using std::cerr;
 using std::vector;
 using std::pair;
 using std::max;
+using std::min;
 using std::ostream;
+using std::deque;
+using std::set;
+using std::ifstream;
+using std::ofstream;
+using std::ostringstream;
 
 class KfsTool
 {
 public:
     KfsTool()
         : mIoBufferSize(6 << 20),
-          mIoBufferPtr(new char[mIoBufferSize])
+          mIoBufferPtr(new char[mIoBufferSize]),
+          mCopyThreadCount(8),
+          mCopyMaxBytesPerSec(0),
+          mCopyRangeSize(int64_t(4) * CHUNKSIZE),
+          mCopyJournal(),
+          mCopyCreateParams()
         {}
     ~KfsTool()
     {
@@ -74,9 +94,31 @@ public:
         bool                theHelpFlag = false;
         MsgLogger::LogLevel theLogLevel = MsgLogger::kLogLevelINFO;
 
+        // The commands start with "-", stop options parsing at the first
+        // command.
+        int theCmdIdx = 1;
+        while (theCmdIdx < inArgCount && ! IsCommand(inArgsPtr[theCmdIdx])) {
+            theCmdIdx++;
+        }
         int theOpt;
-        while ((theOpt = getopt(inArgCount, inArgsPtr, "hs:p:v")) != -1) {
+        while ((theOpt = getopt(theCmdIdx, inArgsPtr, "hs:p:vj:B:R:J:o:")) !=
+                -1) {
             switch (theOpt) {
+                case 'j':
+                    mCopyThreadCount = atoi(optarg);
+                    break;
+                case 'B':
+                    mCopyMaxBytesPerSec = (int64_t)atof(optarg);
+                    break;
+                case 'R':
+                    mCopyRangeSize = (int64_t)atof(optarg);
+                    break;
+                case 'J':
+                    mCopyJournal = optarg;
+                    break;
+                case 'o':
+                    mCopyCreateParams = optarg;
+                    break;
                 case 's':
                     theMetaHost = optarg;
                     break;
@@ -96,11 +138,28 @@ public:
             }
         }
 
-        if (theHelpFlag || (theMetaHost.empty() && ! theMetaPort.empty())) {
+        if (theHelpFlag || optind < theCmdIdx ||
+                (theMetaHost.empty() && ! theMetaPort.empty())) {
             cout <<
                 "Usage: " << (inArgCount > 0 ? inArgsPtr[0] : "") << "\n"
                 " [-s <meta server host>]\n"
                 " [-p <meta server port>]\n"
+                " [-j <max concurrent copies> default: " <<
+                    mCopyThreadCount << "]\n"
+                " [-B <max copy bytes per second, all copies> default: "
+                    "unlimited]\n"
+                " [-R <copy range size> split files larger than range"
+                    " size into ranges copied in parallel; 0 -- no split;"
+                    " default: " << mCopyRangeSize << "]\n"
+                " [-J <copy journal> record completed copies, and skip"
+                    " these when restarted]\n"
+                " [-o <qfs create params> default: S -- RS 6+3]\n"
+                " -cat <path>...\n"
+                " -ls <path>...\n"
+                " -lsr <path>...\n"
+                " -cp <src>... <dst>\n"
+                " -put <local src>... <dst>\n"
+                " -get <src>... <local dst>\n"
             ;
             return 1;
         }
@@ -108,7 +167,7 @@ public:
 
         if (! theMetaHost.empty()) {
             string theUri = "qfs://" + theMetaHost;
-            if (theMetaPort.empty()) {
+            if (! theMetaPort.empty()) {
                 theUri += ":";
                 theUri += theMetaPort;
             }
@@ -120,6 +179,7 @@ public:
             }
         }
         int theErr = 0;
+        optind = theCmdIdx;
         if (optind < inArgCount) {
             const char* const theCmdPtr = inArgsPtr[optind];
             if (strcmp(theCmdPtr, "-cat") == 0) {
@@ -128,10 +188,19 @@ public:
                 const bool kRecursiveFlag = false;
                 theErr = List(inArgsPtr + optind + 1, inArgCount - optind - 1,
                     kRecursiveFlag);
-            } else if (strcmp(theCmdPtr, "-ls") == 0) {
+            } else if (strcmp(theCmdPtr, "-lsr") == 0) {
                 const bool kRecursiveFlag = true;
                 theErr = List(inArgsPtr + optind + 1, inArgCount - optind - 1,
                     kRecursiveFlag);
+            } else if (strcmp(theCmdPtr, "-cp") == 0) {
+                theErr = Copy(inArgsPtr + optind + 1, inArgCount - optind - 1,
+                    0, 0);
+            } else if (strcmp(theCmdPtr, "-put") == 0) {
+                theErr = Copy(inArgsPtr + optind + 1, inArgCount - optind - 1,
+                    "file:", 0);
+            } else if (strcmp(theCmdPtr, "-get") == 0) {
+                theErr = Copy(inArgsPtr + optind + 1, inArgCount - optind - 1,
+                    0, "file:");
             } else {
                 cerr << "unsupported option: " << theCmdPtr << "\n";
                 theErr = EINVAL;
@@ -140,6 +209,25 @@ public:
         return (theErr == 0 ? 0 : 1);
     }
 private:
+    static bool IsCommand(
+        const char* inArgPtr)
+    {
+        const char* const kCommands[] = {
+            "-cat",
+            "-ls",
+            "-lsr",
+            "-cp",
+            "-put",
+            "-get",
+            0
+        };
+        for (const char* const* thePtr = kCommands; *thePtr; ++thePtr) {
+            if (strcmp(*thePtr, inArgPtr) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
     static const char* GlobError(
         int inError)
     {
@@ -367,8 +455,9 @@ private:
                 return true;
             }
             Show(inFs, inPath, string(), mStat);
+            const bool theDirFlag = (mStat.st_mode & S_IFDIR) != 0;
             mStat.Reset();
-            if ((mStat.st_mode & S_IFDIR) != 0) {
+            if (theDirFlag) {
                 FileSystem::DirIterator* theItPtr = 0;
                 const bool kFetchAttributesFlag = true;
                 if ((theErr = inFs.Open(
@@ -525,9 +614,589 @@ private:
         ListFunctor theFunc(cout, "stdout", cerr, inRecursiveFlag);
         return Apply(inArgsPtr, inArgCount, theFunc);
     }
+    // Parallel copy. The worker threads walk the source directories, and
+    // copy the files. The files larger than the range size are split into
+    // ranges copied in parallel, if the destination permits concurrent
+    // writes into the same file: local file system, or qfs non striped
+    // files. The completed ranges are recorded in the journal, if any, and
+    // skipped when the copy is restarted with the same journal.
+    class Copier : public QCRunnable
+    {
+    public:
+        Copier(
+            ostream&      inErrorStream,
+            int           inThreadCount,
+            int64_t       inMaxBytesPerSec,
+            int64_t       inRangeSize,
+            size_t        inIoBufferSize,
+            const string& inJournal,
+            const string& inCreateParams)
+            : QCRunnable(),
+              mErrorStream(inErrorStream),
+              mThreadCount(max(1, inThreadCount)),
+              mMaxBytesPerSec(inMaxBytesPerSec),
+              mRangeSize(inRangeSize),
+              mIoBufferSize(inIoBufferSize),
+              mJournal(inJournal),
+              mCreateParams(inCreateParams),
+              mQfsRangesFlag(false),
+              mMutex(),
+              mCond(),
+              mQueue(),
+              mPendingCount(0),
+              mStatus(0),
+              mThrottleTime(0),
+              mDone(),
+              mJournalStream(),
+              mFileCount(0),
+              mSkippedCount(0),
+              mByteCount(0)
+        {
+            int theReplicas;
+            int theStripes;
+            int theRecoveryStripes;
+            int theStripeSize;
+            int theStriperType;
+            mQfsRangesFlag = ! mCreateParams.empty() &&
+                KfsClient::ParseCreateParams(mCreateParams.c_str(),
+                    theReplicas, theStripes, theRecoveryStripes,
+                    theStripeSize, theStriperType) == 0 &&
+                theStriperType == KFS_STRIPED_FILE_TYPE_NONE;
+            if (mRangeSize > 0) {
+                // Align ranges to chunk boundary, in order to ensure that
+                // concurrent qfs writers never write into the same chunk.
+                mRangeSize = (mRangeSize + CHUNKSIZE - 1) /
+                    CHUNKSIZE * CHUNKSIZE;
+            }
+        }
+        int Copy(
+            const GlobResult& inSrcs,
+            FileSystem&       inDstFs,
+            const string&     inDstPath)
+        {
+            FileSystem::StatBuf theStat;
+            const bool theDirFlag = inDstFs.Stat(inDstPath, theStat) == 0 &&
+                (theStat.st_mode & S_IFDIR) != 0;
+            size_t theSrcCount = 0;
+            for (GlobResult::const_iterator theIt = inSrcs.begin();
+                    theIt != inSrcs.end();
+                    ++theIt) {
+                theSrcCount += theIt->second.size();
+            }
+            if (! theDirFlag && theSrcCount > 1) {
+                mErrorStream << inDstFs.GetUri() << inDstPath <<
+                    ": " << inDstFs.StrError(-ENOTDIR) << "\n";
+                return -ENOTDIR;
+            }
+            int theErr;
+            if ((theErr = LoadJournal())) {
+                return theErr;
+            }
+            for (GlobResult::const_iterator theFsIt = inSrcs.begin();
+                    theFsIt != inSrcs.end();
+                    ++theFsIt) {
+                FileSystem& theFs = *(theFsIt->first);
+                for (vector<string>::const_iterator
+                        theIt = theFsIt->second.begin();
+                        theIt != theFsIt->second.end();
+                        ++theIt) {
+                    if ((theErr = theFs.Stat(*theIt, theStat))) {
+                        Error(theFs, *theIt, theErr);
+                        continue;
+                    }
+                    string theDstPath = inDstPath;
+                    if (theDirFlag) {
+                        const size_t thePos = theIt->find_last_not_of('/');
+                        const size_t theEnd = thePos == string::npos ?
+                            0 : thePos + 1;
+                        const size_t theStart =
+                            theIt->rfind('/', thePos) + 1;
+                        if (*theDstPath.rbegin() != '/') {
+                            theDstPath += "/";
+                        }
+                        theDstPath += theIt->substr(
+                            theStart, theEnd - theStart);
+                    }
+                    Enqueue(Task(
+                        (theStat.st_mode & S_IFDIR) != 0 ?
+                            Task::kDir : Task::kFile,
+                        theFs, *theIt, inDstFs, theDstPath));
+                }
+            }
+            const int64_t theStartTime = microseconds();
+            vector<QCThread*> theThreads;
+            theThreads.reserve(mThreadCount);
+            for (int i = 0; i < mThreadCount; i++) {
+                theThreads.push_back(new QCThread(this, "copy"));
+                theThreads.back()->Start();
+            }
+            for (vector<QCThread*>::const_iterator theIt = theThreads.begin();
+                    theIt != theThreads.end();
+                    ++theIt) {
+                (*theIt)->Join();
+                delete *theIt;
+            }
+            const double theTime = max(int64_t(1),
+                microseconds() - theStartTime) * 1e-6;
+            mErrorStream <<
+                "copied: "   << mFileCount <<
+                " skipped: " << mSkippedCount <<
+                " bytes: "   << mByteCount <<
+                " "          << theTime << " sec. " <<
+                (mByteCount / theTime / (1 << 20)) << " MB/sec\n";
+            mJournalStream.close();
+            return mStatus;
+        }
+        virtual void Run()
+        {
+            vector<char> theBuf(mIoBufferSize);
+            QCStMutexLocker theLock(mMutex);
+            for (; ;) {
+                while (mQueue.empty() && mPendingCount > 0) {
+                    mCond.Wait(mMutex);
+                }
+                if (mQueue.empty()) {
+                    break;
+                }
+                const Task theTask = mQueue.front();
+                mQueue.pop_front();
+                {
+                    QCStMutexUnlocker theUnlock(mMutex);
+                    Process(theTask, &theBuf[0]);
+                }
+                if (--mPendingCount <= 0) {
+                    mCond.NotifyAll();
+                }
+            }
+        }
+    private:
+        struct Task
+        {
+            enum Type
+            {
+                kDir,
+                kFile,
+                kRange
+            };
+            Task(
+                Type          inType,
+                FileSystem&   inSrcFs,
+                const string& inSrcPath,
+                FileSystem&   inDstFs,
+                const string& inDstPath,
+                int64_t       inStart = -1,
+                int64_t       inEnd   = -1,
+                int64_t       inSize  = -1,
+                int64_t       inMtime = -1)
+                : mType(inType),
+                  mSrcFsPtr(&inSrcFs),
+                  mSrcPath(inSrcPath),
+                  mDstFsPtr(&inDstFs),
+                  mDstPath(inDstPath),
+                  mStart(inStart),
+                  mEnd(inEnd),
+                  mSize(inSize),
+                  mMtime(inMtime)
+                {}
+            Type        mType;
+            FileSystem* mSrcFsPtr;
+            string      mSrcPath;
+            FileSystem* mDstFsPtr;
+            string      mDstPath;
+            int64_t     mStart;
+            int64_t     mEnd;
+            int64_t     mSize;
+            int64_t     mMtime;
+        };
+        typedef deque<Task> Queue;
+        typedef set<string> Done;
+
+        ostream&      mErrorStream;
+        const int     mThreadCount;
+        const int64_t mMaxBytesPerSec;
+        int64_t       mRangeSize;
+        const size_t  mIoBufferSize;
+        const string  mJournal;
+        const string  mCreateParams;
+        bool          mQfsRangesFlag;
+        QCMutex       mMutex;
+        QCCondVar     mCond;
+        Queue         mQueue;
+        int64_t       mPendingCount;
+        int           mStatus;
+        int64_t       mThrottleTime;
+        Done          mDone;
+        ofstream      mJournalStream;
+        int64_t       mFileCount;
+        int64_t       mSkippedCount;
+        int64_t       mByteCount;
+
+        void Enqueue(
+            const Task& inTask)
+        {
+            QCStMutexLocker theLock(mMutex);
+            mQueue.push_back(inTask);
+            mPendingCount++;
+            mCond.Notify();
+        }
+        void Error(
+            FileSystem&   inFs,
+            const string& inPath,
+            int           inErr)
+        {
+            QCStMutexLocker theLock(mMutex);
+            mErrorStream << inFs.GetUri() << inPath <<
+                ": " << inFs.StrError(inErr) << "\n";
+            if (mStatus == 0) {
+                mStatus = inErr;
+            }
+        }
+        static string JournalKey(
+            const Task& inTask)
+        {
+            ostringstream theStream;
+            theStream << inTask.mSrcFsPtr->GetUri() << inTask.mSrcPath <<
+                "\t" << inTask.mDstFsPtr->GetUri() << inTask.mDstPath <<
+                "\t" << inTask.mSize <<
+                "\t" << inTask.mMtime <<
+                "\t" << inTask.mStart <<
+                "\t" << inTask.mEnd;
+            return theStream.str();
+        }
+        int LoadJournal()
+        {
+            if (mJournal.empty()) {
+                return 0;
+            }
+            ifstream theStream(mJournal.c_str());
+            string   theLine;
+            while (getline(theStream, theLine)) {
+                mDone.insert(theLine);
+            }
+            mJournalStream.open(mJournal.c_str(), ofstream::app);
+            if (! mJournalStream) {
+                const int theErr = errno;
+                mErrorStream << mJournal << ": " <<
+                    QCUtils::SysError(theErr) << "\n";
+                return (theErr > 0 ? -theErr : -EIO);
+            }
+            return 0;
+        }
+        bool IsDone(
+            const Task& inTask)
+        {
+            QCStMutexLocker theLock(mMutex);
+            return (mDone.find(JournalKey(inTask)) != mDone.end());
+        }
+        void Completed(
+            const Task& inTask,
+            int64_t     inByteCount)
+        {
+            QCStMutexLocker theLock(mMutex);
+            mByteCount += inByteCount;
+            if (! mJournalStream.is_open()) {
+                return;
+            }
+            mJournalStream << JournalKey(inTask) << "\n";
+            mJournalStream.flush();
+        }
+        void Throttle(
+            int64_t inByteCount)
+        {
+            if (mMaxBytesPerSec <= 0) {
+                return;
+            }
+            int64_t theSleepTime;
+            {
+                QCStMutexLocker theLock(mMutex);
+                const int64_t theNow = microseconds();
+                mThrottleTime = max(mThrottleTime, theNow) +
+                    inByteCount * 1000 * 1000 / mMaxBytesPerSec;
+                theSleepTime = mThrottleTime - theNow;
+            }
+            if (theSleepTime > 0) {
+                usleep((useconds_t)theSleepTime);
+            }
+        }
+        void Process(
+            const Task& inTask,
+            char*       inBufPtr)
+        {
+            switch (inTask.mType) {
+                case Task::kDir:
+                    CopyDir(inTask);
+                    break;
+                case Task::kFile:
+                    CopyFile(inTask, inBufPtr);
+                    break;
+                case Task::kRange:
+                    CopyRange(inTask, inBufPtr);
+                    break;
+            }
+        }
+        void CopyDir(
+            const Task& inTask)
+        {
+            FileSystem& theSrcFs = *inTask.mSrcFsPtr;
+            FileSystem& theDstFs = *inTask.mDstFsPtr;
+            FileSystem::StatBuf theStat;
+            int theErr = theDstFs.Mkdir(inTask.mDstPath, 0777);
+            if (theErr != 0 && (theDstFs.Stat(inTask.mDstPath, theStat) != 0 ||
+                    (theStat.st_mode & S_IFDIR) == 0)) {
+                Error(theDstFs, inTask.mDstPath, theErr);
+                return;
+            }
+            FileSystem::DirIterator* theItPtr = 0;
+            const bool kFetchAttributesFlag = true;
+            if ((theErr = theSrcFs.Open(
+                    inTask.mSrcPath, kFetchAttributesFlag, theItPtr))) {
+                Error(theSrcFs, inTask.mSrcPath, theErr);
+                return;
+            }
+            string theName;
+            for (; ;) {
+                const FileSystem::StatBuf* theStatPtr = 0;
+                if ((theErr = theSrcFs.Next(theItPtr, theName, theStatPtr))) {
+                    Error(theSrcFs, inTask.mSrcPath, theErr);
+                }
+                if (theName.empty()) {
+                    break;
+                }
+                if (theName == "." || theName == "..") {
+                    continue;
+                }
+                const string theSrcPath = inTask.mSrcPath + "/" + theName;
+                if (! theStatPtr) {
+                    if ((theErr = theSrcFs.Stat(theSrcPath, theStat))) {
+                        Error(theSrcFs, theSrcPath, theErr);
+                        continue;
+                    }
+                    theStatPtr = &theStat;
+                }
+                Enqueue(Task(
+                    (theStatPtr->st_mode & S_IFDIR) != 0 ?
+                        Task::kDir : Task::kFile,
+                    theSrcFs, theSrcPath,
+                    theDstFs, inTask.mDstPath + "/" + theName));
+            }
+            theSrcFs.Close(theItPtr);
+        }
+        void CopyFile(
+            const Task& inTask,
+            char*       inBufPtr)
+        {
+            FileSystem& theSrcFs = *inTask.mSrcFsPtr;
+            FileSystem& theDstFs = *inTask.mDstFsPtr;
+            FileSystem::StatBuf theStat;
+            int theErr;
+            if ((theErr = theSrcFs.Stat(inTask.mSrcPath, theStat))) {
+                Error(theSrcFs, inTask.mSrcPath, theErr);
+                return;
+            }
+            const int64_t theSize = max(int64_t(0), (int64_t)theStat.st_size);
+            const bool    theSplitFlag = 0 < mRangeSize &&
+                mRangeSize < theSize &&
+                (theDstFs.GetUri().compare(0, 5, "file:") == 0 ||
+                    mQfsRangesFlag);
+            const int64_t theRangeSize = theSplitFlag ? mRangeSize :
+                max(int64_t(1), theSize);
+            // The source modification time is part of the journal key, in
+            // order not to skip ranges of the source that has changed since
+            // the ranges were copied.
+            const int64_t theMtime = (int64_t)theStat.st_mtime;
+            vector<Task> theRanges;
+            bool         theDoneFlag = false;
+            int64_t      theDoneEnd  = 0;
+            for (int64_t thePos = 0; thePos < theSize || thePos == 0; ) {
+                const int64_t theEnd = min(theSize, thePos + theRangeSize);
+                const Task theRange(Task::kRange,
+                    theSrcFs, inTask.mSrcPath, theDstFs, inTask.mDstPath,
+                    thePos, theEnd, theSize, theMtime);
+                if (IsDone(theRange)) {
+                    theDoneFlag = true;
+                    theDoneEnd  = theEnd;
+                } else {
+                    theRanges.push_back(theRange);
+                }
+                if (theSize <= (thePos = theEnd)) {
+                    break;
+                }
+            }
+            if (theRanges.empty()) {
+                QCStMutexLocker theLock(mMutex);
+                mSkippedCount++;
+                return;
+            }
+            // Do not truncate partially copied file.
+            const int theFd = theDstFs.Open(inTask.mDstPath,
+                O_WRONLY | O_CREAT | (theDoneFlag ? 0 : O_TRUNC),
+                (int)(theStat.st_mode & 0777),
+                mCreateParams.empty() ? 0 : &mCreateParams);
+            if (theFd < 0) {
+                Error(theDstFs, inTask.mDstPath, theFd);
+                return;
+            }
+            // Discard whatever the interrupted copy has written past the last
+            // completed range, the remaining ranges are copied again.
+            if (theDoneFlag &&
+                    (theErr = theDstFs.Truncate(theFd, theDoneEnd))) {
+                Error(theDstFs, inTask.mDstPath, theErr);
+                theDstFs.Close(theFd);
+                return;
+            }
+            {
+                QCStMutexLocker theLock(mMutex);
+                mFileCount++;
+            }
+            if (theRanges.size() == 1) {
+                CopyRange(theRanges.front(), inBufPtr, theFd);
+                return;
+            }
+            if ((theErr = theDstFs.Close(theFd))) {
+                Error(theDstFs, inTask.mDstPath, theErr);
+                return;
+            }
+            for (vector<Task>::const_iterator theIt = theRanges.begin();
+                    theIt != theRanges.end();
+                    ++theIt) {
+                Enqueue(*theIt);
+            }
+        }
+        void CopyRange(
+            const Task& inTask,
+            char*       inBufPtr,
+            int         inDstFd = -1)
+        {
+            FileSystem& theSrcFs = *inTask.mSrcFsPtr;
+            FileSystem& theDstFs = *inTask.mDstFsPtr;
+            const int   theDstFd = inDstFd < 0 ?
+                theDstFs.Open(inTask.mDstPath, O_WRONLY, 0) : inDstFd;
+            if (theDstFd < 0) {
+                Error(theDstFs, inTask.mDstPath, theDstFd);
+                return;
+            }
+            const int theSrcFd = theSrcFs.Open(inTask.mSrcPath, O_RDONLY, 0);
+            if (theSrcFd < 0) {
+                Error(theSrcFs, inTask.mSrcPath, theSrcFd);
+                theDstFs.Close(theDstFd);
+                return;
+            }
+            int     theErr = 0;
+            int64_t thePos = inTask.mStart;
+            int64_t theRes;
+            if (0 < thePos && (theRes = theSrcFs.Seek(
+                    theSrcFd, thePos, SEEK_SET)) != thePos) {
+                theErr = theRes < 0 ? (int)theRes : -EIO;
+                Error(theSrcFs, inTask.mSrcPath, theErr);
+            } else if (0 < thePos && (theRes = theDstFs.Seek(
+                    theDstFd, thePos, SEEK_SET)) != thePos) {
+                theErr = theRes < 0 ? (int)theRes : -EIO;
+                Error(theDstFs, inTask.mDstPath, theErr);
+            }
+            while (theErr == 0 && thePos < inTask.mEnd) {
+                const ssize_t theNRead = theSrcFs.Read(theSrcFd, inBufPtr,
+                    (size_t)min(inTask.mEnd - thePos, (int64_t)mIoBufferSize));
+                if (theNRead <= 0) {
+                    theErr = theNRead < 0 ? (int)theNRead : -EIO;
+                    Error(theSrcFs, inTask.mSrcPath, theErr);
+                    break;
+                }
+                Throttle(theNRead);
+                for (ssize_t theOff = 0; theOff < theNRead; ) {
+                    const ssize_t theNWr = theDstFs.Write(theDstFd,
+                        inBufPtr + theOff, theNRead - theOff);
+                    if (theNWr <= 0) {
+                        theErr = theNWr < 0 ? (int)theNWr : -EIO;
+                        Error(theDstFs, inTask.mDstPath, theErr);
+                        break;
+                    }
+                    theOff += theNWr;
+                }
+                thePos += theNRead;
+            }
+            theSrcFs.Close(theSrcFd);
+            const int theCloseErr = theDstFs.Close(theDstFd);
+            if (theErr == 0 && theCloseErr != 0) {
+                theErr = theCloseErr;
+                Error(theDstFs, inTask.mDstPath, theErr);
+            }
+            if (theErr == 0) {
+                Completed(inTask, thePos - inTask.mStart);
+            }
+        }
+    private:
+        Copier(
+            const Copier& inCopier);
+        Copier& operator=(
+            const Copier& inCopier);
+    };
+    static bool HasScheme(
+        const char* inPathPtr)
+    {
+        const char* const thePtr = inPathPtr + strcspn(inPathPtr, ":/?#");
+        return (thePtr != inPathPtr && *thePtr == ':');
+    }
+    int Copy(
+        char**      inArgsPtr,
+        int         inArgCount,
+        const char* inSrcDefaultPtr,
+        const char* inDstDefaultPtr)
+    {
+        if (inArgCount < 2) {
+            cerr << "source and destination required\n";
+            return -EINVAL;
+        }
+        vector<string> theArgs;
+        vector<char*>  theArgsPtr;
+        theArgs.reserve(inArgCount - 1);
+        theArgsPtr.reserve(inArgCount - 1);
+        for (int i = 0; i < inArgCount - 1; i++) {
+            theArgs.push_back(string(
+                (inSrcDefaultPtr && ! HasScheme(inArgsPtr[i])) ?
+                    inSrcDefaultPtr : "") + inArgsPtr[i]);
+            theArgsPtr.push_back(&theArgs.back()[0]);
+        }
+        GlobResult theSrcs;
+        int theErr = Glob(&theArgsPtr[0], (int)theArgsPtr.size(), theSrcs);
+        if (theErr) {
+            return theErr;
+        }
+        const char* const theDstPtr = inArgsPtr[inArgCount - 1];
+        const string theDst = string(
+            (inDstDefaultPtr && ! HasScheme(theDstPtr)) ?
+                inDstDefaultPtr : "") + theDstPtr;
+        FileSystem* theFsPtr = 0;
+        string      thePath;
+        if ((theErr = FileSystem::Get(theDst, theFsPtr, &thePath))) {
+            cerr << theDst << ": " << FileSystem::GetStrError(theErr) << "\n";
+            return theErr;
+        }
+        if (thePath.empty() || thePath[0] != '/') {
+            string theCwd;
+            if ((theErr = theFsPtr->GetCwd(theCwd))) {
+                cerr << theDst << ": " << theFsPtr->StrError(theErr) << "\n";
+                return theErr;
+            }
+            if (! thePath.empty()) {
+                if (theCwd.empty() || *theCwd.rbegin() != '/') {
+                    theCwd += "/";
+                }
+                theCwd += thePath;
+            }
+            thePath.swap(theCwd);
+        }
+        Copier theCopier(cerr, mCopyThreadCount, mCopyMaxBytesPerSec,
+            mCopyRangeSize, mIoBufferSize, mCopyJournal, mCopyCreateParams);
+        return theCopier.Copy(theSrcs, *theFsPtr, thePath);
+    }
 private:
-    size_t mIoBufferSize;
-    char*  mIoBufferPtr;
+    size_t  mIoBufferSize;
+    char*   mIoBufferPtr;
+    int     mCopyThreadCount;
+    int64_t mCopyMaxBytesPerSec;
+    int64_t mCopyRangeSize;
+    string  mCopyJournal;
+    string  mCopyCreateParams;
 private:
     KfsTool(const KfsTool& inTool);
     KfsTool& operator=(const KfsTool& inTool);
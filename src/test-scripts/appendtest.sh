@@ -0,0 +1,88 @@
+#!/bin/sh
+#
+# $Id$
+#
+# Created 2026/10/18
+#
+# Copyright 2026 Quantcast Corp.
+#
+# This file is part of Kosmos File System (KFS).
+#
+# Licensed under the Apache License, Version 2.0
+# (the "License"); you may not use this file except in compliance with
+# the License. You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+# implied. See the License for the specific language governing
+# permissions and limitations under the License.
+#
+# Record append test with a single appender spraying records over multiple
+# chunks. The records are whole fixed size lines, therefore the sorted file
+# content must match the input, and every chain must get a chunk of its own.
+# The chunks are partially filled, the file is read with holes skipped.
+#
+
+meta=${meta-'-s 127.0.0.1 -p 20000'}
+dir="/kfstest/`hostname`/`basename "$0" .sh`${1-}"
+log="`basename "$0" .sh`${1-}.log"
+kfstools=${kfstools-'src/cc/tools'}
+kfsshell="qfsshell $meta -q --"
+appendchunks=${appendchunks-3}
+appendrecsize=${appendrecsize-4096}
+appendlines=${appendlines-524288}
+
+if [ -d "${kfstools}" ]; then
+    kfstools=`cd "${kfstools}" && pwd`
+fi
+PATH="`pwd`:${PATH}"
+[ -d "${kfstools}" ] && PATH="${kfstools}:${PATH}"
+export PATH
+
+if [ ! -d "$log" ]; then
+    mkdir -p "$log" || exit
+fi
+
+cd "$log" || exit
+
+$kfsshell rm "$dir" > /dev/null 2>&1
+$kfsshell mkdir "$dir" || exit
+
+# 16 byte lines, the record size must be multiple of the line size.
+awk 'BEGIN { for (i = 0; i < '"$appendlines"'; i++) printf("%015d\n", i); }' \
+    > append.in || exit
+cptoqfs $meta -a -b "$appendrecsize" -c "$appendchunks" \
+    -k "$dir/append.test" -d append.in > append.log 2>&1 || exit
+# The chunk servers make the append chunks stable after the appender closes,
+# and report chunk size as CHUNKSIZE until then. Wait for the chunk sizes to
+# add up to the input size, in order not to read past the end of the chunk
+# that is being made stable.
+insize=`wc -c < append.in`
+chunks=0
+i=0
+while true; do
+    qfsfileenum $meta -f "$dir/append.test" > append.enum || exit
+    set `awk '
+        /^position:/ { if (! ($4 in ids)) { ids[$4] = 1; n++; s += $8; } }
+        END { print n + 0, s + 0; }' append.enum`
+    chunks=$1
+    [ $2 -eq $insize ] && break
+    i=`expr $i + 1`
+    if [ $i -ge 120 ]; then
+        cat append.enum
+        echo "append chunks size does not match input size: $insize"
+        exit 1
+    fi
+    sleep 1
+done
+if [ $chunks -lt $appendchunks ]; then
+    cat append.enum
+    echo "expected at least $appendchunks chunks"
+    exit 1
+fi
+cpfromqfs $meta -S -k "$dir/append.test" -d - 2>>append.log \
+    | sort | cmp - append.in || exit
+echo "Passed append test."
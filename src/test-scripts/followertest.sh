@@ -0,0 +1,98 @@
+#!/bin/sh
+#
+# $Id$
+#
+# Created 2026/10/18
+#
+# Copyright 2026 Quantcast Corp.
+#
+# This file is part of Kosmos File System (KFS).
+#
+# Licensed under the Apache License, Version 2.0
+# (the "License"); you may not use this file except in compliance with
+# the License. You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+# implied. See the License for the specific language governing
+# permissions and limitations under the License.
+#
+# Meta server follower test. The follower replays the checkpoint and tails the
+# log of the running primary meta server. The follower services the name space
+# lookups, and rejects the name space modifications, and the requests that need
+# the chunk locations, as chunk servers do not connect to the follower.
+#
+
+metahost=${metahost-'127.0.0.1'}
+metasrvdir=${metasrvdir-'meta'}
+followerport=${followerport-20201}
+followerchunkport=${followerchunkport-20301}
+dir="/kfstest/`hostname`"
+file="$dir/appendtest/append.test"
+log="`basename "$0" .sh`${1-}.log"
+kfsshell="qfsshell -s $metahost -p $followerport -q --"
+
+metasrvdir=`cd "$metasrvdir" && pwd` || exit
+
+if [ ! -d "$log" ]; then
+    mkdir -p "$log" || exit
+fi
+
+cd "$log" || exit
+logdir=`pwd`
+
+# The checkpoint refers to the log by the path relative to the primary's
+# working directory.
+cat > MetaServer.prp << EOF2
+metaServer.clientPort = $followerport
+metaServer.chunkServerPort = $followerchunkport
+metaServer.cpDir = kfscp
+metaServer.logDir = kfslog
+metaServer.follower = 1
+metaServer.follower.pollIntervalMs = 100
+metaServer.follower.maxStalenessSec = 30
+metaServer.loglevel = DEBUG
+EOF2
+
+cd "$metasrvdir" || exit
+metaserver -c "$logdir/MetaServer.prp" "$logdir/metaserver.log" \
+    > "$logdir/metaserver.out" 2>&1 &
+followerpid=$!
+cd "$logdir" || exit
+trap 'kill -KILL $followerpid 2>/dev/null' EXIT
+
+sleep 3
+
+kill -0 $followerpid || exit
+
+status=0
+$kfsshell ls "$dir" > ls.out 2>&1 || {
+    echo "follower: directory listing failed"
+    status=1
+}
+$kfsshell stat "$dir/appendtest" > stat.out 2>&1 || {
+    echo "follower: stat failed"
+    status=1
+}
+if $kfsshell mkdir "$dir/followertest" > mkdir.out 2>&1; then
+    echo "follower: mkdir succeeded"
+    status=1
+fi
+if cpfromqfs -s $metahost -p $followerport -k "$file" -d /dev/null \
+        > cpfromqfs.out 2>&1; then
+    echo "follower: read succeeded, chunk locations are not known"
+    status=1
+fi
+
+kill -QUIT $followerpid
+wait $followerpid || status=1
+trap '' EXIT
+
+if [ $status -ne 0 ]; then
+    tail -n 20 metaserver.log
+    exit $status
+fi
+echo "Passed follower test."
@@ -143,6 +143,7 @@ for dir in  \
         'src/cc/qcdio' \
         'src/cc/common' \
         'src/cc/qcrs' \
+        'src/cc/tests' \
         "`dirname "$0"`" \
         "$fosdir" \
         "$fodir" \
@@ -267,6 +268,12 @@ cppidf="cptest${pidsuf}"
 cppid=$!
 echo "$cppid" > "$cppidf"
 
+echo "Starting record append test"
+appendpidf="appendtest${pidsuf}"
+appendtest.sh > appendtest.out 2>&1 &
+appendpid=$!
+echo "$appendpid" > "$appendpidf"
+
 if [ $fotest -ne 0 ]; then
     echo "Starting fanout test. Fanout test data size: $fanouttestsize"
     fopidf="kfanout_test${pidsuf}"
@@ -313,6 +320,28 @@ rm "$cppidf"
 
 cat cptest.out
 
+wait $appendpid
+appendstatus=$?
+rm "$appendpidf"
+
+cat appendtest.out
+
+echo "Starting follower test"
+metasrvdir="$metasrvdir" \
+followerport=`expr $metasrvport + 1` \
+followerchunkport=`expr $metasrvchunkport + 1` \
+    followertest.sh > followertest.out 2>&1
+followerstatus=$?
+
+cat followertest.out
+
+echo "Starting allocate ahead test"
+allocahead_test "$metahost" "$metasrvport" \
+    "/kfstest/`hostname`/allocahead.test" > allocahead_test.out 2>&1
+allocaheadstatus=$?
+
+cat allocahead_test.out
+
 if [ $fotest -ne 0 ]; then
     wait $fopid
     fostatus=$?
@@ -384,7 +413,8 @@ done
 
 find "$testdir" -name core\* || status=1
 
-if [ $status -eq 0 -a $cpstatus -eq 0 \
+if [ $status -eq 0 -a $cpstatus -eq 0 -a $appendstatus -eq 0 \
+        -a $followerstatus -eq 0 -a $allocaheadstatus -eq 0 \
         -a $fostatus -eq 0 -a $smstatus -eq 0 \
         -a $kfsaccessstatus -eq 0 ]; then
     echo "Passed all tests"